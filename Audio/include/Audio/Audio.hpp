@@ -4,6 +4,37 @@
 
 extern class Audio* g_audio;
 
+// Buffer sizes of the audio device and the mixer, smaller buffers lower the latency but need more frequent callbacks
+struct AudioBufferSettings
+{
+	// Device buffer in samples, 0 for the default of the driver
+	uint32 bufferSize = 0;
+	// Number of samples the mixer renders at once
+	uint32 blockSize = 384;
+	// Grows the device buffer after underruns and shrinks it back once playback is stable
+	bool adaptive = false;
+	// Renders streams and samples with their effects on worker threads as well, for CPUs with slow cores
+	bool parallelRender = false;
+	uint32 renderThreads = 2;
+};
+
+// Counters of the mixer, for the debug overlay
+struct AudioStats
+{
+	uint32 bufferSize;
+	uint32 blockSize;
+	uint32 underruns;
+	// Longest mix callback in milliseconds
+	float worstCallbackTime;
+	// Smallest time in milliseconds that was left of the queued audio when a callback finished, since the last call
+	float deadlineSlack;
+	// Worker threads next to the audio thread, 0 when rendering on the audio thread only
+	uint32 renderThreads;
+	uint32 voices;
+	// Render time per block of the most expensive stream or sample with its effects, in milliseconds
+	float costliestVoice;
+};
+
 /*
 	Main audio manager
 	keeps track of active samples and audio streams
@@ -15,7 +46,9 @@ public:
 	Audio();
 	~Audio();
 	// Initializes the audio device
-	bool Init(bool exclusive);
+	bool Init(bool exclusive, const AudioBufferSettings& bufferSettings = AudioBufferSettings());
+	// Applies buffer size changes made by the adaptive buffer mode, called every frame
+	void Update();
 	void SetGlobalVolume(float vol);
 
 	// Opens a stream at path
@@ -26,11 +59,13 @@ public:
 
 	// Target/Output sample rate
 	uint32 GetSampleRate() const;
+	// Resets the deadline slack
+	AudioStats GetStats() const;
 
 	// Private
 	class Audio_Impl* GetImpl();
 
-	// Calculated audio latency by the audio driver (currently unused)
+	// Audio latency of the output device in milliseconds, the stream position already accounts for it
 	int64 audioLatency;
 
 private:
@@ -1,4 +1,109 @@
 #pragma once
+#include <atomic>
+
+/*
+	DSP parameter that is written by the game thread while the audio thread uses it
+	Writes only store a new target, the audio thread picks it up at the start of a block and ramps to it over that block
+	so automated parameters like the laser effect mix don't click
+*/
+class DSPParameter
+{
+public:
+	DSPParameter(float value = 0.0f) : m_target(value), m_value(value), m_blockEnd(value) {}
+	DSPParameter& operator=(float value)
+	{
+		Set(value);
+		return *this;
+	}
+
+	// Sets a new target, safe to call from any thread
+	void Set(float value)
+	{
+		m_target.store(value, std::memory_order_relaxed);
+	}
+	// The last set target
+	float Get() const
+	{
+		return m_target.load(std::memory_order_relaxed);
+	}
+
+	// Audio thread, starts a ramp from the end of the previous block to the current target over <numSamples>
+	//	the first block after creation starts at the target
+	void BeginBlock(uint32 numSamples)
+	{
+		float target = Get();
+		if(!m_started || numSamples == 0)
+		{
+			m_started = true;
+			m_value = m_blockEnd = target;
+			m_step = 0.0f;
+			return;
+		}
+		m_value = m_blockEnd;
+		m_step = (target - m_value) / (float)numSamples;
+		m_blockEnd = target;
+	}
+	// Audio thread, value for the next sample in the block
+	float Next()
+	{
+		m_value += m_step;
+		return m_value;
+	}
+	// Audio thread, jumps to the target at the next block instead of ramping to it
+	void Reset()
+	{
+		m_started = false;
+	}
+
+private:
+	std::atomic<float> m_target;
+	float m_value;
+	float m_blockEnd;
+	float m_step = 0.0f;
+	bool m_started = false;
+};
+
+/*
+	Lock-free single writer, single reader snapshot of a set of parameters that have to change together, like filter coefficients
+	Triple buffered, the writer never waits on the reader and the reader always gets the latest complete set
+*/
+template<typename T>
+class DSPSnapshot
+{
+public:
+	// Writer, fills the write buffer and then publishes it
+	T& GetWriteBuffer()
+	{
+		return m_buffers[m_write];
+	}
+	void Publish()
+	{
+		uint8 old = m_shared.exchange(m_write | newFlag, std::memory_order_acq_rel);
+		m_write = old & indexMask;
+	}
+
+	// Reader, swaps in the latest published snapshot, returns false if nothing was published since the last call
+	bool Update()
+	{
+		if((m_shared.load(std::memory_order_relaxed) & newFlag) == 0)
+			return false;
+		uint8 old = m_shared.exchange(m_read, std::memory_order_acq_rel);
+		m_read = old & indexMask;
+		return true;
+	}
+	const T& GetReadBuffer() const
+	{
+		return m_buffers[m_read];
+	}
+
+private:
+	static const uint8 newFlag = 4;
+	static const uint8 indexMask = 3;
+	T m_buffers[3];
+	std::atomic<uint8> m_shared{ 1 };
+	uint8 m_write = 0;
+	uint8 m_read = 2;
+};
 
 /*
 	Base class for Digital Signal Processors
@@ -11,14 +116,43 @@ public:
 	virtual ~DSP();
 	// Process <numSamples> amount of samples in stereo float format
 	virtual void Process(float* out, uint32 numSamples) = 0;
+	// Allocates everything Process needs for blocks of up to <numSamples>, called by AddDSP before the audio thread can see this DSP
+	virtual void Prepare(uint32 numSamples) {}
+
+	// Turns processing on or off without removing the DSP from its AudioBase, these don't allocate or lock
+	//	the audio thread applies the change at the start of the next block and calls Reset when enabling
+	//	a DSP that isn't added to an AudioBase changes state immediately
+	void Enable();
+	void Bypass();
+	bool IsEnabled() const;
+	// True when bypassed and the audio thread stopped processing it,
+	//	parameters that are not atomic should only be changed while idle or before the DSP is added
+	bool IsIdle() const;
+
+	// Audio thread, applies Enable/Bypass and starts the mix ramp, returns false if this block should skip the DSP
+	bool BeginBlock(uint32 numSamples);
 
-	float mix = 1.0f;
+	// Dry/wet mix, ramped per block by BeginBlock and read per sample with mix.Next()
+	DSPParameter mix{ 1.0f };
 	uint32 priority = 0;
 	uint32 startTime = 0;
 	int32 chartOffset = 0;
 	int32 lastTimingPoint = 0;
 	class AudioBase* audioBase = nullptr;
 	class Audio_Impl* audio = nullptr;
+
+protected:
+	// Audio thread, clears what is left from the last time the DSP was enabled
+	virtual void Reset() {}
+
+private:
+	void m_SetCommand(bool enabled);
+
+	// Sequence number of the last Enable/Bypass in the upper bits, enabled state in bit 0
+	std::atomic<uint32> m_command{ 1 };
+	// Last command the audio thread has applied
+	std::atomic<uint32> m_acknowledged{ 1 };
+	uint32 m_applied = 1;
 };
 
 /*
@@ -62,6 +196,8 @@ public:
 	Vector<DSP*> DSPs;
 	float PlaybackSpeed = 1.0;
 	class Audio_Impl* audio = nullptr;
+	// Time Process and the DSPs take per block in milliseconds, smoothed over a few blocks, measured by the mixer
+	std::atomic<float> renderTime{ 0.0f };
 private:
 	float m_volume = 1.0f;
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+
+/*
+	Smoothed song time for the game thread
+	The audio thread reports which media time it rendered for a moment on the monotonic clock (when it will be heard),
+	these observations jitter with the callback scheduling so the clock follows them with a phase locked loop
+	that corrects both the offset and the rate, and it only ever moves forward between resets
+*/
+class AudioClock
+{
+public:
+	// Current time of the monotonic clock all timestamps use, in seconds
+	static double Now();
+
+	// Restarts the clock at a media time, it stays there until the first observation
+	void Reset(double mediaTime);
+	// Audio thread, <mediaTime> is heard at <time>, <rate> is the expected media time per second
+	//	returns false when the observation was too far off and the clock jumped to it
+	bool Observe(double time, double mediaTime, double rate = 1.0);
+	// Smoothed media time at <time>, never less than a previously returned value since the last reset
+	double GetTime(double time) const;
+	double GetTime() const;
+
+	// Fraction of the phase error corrected with each observation
+	double phaseGain = 0.02;
+	// Rate correction added per second of phase error with each observation
+	double frequencyGain = 0.02;
+	// Largest relative rate correction, the drift between the device and the monotonic clock is much smaller than this
+	double maxRateCorrection = 0.005;
+	// Errors larger than this are seeks or stalls, the clock jumps instead of following them
+	double resetThreshold = 0.15;
+	// How far the clock runs past the last observation, so it stops when the audio thread stops
+	double maxExtrapolation = 0.2;
+
+private:
+	// Starts a change of the members below, returns false if another thread is changing them and <wait> is false
+	bool m_BeginWrite(bool wait);
+	void m_EndWrite();
+
+	// Seqlock for the members below, odd while they are being changed
+	//	readers retry instead of blocking, so the audio thread never waits on the game thread
+	std::atomic<uint32> m_sequence{ 0 };
+	std::atomic<bool> m_started{ false };
+	// Line through the smoothed estimate
+	std::atomic<double> m_anchorTime{ 0.0 };
+	std::atomic<double> m_anchorMedia{ 0.0 };
+	std::atomic<double> m_rate{ 1.0 };
+	std::atomic<double> m_rateCorrection{ 0.0 };
+	std::atomic<double> m_lastObservation{ 0.0 };
+	mutable std::atomic<double> m_lastReturned{ 0.0 };
+};
@@ -3,7 +3,8 @@
 class IMixer
 {
 public:
-	virtual void Mix(void* data, uint32& numSamples) = 0;
+	// <queuedSamples> is the audio the device still has to play, mixing has to finish before it runs out
+	virtual void Mix(void* data, uint32& numSamples, uint32 queuedSamples) = 0;
 };
 
 /*
@@ -15,7 +16,10 @@ public:
 	AudioOutput();
 	~AudioOutput();
 
-	bool Init(bool exclusive);
+	// <bufferSize> is the device buffer size in samples, 0 for the default of the driver
+	bool Init(bool exclusive, uint32 bufferSize = 0);
+	// Reopens the device with a different buffer size, from the game thread
+	bool SetBufferSize(uint32 bufferSize);
 
 	// Safe to start mixing
 	void Start(IMixer* mixer);
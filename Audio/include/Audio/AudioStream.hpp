@@ -9,6 +9,9 @@ class AudioStreamRes : public AudioBase
 {
 public:
 	static Ref<AudioStreamRes> Create(class Audio* audio, const String& path, bool preload);
+	// Opens a stream that is only read with DecodeNext, it is never mixed and doesn't hold the whole file in memory
+	//	can be called from any thread
+	static Ref<AudioStreamRes> CreateDecoder(class Audio* audio, const String& path);
 	virtual ~AudioStreamRes() = default;
 public:
 	// Starts playback of the stream or continues a paused stream
@@ -20,6 +23,30 @@ public:
 	// Sets the playback position in milliseconds
 	// negative time alowed, which will produce no audio for a certain amount of time
 	virtual void SetPosition(int32 pos) = 0;
+
+	// Decodes the first block of audio at the current position, so starting playback doesn't have to
+	//	can be called from any thread while the stream is not playing
+	virtual void PreBuffer() = 0;
+
+	// Practice mode, plays at <tempo> times the normal speed without changing the pitch
+	//	only works on preloaded streams, returns false otherwise
+	virtual bool SetTempo(float tempo) = 0;
+	virtual float GetTempo() const = 0;
+	// Jumps back to <start> when <end> is reached, positions in milliseconds, an end at or before the start disables the loop
+	//	only works on preloaded streams, returns false otherwise
+	virtual bool SetLoop(int32 start, int32 end) = 0;
+	// Number of times playback jumped back to the start of the loop
+	virtual uint32 GetLoopCount() const = 0;
+	// CPU time spent time stretching relative to the duration of the audio, 0 when not stretching
+	virtual float GetTimeStretchLoad() const = 0;
+
+	// Milliseconds from opening the stream until its first samples were decoded for playback, negative before that
+	virtual double GetFirstSampleLatency() const = 0;
+	// Number of stereo frames in the data returned by GetPCM, 0 when the stream isn't preloaded
+	virtual int64 GetPCMCount() const = 0;
+	// Decodes the next block of the file at its own sample rate, <left> and <right> point to the samples until the next call
+	//	returns the number of frames in the block, 0 at the end of the file
+	virtual uint32 DecodeNext(const float*& left, const float*& right) = 0;
 };
 
 typedef Ref<AudioStreamRes> AudioStream;
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Audio.hpp"
 #include "AudioStream.hpp"
 #include "Audio_Impl.hpp"
+#include "AudioClock.hpp"
+#include "TimeStretcher.hpp"
 
 class AudioStreamBase : public AudioStreamRes
 {
@@ -32,13 +34,8 @@ protected:
 	uint64 m_sampleStep = 0;
 	uint64 m_sampleStepIncrement = 0;
 
-	Timer m_deltaTimer;
-	Timer m_streamTimer;
-	double m_streamTimeOffset = 0.0f;
-	double m_offsetCorrection = 0.0f;
-
-	double m_deltaSum = 0.0f;
-	int32 m_deltaSamples = 0;
+	// Follows the position the audio thread renders, shifted by the output latency
+	AudioClock m_clock;
 
 	bool m_paused = false;
 	bool m_playing = false;
@@ -46,6 +43,32 @@ protected:
 
 	float m_volume = 0.8f;
 
+	// Started when the stream is opened, stopped by the first decoded block
+	Timer m_openTimer;
+	double m_firstSampleLatency = -1.0;
+	void m_OnDecoded();
+
+	// Practice mode, the stretcher replaces decoding while the tempo is changed or a loop is set
+	TimeStretcher* m_stretcher = nullptr;
+	float m_tempo = 1.0f;
+	int64 m_loopStart = 0;
+	int64 m_loopEnd = 0;
+	// Chunk the read buffer holds
+	TimeStretcher::ReadInfo m_stretchInfo;
+	bool m_stretchEnded = false;
+	// Loops played since the stream was opened, which keeps counting up when the stretcher is recreated
+	std::atomic<uint32> m_loopCount{ 0 };
+	// Loops played by earlier stretchers
+	uint32 m_loopCountOffset = 0;
+
+	// Creates or removes the stretcher depending on the tempo and loop
+	//	takes the lock only to read the settings and swap the stretcher, creating or stopping one happens outside of it
+	bool m_UpdateStretcher();
+	// Stops the stretcher worker, the derived stream calls this before its PCM is freed
+	void m_DestroyStretcher();
+	// Fills the read buffer with the next stretched chunk
+	int32 m_DecodeStretched();
+
 public:
 	virtual bool Init(Audio* audio, const String& path, bool preload);
 	void InitSampling(uint32 sampleRate);
@@ -55,13 +78,22 @@ public:
 	virtual bool HasEnded() const override;
 	uint64 SecondsToSamples(double s) const;
 	double SamplesToSeconds(int64 s) const;
-	double GetPositionSeconds(bool allowFreezeSkip = true) const;
+	double GetPositionSeconds() const;
 	virtual int32 GetPosition() const override;
 	virtual void SetPosition(int32 pos) override;
+	virtual void PreBuffer() override;
 	virtual float* GetPCM() override;
 	virtual uint32 GetSampleRate() const override;
 	void RestartTiming();
 	virtual void Process(float* out, uint32 numSamples) override;
+	virtual bool SetTempo(float tempo) override;
+	virtual float GetTempo() const override;
+	virtual bool SetLoop(int32 start, int32 end) override;
+	virtual uint32 GetLoopCount() const override;
+	virtual float GetTimeStretchLoad() const override;
+	virtual double GetFirstSampleLatency() const override;
+	virtual int64 GetPCMCount() const override;
+	virtual uint32 DecodeNext(const float*& left, const float*& right) override;
 
 	// Implementation specific set position
 	virtual void SetPosition_Internal(int32 pos) = 0;
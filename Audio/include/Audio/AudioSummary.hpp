@@ -0,0 +1,62 @@
+#pragma once
+
+/*
+	Overview of a whole audio file for skins to draw, computed once so nothing has to be decoded while drawing
+	Contains a min/max/RMS waveform at several resolutions, each level having half the bins of the one before,
+	and a coarse spectrogram with logarithmically spaced bands
+*/
+class AudioSummary
+{
+public:
+	// Frames per bin of the most detailed waveform level
+	static const uint32 baseBinFrames = 256;
+	// The coarsest waveform level has no more than this many bins
+	static const uint32 minBins = 64;
+	// Spectrogram analysis window, distance between columns and number of bands
+	static const uint32 fftSize = 1024;
+	static const uint32 spectrumHop = 2048;
+	static const uint32 numBands = 16;
+	// Level in dB relative to a full scale sine that is stored as 0 in the spectrogram
+	static const float spectrumFloor;
+
+	struct WaveformLevel
+	{
+		uint32 binFrames = 0;
+		// Lowest and highest sample of both channels in each bin as -127 to 127
+		Vector<int8> min;
+		Vector<int8> max;
+		// RMS of each bin as 0 to 255
+		Vector<uint8> rms;
+	};
+
+	// Builds the summary from interleaved stereo samples
+	void Build(const float* pcm, int64 numFrames, uint32 sampleRate);
+	// Decodes an audio file block by block and builds the summary from it, returns false if the file can't be decoded
+	//	can be called from any thread
+	bool Build(class Audio* audio, const String& path);
+
+	// Waveform reduced to <columns> bins from the coarsest level that has at least that many,
+	//	min and max from -1 to 1 and rms from 0 to 1
+	void GetWaveform(uint32 columns, Vector<float>& min, Vector<float>& max, Vector<float>& rms) const;
+	// Spectrogram reduced to <columns> columns of numBands levels from 0 to 1, lowest band first
+	void GetSpectrum(uint32 columns, Vector<float>& levels) const;
+
+	const Vector<WaveformLevel>& GetLevels() const;
+	// Number of spectrogram columns
+	uint32 GetSpectrumLength() const;
+	double GetDuration() const;
+	size_t GetMemoryUsage() const;
+
+	// Reads or writes the summary, returns false if stored data has a different version
+	bool Serialize(BinaryStream& stream);
+
+private:
+	// Builds the summary from blocks of samples, so a file never has to be decoded all at once
+	class Builder;
+
+	uint32 m_sampleRate = 0;
+	int64 m_numFrames = 0;
+	Vector<WaveformLevel> m_levels;
+	// numBands values per column as 0 to 255 between spectrumFloor and 0 dB
+	Vector<uint8> m_spectrum;
+};
@@ -5,6 +5,9 @@
 // Threading
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <Shared/Thread.hpp>
 using std::thread;
 using std::mutex;
 
@@ -13,8 +16,10 @@ class Audio_Impl : public IMixer
 public:
 	void Start();
 	void Stop();
-	// Get samples
-	virtual void Mix(void* data, uint32& numSamples) override;
+	// Get samples, timestamped with the current time
+	virtual void Mix(void* data, uint32& numSamples, uint32 queuedSamples) override;
+	// Get samples for a callback that happened at <callbackTime> on the AudioClock, used to simulate an output device
+	void Mix(void* data, uint32& numSamples, uint32 queuedSamples, double callbackTime);
 	// Registers an AudioBase to be rendered
 	void Register(AudioBase* audio);
 	// Removes an AudioBase so it is no longer rendered
@@ -22,9 +27,47 @@ public:
 
 	uint32 GetSampleRate() const;
 	double GetSecondsPerSample() const;
+	// Time from a callback until its first sample is heard
+	double GetOutputLatency() const;
+	// Time at which the first sample of the block that is being rendered is heard, on the AudioClock
+	double GetBlockOutputTime() const;
+
+	// Sample rate reported when there is no output device, used to process audio in tests
+	uint32 fallbackSampleRate = 44100;
 
 	float globalVolume = 1.0f;
 
+	// Latency used instead of the device buffer length when it is set, for a measured value
+	double measuredLatency = 0.0;
+	// Latency of the device buffer, read from the output when it starts and changed by Audio::Update
+	std::atomic<double> bufferLatency{ 0.0 };
+	double m_blockOutputTime = 0.0;
+
+	// Device buffer size in samples to start with, 0 for the default of the output
+	uint32 bufferSize = 0;
+	// Grows the device buffer after underruns and shrinks it back to the starting size once playback is stable
+	bool adaptiveBuffer = false;
+	uint32 maxBufferSize = 8192;
+	// Seconds of audio without underruns before the adaptive mode halves the buffer again
+	double stableDuration = 10.0;
+	// Buffer size the output uses and the one the adaptive mode wants, Audio::Update applies it to the output
+	std::atomic<uint32> currentBufferSize{ 0 };
+	std::atomic<uint32> targetBufferSize{ 0 };
+
+	// Callbacks that didn't finish before the queued audio ran out and the longest callback in microseconds
+	std::atomic<uint32> underruns{ 0 };
+	std::atomic<uint32> worstCallbackTime{ 0 };
+	// Smallest time in microseconds that was left of the queued audio when a callback finished, reset by reading it through Audio::GetStats
+	std::atomic<int32> minDeadlineSlack{ INT32_MAX };
+
+	// Renders items with their DSP chains on worker threads next to the audio thread, set before Start
+	//	the items are mixed in the same order either way, so the output doesn't change
+	bool parallelRender = false;
+	uint32 renderThreads = 2;
+	// Highest render time of a single item of the last block, in milliseconds
+	std::atomic<float> costliestItem{ 0.0f };
+	uint32 GetNumRenderThreads() const;
+
 	mutex lock;
 	Vector<AudioBase*> itemsToRender;
 	Vector<DSP*> globalDSPs;
@@ -33,9 +76,46 @@ public:
 
 	// Used to limit rendering to a fixed number of samples (512)
 	float* m_sampleBuffer = nullptr;
+	// Buffers the items are rendered into before they are mixed, one per item so they can be rendered in parallel
+	//	grown by Register so mixing doesn't allocate
+	Vector<float> m_itemBuffers;
 	uint32 m_sampleBufferLength = 384;
 	uint32 m_remainingSamples = 0;
 
+private:
+	void m_UpdateBufferSize(uint32 numSamples, uint32 queuedSamples, double duration);
+	// Makes room in the item buffers for <numItems>, called with the lock held
+	void m_ReserveItemBuffers(uint32 numItems);
+	float* m_GetItemBuffer(uint32 index);
+	// Renders an item and its DSPs into its buffer
+	void m_RenderItem(uint32 index);
+	// Renders items of the current block until all of them are claimed, on the audio thread and the workers
+	void m_RenderClaimed();
+	void m_RenderWorker();
+	void m_StartRenderThreads();
+	void m_StopRenderThreads();
+
+	// Profiler event buffer of the audio thread, created in Start
+	struct ProfilerThreadBuffer* m_profilerThread = nullptr;
+
+	Vector<Thread> m_renderThreads;
+	std::atomic<bool> m_runRenderThreads{ false };
+	// Number of items of the current block in the upper 32 bits, the next item to claim in the lower 32 bits
+	//	claiming is a single fetch_add, so a worker that is late for a block can't claim an item of the next one
+	std::atomic<uint64> m_renderClaim{ 0 };
+	std::atomic<uint32> m_renderDone{ 0 };
+	// Incremented for every block, workers sleep until it changes
+	std::atomic<uint32> m_renderGeneration{ 0 };
+	std::atomic<uint32> m_sleepingWorkers{ 0 };
+	std::mutex m_renderWakeLock;
+	std::condition_variable m_renderWake;
+
+	uint32 m_minBufferSize = 0;
+	double m_stableTime = 0.0;
+	// Longest callback since the buffer size last changed, in seconds
+	double m_recentWorstCallback = 0.0;
+
+public:
 	thread audioThread;
 	bool runAudioThread = false;
 	AudioOutput* output = nullptr;
@@ -19,16 +19,21 @@ public:
 class BQFDSP : public DSP
 {
 public:
-	float b0 = 1.0f;
-	float b1 = 0.0f;
-	float b2 = 0.0f;
-	float a0 = 1.0f;
-	float a1 = 0.0f;
-	float a2 = 0.0f;
+	// Filter coefficients, divided by a0
+	struct Coefficients
+	{
+		float b0 = 1.0f;
+		float b1 = 0.0f;
+		float b2 = 0.0f;
+		float a1 = 0.0f;
+		float a2 = 0.0f;
+	};
 
 	virtual void Process(float* out, uint32 numSamples);
 
 	// Sets the filter parameters
+	//	these can be called from the game thread while the filter is running,
+	//	the filter picks up the latest coefficients at the start of a block and interpolates to them over that block
 	void SetPeaking(float q, float freq, float gain);
 	void SetLowPass(float q, float freq);
 	void SetHighPass(float q, float freq);
@@ -36,13 +41,32 @@ public:
 	void SetPeaking(float q, float freq, float gain, float sampleRate);
 	void SetLowPass(float q, float freq, float sampleRate);
 	void SetHighPass(float q, float freq, float sampleRate);
+
+	static Coefficients CalculatePeaking(float q, float freq, float gain, float sampleRate);
+	static Coefficients CalculateLowPass(float q, float freq, float sampleRate);
+	static Coefficients CalculateHighPass(float q, float freq, float sampleRate);
+
+protected:
+	virtual void Reset() override;
+	// Runs one stereo frame through the filter, only for use on the audio thread
+	void m_FilterFrame(float* frame, const Coefficients& coefficients);
+	// Drops coefficients published by the setters, for subclasses that calculate their own
+	void m_DiscardPending();
+
 private:
+	void m_Publish(const Coefficients& coefficients);
+
+	// Coefficients published by the setters
+	DSPSnapshot<Coefficients> m_pending;
+	// Coefficients at the end of the last processed block
+	Coefficients m_coefficients;
+
 	// Delayed samples
 	static const uint32 order = 2;
 	// FIR Delay buffers
-	float zb[2][order];
+	float zb[2][order] = { { 0.0f } };
 	// IIR Delay buffers
-	float za[2][order];
+	float za[2][order] = { { 0.0f } };
 };
 
 // Combinded Low/High-pass and Peaking filter
@@ -52,10 +76,13 @@ public:
 	void SetLowPass(float q, float freq, float peakQ, float peakGain);
 	void SetHighPass(float q, float freq, float peakQ, float peakGain);
 
+	virtual void Prepare(uint32 numSamples) override;
 	virtual void Process(float* out, uint32 numSamples);
 private:
 	BQFDSP a;
 	BQFDSP peak;
+	// Unfiltered copy of the block for the mix
+	Vector<float> m_dry;
 };
 
 // Basic limiter
@@ -75,8 +102,11 @@ public:
 	// Duration of samples, <1 = disable
 	void SetPeriod(float period = 0);
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
-	uint32 m_period = 1;
+	// Set from the game thread
+	std::atomic<uint32> m_period{ 1 };
 	uint32 m_increment = 0;
 	float m_sampleBuffer[2] = { 0.0f };
 	uint32 m_currentDuration = 0;
@@ -93,7 +123,16 @@ public:
 	float low = 0.1f;
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
+	// Applies a changed length or gating at the start of a block
+	void m_UpdateLength();
+
+	// Set from the game thread
+	std::atomic<uint32> m_targetLength{ 0 };
+	std::atomic<float> m_targetGating{ 0.5f };
+
 	float m_gating = 0.5f;
 	uint32 m_length = 0;
 	uint32 m_fadeIn = 0; // Fade In mark
@@ -105,12 +144,18 @@ private:
 class TapeStopDSP : public DSP
 {
 public:
+	// Allocates the sample buffer for stops of up to <length> milliseconds
+	void SetMaxLength(double length);
 	void SetLength(double length);
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
 	uint32 m_length = 0;
+	// Stores the samples played since the stop started, fixed size so processing doesn't allocate
 	Vector<float> m_sampleBuffer;
+	uint32 m_numStored = 0;
 	float m_sampleIdx = 0.0f;
 	uint32 m_lastSample = 0;
 	uint32 m_currentSample = 0;
@@ -125,7 +170,16 @@ public:
 	void SetMaxLength(uint32 length);
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
+	// Applies a changed length or gating at the start of a block
+	void m_UpdateLength();
+
+	// Set from the game thread
+	std::atomic<uint32> m_targetLength{ 0 };
+	std::atomic<float> m_targetGating{ 0.75f };
+
 	float m_gating = 0.75f;
 	uint32 m_length = 0;
 	uint32 m_gateLength = 0;
@@ -147,6 +201,8 @@ public:
 	float q = 1.414f;
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
 	uint32 m_length;
 	uint32 m_currentSample = 0;
@@ -167,6 +223,8 @@ public:
 	void SetLength(double length);
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 
 private:
 	uint32 m_length = 0;
@@ -187,9 +245,12 @@ class FlangerDSP : public DSP
 {
 public:
 	void SetLength(double length);
+	// Only allocates when the range is larger than any range set before
 	void SetDelayRange(uint32 min, uint32 max);
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
 	uint32 m_length = 0;
 
@@ -206,11 +267,16 @@ private:
 class EchoDSP : public DSP
 {
 public:
+	// Allocates the delay buffer for delays of up to <length> milliseconds
+	void SetMaxLength(double length);
+	// Only allocates when the delay is longer than the buffer
 	void SetLength(double length);
 
-	float feedback = 0.6f;
+	DSPParameter feedback{ 0.6f };
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
 	uint32 m_bufferLength = 0;
 	size_t m_bufferOffset = 0;
@@ -231,6 +297,8 @@ public:
 	Interpolation::CubicBezier curve;
 
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
 	uint32 m_length = 0;
 	size_t m_time = 0;
@@ -240,12 +308,15 @@ class PitchShiftDSP : public DSP
 {
 public:
 	// Pitch change amount
-	float amount = 0.0f;
+	DSPParameter amount{ 0.0f };
 
 	PitchShiftDSP();
 	~PitchShiftDSP();
 
+	virtual void Prepare(uint32 numSamples) override;
 	virtual void Process(float* out, uint32 numSamples);
+protected:
+	virtual void Reset() override;
 private:
 	class PitchShiftDSP_Impl* m_impl;
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+	Measures the integrated loudness (EBU R128, ITU-R BS.1770) and the true peak of stereo audio
+	The library scan uses this so charts can be played back at a similar loudness without relying on the limiter
+*/
+class LoudnessMeter
+{
+public:
+	// Loudness reported for audio that is silent or below the absolute gate
+	static const double silence;
+
+	LoudnessMeter(uint32 sampleRate);
+
+	// Adds interleaved stereo samples
+	void Process(const float* samples, uint32 numFrames);
+
+	// Gated integrated loudness in LUFS over everything added so far
+	double GetIntegratedLoudness() const;
+	// Highest peak of the 4x oversampled signal in dBTP
+	double GetTruePeak() const;
+
+	// Decodes a whole audio file and measures it, returns false if the file can't be decoded
+	//	can be called from any thread
+	static bool Measure(class Audio* audio, const String& path, float& loudness, float& truePeak);
+
+private:
+	struct Biquad
+	{
+		double b0, b1, b2, a1, a2;
+		double z1[2] = { 0.0 };
+		double z2[2] = { 0.0 };
+		double Process(double in, uint32 channel);
+	};
+
+	// Ends the current 100ms step of the 400ms gating blocks
+	void m_EndStep();
+
+	// K-weighting, a high shelf followed by a high pass
+	Biquad m_shelf;
+	Biquad m_highPass;
+
+	// Mean square energy of every gating block, 4 steps long overlapping by 3 steps
+	Vector<double> m_blocks;
+	double m_steps[4] = { 0.0 };
+	uint32 m_numSteps = 0;
+	double m_stepEnergy = 0.0;
+	uint32 m_stepFrames = 0;
+	uint32 m_framesPerStep;
+
+	// Previous samples of both channels for the oversampling filter, stored twice in a ring
+	float m_history[2][24] = { { 0.0f } };
+	uint32 m_historyPosition = 0;
+	float m_peak = 0.0f;
+};
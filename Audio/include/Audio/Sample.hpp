@@ -2,16 +2,27 @@
 #include "AudioBase.hpp"
 
 /*
-	Audio sample, only supports wav files in signed 16 bit stereo or mono
+	Audio sample, loads wav files in 8, 16, 24 or 32 bit PCM, float or MS-ADPCM with one or two channels
+	The whole file is decoded once when loading to stereo float at the output sample rate, so playing it is only a copy
+	Big float files that already have that format are played straight from the memory mapped file instead
 */
 class SampleRes : public AudioBase
 {
 public:
 	static Ref<SampleRes> Create(class Audio* audio, const String& path);
+	// Create a sample from the contents of a wav file in memory, name is only used for logging
+	static Ref<SampleRes> Create(class Audio* audio, const uint8* data, size_t size, const String& name = "<memory>");
 	virtual ~SampleRes() = default;
 
 public:
-	virtual const Buffer& GetData() const = 0;
+	// Decoded samples, interleaved stereo at the output sample rate
+	virtual const float* GetSamples() const = 0;
+	// Number of decoded frames
+	virtual uint64 GetLength() const = 0;
+	// Time it took to load and decode the sample in milliseconds
+	virtual double GetLoadTime() const = 0;
+	virtual bool IsMapped() const = 0;
+	// Format of the file the sample was loaded from
 	virtual uint32 GetBitsPerSample() const = 0;
 	virtual uint32 GetNumChannels() const = 0;
 
@@ -20,4 +31,4 @@ public:
 	virtual void Stop() = 0;
 };
 
-typedef Ref<SampleRes> Sample;
\ No newline at end of file
+typedef Ref<SampleRes> Sample;
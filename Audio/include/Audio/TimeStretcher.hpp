@@ -0,0 +1,103 @@
+#pragma once
+#include <Shared/Thread.hpp>
+#include <atomic>
+
+namespace soundtouch
+{
+	class SoundTouch;
+}
+
+/*
+	Plays preloaded PCM at a different tempo without changing the pitch, used for practice mode
+	A worker thread runs SoundTouch ahead of the audio thread and queues the result in fixed size chunks, so the audio thread only copies samples
+	Seeking and looping restart from the preloaded PCM, nothing has to be decoded again
+*/
+class TimeStretcher : Unique
+{
+public:
+	// Frames per queued chunk and the number of chunks the worker keeps ready
+	static const uint32 chunkFrames = 512;
+	static const uint32 numChunks = 32;
+
+	// A chunk of stretched audio as it is handed to the audio thread
+	struct ReadInfo
+	{
+		uint32 numFrames = 0;
+		// Position in the source PCM of the first frame and the one after the last frame
+		double sourceStart = 0.0;
+		double sourceEnd = 0.0;
+		// Number of times the loop jumped back before this chunk
+		uint32 loopCount = 0;
+		// Set on the last chunk of the source
+		bool end = false;
+	};
+
+	// <pcm> is interleaved stereo and has to stay valid while this exists
+	TimeStretcher(const float* pcm, int64 numFrames, uint32 sampleRate);
+	~TimeStretcher();
+
+	// Runs the worker thread
+	void Start();
+	void Stop();
+
+	// These can be called from any thread
+	void SetTempo(float tempo);
+	float GetTempo() const;
+	// Jumps back to <start> when <end> is reached, an end at or before the start disables the loop
+	void SetLoop(int64 start, int64 end);
+	// Restarts at <frame>, chunks rendered before this are dropped
+	void Seek(int64 frame);
+
+	// Audio thread, copies the next chunk into <left> and <right> which must have room for chunkFrames
+	//	returns false when the worker hasn't rendered it yet
+	bool Read(float* left, float* right, ReadInfo& info);
+
+	// Renders the next chunk on the calling thread, returns false when the queue is full or the source ended
+	//	used by the worker, and by tests without starting it
+	bool Render();
+
+	// Time spent rendering divided by the duration of the rendered audio
+	float GetLoad() const;
+
+private:
+	struct Chunk
+	{
+		float samples[chunkFrames * 2];
+		ReadInfo info;
+		uint32 seekIndex;
+	};
+
+	void m_Worker();
+	// Feeds the next block of the source to SoundTouch, wrapping around the loop
+	void m_FeedInput();
+
+	const float* m_pcm;
+	int64 m_numFrames;
+	uint32 m_sampleRate;
+	soundtouch::SoundTouch* m_soundtouch;
+
+	Chunk* m_chunks;
+	// Chunks written by the worker and read by the audio thread, counted up forever
+	std::atomic<uint32> m_writeCount{ 0 };
+	std::atomic<uint32> m_readCount{ 0 };
+
+	std::atomic<float> m_tempo{ 1.0f };
+	std::atomic<int64> m_loopStart{ 0 };
+	std::atomic<int64> m_loopEnd{ 0 };
+	std::atomic<int64> m_seekFrame{ 0 };
+	// Incremented by every seek, chunks from before it are dropped
+	std::atomic<uint32> m_seekIndex{ 0 };
+	std::atomic<float> m_load{ 0.0f };
+
+	// Worker state
+	uint32 m_workerSeekIndex = 0;
+	int64 m_inputPosition = 0;
+	double m_outputPosition = 0.0;
+	uint32 m_loopCount = 0;
+	bool m_inputEnded = false;
+	bool m_ended = false;
+	float m_tempoApplied = 1.0f;
+
+	Thread m_thread;
+	std::atomic<bool> m_running{ false };
+};
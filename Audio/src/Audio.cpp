@@ -4,25 +4,38 @@
 #include "Audio_Impl.hpp"
 #include "AudioOutput.hpp"
 #include "DSP.hpp"
+#include "AudioClock.hpp"
+#include <Shared/Profiling.hpp>
 
 Audio* g_audio = nullptr;
 Audio_Impl impl;
 
-void Audio_Impl::Mix(void* data, uint32& numSamples)
-{
 #if _DEBUG
-	static const uint32 guardBand = 1024;
+static const uint32 guardBand = 1024;
 #else
-	static const uint32 guardBand = 0;
+static const uint32 guardBand = 0;
 #endif
 
-	// Per-Channel data buffer
-	float* tempData = new float[m_sampleBufferLength * 2 + guardBand];
-	uint32* guardBuffer = (uint32*)tempData + 2 * m_sampleBufferLength;
+// Largest device buffer in samples, SDL stores it in 16 bits
+static const uint32 maxOutputBufferSize = 65535;
+
+void Audio_Impl::Mix(void* data, uint32& numSamples, uint32 queuedSamples)
+{
+	Mix(data, numSamples, queuedSamples, AudioClock::Now());
+}
+void Audio_Impl::Mix(void* data, uint32& numSamples, uint32 queuedSamples, double callbackTime)
+{
+	ProfileAttachThread(m_profilerThread);
+	ProfileScope("Audio::Mix");
+	double mixStart = AudioClock::Now();
+
 	double adv = GetSecondsPerSample();
+	double latency = GetOutputLatency();
 
-	uint32 outputChannels = this->output->GetNumChannels();
-	if (output->IsIntegerFormat())
+	// Without an output the samples are stereo floats
+	uint32 outputChannels = output ? output->GetNumChannels() : 2;
+	bool integerFormat = output && output->IsIntegerFormat();
+	if (integerFormat)
 	{
 		memset(data, 0, numSamples * sizeof(int16) * outputChannels);
 	}
@@ -39,42 +52,57 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 		{
 			// Clear sample buffer storing a fixed amount of samples
 			memset(m_sampleBuffer, 0, sizeof(float) * 2 * m_sampleBufferLength);
+			m_blockOutputTime = callbackTime + latency + (double)currentNumberOfSamples * adv;
 
 			// Render items
 			lock.lock();
-			for(auto& item : itemsToRender)
+			uint32 numItems = (uint32)itemsToRender.size();
+			if(!m_renderThreads.empty() && numItems > 1)
 			{
-				// Clearn per-channel data (and guard buffer in debug mode)
-				memset(tempData, 0, sizeof(float) * (2 * m_sampleBufferLength + guardBand));
-				item->Process(tempData, m_sampleBufferLength);
-#if _DEBUG
-				// Check for memory corruption
-				for(uint32 i = 0; i < guardBand; i++)
-				{
-					assert(guardBuffer[i] == 0);
-				}
-#endif
-				item->ProcessDSPs(tempData, m_sampleBufferLength);
-#if _DEBUG
-				// Check for memory corruption
-				for(uint32 i = 0; i < guardBand; i++)
+				// Hand out the items, this thread renders as well and then waits for the items the workers took
+				m_renderDone.store(0, std::memory_order_relaxed);
+				m_renderClaim.store((uint64)numItems << 32, std::memory_order_release);
+				m_renderGeneration++;
+				if(m_sleepingWorkers > 0)
 				{
-					assert(guardBuffer[i] == 0);
+					// A worker checks the generation under the lock before it waits, taking the lock here makes sure it either saw the new one or is waiting already
+					//	only needed after the workers fell asleep, blocks of one callback find them spinning
+					m_renderWakeLock.lock();
+					m_renderWakeLock.unlock();
+					m_renderWake.notify_all();
 				}
-#endif
+				m_RenderClaimed();
+				while(m_renderDone.load(std::memory_order_acquire) < numItems)
+					std::this_thread::yield();
+			}
+			else
+			{
+				for(uint32 i = 0; i < numItems; i++)
+					m_RenderItem(i);
+			}
 
-				// Mix into buffer and apply volume scaling
+			// Mix into buffer and apply volume scaling, in a fixed order so the result doesn't depend on the threads
+			float costliest = 0.0f;
+			for(uint32 j = 0; j < numItems; j++)
+			{
+				AudioBase* item = itemsToRender[j];
+				const float* itemData = m_GetItemBuffer(j);
+				float volume = item->GetVolume();
 				for(uint32 i = 0; i < m_sampleBufferLength; i++)
 				{
-					m_sampleBuffer[i * 2 + 0] += tempData[i * 2] * item->GetVolume();
-					m_sampleBuffer[i * 2 + 1] += tempData[i * 2 + 1] * item->GetVolume();
+					m_sampleBuffer[i * 2 + 0] += itemData[i * 2] * volume;
+					m_sampleBuffer[i * 2 + 1] += itemData[i * 2 + 1] * volume;
 				}
+				costliest = Math::Max(costliest, (float)item->renderTime);
 			}
+			costliestItem = costliest;
 
 			// Process global DSPs
+			ProfileScope("Audio::Mix Global DSPs");
 			for(auto dsp : globalDSPs)
 			{
-				dsp->Process(m_sampleBuffer, m_sampleBufferLength);
+				if(dsp->BeginBlock(m_sampleBufferLength))
+					dsp->Process(m_sampleBuffer, m_sampleBufferLength);
 			}
 			lock.unlock();
 
@@ -98,7 +126,7 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 			{
 				for(uint32 i = 0; i < maxSamples; i++)
 				{
-					if (output->IsIntegerFormat())
+					if (integerFormat)
 					{
 						((int16*)data)[(currentNumberOfSamples + i) * outputChannels + c] = (int16)(0x7FFF * Math::Clamp(m_sampleBuffer[(sampleOffset + i) * 2 + c],-1.f,1.f));
 					}
@@ -114,31 +142,207 @@ void Audio_Impl::Mix(void* data, uint32& numSamples)
 		currentNumberOfSamples += maxSamples;
 	}
 
-	delete[] tempData;
+	m_UpdateBufferSize(numSamples, queuedSamples, AudioClock::Now() - mixStart);
+}
+float* Audio_Impl::m_GetItemBuffer(uint32 index)
+{
+	return m_itemBuffers.data() + (size_t)index * (2 * m_sampleBufferLength + guardBand);
+}
+void Audio_Impl::m_ReserveItemBuffers(uint32 numItems)
+{
+	size_t size = (size_t)numItems * (2 * m_sampleBufferLength + guardBand);
+	if(m_itemBuffers.size() < size)
+		m_itemBuffers.resize(size);
+}
+void Audio_Impl::m_RenderItem(uint32 index)
+{
+	ProfileScope("Audio::Mix Item");
+	double start = AudioClock::Now();
+	AudioBase* item = itemsToRender[index];
+	float* itemData = m_GetItemBuffer(index);
+#if _DEBUG
+	uint32* guardBuffer = (uint32*)itemData + 2 * m_sampleBufferLength;
+#endif
+
+	// Clear per-channel data (and guard buffer in debug mode)
+	memset(itemData, 0, sizeof(float) * (2 * m_sampleBufferLength + guardBand));
+	item->Process(itemData, m_sampleBufferLength);
+#if _DEBUG
+	// Check for memory corruption
+	for(uint32 i = 0; i < guardBand; i++)
+	{
+		assert(guardBuffer[i] == 0);
+	}
+#endif
+	item->ProcessDSPs(itemData, m_sampleBufferLength);
+#if _DEBUG
+	// Check for memory corruption
+	for(uint32 i = 0; i < guardBand; i++)
+	{
+		assert(guardBuffer[i] == 0);
+	}
+#endif
+
+	// Smoothed over about 16 blocks
+	float time = (float)((AudioClock::Now() - start) * 1000.0);
+	float smoothed = item->renderTime;
+	item->renderTime = smoothed + (time - smoothed) * 0.0625f;
+}
+void Audio_Impl::m_RenderClaimed()
+{
+	while(true)
+	{
+		uint64 claim = m_renderClaim.fetch_add(1, std::memory_order_acquire);
+		uint32 index = (uint32)claim;
+		if(index >= (uint32)(claim >> 32))
+			return;
+		m_RenderItem(index);
+		m_renderDone.fetch_add(1, std::memory_order_release);
+	}
+}
+void Audio_Impl::m_RenderWorker()
+{
+	ProfileThreadName("Audio Render");
+	if(!Thread::SetCurrentThreadRealtimePriority())
+		Logf("Couldn't raise the priority of an audio render thread", Logger::Warning);
+
+	uint32 generation = m_renderGeneration;
+	while(m_runRenderThreads)
+	{
+		// Blocks of one callback come right after each other, spin a bit before sleeping until the next callback
+		for(uint32 i = 0; i < 64 && m_renderGeneration == generation; i++)
+			std::this_thread::yield();
+		if(m_renderGeneration == generation)
+		{
+			// Counted before checking the generation, so the audio thread either sees this worker sleeping or the worker sees the new generation
+			std::unique_lock<std::mutex> wakeLock(m_renderWakeLock);
+			m_sleepingWorkers++;
+			m_renderWake.wait(wakeLock, [&]() { return m_renderGeneration != generation || !m_runRenderThreads; });
+			m_sleepingWorkers--;
+		}
+		if(m_renderGeneration == generation)
+			continue;
+		generation = m_renderGeneration;
+		m_RenderClaimed();
+	}
+}
+uint32 Audio_Impl::GetNumRenderThreads() const
+{
+	return (uint32)m_renderThreads.size();
+}
+void Audio_Impl::m_StartRenderThreads()
+{
+	uint32 numThreads = renderThreads;
+	// The audio thread renders as well, and the game thread needs a core of its own
+	if(numThreads + 2 > std::thread::hardware_concurrency())
+		Logf("%d audio render threads are more than this CPU has free cores for", Logger::Warning, numThreads);
+	m_runRenderThreads = true;
+	for(uint32 i = 0; i < numThreads; i++)
+		m_renderThreads.emplace_back(&Audio_Impl::m_RenderWorker, this);
+	Logf("Rendering audio on %d worker threads", Logger::Info, numThreads);
+}
+void Audio_Impl::m_StopRenderThreads()
+{
+	{
+		std::lock_guard<std::mutex> wakeLock(m_renderWakeLock);
+		m_runRenderThreads = false;
+	}
+	m_renderWake.notify_all();
+	for(auto& thread : m_renderThreads)
+		thread.join();
+	m_renderThreads.clear();
+}
+void Audio_Impl::m_UpdateBufferSize(uint32 numSamples, uint32 queuedSamples, double duration)
+{
+	uint32 durationMicroseconds = (uint32)(duration * 1000000.0);
+	if(durationMicroseconds > worstCallbackTime)
+		worstCallbackTime = durationMicroseconds;
+	int32 slackMicroseconds = (int32)(((double)queuedSamples * GetSecondsPerSample() - duration) * 1000000.0);
+	if(slackMicroseconds < minDeadlineSlack)
+		minDeadlineSlack = slackMicroseconds;
+	m_recentWorstCallback = Math::Max(m_recentWorstCallback, duration);
+
+	double queuedTime = (double)queuedSamples * GetSecondsPerSample();
+	uint32 current = currentBufferSize;
+	uint32 target = targetBufferSize;
+	if(duration > queuedTime)
+	{
+		underruns++;
+		m_stableTime = 0.0;
+		// Double the buffer, unless a change is still being applied
+		if(adaptiveBuffer && current == target && current < maxBufferSize)
+		{
+			targetBufferSize = Math::Min(current * 2, maxBufferSize);
+			m_recentWorstCallback = 0.0;
+		}
+		return;
+	}
+
+	m_stableTime += (double)numSamples * GetSecondsPerSample();
+	if(adaptiveBuffer && current == target && current > m_minBufferSize && m_stableTime > stableDuration)
+	{
+		// Only shrink when the slowest callback would still fit comfortably in half the buffer
+		double halfBufferTime = (double)(current / 2) * GetSecondsPerSample();
+		if(m_recentWorstCallback < halfBufferTime * 0.5)
+			targetBufferSize = Math::Max(current / 2, m_minBufferSize);
+		m_stableTime = 0.0;
+		m_recentWorstCallback = 0.0;
+	}
 }
 void Audio_Impl::Start()
 {
+#ifdef PROFILER_ENABLED
+	// The audio thread only attaches to this, so it never allocates its event buffer itself
+	if(!m_profilerThread)
+		m_profilerThread = Profiler::ReserveThread("Audio");
+#endif
 	m_sampleBuffer = new float[2 * m_sampleBufferLength];
+	lock.lock();
+	m_itemBuffers.clear();
+	m_ReserveItemBuffers(Math::Max((uint32)itemsToRender.size(), 16u));
+	lock.unlock();
+	if(parallelRender)
+		m_StartRenderThreads();
 
 	limiter = new LimiterDSP();
 	limiter->audio = this;
 	limiter->releaseTime = 0.2f;
 	globalDSPs.Add(limiter);
-	output->Start(this);
+	if(output)
+	{
+		bufferLatency = output->GetBufferLength();
+		currentBufferSize = (uint32)(bufferLatency * (double)GetSampleRate() + 0.5);
+	}
+	else
+	{
+		currentBufferSize = bufferSize;
+	}
+	targetBufferSize = (uint32)currentBufferSize;
+	m_minBufferSize = currentBufferSize;
+	maxBufferSize = Math::Max(maxBufferSize, m_minBufferSize);
+	m_stableTime = 0.0;
+	m_recentWorstCallback = 0.0;
+	if(output)
+		output->Start(this);
 }
 void Audio_Impl::Stop()
 {
-	output->Stop();
+	if(output)
+		output->Stop();
+	m_StopRenderThreads();
 	delete limiter;
 	globalDSPs.Remove(limiter);
 
 	delete[] m_sampleBuffer;
 	m_sampleBuffer = nullptr;
+	m_itemBuffers.clear();
+	m_itemBuffers.shrink_to_fit();
 }
 void Audio_Impl::Register(AudioBase* audio)
 {
 	lock.lock();
 	itemsToRender.AddUnique(audio);
+	m_ReserveItemBuffers((uint32)itemsToRender.size());
 	audio->audio = this;
 	lock.unlock();
 }
@@ -151,12 +355,22 @@ void Audio_Impl::Deregister(AudioBase* audio)
 }
 uint32 Audio_Impl::GetSampleRate() const
 {
+	if(!output)
+		return fallbackSampleRate;
 	return output->GetSampleRate();
 }
 double Audio_Impl::GetSecondsPerSample() const
 {
 	return 1.0 / (double)GetSampleRate();
 }
+double Audio_Impl::GetOutputLatency() const
+{
+	return measuredLatency > 0.0 ? measuredLatency : bufferLatency.load();
+}
+double Audio_Impl::GetBlockOutputTime() const
+{
+	return m_blockOutputTime;
+}
 
 Audio::Audio()
 {
@@ -176,12 +390,20 @@ Audio::~Audio()
 	assert(g_audio == this);
 	g_audio = nullptr;
 }
-bool Audio::Init(bool exclusive)
+bool Audio::Init(bool exclusive, const AudioBufferSettings& bufferSettings)
 {
 	audioLatency = 0;
 
+	const uint32 bufferSize = Math::Min(bufferSettings.bufferSize, maxOutputBufferSize);
+	impl.bufferSize = bufferSize;
+	impl.maxBufferSize = Math::Min(impl.maxBufferSize, maxOutputBufferSize);
+	impl.adaptiveBuffer = bufferSettings.adaptive;
+	impl.m_sampleBufferLength = Math::Clamp(bufferSettings.blockSize, 32u, 4096u);
+	impl.parallelRender = bufferSettings.parallelRender;
+	impl.renderThreads = bufferSettings.renderThreads;
+
 	impl.output = new AudioOutput();
-	if(!impl.output->Init(exclusive))
+	if(!impl.output->Init(exclusive, bufferSize))
 	{
 		delete impl.output;
 		impl.output = nullptr;
@@ -189,16 +411,56 @@ bool Audio::Init(bool exclusive)
 	}
 
 	impl.Start();
+	audioLatency = (int64)(impl.GetOutputLatency() * 1000.0);
 
 	return m_initialized = true;
 }
+void Audio::Update()
+{
+	if(!m_initialized)
+		return;
+	uint32 target = impl.targetBufferSize;
+	if(target == impl.currentBufferSize)
+		return;
+
+	Logf("Changing audio buffer size from %d to %d samples", Logger::Info, (uint32)impl.currentBufferSize, target);
+	if(!impl.output->SetBufferSize(target))
+	{
+		// Stay on the current size
+		impl.targetBufferSize = (uint32)impl.currentBufferSize;
+		return;
+	}
+	// The device can grant a different size than requested, the target follows it so the same change isn't requested again
+	impl.bufferLatency = impl.output->GetBufferLength();
+	impl.currentBufferSize = (uint32)(impl.bufferLatency * (double)impl.GetSampleRate() + 0.5);
+	impl.targetBufferSize = (uint32)impl.currentBufferSize;
+	if(impl.currentBufferSize != target)
+		Logf("Audio device uses a buffer of %d samples instead", Logger::Info, (uint32)impl.currentBufferSize);
+	audioLatency = (int64)(impl.GetOutputLatency() * 1000.0);
+}
 void Audio::SetGlobalVolume(float vol)
 {
 	impl.globalVolume = vol;
 }
 uint32 Audio::GetSampleRate() const
 {
-	return impl.output->GetSampleRate();
+	return impl.GetSampleRate();
+}
+AudioStats Audio::GetStats() const
+{
+	AudioStats stats;
+	stats.bufferSize = impl.currentBufferSize;
+	stats.blockSize = impl.m_sampleBufferLength;
+	stats.underruns = impl.underruns;
+	stats.worstCallbackTime = (float)impl.worstCallbackTime / 1000.0f;
+	int32 slack = impl.minDeadlineSlack.exchange(INT32_MAX);
+	stats.deadlineSlack = slack == INT32_MAX ? 0.0f : (float)slack / 1000.0f;
+	stats.renderThreads = impl.GetNumRenderThreads();
+	stats.costliestVoice = impl.costliestItem;
+	impl.lock.lock();
+	stats.voices = (uint32)impl.itemsToRender.size();
+	impl.lock.unlock();
+	return stats;
 }
 class Audio_Impl* Audio::GetImpl()
 {
@@ -8,6 +8,52 @@ DSP::~DSP()
 	// Make sure this is removed from parent
 	assert(!audioBase);
 }
+void DSP::Enable()
+{
+	m_SetCommand(true);
+}
+void DSP::Bypass()
+{
+	m_SetCommand(false);
+}
+void DSP::m_SetCommand(bool enabled)
+{
+	uint32 command = ((m_command.load(std::memory_order_relaxed) | 1) + 1) | (enabled ? 1 : 0);
+	if(!audioBase)
+	{
+		m_applied = command;
+		m_acknowledged.store(command, std::memory_order_relaxed);
+	}
+	m_command.store(command, std::memory_order_release);
+}
+bool DSP::IsEnabled() const
+{
+	return (m_command.load(std::memory_order_relaxed) & 1) != 0;
+}
+bool DSP::IsIdle() const
+{
+	uint32 command = m_command.load(std::memory_order_relaxed);
+	return (command & 1) == 0 && m_acknowledged.load(std::memory_order_acquire) == command;
+}
+bool DSP::BeginBlock(uint32 numSamples)
+{
+	uint32 command = m_command.load(std::memory_order_acquire);
+	if(command != m_applied)
+	{
+		m_applied = command;
+		if(command & 1)
+		{
+			Reset();
+			mix.Reset();
+		}
+		m_acknowledged.store(command, std::memory_order_release);
+	}
+	if((m_applied & 1) == 0)
+		return false;
+
+	mix.BeginBlock(numSamples);
+	return true;
+}
 
 AudioBase::~AudioBase()
 {
@@ -19,11 +65,16 @@ void AudioBase::ProcessDSPs(float*& out, uint32 numSamples)
 {
 	for(DSP* dsp : DSPs)
 	{
-		dsp->Process(out, numSamples);
+		if(dsp->BeginBlock(numSamples))
+			dsp->Process(out, numSamples);
 	}
 }
 void AudioBase::AddDSP(DSP* dsp)
 {
+	// Allocate before the audio thread can process it
+	dsp->audio = audio;
+	dsp->Prepare(audio->m_sampleBufferLength);
+
 	audio->lock.lock();
 	DSPs.AddUnique(dsp);
 	// Sort by priority
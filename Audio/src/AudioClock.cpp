@@ -0,0 +1,122 @@
+#include "stdafx.h"
+#include "AudioClock.hpp"
+#include <chrono>
+#include <thread>
+
+double AudioClock::Now()
+{
+	static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+bool AudioClock::m_BeginWrite(bool wait)
+{
+	while(true)
+	{
+		uint32 sequence = m_sequence.load(std::memory_order_relaxed);
+		if((sequence & 1) == 0 && m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire))
+			break;
+		if(!wait)
+			return false;
+		std::this_thread::yield();
+	}
+	// Readers that see any of the following writes also see the odd sequence
+	std::atomic_thread_fence(std::memory_order_release);
+	return true;
+}
+void AudioClock::m_EndWrite()
+{
+	m_sequence.fetch_add(1, std::memory_order_release);
+}
+
+void AudioClock::Reset(double mediaTime)
+{
+	m_BeginWrite(true);
+	m_started.store(false, std::memory_order_relaxed);
+	m_anchorMedia.store(mediaTime, std::memory_order_relaxed);
+	m_rateCorrection.store(0.0, std::memory_order_relaxed);
+	m_lastReturned.store(mediaTime, std::memory_order_relaxed);
+	m_EndWrite();
+}
+bool AudioClock::Observe(double time, double mediaTime, double rate)
+{
+	// Only a reset can be writing at the same time, the observation is dropped instead of waiting for it
+	if(!m_BeginWrite(false))
+		return true;
+
+	// This is the only writer now, so the members can be read without retrying
+	bool ret = true;
+	m_rate.store(rate, std::memory_order_relaxed);
+	m_lastObservation.store(time, std::memory_order_relaxed);
+	if(!m_started.load(std::memory_order_relaxed))
+	{
+		m_started.store(true, std::memory_order_relaxed);
+		m_anchorTime.store(time, std::memory_order_relaxed);
+		m_anchorMedia.store(mediaTime, std::memory_order_relaxed);
+		m_rateCorrection.store(0.0, std::memory_order_relaxed);
+		m_EndWrite();
+		return ret;
+	}
+
+	double anchorTime = m_anchorTime.load(std::memory_order_relaxed);
+	double anchorMedia = m_anchorMedia.load(std::memory_order_relaxed);
+	double rateCorrection = m_rateCorrection.load(std::memory_order_relaxed);
+	double predicted = anchorMedia + (time - anchorTime) * rate * (1.0 + rateCorrection);
+	double error = mediaTime - predicted;
+	m_anchorTime.store(time, std::memory_order_relaxed);
+	if(fabs(error) > resetThreshold)
+	{
+		// Readers hold their last value when this jumps back
+		m_anchorMedia.store(mediaTime, std::memory_order_relaxed);
+		m_rateCorrection.store(0.0, std::memory_order_relaxed);
+		ret = false;
+	}
+	else
+	{
+		m_rateCorrection.store(Math::Clamp(rateCorrection + error * frequencyGain, -maxRateCorrection, maxRateCorrection), std::memory_order_relaxed);
+		m_anchorMedia.store(predicted + error * phaseGain, std::memory_order_relaxed);
+	}
+	m_EndWrite();
+	return ret;
+}
+double AudioClock::GetTime(double time) const
+{
+	while(true)
+	{
+		uint32 sequence = m_sequence.load(std::memory_order_acquire);
+		if(sequence & 1)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		bool started = m_started.load(std::memory_order_relaxed);
+		double anchorTime = m_anchorTime.load(std::memory_order_relaxed);
+		double anchorMedia = m_anchorMedia.load(std::memory_order_relaxed);
+		double rate = m_rate.load(std::memory_order_relaxed);
+		double rateCorrection = m_rateCorrection.load(std::memory_order_relaxed);
+		double lastObservation = m_lastObservation.load(std::memory_order_relaxed);
+		double lastReturned = m_lastReturned.load(std::memory_order_relaxed);
+
+		// Retry if a writer changed anything while reading
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(m_sequence.load(std::memory_order_relaxed) != sequence)
+			continue;
+
+		double ret = anchorMedia;
+		if(started)
+		{
+			double until = Math::Min(time, lastObservation + maxExtrapolation);
+			ret += (until - anchorTime) * rate * (1.0 + rateCorrection);
+		}
+		if(ret <= lastReturned)
+			return lastReturned;
+		// Start over if another reader returned a later time or the clock was reset in the meantime
+		if(m_lastReturned.compare_exchange_strong(lastReturned, ret, std::memory_order_relaxed))
+			return ret;
+	}
+}
+double AudioClock::GetTime() const
+{
+	return GetTime(Now());
+}
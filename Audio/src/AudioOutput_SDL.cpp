@@ -41,6 +41,9 @@ public:
 	SDL_AudioDeviceID m_deviceId = 0;
 	IMixer* m_mixer = nullptr;
 	volatile bool m_running = false;
+	// Requested buffer size in samples, 0 for the default
+	uint32 m_bufferSize = 0;
+	static const uint32 m_defaultBufferSize = 1024;
 
 public:
 	AudioOutput_Impl()
@@ -72,7 +75,7 @@ public:
 		desiredSpec.freq = 44100;
 		desiredSpec.format = AUDIO_F32;
 		desiredSpec.channels = 2;    /* 1 = mono, 2 = stereo */
-		desiredSpec.samples = 1024;  /* Good low-latency value for callback */
+		desiredSpec.samples = (Uint16)(m_bufferSize > 0 ? m_bufferSize : m_defaultBufferSize);
 		desiredSpec.callback = (SDL_AudioCallback)&AudioOutput_Impl::FillBuffer;
 		desiredSpec.userdata = this;
 
@@ -95,19 +98,22 @@ public:
 			return false;
         }
 
+		Logf("Opened audio device with a buffer of %d samples at %d Hz", Logger::Info, m_audioSpec.samples, m_audioSpec.freq);
 		SDL_PauseAudioDevice(m_deviceId, 0);
 		return true;
 	}
-	bool Init()
+	bool Init(uint32 bufferSize)
 	{
+		m_bufferSize = bufferSize;
 		OpenDevice(nullptr);
 		return true;
 	}
 	static void SDLCALL FillBuffer(AudioOutput_Impl* self, float* data, int len)
 	{
 		uint32 bufferSamples = (uint32)(len / (4 * self->m_audioSpec.channels));
+		// The previous buffer is playing while this one is mixed
 		if(self->m_mixer)
-			self->m_mixer->Mix(data, bufferSamples);
+			self->m_mixer->Mix(data, bufferSamples, bufferSamples);
 	}
 };
 
@@ -119,9 +125,22 @@ AudioOutput::~AudioOutput()
 {
 	delete m_impl;
 }
-bool AudioOutput::Init(bool exclusive)
+bool AudioOutput::Init(bool exclusive, uint32 bufferSize)
 {
-	return m_impl->Init();
+	return m_impl->Init(bufferSize);
+}
+bool AudioOutput::SetBufferSize(uint32 bufferSize)
+{
+	uint32 previousSize = m_impl->m_bufferSize;
+	m_impl->m_bufferSize = bufferSize;
+	if(m_impl->OpenDevice(nullptr))
+		return true;
+
+	// The device is closed at this point, go back to the size that worked before
+	Logf("Reopening audio device with the previous buffer size", Logger::Warning);
+	m_impl->m_bufferSize = previousSize;
+	m_impl->OpenDevice(nullptr);
+	return false;
 }
 uint32_t AudioOutput::GetNumChannels() const
 {
@@ -133,7 +152,9 @@ uint32_t AudioOutput::GetSampleRate() const
 }
 double AudioOutput::GetBufferLength() const
 {
-	return 0;
+	if(m_impl->m_audioSpec.freq == 0)
+		return 0;
+	return (double)m_impl->m_audioSpec.samples / (double)m_impl->m_audioSpec.freq;
 }
 void AudioOutput::Start(IMixer* mixer)
 {
@@ -7,7 +7,7 @@ class AudioStreamRes* CreateAudioStream_ogg(class Audio* audio, const String& pa
 class AudioStreamRes* CreateAudioStream_mp3(class Audio* audio, const String& path, bool preload);
 class AudioStreamRes* CreateAudioStream_wav(class Audio* audio, const String& path, bool preload);
 
-Ref<AudioStreamRes> AudioStreamRes::Create(class Audio* audio, const String& path, bool preload)
+static AudioStreamRes* CreateAudioStream(class Audio* audio, const String& path, bool preload)
 {
 	AudioStreamRes* impl = nullptr;
 
@@ -38,9 +38,23 @@ Ref<AudioStreamRes> AudioStreamRes::Create(class Audio* audio, const String& pat
 		pref = (pref + 1) % 2;
 	}
 
+	return impl;
+}
+
+Ref<AudioStreamRes> AudioStreamRes::Create(class Audio* audio, const String& path, bool preload)
+{
+	AudioStreamRes* impl = CreateAudioStream(audio, path, preload);
 	if(!impl)
 		return AudioStream();
 
 	audio->GetImpl()->Register(impl);
 	return AudioStream(impl);
+}
+Ref<AudioStreamRes> AudioStreamRes::CreateDecoder(class Audio* audio, const String& path)
+{
+	// Not registered, so the mixer never sees it
+	AudioStreamRes* impl = CreateAudioStream(audio, path, false);
+	if(!impl)
+		return AudioStream();
+	return AudioStream(impl);
 }
\ No newline at end of file
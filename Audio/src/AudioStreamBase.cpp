@@ -11,6 +11,7 @@ BinaryStream& AudioStreamBase::Reader()
 bool AudioStreamBase::Init(Audio* audio, const String& path, bool preload)
 {
 	m_audio = audio;
+	m_openTimer.Restart();
 
 	if(!m_file.OpenRead(path))
 		return false;
@@ -35,8 +36,6 @@ void AudioStreamBase::InitSampling(uint32 sampleRate)
 	// Calculate the sample step if the rate is not the same as the output rate
 	double sampleStep = (double)sampleRate / (double)m_audio->GetSampleRate();
 	m_sampleStepIncrement = (uint64)(sampleStep * (double)fp_sampleStep);
-	double stepCheck = (double)m_sampleStepIncrement / (double)fp_sampleStep;
-	// TODO: for practice mode: m_sampleStepIncrement *= playback_speed;
 	m_numChannels = 2;
 	m_readBuffer = new float*[m_numChannels];
 	for(uint32 c = 0; c < m_numChannels; c++)
@@ -61,8 +60,6 @@ void AudioStreamBase::Pause()
 {
 	if(!m_paused)
 	{
-		// Store time the stream was paused
-		m_streamTimeOffset = m_streamTimer.SecondsAsDouble();
 		m_paused = true;
 	}
 	else
@@ -83,18 +80,11 @@ double AudioStreamBase::SamplesToSeconds(int64 s) const
 {
 	return (double)s / (double)const_cast<AudioStreamBase*>(this)->GetStreamRate_Internal();
 }
-double AudioStreamBase::GetPositionSeconds(bool allowFreezeSkip /*= true*/) const
+double AudioStreamBase::GetPositionSeconds() const
 {
-	double samplePosTime = SamplesToSeconds(m_samplePos);
-	if(m_paused || m_samplePos < 0)
-		return samplePosTime;
-	else
-	{
-		double ret = m_streamTimeOffset + m_streamTimer.SecondsAsDouble() - m_offsetCorrection;
-		if(allowFreezeSkip && (ret - samplePosTime) > 0.2f) // Prevent time from running of when the application freezes
-			return samplePosTime;
-		return ret;
-	}
+	if(m_paused)
+		return SamplesToSeconds(m_samplePos);
+	return m_clock.GetTime();
 }
 int32 AudioStreamBase::GetPosition() const
 {
@@ -106,9 +96,51 @@ void AudioStreamBase::SetPosition(int32 pos)
 	m_remainingBufferData = 0;
 	m_samplePos = SecondsToSamples((double)pos / 1000.0);
 	SetPosition_Internal((int32)m_samplePos);
+	if(m_stretcher)
+	{
+		m_stretcher->Seek(m_samplePos);
+		m_stretchEnded = false;
+	}
+	m_clock.Reset(SamplesToSeconds(m_samplePos));
 	m_ended = false;
 	m_lock.unlock();
 }
+void AudioStreamBase::PreBuffer()
+{
+	m_lock.lock();
+	if(m_remainingBufferData == 0 && !m_ended)
+	{
+		if(DecodeData_Internal() <= 0)
+			m_ended = true;
+	}
+	if(m_remainingBufferData > 0)
+		m_OnDecoded();
+	m_lock.unlock();
+}
+uint32 AudioStreamBase::DecodeNext(const float*& left, const float*& right)
+{
+	m_lock.lock();
+	// A block decoded when opening the stream comes first
+	uint32 numFrames = m_remainingBufferData;
+	if(numFrames == 0 && !m_ended)
+	{
+		int32 decoded = DecodeData_Internal();
+		if(decoded <= 0)
+			m_ended = true;
+		else
+			numFrames = (uint32)decoded;
+	}
+	if(numFrames > 0)
+	{
+		// Streams that skip samples after a seek leave them at the front of the buffer
+		uint32 offset = m_currentBufferSize - m_remainingBufferData;
+		left = m_readBuffer[0] + offset;
+		right = m_readBuffer[1] + offset;
+		m_remainingBufferData = 0;
+	}
+	m_lock.unlock();
+	return numFrames;
+}
 float* AudioStreamBase::GetPCM()
 {
 	return GetPCM_Internal();
@@ -117,14 +149,22 @@ uint32 AudioStreamBase::GetSampleRate() const
 {
 	return GetSampleRate_Internal();
 }
+int64 AudioStreamBase::GetPCMCount() const
+{
+	return m_preloaded ? m_samplesTotal : 0;
+}
+double AudioStreamBase::GetFirstSampleLatency() const
+{
+	return m_firstSampleLatency;
+}
+void AudioStreamBase::m_OnDecoded()
+{
+	if(m_firstSampleLatency < 0.0)
+		m_firstSampleLatency = m_openTimer.SecondsAsDouble() * 1000.0;
+}
 void AudioStreamBase::RestartTiming()
 {
-	m_streamTimeOffset = SamplesToSeconds(m_samplePos); // Add audio latency to this offset
-	m_samplePos = 0;
-	m_streamTimer.Restart();
-	m_offsetCorrection = 0.0f;
-	m_deltaSum = 0;
-	m_deltaSamples = 0;
+	m_clock.Reset(SamplesToSeconds(m_samplePos));
 }
 void AudioStreamBase::Process(float* out, uint32 numSamples)
 {
@@ -133,6 +173,10 @@ void AudioStreamBase::Process(float* out, uint32 numSamples)
 
 	m_lock.lock();
 
+	// Silence before the start plays at the practice tempo as well
+	float leadInSpeed = PlaybackSpeed * m_tempo;
+	uint32 loopCount = m_loopCount;
+
 	uint32 outCount = 0;
 	while(outCount < numSamples)
 	{
@@ -155,7 +199,7 @@ void AudioStreamBase::Process(float* out, uint32 numSamples)
 				outCount++;
 
 				// Increment source sample with resampling
-				m_sampleStep += m_sampleStepIncrement * PlaybackSpeed;
+				m_sampleStep += m_sampleStepIncrement * (m_samplePos < 0 ? leadInSpeed : PlaybackSpeed);
 				while(m_sampleStep >= fp_sampleStep)
 				{
 					m_sampleStep -= fp_sampleStep;
@@ -171,7 +215,7 @@ void AudioStreamBase::Process(float* out, uint32 numSamples)
 			break;
 
 		// Read more data
-		if(DecodeData_Internal() <= 0)
+		if((m_stretcher ? m_DecodeStretched() : DecodeData_Internal()) <= 0)
 		{
 			// Ended
 			Logf("Audio stream ended", Logger::Info);
@@ -179,10 +223,23 @@ void AudioStreamBase::Process(float* out, uint32 numSamples)
 			m_playing = false;
 			break;
 		}
+		m_OnDecoded();
 	}
 
 	// Store timing info
-	if(m_samplePos > 0)
+	if(m_stretcher)
+	{
+		// Position in the source of the next sample of the current chunk
+		if(m_samplePos >= 0 && m_stretchInfo.numFrames > 0)
+		{
+			double consumed = (double)(m_currentBufferSize - m_remainingBufferData) / (double)m_stretchInfo.numFrames;
+			m_samplePos = (int64)(m_stretchInfo.sourceStart + (m_stretchInfo.sourceEnd - m_stretchInfo.sourceStart) * consumed);
+		}
+		// Time jumps back with the loop
+		if(m_loopCount != loopCount)
+			m_clock.Reset(SamplesToSeconds(m_samplePos));
+	}
+	else if(m_samplePos > 0)
 	{
 		m_samplePos = GetStreamPosition_Internal() - (int64)m_remainingBufferData;
 		if(m_samplePos >= m_samplesTotal)
@@ -194,28 +251,151 @@ void AudioStreamBase::Process(float* out, uint32 numSamples)
 				m_ended = true;
 			}
 		}
+	}
 
-		double timingDelta = GetPositionSeconds(false) - SamplesToSeconds(m_samplePos);
-		m_deltaSum += timingDelta;
-		m_deltaSamples += 1;
+	// The end of this block is heard after the output latency
+	if(audio)
+	{
+		double time = audio->GetBlockOutputTime() + (double)numSamples * audio->GetSecondsPerSample();
+		if(!m_clock.Observe(time, SamplesToSeconds(m_samplePos), PlaybackSpeed * m_tempo))
+			Logf("Timing restart at %f", Logger::Info, SamplesToSeconds(m_samplePos));
+	}
 
-		double avgDelta = m_deltaSum / (double)m_deltaSamples;
-		if(abs(timingDelta - avgDelta) > 0.2)
+	m_lock.unlock();
+}
+
+bool AudioStreamBase::SetTempo(float tempo)
+{
+	m_lock.lock();
+	m_tempo = tempo;
+	m_lock.unlock();
+	return m_UpdateStretcher();
+}
+float AudioStreamBase::GetTempo() const
+{
+	return m_tempo;
+}
+bool AudioStreamBase::SetLoop(int32 start, int32 end)
+{
+	m_lock.lock();
+	if(end > start)
+	{
+		m_loopStart = SecondsToSamples(Math::Max(start, 0) / 1000.0);
+		m_loopEnd = SecondsToSamples(end / 1000.0);
+	}
+	else
+	{
+		m_loopStart = m_loopEnd = 0;
+	}
+	m_lock.unlock();
+	return m_UpdateStretcher();
+}
+uint32 AudioStreamBase::GetLoopCount() const
+{
+	return m_loopCount;
+}
+float AudioStreamBase::GetTimeStretchLoad() const
+{
+	return m_stretcher ? m_stretcher->GetLoad() : 0.0f;
+}
+bool AudioStreamBase::m_UpdateStretcher()
+{
+	m_lock.lock();
+	bool stretch = m_tempo != 1.0f || m_loopEnd > m_loopStart;
+	if(stretch && m_stretcher)
+	{
+		// Only updates atomics of the running stretcher
+		m_stretcher->SetTempo(m_tempo);
+		m_stretcher->SetLoop(m_loopStart, m_loopEnd);
+		m_lock.unlock();
+		return true;
+	}
+	if(!stretch)
+	{
+		// Continue decoding from where the stretcher was
+		TimeStretcher* oldStretcher = m_stretcher;
+		if(oldStretcher)
 		{
-			Logf("Timing restart, delta = %f", Logger::Info, avgDelta);
-			RestartTiming();
+			m_stretcher = nullptr;
+			m_loopCountOffset = m_loopCount;
+			m_remainingBufferData = 0;
+			SetPosition_Internal((int32)Math::Max<int64>(m_samplePos, 0));
 		}
-		else
+		m_lock.unlock();
+		// Joins the worker, so the audio thread must not wait for this
+		delete oldStretcher;
+		return true;
+	}
+
+	float* pcm = GetPCM_Internal();
+	if(!pcm)
+	{
+		m_tempo = 1.0f;
+		m_loopStart = m_loopEnd = 0;
+		m_lock.unlock();
+		Log("Time stretching and looping need a preloaded stream", Logger::Warning);
+		return false;
+	}
+	int64 position = Math::Max<int64>(m_samplePos, 0);
+	m_lock.unlock();
+
+	// Creating the stretcher allocates and starts a thread, the audio thread keeps decoding meanwhile
+	TimeStretcher* stretcher = new TimeStretcher(pcm, m_samplesTotal, GetStreamRate_Internal());
+	stretcher->Seek(position);
+	stretcher->Start();
+
+	m_lock.lock();
+	int64 currentPosition = Math::Max<int64>(m_samplePos, 0);
+	if(currentPosition != position)
+		stretcher->Seek(currentPosition);
+	stretcher->SetTempo(m_tempo);
+	stretcher->SetLoop(m_loopStart, m_loopEnd);
+	std::swap(stretcher, m_stretcher);
+	m_stretchInfo = TimeStretcher::ReadInfo();
+	m_stretchEnded = false;
+	m_remainingBufferData = 0;
+	m_loopCountOffset = m_loopCount;
+	m_lock.unlock();
+
+	delete stretcher;
+	return true;
+}
+void AudioStreamBase::m_DestroyStretcher()
+{
+	m_lock.lock();
+	TimeStretcher* stretcher = m_stretcher;
+	m_stretcher = nullptr;
+	m_lock.unlock();
+	delete stretcher;
+}
+int32 AudioStreamBase::m_DecodeStretched()
+{
+	if(m_stretchEnded)
+		return -1;
+
+	TimeStretcher::ReadInfo info;
+	if(!m_stretcher->Read(m_readBuffer[0], m_readBuffer[1], info))
+	{
+		// The worker is behind, play a bit of silence at the same position
+		const uint32 silence = 64;
+		for(uint32 i = 0; i < silence; i++)
 		{
-			if(fabs(avgDelta) > 0.001f)
-			{
-				// Fine tune timing
-				double step = abs(avgDelta) * 0.1f;
-				step = Math::Min(step, fabs(timingDelta)) * Math::Sign(timingDelta);
-				m_offsetCorrection += step;
-			}
+			m_readBuffer[0][i] = 0.0f;
+			m_readBuffer[1][i] = 0.0f;
 		}
+		m_stretchInfo.numFrames = silence;
+		m_stretchInfo.sourceEnd = m_stretchInfo.sourceStart = (double)Math::Max<int64>(m_samplePos, 0);
+		m_currentBufferSize = silence;
+		m_remainingBufferData = silence;
+		return silence;
 	}
 
-	m_lock.unlock();
+	m_stretchInfo = info;
+	m_loopCount = m_loopCountOffset + info.loopCount;
+	m_stretchEnded = info.end;
+	m_currentBufferSize = info.numFrames;
+	m_remainingBufferData = info.numFrames;
+	if(info.numFrames == 0)
+		return -1;
+	return info.numFrames;
 }
@@ -1,25 +1,121 @@
 #include "stdafx.h"
 #include "AudioStreamBase.hpp"
+#include <Shared/MappedFile.hpp>
+#include <algorithm>
 extern "C"
 {
 	#include "minimp3.h"
 }
 
+// Seek indices of fully scanned files are kept in cache/audio, keyed on the path and modification time of the file
+static String GetSeekIndexFolder()
+{
+	return Path::GetCacheFolder("audio");
+}
+// Increase this when the seek index format changes, so old indices are not used anymore
+static const uint32 seekIndexVersion = 1;
+
+static String GetSeekIndexPath(const String& path, uint64 lastWriteTime)
+{
+	String key = Utility::Sprintf("%s|%llu|%d", path, lastWriteTime, seekIndexVersion);
+	return Path::GetCacheFilePath(GetSeekIndexFolder(), key, "mp3idx");
+}
+
+// minimp3 fills its shared tables when the first decoder is created, decoding only touches the state of the decoder itself
+//	so the audio render threads, preview loading and preloading can decode different files at the same time without locking
+static mutex createLock;
+
+// Length in bytes of the layer III frame starting at <data>, 0 when there is no valid header there
+static uint32 ParseFrameHeader(const uint8* data, size_t size, uint32& frameSamples, uint32& sampleRate)
+{
+	if(size < 4 || data[0] != 0xFF || (data[1] & 0xE0) != 0xE0)
+		return 0;
+	uint32 header = ((uint32)data[0] << 24) | ((uint32)data[1] << 16) | ((uint32)data[2] << 8) | (uint32)data[3];
+	// Same layout as the decoder reads it
+	uint32 lsf, mpeg25;
+	if(header & (1 << 20))
+	{
+		lsf = (header & (1 << 19)) ? 0 : 1;
+		mpeg25 = 0;
+	}
+	else
+	{
+		if(header & (1 << 19)) // Reserved version
+			return 0;
+		lsf = 1;
+		mpeg25 = 1;
+	}
+	uint32 layer = (header >> 17) & 3;
+	uint32 rateIndex = (header >> 10) & 3;
+	uint32 bitrateIndex = (header >> 12) & 0xF;
+	if(layer != 1 || rateIndex == 3 || bitrateIndex == 0 || bitrateIndex == 0xF)
+		return 0;
+
+	sampleRate = mp3_freq_tab[rateIndex] >> (lsf + mpeg25);
+	frameSamples = lsf ? 576 : 1152;
+	uint32 padding = (header >> 9) & 1;
+	return (mp3_bitrate_tab[lsf][bitrateIndex] * 144000) / (sampleRate << lsf) + padding;
+}
+
+// Bytes of a valid frame in front of its main data, the header, the optional CRC and the side info
+static uint32 FrameSideSize(const uint8* data)
+{
+	bool lsf = (data[1] & 0x08) == 0;
+	bool mono = (data[3] >> 6) == 3;
+	bool crc = (data[1] & 0x01) == 0;
+	uint32 sideInfo = lsf ? (mono ? 9 : 17) : (mono ? 17 : 32);
+	return 4 + (crc ? 2 : 0) + sideInfo;
+}
+
+/*
+	Streams are opened lazily from a mapped file, only the tags and the first frame header are read
+	The frame index is built by scanning frame headers on a background thread, seeks past the scanned part scan up to the seek target themselves
+	Once the whole file is scanned the index is saved, reopening the file loads it so seeking doesn't have to scan anything
+*/
 class AudioStreamMP3_Impl : public AudioStreamBase
 {
-	mp3_decoder_t* m_decoder;
+	// An index entry is kept for every this many frames, seeking parses at most this many frame headers after the lookup
+	static const uint32 indexInterval = 16;
+	// Frames scanned by the background thread each time it takes the index lock
+	static const uint32 scanBatchFrames = 256;
+	// Main data of a frame can start this many bytes back, in the frames before it
+	static const uint32 maxMainDataBegin = 511;
+	// Index entries a seek steps back, enough frames to fill the bit reservoir at the lowest bitrates
+	static const uint32 seekPrerollEntries = 4;
+
+	struct SeekPoint
+	{
+		int32 sample;
+		uint32 offset;
+	};
+
+	mp3_decoder_t* m_decoder = nullptr;
+	MappedFile m_mappedFile;
+	String m_path;
+	uint64 m_lastWriteTime = 0;
 	size_t m_mp3dataOffset = 0;
 	size_t m_mp3dataLength = 0;
+	size_t m_firstFrameOffset = 0;
 	int32 m_mp3samplePosition = 0;
 	int32 m_samplingRate = 0;
-	uint8* m_dataSource = 0;
+	const uint8* m_dataSource = nullptr;
+	// Decoded samples to drop after a seek, seeks start decoding before the target so the bit reservoir is filled
+	int32 m_skipSamples = 0;
+
+	// Sparse frame index, one entry every indexInterval frames
+	Vector<SeekPoint> m_seekIndex;
+	mutex m_indexLock;
+	// End of the scanned part of the file
+	size_t m_scanOffset = 0;
+	int32 m_scanSample = 0;
+	uint32 m_scanFrames = 0;
+	bool m_indexComplete = false;
+	Thread m_indexThread;
+	std::atomic<bool> m_stopIndexing{ false };
 
-	Map<int32, size_t> m_frameIndices;
-	uint32 m_largetsFrameIndex;
 	Vector<float> m_pcm;
 	int64 m_playPos;
 
-
 	bool m_firstFrame = true;
 
 	// https://en.wikipedia.org/wiki/Synchsafe
@@ -45,133 +141,230 @@ class AudioStreamMP3_Impl : public AudioStreamBase
 
 	}
 
-public:
-	~AudioStreamMP3_Impl()
-	{
-		Deregister();
-		mp3_done(m_decoder);
-	}
-	bool Init(Audio* audio, const String& path, bool preload)
+	size_t m_SkipTags()
 	{
-		///TODO: Write non-preload functions
-		if(!AudioStreamBase::Init(audio, path, true)) // Always preload for now
-			return false;
-		
-
-		// Always use preloaded data
-		m_mp3dataLength = Reader().GetSize();
-		m_dataSource = m_data.data();
-		int32 tagSize = 0;
-
-		String tag = "tag";
-		for (size_t i = 0; i < 3; i++)
+		size_t tagSize = 0;
+		while(tagSize + 10 <= m_mp3dataLength && memcmp(m_dataSource + tagSize, "ID3", 3) == 0)
 		{
-			tag[i] = m_dataSource[i];
+			tagSize += m_unsynchsafe(m_toLittleEndian(*(int32*)(m_dataSource + tagSize + 6))) + 10;
+			// Footer
+			if(tagSize + 3 <= m_mp3dataLength && memcmp(m_dataSource + tagSize, "3DI", 3) == 0)
+				tagSize += 10;
 		}
-		while (tag == "ID3")
+		return tagSize;
+	}
+
+	// Scans frame headers until the frame containing <untilSample> or <maxFrames> frames were scanned, called with the index lock held
+	void m_ScanFrames(int64 untilSample, uint32 maxFrames)
+	{
+		for(uint32 i = 0; i < maxFrames && !m_indexComplete && m_scanSample <= untilSample;)
 		{
-			tagSize += m_unsynchsafe(m_toLittleEndian(*(int32*)(m_dataSource + 6 + tagSize))) + 10;
-			for (size_t i = 0; i < 3; i++)
-			{
-				tag[i] = m_dataSource[i + tagSize];
-			}
-			if (tag == "3DI")
+			uint32 frameSamples, sampleRate;
+			uint32 frameLength = ParseFrameHeader(m_dataSource + m_scanOffset, m_mp3dataLength - m_scanOffset, frameSamples, sampleRate);
+			if(frameLength == 0 || m_scanOffset + frameLength > m_mp3dataLength)
 			{
-				tagSize += 10;
+				// Resync on garbage between frames
+				if(++m_scanOffset + 4 > m_mp3dataLength)
+					m_indexComplete = true;
+				continue;
 			}
-			for (size_t i = 0; i < 3; i++)
+			if(m_scanFrames % indexInterval == 0)
+				m_seekIndex.Add({ m_scanSample, (uint32)m_scanOffset });
+			m_scanOffset += frameLength;
+			m_scanSample += frameSamples;
+			m_scanFrames++;
+			i++;
+		}
+	}
+	void m_IndexWorker()
+	{
+		while(!m_stopIndexing)
+		{
+			m_indexLock.lock();
+			m_ScanFrames(INT32_MAX, scanBatchFrames);
+			bool complete = m_indexComplete;
+			m_indexLock.unlock();
+			if(complete)
 			{
-				tag[i] = m_dataSource[i + tagSize];
+				m_OnIndexComplete();
+				break;
 			}
 		}
-		// Scan MP3 frame offsets
-		uint32 sampleOffset = 0;
-		for(size_t i = tagSize; i < m_mp3dataLength;)
+	}
+	void m_OnIndexComplete()
+	{
+		m_lock.lock();
+		m_samplesTotal = m_scanSample;
+		m_lock.unlock();
+		m_SaveSeekIndex();
+	}
+
+	bool m_LoadSeekIndex()
+	{
+		String indexPath = GetSeekIndexPath(m_path, m_lastWriteTime);
+		File file;
+		if(!Path::FileExists(indexPath) || !file.OpenRead(indexPath))
+			return false;
+		FileReader reader(file);
+		uint32 version = 0, numPoints = 0;
+		uint64 scanOffset = 0;
+		reader << version << m_scanSample << m_scanFrames << scanOffset << numPoints;
+		if(version != seekIndexVersion || scanOffset > m_mp3dataLength || (size_t)numPoints * sizeof(SeekPoint) != reader.GetSize() - reader.Tell())
+			return false;
+		m_seekIndex.resize(numPoints);
+		reader.Serialize(m_seekIndex.data(), numPoints * sizeof(SeekPoint));
+		// A damaged index could make decoding start outside of the data
+		for(uint32 i = 0; i < numPoints; i++)
+		{
+			if(m_seekIndex[i].offset >= m_mp3dataLength || (i > 0 && m_seekIndex[i].offset <= m_seekIndex[i - 1].offset))
+				return false;
+		}
+		m_scanOffset = (size_t)scanOffset;
+		m_indexComplete = true;
+		return true;
+	}
+	void m_SaveSeekIndex()
+	{
+		Path::CreateDirRecursive(GetSeekIndexFolder());
+		File file;
+		if(!file.OpenWrite(GetSeekIndexPath(m_path, m_lastWriteTime)))
+			return;
+		FileWriter writer(file);
+		uint32 version = seekIndexVersion;
+		uint32 numPoints = (uint32)m_seekIndex.size();
+		uint64 scanOffset = m_scanOffset;
+		writer << version << m_scanSample << m_scanFrames << scanOffset << numPoints;
+		writer.Serialize(m_seekIndex.data(), numPoints * sizeof(SeekPoint));
+	}
+
+	// Decodes the frame at the current offset, returns the number of samples per channel or -1 at the end
+	int32 m_DecodeFrame(int16* buffer, mp3_info_t& info)
+	{
+		while(m_mp3dataOffset < m_mp3dataLength)
 		{
-			if(m_dataSource[i] == 0xFF)
+			int32 readData = mp3_decode(m_decoder, (uint8*)m_dataSource + m_mp3dataOffset, (int)(m_mp3dataLength - m_mp3dataOffset), buffer, &info);
+			if(readData <= 0)
+				return -1;
+			m_mp3dataOffset += readData;
+			if(info.audio_bytes >= 0)
 			{
-				if(i + 1 > m_mp3dataLength)
-					continue;
-				if((m_dataSource[i + 1] & 0xE0) == 0xE0) // Frame Sync
-				{
-					uint8 version = (m_dataSource[i+1] & 0x18) >> 3;
-					uint8 layer = (m_dataSource[i + 1] & 0x06) >> 1;
-					bool crc = (m_dataSource[i + 1] & 0x01) != 0;
-					uint8 bitrateIndex = (m_dataSource[i + 2] & 0xF0) >> 4;
-					uint8 rateIndex = (m_dataSource[i + 2] & 0x0C) >> 2;
-					bool paddingEnabled = ((m_dataSource[i + 2] & 0x02) >> 1) != 0;
-					uint8 channelFlags = ((m_dataSource[i + 3] & 0xC0) >> 6);
-					if(bitrateIndex == 0xF || rateIndex > 2) // bad
-					{
-						return false;
-						i++;
-						continue;
-					}
-
-					uint8 channels = ((channelFlags & 0x3) == 0x3) ? 1 : 2;
-
-					uint32 linearVersion = version == 0x03 ? 0 : 1; // Version 1/2
-					uint32 bitrate = mp3_bitrate_tab[linearVersion][bitrateIndex] * 1000;
-					uint32 sampleRate = mp3_freq_tab[rateIndex];
-					uint32 padding = paddingEnabled ? 1 : 0;
-
-					uint32 frameLength = 144 * bitrate / sampleRate + padding;
-					if(frameLength == 0)
-					{
-						return false;
-						i++;
-						continue;
-					}
-					
-					i += frameLength;
-					uint32 frameSamples = (linearVersion == 0) ? 1152 : 576;
-					m_frameIndices.Add((int32)sampleOffset, i);
-					sampleOffset += frameSamples;
-					continue; // Skip header
-				}
+				int32 samplesGotten = info.audio_bytes / (info.channels * sizeof(short));
+				m_mp3samplePosition += samplesGotten;
+				return samplesGotten;
 			}
-			i++;
+		}
+		return -1;
+	}
+
+public:
+	~AudioStreamMP3_Impl()
+	{
+		Deregister();
+		m_DestroyStretcher();
+		m_stopIndexing = true;
+		if(m_indexThread.joinable())
+			m_indexThread.join();
+		if(m_decoder)
+			mp3_done(m_decoder);
+	}
+	bool Init(Audio* audio, const String& path, bool preload)
+	{
+		if(!AudioStreamBase::Init(audio, path, false))
+			return false;
+		m_lastWriteTime = m_file.GetLastWriteTime();
+		m_file.Close();
+		if(!m_mappedFile.Open(path))
+			return false;
+		m_path = path;
+		m_dataSource = m_mappedFile.GetData();
+		m_mp3dataLength = m_mappedFile.GetSize();
+
+		m_firstFrameOffset = m_SkipTags();
+		bool indexLoaded = m_LoadSeekIndex();
+		if(!indexLoaded)
+		{
+			m_seekIndex.clear();
+			m_scanOffset = m_firstFrameOffset;
+			m_scanSample = 0;
+			m_scanFrames = 0;
+			// Only the first frame is needed to start playing
+			m_ScanFrames(0, 1);
 		}
 
 		// No mp3 frames found
-		if(m_frameIndices.empty())
+		if(m_seekIndex.empty())
 		{
 			Logf("No valid mp3 frames found in file \"%s\"", Logger::Warning, path);
 			return false;
 		}
 
-
-		// Total sample
-		m_samplesTotal = sampleOffset;
-
+		createLock.lock();
 		m_decoder = (mp3_decoder_t*)mp3_create();
-		m_preloaded = false;
-		SetPosition_Internal(-400000);
-		int32 r = DecodeData_Internal();
-		if(r <= 0)
-			return false;
-
-		if (preload)
+		createLock.unlock();
+		if(preload)
 		{
-			int totalSamples = 0;
-			while (r > 0)
-			{
-				for (size_t i = 0; i < r; i++)
-				{
-					m_pcm.Add(m_readBuffer[0][i]);
-					m_pcm.Add(m_readBuffer[1][i]);	
-				}
-				totalSamples += r;
-				r = DecodeData_Internal();
-			}
-			m_data.clear();
+			// The whole file is decoded now, so all frames are needed anyway
+			m_ScanFrames(INT32_MAX, UINT32_MAX);
+			m_samplesTotal = m_scanSample;
+			if(!indexLoaded)
+				m_SaveSeekIndex();
+			if(!m_Preload())
+				return false;
+			m_mappedFile.Close();
 			m_dataSource = nullptr;
-			m_samplesTotal = totalSamples;
 		}
-		m_preloaded = preload;
+		else
+		{
+			// Never ends on the position before the length is known, the decoder still reports the end
+			m_samplesTotal = m_indexComplete ? m_scanSample : INT64_MAX;
+			// The first frame gives the sample rate
+			SetPosition_Internal(0);
+			if(DecodeData_Internal() <= 0)
+				return false;
+			if(!m_indexComplete)
+				m_indexThread = Thread(&AudioStreamMP3_Impl::m_IndexWorker, this);
+		}
 		m_playPos = 0;
 
-
+		return true;
+	}
+	bool m_Preload()
+	{
+		// Decode straight into the final buffer, the index knows the length
+		m_pcm.resize((size_t)m_samplesTotal * 2);
+		m_mp3dataOffset = m_firstFrameOffset;
+		m_mp3samplePosition = 0;
+		int16 buffer[MP3_MAX_SAMPLES_PER_FRAME];
+		mp3_info_t info;
+		int64 totalSamples = 0;
+		int32 r;
+		while((r = m_DecodeFrame(buffer, info)) > 0)
+		{
+			if(m_firstFrame)
+			{
+				m_bufferSize = MP3_MAX_SAMPLES_PER_FRAME / 2;
+				InitSampling(m_samplingRate = info.sample_rate);
+				m_firstFrame = false;
+			}
+			r = (int32)Math::Min<int64>(r, m_samplesTotal - totalSamples);
+			float* dst = m_pcm.data() + totalSamples * 2;
+			if(info.channels == 1)
+			{
+				for(int32 i = 0; i < r; i++)
+					dst[i * 2] = dst[i * 2 + 1] = (float)buffer[i] / (float)0x7FFF;
+			}
+			else
+			{
+				for(int32 i = 0; i < r * 2; i++)
+					dst[i] = (float)buffer[i] / (float)0x7FFF;
+			}
+			totalSamples += r;
+		}
+		if(totalSamples == 0)
+			return false;
+		m_samplesTotal = totalSamples;
+		m_pcm.resize((size_t)totalSamples * 2);
+		m_preloaded = true;
 		return true;
 	}
 	virtual void SetPosition_Internal(int32 pos)
@@ -187,16 +380,56 @@ public:
 			return;
 		}
 
-		auto it = m_frameIndices.lower_bound(pos);
-		if(it == m_frameIndices.end())
+		pos = Math::Max(pos, 0);
+		m_indexLock.lock();
+		if(!m_indexComplete && pos >= m_scanSample)
+			m_ScanFrames(pos, UINT32_MAX);
+
+		// Last index entry at or before the position, then the last frame header before it
+		auto it = std::upper_bound(m_seekIndex.begin(), m_seekIndex.end(), pos, [](int32 sample, const SeekPoint& point) { return sample < point.sample; });
+		if(it != m_seekIndex.begin())
+			--it;
+		// Parse from a few entries earlier so the frames before the target are known as well
+		it -= Math::Min((size_t)(it - m_seekIndex.begin()), (size_t)seekPrerollEntries);
+		SeekPoint frame = *it;
+		m_indexLock.unlock();
+
+		// The last frames before the target with the size of their main data
+		//	every frame after the index entry was scanned before, so the headers are valid
+		static const uint32 historySize = seekPrerollEntries * indexInterval;
+		SeekPoint history[historySize];
+		uint32 historyMainData[historySize];
+		uint32 numFrames = 0;
+		while(true)
 		{
-			--it; // Take the last frame
+			uint32 frameSamples, sampleRate;
+			uint32 frameLength = ParseFrameHeader(m_dataSource + frame.offset, m_mp3dataLength - frame.offset, frameSamples, sampleRate);
+			if(frameLength == 0 || frame.offset + frameLength > m_mp3dataLength || frame.sample + (int32)frameSamples > pos)
+				break;
+			history[numFrames % historySize] = frame;
+			historyMainData[numFrames % historySize] = frameLength - FrameSideSize(m_dataSource + frame.offset);
+			numFrames++;
+			frame.sample += frameSamples;
+			frame.offset += frameLength;
 		}
-		if(it != m_frameIndices.end())
+
+		// The frame before the target has to decode correctly since its output overlaps the target's,
+		//	decoding starts early enough that the frames before it hold the whole bit reservoir it can reach back into
+		SeekPoint start = frame;
+		uint32 mainData = 0;
+		for(uint32 i = 0; i < Math::Min(numFrames, historySize); i++)
 		{
-			m_mp3samplePosition = it->first;
-			m_mp3dataOffset = it->second;
+			uint32 index = (numFrames - 1 - i) % historySize;
+			start = history[index];
+			if(i > 0 && (mainData += historyMainData[index]) >= maxMainDataBegin)
+				break;
 		}
+
+		// The reservoir and overlap of the old position don't belong to the new one, the frames before the target are dropped again
+		mp3_reset(m_decoder);
+		m_mp3samplePosition = start.sample;
+		m_mp3dataOffset = start.offset;
+		m_skipSamples = pos - start.sample;
 	}
 	virtual int32 GetStreamPosition_Internal()
 	{
@@ -253,22 +486,18 @@ public:
 
 		int16 buffer[MP3_MAX_SAMPLES_PER_FRAME];
 		mp3_info_t info;
-		int32 readData = 0;
+		int32 samplesGotten;
+		// Drop the frames decoded to fill the bit reservoir after a seek
 		while(true)
 		{
-			readData = mp3_decode(m_decoder, (uint8*)m_dataSource + m_mp3dataOffset, (int)(m_mp3dataLength - m_mp3dataOffset), buffer, &info);
-			m_mp3dataOffset += readData;
-			if(m_mp3dataOffset >= m_mp3dataLength) // EOF
+			samplesGotten = m_DecodeFrame(buffer, info);
+			if(samplesGotten <= 0)
 				return -1;
-			if(readData <= 0)
-				return -1;
-			if(info.audio_bytes >= 0)
+			if(m_skipSamples < samplesGotten)
 				break;
+			m_skipSamples -= samplesGotten;
 		}
 
-		int32 samplesGotten = info.audio_bytes / (info.channels * sizeof(short));
-		m_mp3samplePosition += samplesGotten;
-
 		if(m_firstFrame)
 		{
 			m_bufferSize = MP3_MAX_SAMPLES_PER_FRAME / 2;
@@ -290,9 +519,11 @@ public:
 				m_readBuffer[1][i] = (float)buffer[i * 2 + 1] / (float)0x7FFF;
 			}
 		}
+		// The samples before the seek position are skipped in the buffer
 		m_currentBufferSize = samplesGotten;
-		m_remainingBufferData = samplesGotten;
-		return samplesGotten;
+		m_remainingBufferData = samplesGotten - m_skipSamples;
+		m_skipSamples = 0;
+		return m_remainingBufferData;
 	}
 };
 
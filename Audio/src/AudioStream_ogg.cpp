@@ -21,6 +21,7 @@ public:
 	~AudioStreamOGG_Impl()
 	{
 		Deregister();
+		m_DestroyStretcher();
 	}
 	bool Init(Audio* audio, const String& path, bool preload)
 	{
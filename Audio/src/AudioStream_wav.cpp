@@ -117,6 +117,7 @@ public:
 	~AudioStreamWAV_Impl()
 	{
 		Deregister();
+		m_DestroyStretcher();
 	}
 
 	bool Init(Audio* audio, const String& path, bool preload)
@@ -299,7 +300,7 @@ public:
 
 					if (m_format.nFormat == 1)
 					{
-						m_samplesTotal = chunkHdr.nLength / sizeof(short);
+						m_samplesTotal = chunkHdr.nLength / sizeof(short) / m_format.nChannels;
 					}
 					else if (m_format.nFormat == 2)
 					{
@@ -316,6 +317,9 @@ public:
 
 		InitSampling(m_format.nSampleRate);
 		m_playbackPointer = 0;
+		// Reading the chunks left the file at its end
+		if (!m_preloaded)
+			SetPosition_Internal(0);
 		return true;
 	}
 	virtual int32 GetStreamPosition_Internal()
@@ -342,7 +346,7 @@ public:
 			int filePos = 0;
 			if (m_format.nFormat == 1)
 			{
-				filePos = m_dataPosition + pos * sizeof(short);
+				filePos = m_dataPosition + pos * sizeof(short) * m_format.nChannels;
 			}
 			else if (m_format.nFormat == 2)
 			{
@@ -391,8 +395,8 @@ public:
 							m_remainingBufferData = samplesPerRead;
 							return i;
 						}
-						m_readBuffer[0][i] = (float)src[0] / (float)0x7FFF;
-						m_readBuffer[1][i] = (float)src[0] / (float)0x7FFF;
+						m_readBuffer[0][i] = (float)src[i] / (float)0x7FFF;
+						m_readBuffer[1][i] = (float)src[i] / (float)0x7FFF;
 						m_playbackPointer++;
 					}
 				}
@@ -0,0 +1,337 @@
+#include "stdafx.h"
+#include "AudioSummary.hpp"
+#include "Audio.hpp"
+#include "AudioStream.hpp"
+#include <complex>
+
+// Increase this when the way summaries are built changes, so stored ones are built again
+static const uint32 summaryVersion = 1;
+
+const float AudioSummary::spectrumFloor = -80.0f;
+
+// In-place radix-2 FFT, the size has to be a power of 2
+static void FFT(std::complex<float>* data, uint32 size)
+{
+	for(uint32 i = 1, j = 0; i < size; i++)
+	{
+		uint32 bit = size >> 1;
+		for(; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		if(i < j)
+			std::swap(data[i], data[j]);
+	}
+	for(uint32 length = 2; length <= size; length <<= 1)
+	{
+		float angle = -2.0f * Math::pi / length;
+		std::complex<float> step(cosf(angle), sinf(angle));
+		for(uint32 i = 0; i < size; i += length)
+		{
+			std::complex<float> w(1.0f, 0.0f);
+			for(uint32 j = 0; j < length / 2; j++)
+			{
+				std::complex<float> u = data[i + j];
+				std::complex<float> v = data[i + j + length / 2] * w;
+				data[i + j] = u + v;
+				data[i + j + length / 2] = u - v;
+				w *= step;
+			}
+		}
+	}
+}
+
+// Writes or reads the size of an array followed by its contents in one block
+template<typename T>
+static bool SerializeArray(BinaryStream& stream, Vector<T>& array)
+{
+	uint32 size = (uint32)array.size();
+	stream << size;
+	if(stream.IsReading())
+	{
+		if(size * sizeof(T) > stream.GetSize() - stream.Tell())
+			return false;
+		array.resize(size);
+	}
+	size_t numBytes = size * sizeof(T);
+	return numBytes == 0 || stream.Serialize(array.data(), numBytes) == numBytes;
+}
+
+class AudioSummary::Builder
+{
+public:
+	Builder(AudioSummary& summary, uint32 sampleRate) : m_summary(summary)
+	{
+		m_summary.m_sampleRate = sampleRate;
+		m_summary.m_numFrames = 0;
+		m_summary.m_levels.clear();
+		m_summary.m_spectrum.clear();
+
+		for(uint32 i = 0; i < fftSize; i++)
+			m_window[i] = 0.5f - 0.5f * cosf(2.0f * Math::pi * i / fftSize);
+
+		// Logarithmically spaced bands between 40Hz and 16kHz, at least one FFT bin each
+		if(sampleRate == 0)
+			return;
+		float binWidth = (float)sampleRate / fftSize;
+		float maxFrequency = Math::Min(16000.0f, sampleRate * 0.5f);
+		for(uint32 i = 0; i <= numBands; i++)
+		{
+			float frequency = 40.0f * powf(maxFrequency / 40.0f, (float)i / numBands);
+			m_bandStart[i] = Math::Clamp((uint32)(frequency / binWidth), 1U, fftSize / 2);
+			if(i > 0)
+				m_bandStart[i] = Math::Max(m_bandStart[i], m_bandStart[i - 1] + 1);
+		}
+	}
+
+	// Adds <numFrames> frames, the samples of each channel are <stride> floats apart
+	void Add(const float* left, const float* right, uint32 stride, uint32 numFrames)
+	{
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			float l = left[i * stride];
+			float r = right[i * stride];
+
+			m_bin.min = Math::Min(m_bin.min, Math::Min(l, r));
+			m_bin.max = Math::Max(m_bin.max, Math::Max(l, r));
+			m_bin.meanSquare += l * l + r * r;
+			if(++m_binFrames == baseBinFrames)
+				m_EndBin();
+
+			// Spectrogram columns only use the start of every hop
+			uint32 offset = (uint32)(m_summary.m_numFrames % spectrumHop);
+			if(offset < fftSize)
+			{
+				m_input[offset] = (l + r) * 0.5f;
+				if(offset == fftSize - 1)
+					m_EndColumn(fftSize);
+			}
+			m_summary.m_numFrames++;
+		}
+	}
+
+	void Finish()
+	{
+		if(m_binFrames > 0)
+			m_EndBin();
+		uint32 offset = (uint32)(m_summary.m_numFrames % spectrumHop);
+		if(m_summary.m_numFrames > 0 && offset > 0 && offset < fftSize)
+			m_EndColumn(offset);
+		m_BuildLevels();
+	}
+
+private:
+	struct Bin
+	{
+		float min;
+		float max;
+		float meanSquare;
+	};
+
+	void m_EndBin()
+	{
+		m_bin.meanSquare /= (float)(m_binFrames * 2);
+		m_bins.Add(m_bin);
+		m_bin = { 0.0f, 0.0f, 0.0f };
+		m_binFrames = 0;
+	}
+	// Levels are reduced from the unquantized values of the level before
+	void m_BuildLevels()
+	{
+		Vector<WaveformLevel>& levels = m_summary.m_levels;
+		uint32 binFrames = baseBinFrames;
+		while(true)
+		{
+			WaveformLevel& level = levels.Add();
+			level.binFrames = binFrames;
+			level.min.resize(m_bins.size());
+			level.max.resize(m_bins.size());
+			level.rms.resize(m_bins.size());
+			for(size_t i = 0; i < m_bins.size(); i++)
+			{
+				level.min[i] = (int8)Math::Clamp(floorf(m_bins[i].min * 127.0f), -127.0f, 127.0f);
+				level.max[i] = (int8)Math::Clamp(ceilf(m_bins[i].max * 127.0f), -127.0f, 127.0f);
+				level.rms[i] = (uint8)Math::Clamp(sqrtf(m_bins[i].meanSquare) * 255.0f + 0.5f, 0.0f, 255.0f);
+			}
+			if(m_bins.size() <= minBins)
+				break;
+
+			// Merge pairs of bins, a last bin without a pair is kept as it is
+			for(size_t i = 0; i < m_bins.size() / 2; i++)
+			{
+				const Bin& a = m_bins[i * 2];
+				const Bin& b = m_bins[i * 2 + 1];
+				m_bins[i] = { Math::Min(a.min, b.min), Math::Max(a.max, b.max), (a.meanSquare + b.meanSquare) * 0.5f };
+			}
+			if(m_bins.size() % 2)
+				m_bins[m_bins.size() / 2] = m_bins.back();
+			m_bins.resize((m_bins.size() + 1) / 2);
+			binFrames *= 2;
+		}
+	}
+	// Analyzes the column in the input buffer, the part after <numFrames> is past the end of the file
+	void m_EndColumn(uint32 numFrames)
+	{
+		if(m_summary.m_sampleRate == 0)
+			return;
+		for(uint32 i = 0; i < fftSize; i++)
+			m_fft[i] = std::complex<float>(i < numFrames ? m_input[i] * m_window[i] : 0.0f, 0.0f);
+		FFT(m_fft, fftSize);
+
+		// A full scale sine has a magnitude of a quarter of the FFT size with a Hann window
+		const float fullScale = (fftSize / 4.0f) * (fftSize / 4.0f);
+		for(uint32 band = 0; band < numBands; band++)
+		{
+			float power = 0.0f;
+			uint32 end = Math::Min(m_bandStart[band + 1], fftSize / 2 + 1);
+			for(uint32 i = m_bandStart[band]; i < end; i++)
+				power = Math::Max(power, std::norm(m_fft[i]));
+			float db = 10.0f * log10f(power / fullScale + 1e-12f);
+			m_summary.m_spectrum.Add((uint8)Math::Clamp((1.0f - db / spectrumFloor) * 255.0f + 0.5f, 0.0f, 255.0f));
+		}
+	}
+
+	AudioSummary& m_summary;
+
+	Vector<Bin> m_bins;
+	Bin m_bin = { 0.0f, 0.0f, 0.0f };
+	uint32 m_binFrames = 0;
+
+	float m_window[fftSize];
+	uint32 m_bandStart[numBands + 1];
+	float m_input[fftSize];
+	std::complex<float> m_fft[fftSize];
+};
+
+void AudioSummary::Build(const float* pcm, int64 numFrames, uint32 sampleRate)
+{
+	Builder builder(*this, sampleRate);
+	const int64 framesPerCall = 1 << 16;
+	for(int64 i = 0; i < numFrames; i += framesPerCall)
+		builder.Add(pcm + i * 2, pcm + i * 2 + 1, 2, (uint32)Math::Min(framesPerCall, numFrames - i));
+	builder.Finish();
+}
+bool AudioSummary::Build(class Audio* audio, const String& path)
+{
+	AudioStream stream = AudioStreamRes::CreateDecoder(audio, path);
+	if(!stream)
+		return false;
+
+	Builder builder(*this, stream->GetSampleRate());
+	const float* left;
+	const float* right;
+	while(uint32 numFrames = stream->DecodeNext(left, right))
+		builder.Add(left, right, 1, numFrames);
+	builder.Finish();
+	return m_numFrames > 0;
+}
+
+void AudioSummary::GetWaveform(uint32 columns, Vector<float>& min, Vector<float>& max, Vector<float>& rms) const
+{
+	min.clear();
+	max.clear();
+	rms.clear();
+	if(m_levels.empty() || columns == 0)
+		return;
+
+	// Levels get coarser towards the back
+	const WaveformLevel* level = &m_levels.front();
+	for(const WaveformLevel& l : m_levels)
+	{
+		if(l.rms.size() >= columns)
+			level = &l;
+	}
+
+	size_t numBins = level->rms.size();
+	min.resize(columns);
+	max.resize(columns);
+	rms.resize(columns);
+	for(uint32 c = 0; c < columns; c++)
+	{
+		size_t start = c * numBins / columns;
+		size_t end = Math::Max((c + 1) * numBins / columns, start + 1);
+		int32 low = 127, high = -127;
+		float sum = 0.0f;
+		for(size_t i = start; i < end; i++)
+		{
+			low = Math::Min<int32>(low, level->min[i]);
+			high = Math::Max<int32>(high, level->max[i]);
+			float value = level->rms[i] / 255.0f;
+			sum += value * value;
+		}
+		min[c] = low / 127.0f;
+		max[c] = high / 127.0f;
+		rms[c] = sqrtf(sum / (end - start));
+	}
+}
+void AudioSummary::GetSpectrum(uint32 columns, Vector<float>& levels) const
+{
+	levels.clear();
+	uint32 numSpectrumColumns = GetSpectrumLength();
+	if(numSpectrumColumns == 0 || columns == 0)
+		return;
+
+	// Loudest value of the columns merged into each one
+	levels.resize(columns * numBands);
+	for(uint32 c = 0; c < columns; c++)
+	{
+		uint32 start = (uint32)((uint64)c * numSpectrumColumns / columns);
+		uint32 end = Math::Max((uint32)((uint64)(c + 1) * numSpectrumColumns / columns), start + 1);
+		for(uint32 band = 0; band < numBands; band++)
+		{
+			uint8 value = 0;
+			for(uint32 i = start; i < end; i++)
+				value = Math::Max(value, m_spectrum[i * numBands + band]);
+			levels[c * numBands + band] = value / 255.0f;
+		}
+	}
+}
+
+const Vector<AudioSummary::WaveformLevel>& AudioSummary::GetLevels() const
+{
+	return m_levels;
+}
+uint32 AudioSummary::GetSpectrumLength() const
+{
+	return (uint32)(m_spectrum.size() / numBands);
+}
+double AudioSummary::GetDuration() const
+{
+	return m_sampleRate > 0 ? (double)m_numFrames / m_sampleRate : 0.0;
+}
+size_t AudioSummary::GetMemoryUsage() const
+{
+	size_t usage = m_spectrum.size();
+	for(const WaveformLevel& level : m_levels)
+		usage += level.rms.size() * 3;
+	return usage;
+}
+
+bool AudioSummary::Serialize(BinaryStream& stream)
+{
+	uint32 version = summaryVersion;
+	stream << version;
+	if(version != summaryVersion)
+		return false;
+
+	stream << m_sampleRate;
+	stream << m_numFrames;
+	uint32 numLevels = (uint32)m_levels.size();
+	stream << numLevels;
+	if(stream.IsReading())
+	{
+		// Every level halves the number of bins, more than this can't be valid
+		if(numLevels > 64)
+			return false;
+		m_levels.clear();
+		m_levels.resize(numLevels);
+	}
+	for(WaveformLevel& level : m_levels)
+	{
+		stream << level.binFrames;
+		if(!SerializeArray(stream, level.min) || !SerializeArray(stream, level.max) || !SerializeArray(stream, level.rms))
+			return false;
+		if(level.min.size() != level.rms.size() || level.max.size() != level.rms.size())
+			return false;
+	}
+	return SerializeArray(stream, m_spectrum);
+}
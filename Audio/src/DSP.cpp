@@ -8,6 +8,7 @@ void PanDSP::Process(float* out, uint32 numSamples)
 {
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
 		if(panning > 0)
 			out[i * 2 + 0] = (out[i * 2 + 0] * (1.0f - panning)) * mix + out[i * 2 + 0] * (1 - mix);
 		if(panning < 0)
@@ -17,33 +18,79 @@ void PanDSP::Process(float* out, uint32 numSamples)
 
 void BQFDSP::Process(float* out, uint32 numSamples)
 {
-	for(uint32 c = 0; c < 2; c++)
+	if(numSamples == 0)
+		return;
+
+	// Interpolate from the coefficients used at the end of the last block to the latest published ones
+	const Coefficients from = m_coefficients;
+	if(m_pending.Update())
+		m_coefficients = m_pending.GetReadBuffer();
+	const Coefficients& to = m_coefficients;
+
+	// Most blocks don't change the filter
+	if(memcmp(&from, &to, sizeof(Coefficients)) == 0)
 	{
 		for(uint32 i = 0; i < numSamples; i++)
-		{
-			float& sample = out[i * 2 + c];
-			float src = sample;
+			m_FilterFrame(&out[i * 2], to);
+		return;
+	}
+
+	const float step = 1.0f / (float)numSamples;
+	for(uint32 i = 0; i < numSamples; i++)
+	{
+		float t = (float)(i + 1) * step;
+		Coefficients current;
+		current.b0 = from.b0 + (to.b0 - from.b0) * t;
+		current.b1 = from.b1 + (to.b1 - from.b1) * t;
+		current.b2 = from.b2 + (to.b2 - from.b2) * t;
+		current.a1 = from.a1 + (to.a1 - from.a1) * t;
+		current.a2 = from.a2 + (to.a2 - from.a2) * t;
+		m_FilterFrame(&out[i * 2], current);
+	}
+}
+void BQFDSP::m_FilterFrame(float* frame, const Coefficients& coefficients)
+{
+	for(uint32 c = 0; c < 2; c++)
+	{
+		float& sample = frame[c];
+		float src = sample;
 
-			float filtered = 
-				(b0 / a0) * src + 
-				(b1 / a0) * zb[c][0] + 
-				(b2 / a0) * zb[c][1] - 
-				(a1 / a0) * za[c][0] - 
-				(a2 / a0) * za[c][1];
+		float filtered = 
+			coefficients.b0 * src + 
+			coefficients.b1 * zb[c][0] + 
+			coefficients.b2 * zb[c][1] - 
+			coefficients.a1 * za[c][0] - 
+			coefficients.a2 * za[c][1];
 
-			// Shift delay buffers
-			zb[c][1] = zb[c][0];
-			zb[c][0] = src;
+		// Shift delay buffers
+		zb[c][1] = zb[c][0];
+		zb[c][0] = src;
 
-			// Feedback the calculated value into the IIR delay buffers
-			za[c][1] = za[c][0];
-			za[c][0] = filtered;
+		// Feedback the calculated value into the IIR delay buffers
+		za[c][1] = za[c][0];
+		za[c][0] = filtered;
 
-			sample = filtered;
-		}
+		sample = filtered;
 	}
 }
-void BQFDSP::SetLowPass(float q, float freq, float sampleRate)
+void BQFDSP::Reset()
+{
+	memset(zb, 0, sizeof(zb));
+	memset(za, 0, sizeof(za));
+	// Start at the coefficients set while enabling instead of interpolating from the ones used last time
+	if(m_pending.Update())
+		m_coefficients = m_pending.GetReadBuffer();
+}
+void BQFDSP::m_Publish(const Coefficients& coefficients)
+{
+	m_pending.GetWriteBuffer() = coefficients;
+	m_pending.Publish();
+}
+void BQFDSP::m_DiscardPending()
+{
+	m_pending.Update();
+}
+BQFDSP::Coefficients BQFDSP::CalculateLowPass(float q, float freq, float sampleRate)
 {
 	// Limit q
 	q = Math::Max(q, 0.01f);
@@ -51,20 +98,26 @@ void BQFDSP::SetLowPass(float q, float freq, float sampleRate)
 	// Sampling frequency
 	double w0 = (2 * Math::pi * freq) / sampleRate;
 	double cw0 = cos(w0);
-	float alpha = (float)(sin(w0) / (2 * q));
+	double alpha = sin(w0) / (2 * q);
+	double a0 = 1 + alpha;
 
-	b0 = (float)((1 - cw0) / 2);
-	b1 = (float)(1 - cw0);
-	b2 = (float)((1 - cw0) / 2);
-	a0 = 1 + alpha;
-	a1 = (float)(-2 * cw0);
-	a2 = 1 - alpha;
+	Coefficients ret;
+	ret.b0 = (float)(((1 - cw0) / 2) / a0);
+	ret.b1 = (float)((1 - cw0) / a0);
+	ret.b2 = (float)(((1 - cw0) / 2) / a0);
+	ret.a1 = (float)((-2 * cw0) / a0);
+	ret.a2 = (float)((1 - alpha) / a0);
+	return ret;
+}
+void BQFDSP::SetLowPass(float q, float freq, float sampleRate)
+{
+	m_Publish(CalculateLowPass(q, freq, sampleRate));
 }
 void BQFDSP::SetLowPass(float q, float freq)
 {
 	SetLowPass(q, freq, (float)audio->GetSampleRate());
 }
-void BQFDSP::SetHighPass(float q, float freq, float sampleRate)
+BQFDSP::Coefficients BQFDSP::CalculateHighPass(float q, float freq, float sampleRate)
 {
 	// Limit q
 	q = Math::Max(q, 0.01f);
@@ -72,35 +125,47 @@ void BQFDSP::SetHighPass(float q, float freq, float sampleRate)
 	assert(freq < sampleRate);
 	double w0 = (2 * Math::pi * freq) / sampleRate;
 	double cw0 = cos(w0);
-	float alpha = (float)(sin(w0) / (2 * q));
+	double alpha = sin(w0) / (2 * q);
+	double a0 = 1 + alpha;
 
-	b0 = (float)((1 + cw0) / 2);
-	b1 = (float)-(1 + cw0);
-	b2 = float((1 + cw0) / 2);
-	a0 = 1 + alpha;
-	a1 = (float)(-2 * cw0);
-	a2 = 1 - alpha;
+	Coefficients ret;
+	ret.b0 = (float)(((1 + cw0) / 2) / a0);
+	ret.b1 = (float)(-(1 + cw0) / a0);
+	ret.b2 = (float)(((1 + cw0) / 2) / a0);
+	ret.a1 = (float)((-2 * cw0) / a0);
+	ret.a2 = (float)((1 - alpha) / a0);
+	return ret;
+}
+void BQFDSP::SetHighPass(float q, float freq, float sampleRate)
+{
+	m_Publish(CalculateHighPass(q, freq, sampleRate));
 }
 void BQFDSP::SetHighPass(float q, float freq)
 {
 	SetHighPass(q, freq, (float)audio->GetSampleRate());
 }
-void BQFDSP::SetPeaking(float q, float freq, float gain, float sampleRate)
+BQFDSP::Coefficients BQFDSP::CalculatePeaking(float q, float freq, float gain, float sampleRate)
 {
 	// Limit q
 	q = Math::Max(q, 0.01f);
 
 	double w0 = (2 * Math::pi * freq) / sampleRate;
 	double cw0 = cos(w0);
-	float alpha = (float)(sin(w0) / (2 * q));
+	double alpha = sin(w0) / (2 * q);
 	double A = pow(10, (gain / 40));
+	double a0 = 1 + alpha / A;
 
-	b0 = 1 + (float)(alpha * A);
-	b1 = -2 * (float)cw0;
-	b2 = 1 - (float)(alpha*A);
-	a0 = 1 + (float)(alpha / A);
-	a1 = -2 * (float)cw0;
-	a2 = 1 - (float)(alpha / A);
+	Coefficients ret;
+	ret.b0 = (float)((1 + alpha * A) / a0);
+	ret.b1 = (float)((-2 * cw0) / a0);
+	ret.b2 = (float)((1 - alpha * A) / a0);
+	ret.a1 = (float)((-2 * cw0) / a0);
+	ret.a2 = (float)((1 - alpha / A) / a0);
+	return ret;
+}
+void BQFDSP::SetPeaking(float q, float freq, float gain, float sampleRate)
+{
+	m_Publish(CalculatePeaking(q, freq, gain, sampleRate));
 }
 void BQFDSP::SetPeaking(float q, float freq, float gain)
 {
@@ -142,18 +207,20 @@ void BitCrusherDSP::SetPeriod(float period /*= 0*/)
 	assert(audio);
 	double f = audio->GetSampleRate() / 44100.0;
 	m_increment = (uint32)((double)(1 << 16));
-	m_period = (uint32)(f * period * (double)(1 << 16));
+	m_period.store((uint32)(f * period * (double)(1 << 16)), std::memory_order_relaxed);
 }
 void BitCrusherDSP::Process(float* out, uint32 numSamples)
 {
+	const uint32 period = m_period.load(std::memory_order_relaxed);
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
 		m_currentDuration += m_increment;
-		if(m_currentDuration > m_period)
+		if(m_currentDuration > period)
 		{
 			m_sampleBuffer[0] = out[i * 2];
 			m_sampleBuffer[1] = out[i*2+1];
-			m_currentDuration -= m_period;
+			m_currentDuration -= period;
 		}
 
 		out[i * 2] = m_sampleBuffer[0] * mix + out[i * 2] * (1.0f - mix);
@@ -161,25 +228,45 @@ void BitCrusherDSP::Process(float* out, uint32 numSamples)
 	}
 }
 
+void BitCrusherDSP::Reset()
+{
+	m_currentDuration = 0;
+	m_sampleBuffer[0] = 0.0f;
+	m_sampleBuffer[1] = 0.0f;
+}
+
 void GateDSP::SetLength(double length)
 {
 	double flength = length / 1000.0 * audio->GetSampleRate();
-	m_length = (uint32)flength;
-	SetGating(m_gating);
+	m_targetLength.store((uint32)flength, std::memory_order_relaxed);
 }
 void GateDSP::SetGating(float gating)
 {
-	float flength = (float)m_length;
+	m_targetGating.store(gating, std::memory_order_relaxed);
+}
+void GateDSP::m_UpdateLength()
+{
+	uint32 length = m_targetLength.load(std::memory_order_relaxed);
+	float gating = m_targetGating.load(std::memory_order_relaxed);
+	if(length == m_length && gating == m_gating)
+		return;
+
+	m_length = length;
 	m_gating = gating;
-	m_halfway = (uint32)(flength * gating);
+	m_halfway = (uint32)((float)m_length * gating);
 	const float fadeDuration = Math::Min(0.05f, gating * 0.5f);
 	m_fadeIn = (uint32)((float)m_halfway * fadeDuration);
 	m_fadeOut = (uint32)((float)m_halfway * (1.0f - fadeDuration));
 	m_currentSample = 0;
 }
 
+void GateDSP::Reset()
+{
+	m_currentSample = 0;
+}
 void GateDSP::Process(float* out, uint32 numSamples)
 {
+	m_UpdateLength();
 	if(m_length < 2)
 		return;
 
@@ -188,6 +275,7 @@ void GateDSP::Process(float* out, uint32 numSamples)
 
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
 		if(currentSample + i < startSample)
 		{
 			continue;
@@ -220,13 +308,28 @@ void GateDSP::Process(float* out, uint32 numSamples)
 	}
 }
 
+void TapeStopDSP::SetMaxLength(double length)
+{
+	assert(audio);
+	uint32 maxLength = (uint32)(length / 1000.0 * audio->GetSampleRate());
+	if(m_sampleBuffer.size() < maxLength * 2)
+		m_sampleBuffer.resize(maxLength * 2);
+}
 void TapeStopDSP::SetLength(double length)
 {
 	assert(audio);
 	double flength = length / 1000.0 * audio->GetSampleRate();
 	m_length = (uint32)flength;
-	m_sampleBuffer.clear();
-	m_sampleBuffer.reserve(length);
+	// The playback rate reaches 0 after m_length samples, so no more than that are ever stored
+	if(m_sampleBuffer.size() < m_length * 2)
+		m_sampleBuffer.resize(m_length * 2);
+	Reset();
+}
+void TapeStopDSP::Reset()
+{
+	m_numStored = 0;
+	m_sampleIdx = 0.0f;
+	m_currentSample = 0;
 }
 void TapeStopDSP::Process(float* out, uint32 numSamples)
 {
@@ -235,6 +338,7 @@ void TapeStopDSP::Process(float* out, uint32 numSamples)
 
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
 		if(currentSample + i < startSample)
 		{
 			continue;
@@ -248,8 +352,12 @@ void TapeStopDSP::Process(float* out, uint32 numSamples)
 			continue;
 		}
 		// Store samples for later
-		m_sampleBuffer.Add(out[i*2]);
-		m_sampleBuffer.Add(out[i*2+1]);
+		if(m_numStored * 2 < m_sampleBuffer.size())
+		{
+			m_sampleBuffer[m_numStored * 2] = out[i * 2];
+			m_sampleBuffer[m_numStored * 2 + 1] = out[i * 2 + 1];
+			m_numStored++;
+		}
 
 		// The sample index into the buffer
 		uint32 i2 = (uint32)floor(m_sampleIdx);
@@ -265,11 +373,10 @@ void TapeStopDSP::Process(float* out, uint32 numSamples)
 void RetriggerDSP::SetLength(double length)
 {
 	double flength = length / 1000.0 * audio->GetSampleRate();
-	m_length = (uint32)flength;
-	SetGating(m_gating);
+	m_targetLength.store((uint32)flength, std::memory_order_relaxed);
 	if (!m_bufferReserved)
 	{
-		m_sampleBuffer.reserve(m_length + 100);
+		m_sampleBuffer.reserve((uint32)flength + 100);
 		m_bufferReserved = true;
 	}
 }
@@ -280,8 +387,20 @@ void RetriggerDSP::SetResetDuration(uint32 resetDuration)
 }
 void RetriggerDSP::SetGating(float gating)
 {
+	m_targetGating.store(gating, std::memory_order_relaxed);
+}
+void RetriggerDSP::m_UpdateLength()
+{
+	uint32 length = m_targetLength.load(std::memory_order_relaxed);
+	float gating = m_targetGating.load(std::memory_order_relaxed);
+	if(length == m_length && gating == m_gating)
+		return;
+
+	m_length = length;
 	m_gating = gating;
 	m_gateLength = (uint32)((float)m_length * gating);
+	if(m_length > 0)
+		m_currentSample %= m_length;
 }
 void RetriggerDSP::SetMaxLength(uint32 length)
 {
@@ -292,8 +411,16 @@ void RetriggerDSP::SetMaxLength(uint32 length)
 		m_bufferReserved = true;
 	}
 }
+void RetriggerDSP::Reset()
+{
+	m_currentSample = 0;
+}
 void RetriggerDSP::Process(float* out, uint32 numSamples)
 {
+	m_UpdateLength();
+	if(m_length == 0)
+		return;
+
 	///TODO: Clean up casting
 	int32 startSample = (double)startTime * ((double)audio->GetSampleRate() / 1000.0);
 	int32 nowSample = (double)audioBase->GetPosition() * ((double)audio->GetSampleRate() / 1000.0);
@@ -304,6 +431,7 @@ void RetriggerDSP::Process(float* out, uint32 numSamples)
 
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
 		if(nowSample + i < startSample)
 		{
 			continue;
@@ -339,11 +467,20 @@ void WobbleDSP::SetLength(double length)
 	double flength = length / 1000.0 * audio->GetSampleRate();
 	m_length = (uint32)flength;
 }
+void WobbleDSP::Reset()
+{
+	BQFDSP::Reset();
+	m_currentSample = 0;
+}
 void WobbleDSP::Process(float* out, uint32 numSamples)
 {
 	static Interpolation::CubicBezier easing(Interpolation::EaseInExpo);
 	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
 	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
+	float sampleRate = (float)audio->GetSampleRate();
+
+	// The coefficients are calculated here for every sample, so anything published by the setters is dropped once per block
+	m_DiscardPending();
 
 	for(uint32 i = 0; i < numSamples; i++)
 	{
@@ -354,11 +491,10 @@ void WobbleDSP::Process(float* out, uint32 numSamples)
 		float f = abs(2.0f * ((float)m_currentSample / (float)m_length) - 1.0f);
 		f = easing.Sample(f);
 		float freq = fmin + (fmax - fmin) * f;
-		SetLowPass(q, freq);
 
 		float s[2] = { out[i * 2], out[i * 2 + 1] };
 
-		BQFDSP::Process(&out[i * 2], 1);
+		m_FilterFrame(&out[i * 2], CalculateLowPass(q, freq, sampleRate));
 
 		// Apply slight mixing
 		float mix = 0.5f;
@@ -375,6 +511,15 @@ void PhaserDSP::SetLength(double length)
 	double flength = length / 1000.0 * audio->GetSampleRate();
 	m_length = (uint32)flength;
 }
+void PhaserDSP::Reset()
+{
+	for(uint32 c = 0; c < 2; c++)
+	{
+		for(uint32 i = 0; i < 6; i++)
+			filters[c][i].za = 0.0f;
+		za[c] = 0.0f;
+	}
+}
 void PhaserDSP::Process(float* out, uint32 numSamples)
 {
 	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
@@ -382,6 +527,7 @@ void PhaserDSP::Process(float* out, uint32 numSamples)
 
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
 		if(currentSample + i < startSample)
 		{
 			continue;
@@ -441,7 +587,16 @@ void FlangerDSP::SetDelayRange(uint32 min, uint32 max)
 	m_min = min * mult;
 	m_max = max * mult;
 	m_bufferLength = m_max * 2;
-	m_sampleBuffer.resize(m_bufferLength);
+	if(m_sampleBuffer.size() < m_bufferLength)
+		m_sampleBuffer.resize(m_bufferLength);
+	if(m_bufferOffset >= m_bufferLength)
+		m_bufferOffset = 0;
+}
+void FlangerDSP::Reset()
+{
+	memset(m_sampleBuffer.data(), 0, sizeof(float) * m_bufferLength);
+	m_bufferOffset = 0;
+	m_time = 0;
 }
 void FlangerDSP::Process(float* out, uint32 numSamples)
 {
@@ -455,6 +610,7 @@ void FlangerDSP::Process(float* out, uint32 numSamples)
 
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
 		if(currentSample + i < startSample)
 		{
 			continue;
@@ -486,25 +642,39 @@ void FlangerDSP::Process(float* out, uint32 numSamples)
 	}
 }
 
+void EchoDSP::SetMaxLength(double length)
+{
+	uint32 maxLength = (uint32)(length / 1000.0 * audio->GetSampleRate()) * 2;
+	if(m_sampleBuffer.size() < maxLength)
+		m_sampleBuffer.resize(maxLength);
+}
 void EchoDSP::SetLength(double length)
 {
 	double flength = length / 1000.0 * audio->GetSampleRate();
-	m_sampleBuffer.clear();
-	m_bufferLength = (uint32)(flength * 2);
-	m_sampleBuffer.resize(m_bufferLength);
+	m_bufferLength = (uint32)flength * 2;
+	if(m_sampleBuffer.size() < m_bufferLength)
+		m_sampleBuffer.resize(m_bufferLength);
+	Reset();
+}
+void EchoDSP::Reset()
+{
 	memset(m_sampleBuffer.data(), 0, sizeof(float) * m_bufferLength);
+	m_bufferOffset = 0;
 	m_numLoops = 0;
 }
 void EchoDSP::Process(float* out, uint32 numSamples)
 {
 	float* data = m_sampleBuffer.data();
-	if (!data)
+	if(m_bufferLength == 0)
 		return;
 	int32 startSample = startTime * audio->GetSampleRate() / 1000.0;
 	int32 currentSample = audioBase->GetPosition() * audio->GetSampleRate() / 1000.0;
+	feedback.BeginBlock(numSamples);
 
 	for(uint32 i = 0; i < numSamples; i++)
 	{
+		float mix = this->mix.Next();
+		float feedback = this->feedback.Next();
 		if(currentSample + i < startSample)
 		{
 			continue;
@@ -539,6 +709,10 @@ void SidechainDSP::SetLength(double length)
 	m_length = (uint32)flength;
 	m_time = 0;
 }
+void SidechainDSP::Reset()
+{
+	m_time = 0;
+}
 void SidechainDSP::Process(float* out, uint32 numSamples)
 {
 	if(m_length == 0)
@@ -582,12 +756,40 @@ void CombinedFilterDSP::SetHighPass(float q, float freq, float peakQ, float peak
 	a.SetHighPass(q, freq, sr);
 	peak.SetPeaking(peakQ, freq, peakGain, sr);
 }
+void CombinedFilterDSP::Prepare(uint32 numSamples)
+{
+	m_dry.resize(numSamples * 2);
+}
 void CombinedFilterDSP::Process(float* out, uint32 numSamples)
 {
-	a.mix = mix;
-	peak.mix = mix;
-	a.Process(out, numSamples);
-	peak.Process(out, numSamples);
+	// Not added through AddDSP, so there is no buffer to mix with
+	if(m_dry.empty())
+	{
+		a.Process(out, numSamples);
+		peak.Process(out, numSamples);
+		return;
+	}
+
+	// The filters don't apply a mix themselves, so blend the filtered block with a copy of the input
+	const uint32 maxSamples = (uint32)m_dry.size() / 2;
+	while(numSamples > 0)
+	{
+		uint32 count = Math::Min(numSamples, maxSamples);
+		memcpy(m_dry.data(), out, count * 2 * sizeof(float));
+
+		a.Process(out, count);
+		peak.Process(out, count);
+
+		for(uint32 i = 0; i < count; i++)
+		{
+			float mix = this->mix.Next();
+			out[i * 2 + 0] = out[i * 2 + 0] * mix + m_dry[i * 2 + 0] * (1.0f - mix);
+			out[i * 2 + 1] = out[i * 2 + 1] * mix + m_dry[i * 2 + 1] * (1.0f - mix);
+		}
+
+		out += count * 2;
+		numSamples -= count;
+	}
 }
 
 #include "SoundTouch.h"
@@ -618,10 +820,32 @@ public:
 		m_soundtouch.setSetting(SETTING_SEQUENCE_MS, 5);
 		//m_soundtouch.setSetting(SETTING_SEEKWINDOW_MS, 10);
 		//m_soundtouch.setSetting(SETTING_OVERLAP_MS, 10);
+		init = true;
+	}
+	// Runs silence through SoundTouch so its internal buffers are allocated before the audio thread uses it
+	void Prepare(uint32 numSamples)
+	{
+		// Warm up with larger blocks than the audio thread uses, so the buffers have room for the backlog SoundTouch keeps
+		const uint32 warmupSamples = numSamples * 4;
+		Vector<float> silence;
+		silence.resize(warmupSamples * 2);
+		// Switching between pitching up and down moves samples between the stages, which needs the most buffer space
+		for(uint32 i = 0; i < 64; i++)
+		{
+			this->pitch = (i % 2 == 0) ? -12.0f : 12.0f;
+			Process(silence.data(), warmupSamples);
+		}
+		this->pitch = 0.0f;
+		Clear();
+	}
+	void Clear()
+	{
+		m_soundtouch.clear();
 	}
 	void Process(float* out, uint32 numSamples)
 	{
-		m_receiveBuffer.resize(numSamples*2);
+		if(m_receiveBuffer.size() < numSamples * 2)
+			m_receiveBuffer.resize(numSamples * 2);
 		m_soundtouch.setPitchSemiTones(pitch);
 		m_soundtouch.putSamples(out, numSamples);
 		uint32 receivedSamples = m_soundtouch.receiveSamples(m_receiveBuffer.data(), numSamples);
@@ -640,9 +864,19 @@ PitchShiftDSP::~PitchShiftDSP()
 {
 	delete m_impl;
 }
+void PitchShiftDSP::Prepare(uint32 numSamples)
+{
+	if(!m_impl->init)
+		m_impl->Init(audio);
+	m_impl->Prepare(numSamples);
+}
+void PitchShiftDSP::Reset()
+{
+	m_impl->Clear();
+}
 void PitchShiftDSP::Process(float* out, uint32 numSamples)
 {
-	m_impl->pitch = amount;
+	m_impl->pitch = amount.Get();
 	if(!m_impl->init)
 		m_impl->Init(audio);
 	m_impl->Process(out, numSamples);
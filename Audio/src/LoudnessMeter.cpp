@@ -0,0 +1,190 @@
+#include "stdafx.h"
+#include "LoudnessMeter.hpp"
+#include "Audio.hpp"
+#include "AudioStream.hpp"
+
+const double LoudnessMeter::silence = -70.0;
+
+// Taps per phase of the oversampling filter, the history holds this many samples
+static const uint32 oversampleTaps = 12;
+
+// Windowed sinc interpolation between the middle two samples of the history, at 1/4, 2/4 and 3/4 of the way
+struct OversampleFilter
+{
+	float coefficients[3][oversampleTaps];
+	OversampleFilter()
+	{
+		const double center = oversampleTaps / 2 - 1;
+		const double halfWidth = oversampleTaps / 2;
+		for(uint32 p = 0; p < 3; p++)
+		{
+			for(uint32 j = 0; j < oversampleTaps; j++)
+			{
+				double x = center + (p + 1) * 0.25 - j;
+				double sinc = sin(Math::pi * x) / (Math::pi * x);
+				double window = 0.5 * (1.0 + cos(Math::pi * x / halfWidth));
+				coefficients[p][j] = (float)(sinc * window);
+			}
+		}
+	}
+};
+static const OversampleFilter oversampleFilter;
+
+static double EnergyToLoudness(double energy)
+{
+	return -0.691 + 10.0 * log10(energy);
+}
+static double LoudnessToEnergy(double loudness)
+{
+	return pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+double LoudnessMeter::Biquad::Process(double in, uint32 channel)
+{
+	double out = b0 * in + z1[channel];
+	z1[channel] = b1 * in - a1 * out + z2[channel];
+	z2[channel] = b2 * in - a2 * out;
+	return out;
+}
+
+LoudnessMeter::LoudnessMeter(uint32 sampleRate)
+{
+	// K-weighting filters from BS.1770, recalculated for the sample rate of the audio
+	double K = tan(Math::pi * 1681.974450955533 / sampleRate);
+	double Q = 0.7071752369554196;
+	double Vh = pow(10.0, 3.999843853973347 / 20.0);
+	double Vb = pow(Vh, 0.4996667741545416);
+	double a0 = 1.0 + K / Q + K * K;
+	m_shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+	m_shelf.b1 = 2.0 * (K * K - Vh) / a0;
+	m_shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+	m_shelf.a1 = 2.0 * (K * K - 1.0) / a0;
+	m_shelf.a2 = (1.0 - K / Q + K * K) / a0;
+
+	K = tan(Math::pi * 38.13547087602444 / sampleRate);
+	Q = 0.5003270373238773;
+	a0 = 1.0 + K / Q + K * K;
+	m_highPass.b0 = 1.0;
+	m_highPass.b1 = -2.0;
+	m_highPass.b2 = 1.0;
+	m_highPass.a1 = 2.0 * (K * K - 1.0) / a0;
+	m_highPass.a2 = (1.0 - K / Q + K * K) / a0;
+
+	m_framesPerStep = Math::Max(sampleRate / 10, 1U);
+}
+
+void LoudnessMeter::Process(const float* samples, uint32 numFrames)
+{
+	for(uint32 i = 0; i < numFrames; i++)
+	{
+		double energy = 0.0;
+		for(uint32 c = 0; c < 2; c++)
+		{
+			float sample = samples[i * 2 + c];
+
+			// True peak, the sample itself and the 3 points between the middle samples of the history
+			//	every sample is written twice so the last taps are always contiguous
+			float* history = m_history[c];
+			history[m_historyPosition] = sample;
+			history[m_historyPosition + oversampleTaps] = sample;
+			history += m_historyPosition + 1;
+			m_peak = Math::Max(m_peak, fabsf(sample));
+			for(uint32 p = 0; p < 3; p++)
+			{
+				const float* coefficients = oversampleFilter.coefficients[p];
+				float interpolated = 0.0f;
+				for(uint32 j = 0; j < oversampleTaps; j++)
+					interpolated += history[j] * coefficients[j];
+				m_peak = Math::Max(m_peak, fabsf(interpolated));
+			}
+
+			double weighted = m_highPass.Process(m_shelf.Process(sample, c), c);
+			energy += weighted * weighted;
+		}
+
+		m_historyPosition = (m_historyPosition + 1) % oversampleTaps;
+
+		m_stepEnergy += energy;
+		if(++m_stepFrames == m_framesPerStep)
+			m_EndStep();
+	}
+}
+void LoudnessMeter::m_EndStep()
+{
+	m_steps[m_numSteps % 4] = m_stepEnergy;
+	m_numSteps++;
+	m_stepEnergy = 0.0;
+	m_stepFrames = 0;
+	if(m_numSteps >= 4)
+		m_blocks.Add((m_steps[0] + m_steps[1] + m_steps[2] + m_steps[3]) / (4.0 * m_framesPerStep));
+}
+
+double LoudnessMeter::GetIntegratedLoudness() const
+{
+	// Absolute gate
+	const double absoluteGate = LoudnessToEnergy(silence);
+	double sum = 0.0;
+	uint32 count = 0;
+	for(double block : m_blocks)
+	{
+		if(block > absoluteGate)
+		{
+			sum += block;
+			count++;
+		}
+	}
+	if(count == 0)
+		return silence;
+
+	// Relative gate, 10 LU below the loudness of the blocks that passed the absolute gate
+	const double relativeGate = LoudnessToEnergy(EnergyToLoudness(sum / count) - 10.0);
+	sum = 0.0;
+	count = 0;
+	for(double block : m_blocks)
+	{
+		if(block > absoluteGate && block > relativeGate)
+		{
+			sum += block;
+			count++;
+		}
+	}
+	if(count == 0)
+		return silence;
+	return EnergyToLoudness(sum / count);
+}
+double LoudnessMeter::GetTruePeak() const
+{
+	if(m_peak <= 0.0f)
+		return silence;
+	return Math::Max(20.0 * log10((double)m_peak), silence);
+}
+
+bool LoudnessMeter::Measure(class Audio* audio, const String& path, float& loudness, float& truePeak)
+{
+	AudioStream stream = AudioStreamRes::CreateDecoder(audio, path);
+	if(!stream)
+		return false;
+
+	LoudnessMeter meter(stream->GetSampleRate());
+	Vector<float> interleaved;
+	const float* left;
+	const float* right;
+	int64 numFrames = 0;
+	while(uint32 blockFrames = stream->DecodeNext(left, right))
+	{
+		interleaved.resize(blockFrames * 2);
+		for(uint32 i = 0; i < blockFrames; i++)
+		{
+			interleaved[i * 2] = left[i];
+			interleaved[i * 2 + 1] = right[i];
+		}
+		meter.Process(interleaved.data(), blockFrames);
+		numFrames += blockFrames;
+	}
+	if(numFrames == 0)
+		return false;
+
+	loudness = (float)meter.GetIntegratedLoudness();
+	truePeak = (float)meter.GetTruePeak();
+	return true;
+}
@@ -2,23 +2,21 @@
 #include "Sample.hpp"
 #include "Audio_Impl.hpp"
 #include "Audio.hpp"
+#include <Shared/MappedFile.hpp>
 
 // Fixed point format for resampling
 static uint64 fp_sampleStep = 1ull << 48;
 
-struct WavHeader
-{
-	char id[4];
-	uint32 nLength;
+// Uncompressed files of at least this size that are already in the mixer format are played straight from the mapped file
+static const size_t mappedSampleSize = 1 << 20;
 
-	bool operator ==(const char* rhs) const
-	{
-		return strncmp(id, rhs, 4) == 0;
-	}
-	bool operator !=(const char* rhs) const
-	{
-		return !(*this == rhs);
-	}
+enum WavFormatTag : uint16
+{
+	PCM = 1,
+	MSADPCM = 2,
+	IEEEFloat = 3,
+	// Actual format is in the first 2 bytes of the sub format GUID
+	Extensible = 0xFFFE,
 };
 
 struct WavFormat
@@ -31,107 +29,127 @@ struct WavFormat
 	uint16 nBitsPerSample;
 };
 
-BinaryStream& operator <<(BinaryStream& stream, WavHeader& hdr)
+// File contents are little endian and not necessarily aligned
+template<typename T>
+static T ReadLE(const uint8* data)
 {
-	stream.SerializeObject(hdr.id);
-	stream << hdr.nLength;
-	return stream;
+	T value;
+	memcpy(&value, data, sizeof(T));
+	return value;
 }
-BinaryStream& operator <<(BinaryStream& stream, WavFormat& fmt)
+
+/*
+	Conversion of each sample format to float
+	the loops only convert contiguous samples without branches so the compiler can vectorize them
+*/
+static void ConvertU8(const uint8* src, uint64 count, float* out)
 {
-	stream.SerializeObject(fmt);
-	return stream;
+	const float scale = 1.0f / 128.0f;
+	for(uint64 i = 0; i < count; i++)
+		out[i] = (float)((int32)src[i] - 128) * scale;
 }
-
-class Sample_Impl : public SampleRes
+static void ConvertS16(const uint8* src, uint64 count, float* out)
 {
-public:
-	Audio* m_audio;
-	Buffer m_pcm;
-	WavFormat m_format = { 0 };
-	uint32 m_samplesTotal;
-
-	uint32 m_decode_ms_adpcm(const Buffer& encoded, int16* pcm, uint64 pos)
+	const float scale = 1.0f / 32768.0f;
+	for(uint64 i = 0; i < count; i++)
+		out[i] = (float)ReadLE<int16>(src + i * 2) * scale;
+}
+static void ConvertS24(const uint8* src, uint64 count, float* out)
+{
+	// Placed in the upper 3 bytes of an int32 to get the sign
+	const float scale = 1.0f / 2147483648.0f;
+	for(uint64 i = 0; i < count; i++)
 	{
-		int8* src = ((int8*)encoded.data()) + pos;
-		int8 blockPredictors[] = { 0, 0 };
-		int32 ideltas[] = { 0, 0 };
-		int32 sample1[] = { 0, 0 };
-		int32 sample2[] = { 0, 0 };
-
-		blockPredictors[0] = *src++;
-		blockPredictors[1] = *src++;
-		assert(blockPredictors[0] >= 0 && blockPredictors[0] < 7);
-		assert(blockPredictors[1] >= 0 && blockPredictors[0] < 7);
-
-		int16* src_16 = (int16*)src;
-		ideltas[0] = *src_16++;
-		ideltas[1] = *src_16++;
-
-		sample1[0] = *src_16++;
-		sample1[1] = *src_16++;
-
-		sample2[0] = *src_16++;
-		sample2[1] = *src_16++;
-
-		*pcm++ = sample2[0];
-		*pcm++ = sample2[1];
-		*pcm++ = sample1[0];
-		*pcm++ = sample1[1];
-
-
-		src = (int8*)src_16;
-		uint32 decodedCount = 2;
-
-		int AdaptationTable[] = {
-			230, 230, 230, 230, 307, 409, 512, 614,
-			768, 614, 512, 409, 307, 230, 230, 230
-		};
-		int AdaptCoeff1[] = { 256, 512, 0, 192, 240, 460, 392 };
-		int AdaptCoeff2[] = { 0, -256, 0, 64, 0, -208, -232 };
-
-		// Decode the rest of the data in the block
-		int remainingInBlock = m_format.nBlockAlign - 14;
-		while (remainingInBlock > 0)
-		{
-			int8 nibbleData = *src++;
+		const uint8* s = src + i * 3;
+		int32 value = (int32)(((uint32)s[0] << 8) | ((uint32)s[1] << 16) | ((uint32)s[2] << 24));
+		out[i] = (float)value * scale;
+	}
+}
+static void ConvertS32(const uint8* src, uint64 count, float* out)
+{
+	const float scale = 1.0f / 2147483648.0f;
+	for(uint64 i = 0; i < count; i++)
+		out[i] = (float)ReadLE<int32>(src + i * 4) * scale;
+}
+static void ConvertF32(const uint8* src, uint64 count, float* out)
+{
+	memcpy(out, src, (size_t)count * sizeof(float));
+}
 
-			int8 nibbles[] = { 0, 0 };
-			nibbles[0] = nibbleData >> 4;
-			nibbles[0] &= 0x0F;
-			nibbles[1] = nibbleData & 0x0F;
+static const int32 adpcmAdaptationTable[16] = {
+	230, 230, 230, 230, 307, 409, 512, 614,
+	768, 614, 512, 409, 307, 230, 230, 230
+};
+static const int32 adpcmCoefficients[7][2] = {
+	{ 256, 0 }, { 512, -256 }, { 0, 0 }, { 192, 64 }, { 240, 0 }, { 460, -208 }, { 392, -232 }
+};
 
-			int16 predictors[] = { 0, 0 };
-			for (size_t i = 0; i < 2; i++)
-			{
+// Decodes one block of MS-ADPCM into interleaved samples, returns the number of frames written or 0 for an invalid block
+static uint32 DecodeMSADPCMBlock(const uint8* block, uint32 blockSize, uint32 numChannels, uint32 framesPerBlock, float* out)
+{
+	const float scale = 1.0f / 32768.0f;
+	const uint32 headerSize = 7 * numChannels;
+	if(blockSize < headerSize)
+		return 0;
 
+	int32 coefficient1[2], coefficient2[2], delta[2], sample1[2], sample2[2];
+	for(uint32 c = 0; c < numChannels; c++)
+	{
+		uint8 predictor = block[c];
+		if(predictor >= 7)
+			return 0;
+		coefficient1[c] = adpcmCoefficients[predictor][0];
+		coefficient2[c] = adpcmCoefficients[predictor][1];
+		delta[c] = ReadLE<int16>(block + numChannels + c * 2);
+		sample1[c] = ReadLE<int16>(block + numChannels * 3 + c * 2);
+		sample2[c] = ReadLE<int16>(block + numChannels * 5 + c * 2);
+
+		// The header contains the first two frames, oldest one last
+		out[c] = (float)sample2[c] * scale;
+		out[numChannels + c] = (float)sample1[c] * scale;
+	}
 
-				predictors[i] = ((sample1[i] * AdaptCoeff1[blockPredictors[i]]) + (sample2[i] * AdaptCoeff2[blockPredictors[i]])) / 256;
-				if (nibbles[i] & 0x08)
-					predictors[i] += (nibbles[i] - 0x10) * ideltas[i];
-				else
-					predictors[i] += nibbles[i] * ideltas[i];
-				*pcm++ = predictors[i];
-				sample2[i] = sample1[i];
-				sample1[i] = predictors[i];
-				ideltas[i] = (AdaptationTable[nibbles[i]] * ideltas[i]) / 256;
-				if (ideltas[i] < 16)
-					ideltas[i] = 16;
-			}
-			decodedCount++;
-			remainingInBlock--;
-		}
-		return decodedCount;
+	// Channels alternate per nibble, high nibble first
+	uint32 numFrames = Math::Min(framesPerBlock, 2 + (blockSize - headerSize) * 2 / numChannels);
+	uint32 numNibbles = (numFrames - 2) * numChannels;
+	const uint8* nibbles = block + headerSize;
+	out += numChannels * 2;
+	for(uint32 i = 0; i < numNibbles; i++)
+	{
+		uint32 c = i & (numChannels - 1);
+		int32 nibble = (i & 1) ? (nibbles[i >> 1] & 0x0F) : (nibbles[i >> 1] >> 4);
+		int32 signedNibble = nibble >= 8 ? nibble - 16 : nibble;
+		int32 predicted = (sample1[c] * coefficient1[c] + sample2[c] * coefficient2[c]) / 256;
+		int32 sample = Math::Clamp(predicted + signedNibble * delta[c], -32768, 32767);
+		out[i] = (float)sample * scale;
+		sample2[c] = sample1[c];
+		sample1[c] = sample;
+		delta[c] = Math::Max((adpcmAdaptationTable[nibble] * delta[c]) >> 8, 16);
 	}
+	return numFrames;
+}
 
+class Sample_Impl : public SampleRes
+{
+public:
+	Audio* m_audio;
+	// Format of the file the sample was loaded from
+	WavFormat m_format = { 0 };
+	uint32 m_framesPerBlock = 0;
+	uint32 m_factFrames = 0;
+	// Interleaved stereo samples at the output sample rate
+	Vector<float> m_pcm;
+	// Kept open when the samples are played straight from the file
+	MappedFile m_mappedFile;
+	// Either m_pcm or the contents of the mapped file
+	const float* m_samples = nullptr;
+	uint32 m_sampleRate = 0;
+	double m_loadTime = 0.0;
 
 	mutex m_lock;
 
-	// Resampling values
-	uint64 m_sampleStep = 0;
-	uint64 m_sampleStepIncrement = 0;
-
 	uint64 m_playbackPointer = 0;
+	// In frames
 	uint64 m_length = 0;
 	bool m_playing = false;
 	bool m_looping = false;
@@ -147,7 +165,7 @@ public:
 		m_playing = true;
 		m_playbackPointer = 0;
 		m_looping = looping;
-		m_lock.unlock();	
+		m_lock.unlock();
 	}
 	virtual void Stop() override
 	{
@@ -158,174 +176,197 @@ public:
 	}
 	bool Init(const String& path)
 	{
-		File file;
-		if(!file.OpenRead(path))
+		if(!m_mappedFile.Open(path))
 			return false;
-		FileReader stream = FileReader(file);
-
-		WavHeader riff;
-		stream << riff;
-		if(riff != "RIFF")
+		if(!Init(m_mappedFile.GetData(), m_mappedFile.GetSize(), true))
 			return false;
-
-		char riffType[4];
-		stream.SerializeObject(riffType);
-		if(strncmp(riffType, "WAVE", 4) != 0)
+		if(m_samples == m_pcm.data())
+			m_mappedFile.Close();
+		return true;
+	}
+	bool Init(const uint8* file, size_t size, bool mapped)
+	{
+		if(size < 12 || memcmp(file, "RIFF", 4) != 0 || memcmp(file + 8, "WAVE", 4) != 0)
 			return false;
 
-		while(stream.Tell() < stream.GetSize())
+		const uint8* data = nullptr;
+		size_t dataSize = 0;
+		size_t pos = 12;
+		while(pos + 8 <= size)
 		{
-			WavHeader chunkHdr;
-			stream << chunkHdr;
-			if(chunkHdr == "fmt ")
+			const uint8* chunk = file + pos + 8;
+			size_t chunkSize = Math::Min<size_t>(ReadLE<uint32>(file + pos + 4), size - pos - 8);
+			if(memcmp(file + pos, "fmt ", 4) == 0)
 			{
-				stream << m_format;
-				//Logf("Sample format: %s", Logger::Info, (m_format.nFormat == 1) ? "PCM" : "Unknown");
-				//Logf("Channels: %d", Logger::Info, m_format.nChannels);
-				//Logf("Sample rate: %d", Logger::Info, m_format.nSampleRate);
-				//Logf("Bps: %d", Logger::Info, m_format.nBitsPerSample);
-
-				// In case there's some extra data at the end that we dont use.
-				if (m_format.nFormat == 2)
-				{
-					uint16 cbSize;
-					stream << cbSize;
-					stream.Skip(cbSize);
-				}
-				else
-				stream.Skip(chunkHdr.nLength - sizeof(WavFormat));
+				if(chunkSize < sizeof(WavFormat))
+					return false;
+				memcpy(&m_format, chunk, sizeof(WavFormat));
+				uint16 extraSize = chunkSize >= 18 ? ReadLE<uint16>(chunk + 16) : 0;
+				const uint8* extra = chunk + 18;
+				if(m_format.nFormat == Extensible && extraSize >= 22 && chunkSize >= 40)
+					m_format.nFormat = ReadLE<uint16>(extra + 6);
+				if(m_format.nFormat == MSADPCM && extraSize >= 2 && chunkSize >= 20)
+					m_framesPerBlock = ReadLE<uint16>(extra);
 			}
-			else if (chunkHdr == "fact")
+			else if(memcmp(file + pos, "fact", 4) == 0 && chunkSize >= 4)
 			{
-				uint32 fh;
-				stream << fh;
-				m_samplesTotal = fh;
+				m_factFrames = ReadLE<uint32>(chunk);
 			}
-			else if(chunkHdr == "data") // data Chunk
+			else if(memcmp(file + pos, "data", 4) == 0)
 			{
-				// validate header
-				if(m_format.nFormat != 1 && m_format.nFormat != 2)
-					return false;
-				if(m_format.nChannels > 2 || m_format.nChannels == 0)
-					return false;
-				if(m_format.nFormat == 1 && m_format.nBitsPerSample != 16)
-					return false;
-				if (m_format.nFormat == 2 && m_format.nBitsPerSample != 4)
-					return false;
+				data = chunk;
+				dataSize = chunkSize;
+			}
+			// Chunks are padded to an even size
+			pos += 8 + chunkSize + (chunkSize & 1);
+		}
+		if(!data || m_format.nChannels == 0 || m_format.nChannels > 2 || m_format.nSampleRate == 0)
+			return false;
 
-				if (m_format.nFormat == 1)
-				{
-					// Read data
-					m_length = chunkHdr.nLength / sizeof(short);
-					m_pcm.resize(chunkHdr.nLength);
-					stream.Serialize(m_pcm.data(), chunkHdr.nLength);
-				}
-				else if (m_format.nFormat == 2)
-				{
-					m_length = chunkHdr.nLength;
-					Buffer encoded(m_length * m_format.nChannels * sizeof(short));
-					stream.Serialize(encoded.data(), chunkHdr.nLength);
-					m_pcm.resize(m_length * m_format.nChannels * sizeof(short));
-					int16* pcmptr = (int16*)m_pcm.data();
-					int pos = 0;
-					int totalDecoded = 0;
-					while (pos <= m_length)
-					{
-						int decoded = m_decode_ms_adpcm(encoded, pcmptr, pos);
-						pcmptr += 2 * decoded;
-						totalDecoded += decoded;
-						pos += m_format.nBlockAlign;
-					}
-					m_length = totalDecoded * 2;
-				}
+		m_sampleRate = m_audio->GetSampleRate();
+		uint32 numChannels = m_format.nChannels;
+		// Played straight from the mapped file, unless an odd sized chunk before the data leaves the floats misaligned
+		if(mapped && m_format.nFormat == IEEEFloat && m_format.nBitsPerSample == 32 && numChannels == 2 &&
+			m_format.nSampleRate == m_sampleRate && dataSize >= mappedSampleSize && ((uintptr_t)data & 3) == 0)
+		{
+			m_samples = (const float*)data;
+			m_length = dataSize / (sizeof(float) * 2);
+			return true;
+		}
+
+		// Decoded at the rate of the file, with the channels of the file at the start of the buffer
+		uint64 numFrames = 0;
+		if(m_format.nFormat == MSADPCM)
+		{
+			if(m_format.nBitsPerSample != 4 || m_format.nBlockAlign <= 7 * numChannels)
+				return false;
+			if(m_framesPerBlock == 0)
+				m_framesPerBlock = (m_format.nBlockAlign - 7 * numChannels) * 2 / numChannels + 2;
+			if(m_framesPerBlock < 2)
+				return false;
+			uint64 numBlocks = (dataSize + m_format.nBlockAlign - 1) / m_format.nBlockAlign;
+			m_pcm.resize((size_t)(numBlocks * m_framesPerBlock * 2));
+			for(size_t offset = 0; offset < dataSize; offset += m_format.nBlockAlign)
+			{
+				uint32 blockSize = (uint32)Math::Min<size_t>(m_format.nBlockAlign, dataSize - offset);
+				uint32 decoded = DecodeMSADPCMBlock(data + offset, blockSize, numChannels, m_framesPerBlock, m_pcm.data() + numFrames * numChannels);
+				if(decoded == 0)
+					break;
+				numFrames += decoded;
 			}
+			// The last block can be padded
+			if(m_factFrames > 0)
+				numFrames = Math::Min<uint64>(numFrames, m_factFrames);
+		}
+		else
+		{
+			void(*convert)(const uint8*, uint64, float*) = nullptr;
+			if(m_format.nFormat == PCM && m_format.nBitsPerSample == 8)
+				convert = ConvertU8;
+			else if(m_format.nFormat == PCM && m_format.nBitsPerSample == 16)
+				convert = ConvertS16;
+			else if(m_format.nFormat == PCM && m_format.nBitsPerSample == 24)
+				convert = ConvertS24;
+			else if(m_format.nFormat == PCM && m_format.nBitsPerSample == 32)
+				convert = ConvertS32;
+			else if(m_format.nFormat == IEEEFloat && m_format.nBitsPerSample == 32)
+				convert = ConvertF32;
 			else
+				return false;
+			numFrames = dataSize / (m_format.nBitsPerSample / 8 * numChannels);
+			m_pcm.resize((size_t)(numFrames * 2));
+			convert(data, numFrames * numChannels, m_pcm.data());
+		}
+
+		if(numChannels == 1)
+		{
+			// Spread out back to front, every frame is read before it is overwritten
+			float* pcm = m_pcm.data();
+			for(uint64 i = numFrames; i-- > 0;)
 			{
-				stream.Skip(chunkHdr.nLength);
+				float sample = pcm[i];
+				pcm[i * 2] = sample;
+				pcm[i * 2 + 1] = sample;
 			}
 		}
+		m_pcm.resize((size_t)(numFrames * 2));
 
-		// Calculate the sample step if the rate is not the same as the output rate
-		double sampleStep = (double)m_format.nSampleRate / (double)m_audio->GetSampleRate();
-		m_sampleStepIncrement = (uint64)(sampleStep * (double)fp_sampleStep);
+		if(m_format.nSampleRate != m_sampleRate && numFrames > 0)
+			m_Resample(numFrames);
 
+		m_samples = m_pcm.data();
+		m_length = m_pcm.size() / 2;
 		return true;
 	}
+	// Linear interpolation to the output sample rate
+	void m_Resample(uint64 numFrames)
+	{
+		uint64 sampleStepIncrement = (uint64)((double)m_format.nSampleRate / (double)m_sampleRate * (double)fp_sampleStep);
+		uint64 numResampled = numFrames * m_sampleRate / m_format.nSampleRate;
+		Vector<float> resampled;
+		resampled.resize((size_t)(numResampled * 2));
+		uint64 sampleStep = 0;
+		uint64 position = 0;
+		const float* pcm = m_pcm.data();
+		for(uint64 i = 0; i < numResampled; i++)
+		{
+			uint64 next = Math::Min(position + 1, numFrames - 1);
+			float t = (float)((double)sampleStep / (double)fp_sampleStep);
+			resampled[i * 2] = pcm[position * 2] + (pcm[next * 2] - pcm[position * 2]) * t;
+			resampled[i * 2 + 1] = pcm[position * 2 + 1] + (pcm[next * 2 + 1] - pcm[position * 2 + 1]) * t;
+
+			sampleStep += sampleStepIncrement;
+			position += sampleStep / fp_sampleStep;
+			sampleStep %= fp_sampleStep;
+		}
+		m_pcm = std::move(resampled);
+	}
 	virtual void Process(float* out, uint32 numSamples) override
 	{
 		if(!m_playing)
 			return;
 
 		m_lock.lock();
-		if(m_format.nChannels == 2)
+		// Samples are already in the output format, so this is only a copy that wraps around when looping
+		uint32 written = 0;
+		while(written < numSamples)
 		{
-			// Mix stereo sample
-			for(uint32 i = 0; i < numSamples; i++)
+			if(m_playbackPointer >= m_length)
 			{
-				if(m_playbackPointer >= m_length)
+				if(m_looping && m_length > 0)
 				{
-					if(m_looping)
-					{
-						m_playbackPointer = 0;
-					}
-					else
-					{
-						// Playback ended
-						m_playing = false;
-						break;
-					}
+					m_playbackPointer = 0;
 				}
-
-				int16* src = ((int16*)m_pcm.data()) + m_playbackPointer;
-				out[i * 2] = (float)src[0] / (float)0x7FFF;
-				out[i * 2 + 1] = (float)src[1] / (float)0x7FFF;
-
-				// Increment source sample with resampling
-				m_sampleStep += m_sampleStepIncrement;
-				while(m_sampleStep >= fp_sampleStep)
+				else
 				{
-					m_playbackPointer += 2;
-					m_sampleStep -= fp_sampleStep;
+					// Playback ended
+					m_playing = false;
+					break;
 				}
 			}
-		}
-		else 
-		{
-			// Mix mono sample
-			for(uint32 i = 0; i < numSamples; i++)
-			{
-				if(m_playbackPointer >= m_length)
-				{
-					if(m_looping)
-					{
-						m_playbackPointer = 0;
-					}
-					else
-					{
-						// Playback ended
-						m_playing = false;
-						break;
-					}
-				}
-
-				int16* src = ((int16*)m_pcm.data()) + m_playbackPointer;
-				out[i * 2] = (float)src[0] / (float)0x7FFF;
-				out[i * 2 + 1] = (float)src[0] / (float)0x7FFF;
 
-				// Increment source sample with resampling
-				m_sampleStep += m_sampleStepIncrement;
-				while(m_sampleStep >= fp_sampleStep)
-				{
-					m_playbackPointer += 1;
-					m_sampleStep -= fp_sampleStep;
-				}
-			}
+			uint32 count = (uint32)Math::Min<uint64>(numSamples - written, m_length - m_playbackPointer);
+			memcpy(out + written * 2, m_samples + m_playbackPointer * 2, sizeof(float) * 2 * count);
+			m_playbackPointer += count;
+			written += count;
 		}
 		m_lock.unlock();
 	}
-	const Buffer& GetData() const
+	const float* GetSamples() const
+	{
+		return m_samples;
+	}
+	uint64 GetLength() const
 	{
-		return m_pcm;
+		return m_length;
+	}
+	double GetLoadTime() const
+	{
+		return m_loadTime;
+	}
+	bool IsMapped() const
+	{
+		return m_mappedFile.IsOpen();
 	}
 	uint32 GetBitsPerSample() const
 	{
@@ -345,13 +386,21 @@ public:
 	}
 	uint32 GetSampleRate() const
 	{
-		return m_format.nSampleRate;
+		return m_sampleRate;
 	}
 
+	void m_LogLoaded(const String& name)
+	{
+		static const char* formatNames[] = { "unknown", "PCM", "MS-ADPCM", "float" };
+		const char* formatName = m_format.nFormat < 4 ? formatNames[m_format.nFormat] : formatNames[0];
+		Logf("Loaded sample \"%s\" (%s %d bit, %d channels, %d Hz%s) in %.2f ms", Logger::Info, name, formatName,
+			m_format.nBitsPerSample, m_format.nChannels, m_format.nSampleRate, IsMapped() ? ", mapped" : "", m_loadTime);
+	}
 };
 
 Sample SampleRes::Create(Audio* audio, const String& path)
 {
+	Timer timer;
 	Sample_Impl* res = new Sample_Impl();
 	res->m_audio = audio;
 
@@ -360,8 +409,28 @@ Sample SampleRes::Create(Audio* audio, const String& path)
 		delete res;
 		return Sample();
 	}
+	res->m_loadTime = timer.SecondsAsDouble() * 1000.0;
+	res->m_LogLoaded(path);
 
 	audio->GetImpl()->Register(res);
 
 	return Sample(res);
-}
\ No newline at end of file
+}
+Sample SampleRes::Create(Audio* audio, const uint8* data, size_t size, const String& name)
+{
+	Timer timer;
+	Sample_Impl* res = new Sample_Impl();
+	res->m_audio = audio;
+
+	if(!res->Init(data, size, false))
+	{
+		delete res;
+		return Sample();
+	}
+	res->m_loadTime = timer.SecondsAsDouble() * 1000.0;
+	res->m_LogLoaded(name);
+
+	audio->GetImpl()->Register(res);
+
+	return Sample(res);
+}
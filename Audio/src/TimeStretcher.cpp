@@ -0,0 +1,182 @@
+#include "stdafx.h"
+#include "TimeStretcher.hpp"
+#include "SoundTouch.h"
+using namespace soundtouch;
+
+// Frames given to SoundTouch at once
+static const uint32 feedFrames = 1024;
+
+TimeStretcher::TimeStretcher(const float* pcm, int64 numFrames, uint32 sampleRate)
+{
+	m_pcm = pcm;
+	m_numFrames = numFrames;
+	m_sampleRate = sampleRate;
+	m_chunks = new Chunk[numChunks];
+
+	m_soundtouch = new SoundTouch();
+	m_soundtouch->setChannels(2);
+	m_soundtouch->setSampleRate(sampleRate);
+	// Seeking with the quick search keeps the cost low enough to run alongside the game at any tempo
+	m_soundtouch->setSetting(SETTING_USE_QUICKSEEK, 1);
+	m_soundtouch->setSetting(SETTING_USE_AA_FILTER, 0);
+}
+TimeStretcher::~TimeStretcher()
+{
+	Stop();
+	delete m_soundtouch;
+	delete[] m_chunks;
+}
+
+void TimeStretcher::Start()
+{
+	if(m_running)
+		return;
+	m_running = true;
+	m_thread = Thread(&TimeStretcher::m_Worker, this);
+}
+void TimeStretcher::Stop()
+{
+	if(!m_running)
+		return;
+	m_running = false;
+	if(m_thread.joinable())
+		m_thread.join();
+}
+
+void TimeStretcher::SetTempo(float tempo)
+{
+	m_tempo = tempo;
+}
+float TimeStretcher::GetTempo() const
+{
+	return m_tempo;
+}
+void TimeStretcher::SetLoop(int64 start, int64 end)
+{
+	m_loopStart = Math::Max<int64>(start, 0);
+	m_loopEnd = Math::Min(end, m_numFrames);
+}
+void TimeStretcher::Seek(int64 frame)
+{
+	m_seekFrame = Math::Clamp<int64>(frame, 0, m_numFrames);
+	m_seekIndex++;
+}
+
+bool TimeStretcher::Read(float* left, float* right, ReadInfo& info)
+{
+	uint32 seekIndex = m_seekIndex;
+	while(true)
+	{
+		uint32 readCount = m_readCount.load(std::memory_order_relaxed);
+		if(readCount == m_writeCount.load(std::memory_order_acquire))
+			return false;
+
+		// Chunks from before the last seek are skipped
+		const Chunk& chunk = m_chunks[readCount % numChunks];
+		bool current = chunk.seekIndex == seekIndex;
+		if(current)
+		{
+			for(uint32 i = 0; i < chunk.info.numFrames; i++)
+			{
+				left[i] = chunk.samples[i * 2];
+				right[i] = chunk.samples[i * 2 + 1];
+			}
+			info = chunk.info;
+		}
+		m_readCount.store(readCount + 1, std::memory_order_release);
+		if(current)
+			return true;
+	}
+}
+
+bool TimeStretcher::Render()
+{
+	uint32 seekIndex = m_seekIndex;
+	if(seekIndex != m_workerSeekIndex)
+	{
+		m_workerSeekIndex = seekIndex;
+		m_soundtouch->clear();
+		m_inputPosition = m_seekFrame;
+		m_outputPosition = (double)m_inputPosition;
+		m_inputEnded = false;
+		m_ended = false;
+	}
+	if(m_ended)
+		return false;
+	if(m_writeCount.load(std::memory_order_relaxed) - m_readCount.load(std::memory_order_acquire) >= numChunks)
+		return false;
+
+	Timer timer;
+	float tempo = m_tempo;
+	if(tempo != m_tempoApplied)
+	{
+		m_soundtouch->setTempo(tempo);
+		m_tempoApplied = tempo;
+	}
+	while(m_soundtouch->numSamples() < chunkFrames && !m_inputEnded)
+		m_FeedInput();
+
+	Chunk& chunk = m_chunks[m_writeCount.load(std::memory_order_relaxed) % numChunks];
+	ReadInfo& info = chunk.info;
+	info.numFrames = m_soundtouch->receiveSamples(chunk.samples, chunkFrames);
+	info.sourceStart = m_outputPosition;
+	info.sourceEnd = m_outputPosition + (double)info.numFrames * tempo;
+	info.loopCount = m_loopCount;
+	info.end = m_inputEnded && m_soundtouch->numSamples() == 0;
+	chunk.seekIndex = seekIndex;
+	m_ended = info.end;
+
+	// The output follows the input at the nominal tempo, it jumps back once it passes the end of the loop like the input did
+	m_outputPosition = info.sourceEnd;
+	int64 loopStart = m_loopStart, loopEnd = m_loopEnd;
+	if(loopEnd > loopStart && m_outputPosition >= (double)loopEnd)
+	{
+		m_outputPosition -= (double)(loopEnd - loopStart);
+		m_loopCount++;
+	}
+
+	m_writeCount.store(m_writeCount.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+	if(info.numFrames > 0)
+	{
+		float load = (float)(timer.SecondsAsDouble() * (double)m_sampleRate / (double)info.numFrames);
+		m_load = m_load * 0.95f + load * 0.05f;
+	}
+	return true;
+}
+float TimeStretcher::GetLoad() const
+{
+	return m_load;
+}
+
+void TimeStretcher::m_Worker()
+{
+	while(m_running)
+	{
+		if(!Render())
+			std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+}
+void TimeStretcher::m_FeedInput()
+{
+	int64 end = m_numFrames;
+	int64 loopStart = m_loopStart, loopEnd = m_loopEnd;
+	bool looping = loopEnd > loopStart;
+	if(looping)
+		end = loopEnd;
+	if(m_inputPosition >= end)
+	{
+		if(!looping)
+		{
+			// Push out what SoundTouch still holds
+			m_soundtouch->flush();
+			m_inputEnded = true;
+			return;
+		}
+		m_inputPosition = loopStart;
+	}
+
+	uint32 numFrames = (uint32)Math::Min<int64>(feedFrames, end - m_inputPosition);
+	m_soundtouch->putSamples(m_pcm + m_inputPosition * 2, numFrames);
+	m_inputPosition += numFrames;
+}
@@ -21,7 +21,7 @@ static const uint32_t freq = 44100;
 static const uint32_t channels = 2;
 static const uint32_t numBuffers = 2;
 static const uint32_t bufferLength = 10;
-static const REFERENCE_TIME bufferDuration = (REFERENCE_TIME)(bufferLength * REFTIMES_PER_MILLISEC);
+static const REFERENCE_TIME defaultBufferDuration = (REFERENCE_TIME)(bufferLength * REFTIMES_PER_MILLISEC);
 
 // Object that handles the addition/removal of audio devices
 class NotificationClient : public IMMNotificationClient
@@ -64,6 +64,8 @@ public:
 	NotificationClient m_notificationClient;
 
 	double m_bufferLength;
+	// Requested length of the device buffer
+	REFERENCE_TIME m_bufferDuration = defaultBufferDuration;
 
 	// Dummy audio output
 	static const uint32 m_dummyChannelCount = 2;
@@ -121,9 +123,10 @@ public:
 			m_audioThread.join();
 	}
 
-	bool Init(bool exclusive)
+	bool Init(bool exclusive, uint32 bufferSize)
 	{
 		m_exclusive = exclusive;
+		SetBufferDuration(bufferSize);
 
 		// Initialize the WASAPI device enumerator
 		HRESULT res;
@@ -145,6 +148,13 @@ public:
 		m_deviceEnumerator->GetDefaultAudioEndpoint(EDataFlow::eRender, ERole::eMultimedia, &defaultDevice);		
 		return OpenDevice(defaultDevice);
 	}	
+	void SetBufferDuration(uint32 bufferSize)
+	{
+		if(bufferSize > 0)
+			m_bufferDuration = (REFERENCE_TIME)((double)bufferSize * (double)REFTIMES_PER_SEC / (double)freq);
+		else
+			m_bufferDuration = defaultBufferDuration;
+	}
 	void CloseDevice()
 	{
 		if(m_audioClient)
@@ -253,13 +263,13 @@ public:
 			}
 			// Init client
 			res = m_audioClient->Initialize(AUDCLNT_SHAREMODE_EXCLUSIVE, 0,
-				bufferDuration, defaultDevicePeriod, mixFormat, nullptr);
+				m_bufferDuration, defaultDevicePeriod, mixFormat, nullptr);
 		}
 		else
 		{
 			// Init client
 			res = m_audioClient->Initialize(AUDCLNT_SHAREMODE_SHARED, 0,
-				bufferDuration, 0, mixFormat, nullptr);
+				m_bufferDuration, 0, mixFormat, nullptr);
 		}
 		// Store selected format
 		m_format = *mixFormat;
@@ -377,8 +387,9 @@ public:
 			uint32 numSamples;
 			if(Begin(data, numSamples))
 			{
+				// The rest of the buffer is still queued
 				if(m_mixer)
-					m_mixer->Mix(data, numSamples);
+					m_mixer->Mix(data, numSamples, m_device ? m_numBufferFrames - numSamples : numSamples);
 				End(numSamples);
 			}
 			std::this_thread::sleep_for(std::chrono::microseconds(100));
@@ -421,9 +432,20 @@ AudioOutput::~AudioOutput()
 {
 	delete m_impl;
 }
-bool AudioOutput::Init(bool exclusive)
+bool AudioOutput::Init(bool exclusive, uint32 bufferSize)
 {
-	return m_impl->Init(exclusive);
+	return m_impl->Init(exclusive, bufferSize);
+}
+bool AudioOutput::SetBufferSize(uint32 bufferSize)
+{
+	if(!m_impl->m_device)
+		return false;
+	// Reopened on the audio thread, like a device change
+	m_impl->SetBufferDuration(bufferSize);
+	m_impl->m_device->AddRef();
+	m_impl->m_pendingDevice = m_impl->m_device;
+	m_impl->m_pendingDeviceChange = true;
+	return true;
 }
 void AudioOutput::Start(IMixer* mixer)
 {
@@ -106,6 +106,25 @@ typedef struct _vlc {
     int table_size, table_allocated;
 } vlc_t;
 
+typedef struct _granule {
+    uint8_t scfsi;
+    int part2_3_length;
+    int big_values;
+    int global_gain;
+    int scalefac_compress;
+    uint8_t block_type;
+    uint8_t switch_point;
+    int table_select[3];
+    int subblock_gain[3];
+    uint8_t scalefac_scale;
+    uint8_t count1table_select;
+    int region_size[3];
+    int preflag;
+    int short_start, long_end;
+    uint8_t scale_factors[40];
+    int32_t sb_hybrid[SBLIMIT * 18];
+} granule_t;
+
 typedef struct _mp3_context {
     uint8_t last_buf[2*BACKSTEP_SIZE + EXTRABYTES];
     int last_buf_size;
@@ -126,27 +145,11 @@ typedef struct _mp3_context {
     int32_t sb_samples[MP3_MAX_CHANNELS][36][SBLIMIT];
     int32_t mdct_buf[MP3_MAX_CHANNELS][SBLIMIT * 18];
     int dither_state;
+    /* layer 3 state kept between frames, per decoder so several streams can be decoded at the same time */
+    granule_t granules[2][2];
+    int16_t exponents[576];
 } mp3_context_t;
 
-typedef struct _granule {
-    uint8_t scfsi;
-    int part2_3_length;
-    int big_values;
-    int global_gain;
-    int scalefac_compress;
-    uint8_t block_type;
-    uint8_t switch_point;
-    int table_select[3];
-    int subblock_gain[3];
-    uint8_t scalefac_scale;
-    uint8_t count1table_select;
-    int region_size[3];
-    int preflag;
-    int short_start, long_end;
-    uint8_t scale_factors[40];
-    int32_t sb_hybrid[SBLIMIT * 18];
-} granule_t;
-
 typedef struct _huff_table {
     int xsize;
     const uint8_t *bits;
@@ -2106,8 +2109,8 @@ static int mp_decode_layer3(mp3_context_t *s) {
     int nb_granules, main_data_begin, private_bits;
     int gr, ch, blocksplit_flag, i, j, k, n, bits_pos;
     granule_t *g;
-    static granule_t granules[2][2];
-    static int16_t exponents[576];
+    granule_t (*granules)[2] = s->granules;
+    int16_t *exponents = s->exponents;
     const uint8_t *ptr;
 
     if (s->lsf) {
@@ -2642,6 +2645,11 @@ void mp3_done(mp3_decoder_t *dec) {
     if (dec) libc_free(dec);
 }
 
+void mp3_reset(mp3_decoder_t *dec) {
+    /* a cleared context is the same as a freshly created one */
+    if (dec) libc_memset(dec, 0, sizeof(mp3_context_t));
+}
+
 int mp3_decode(mp3_decoder_t *dec, void *buf, int bytes, signed short *out, mp3_info_t *info) {
     int res, size = -1;
     mp3_context_t *s = (mp3_context_t*) dec;
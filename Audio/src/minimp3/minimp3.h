@@ -17,6 +17,8 @@ extern const uint16_t mp3_freq_tab[3];
 extern mp3_decoder_t mp3_create(void);
 extern int mp3_decode(mp3_decoder_t *dec, void *buf, int bytes, signed short *out, mp3_info_t *info);
 extern void mp3_done(mp3_decoder_t *dec);
+/* Forgets the bit reservoir and the overlap of the frames decoded so far, call it before decoding from another position */
+extern void mp3_reset(mp3_decoder_t *dec);
 #define mp3_free(dec) do { mp3_done(dec); dec = NULL; } while(0)
 
 #endif//__MINIMP3_H_INCLUDED__
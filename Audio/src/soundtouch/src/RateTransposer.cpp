@@ -78,6 +78,7 @@ RateTransposer::~RateTransposer()
 void RateTransposer::enableAAFilter(bool newMode)
 {
     bUseAAFilter = newMode;
+    if (bUseAAFilter) setRate(pTransposer->rate);
 }
 
 
@@ -103,6 +104,10 @@ void RateTransposer::setRate(double newRate)
 
     pTransposer->setRate(newRate);
 
+    // Designing the filter allocates, skip it while the filter isn't used so rate changes are real-time safe
+    // (enableAAFilter designs it when the filter is turned on again)
+    if (bUseAAFilter == false) return;
+
     // design a new anti-alias filter
     if (newRate > 1.0) 
     {
@@ -94,6 +94,9 @@ public:
 private:
 	bool m_ProcessKShootMap(BinaryStream& input, bool metadataOnly);
 	bool m_Serialize(BinaryStream& stream, bool metadataOnly);
+	// Moves the loaded objects into arrays per type, in the order they appear in the map, so iterating them doesn't jump around in memory
+	void m_CompactObjects();
+	void m_DeleteObjects();
 
 	Map<EffectType, AudioEffect> m_customEffects;
 	Map<EffectType, AudioEffect> m_customFilters;
@@ -102,6 +105,12 @@ private:
 	Vector<ChartStop*> m_chartStops;
 	Vector<LaneHideTogglePoint*> m_laneTogglePoints;
 	Vector<ObjectState*> m_objectStates;
+	// Storage of the objects in m_objectStates once the map is loaded, before that they are allocated separately
+	Vector<ButtonObjectState> m_buttonObjects;
+	Vector<HoldObjectState> m_holdObjects;
+	Vector<LaserObjectState> m_laserObjects;
+	Vector<EventObjectState> m_eventObjects;
+	bool m_objectsCompacted = false;
 	Vector<ZoomControlPoint*> m_zoomControlPoints;
 	Vector<String> m_samplePaths;
 	BeatmapSettings m_settings;
@@ -1,6 +1,25 @@
 #pragma once
 #include "Beatmap.hpp"
 
+/*
+	Non-owning view of an array of objects
+*/
+struct ObjectSpan
+{
+	ObjectSpan() = default;
+	ObjectSpan(ObjectState* const* data, size_t count) : m_data(data), m_count(count) {};
+
+	ObjectState* const* begin() const { return m_data; }
+	ObjectState* const* end() const { return m_data + m_count; }
+	ObjectState* operator[](size_t index) const { return m_data[index]; }
+	size_t size() const { return m_count; }
+	bool empty() const { return m_count == 0; }
+
+private:
+	ObjectState* const* m_data = nullptr;
+	size_t m_count = 0;
+};
+
 /*
 	Manages the iteration over beatmaps
 */
@@ -20,8 +39,8 @@ public:
 	// if it is a new timing point, this is used for the new BPM
 	void Update(MapTime newTime);
 
-	// Modifyable array of all hittable objects, within -+'hittableObjectTreshold' of current time
-	Set<ObjectState*>& GetHittableObjects();
+	// Modifyable array of all hittable objects, within -+'hittableObjectTreshold' of current time, in the order they became hittable
+	Vector<ObjectState*>& GetHittableObjects();
 	MapTime hittableObjectEnter = 500;
 	MapTime hittableLaserEnter = 1000;
 	MapTime hittableObjectLeave = 500;
@@ -31,12 +50,21 @@ public:
 	float cModSpeed = 400;
 
 
-	// Gets all linear objects that fall within the given time range:
+	// Gets all linear objects that fall within the given time range, in map order:
 	//	<curr - keepObjectDuration, curr + range>
 	Vector<ObjectState*> GetObjectsInRange(MapTime range);
 	// Duration for objects to keep being returned by GetObjectsInRange after they have passed the current time
 	MapTime keepObjectDuration = 1000;
 
+	// Same objects as GetObjectsInRange, grouped in the order they are drawn:
+	//	fx holds -> bt holds -> fx chips -> bt chips -> lasers and events
+	// The window is updated as objects enter and leave it instead of being built every frame,
+	//	the returned span stays valid until the next call to Update, Reset or this function
+	ObjectSpan GetObjectsInView(MapTime range);
+	// Group of an object in GetObjectsInView, lower groups are drawn first
+	static uint32 GetRenderGroup(const ObjectState* obj);
+	static const uint32 numRenderGroups = 5;
+
 	// Get the timing point at the current time
 	const TimingPoint& GetCurrentTimingPoint() const;
 	// Get the timing point at a given time
@@ -114,6 +142,12 @@ private:
 	bool IsEndLaneToggle(LaneHideTogglePoint ** obj);
 	bool IsEndZoomPoint(ZoomControlPoint** obj);
 
+	void m_AddHoldObject(ObjectState** obj);
+	void m_RemoveHoldFromView(ObjectState** obj);
+	bool m_IsHoldObject(ObjectState** obj) const;
+	void m_ViewInsert(ObjectState* obj);
+	void m_ViewRemove(ObjectState* obj);
+
 	// Current map position of this playback object
 	MapTime m_playbackTime;
 	Vector<TimingPoint*> m_timingPoints;
@@ -134,12 +168,22 @@ private:
 	ZoomControlPoint* m_zoomStartPoints[4] = { nullptr };
 	ZoomControlPoint* m_zoomEndPoints[4] = { nullptr };
 
+	// These only contain a few objects at a time, so they are small arrays instead of trees
 	// Contains all the objects that are in the current valid timing area
-	Set<ObjectState*> m_hittableObjects;
+	Vector<ObjectState*> m_hittableObjects;
 	// Hold objects to render even when their start time is not in the current visibility range
-	Set<ObjectState*> m_holdObjects;
+	//	positions in m_objects, kept sorted so they can be merged with the upcoming objects
+	Vector<ObjectState**> m_holdObjects;
 	// Hold buttons with effects that are active
-	Set<ObjectState*> m_effectObjects;
+	Vector<ObjectState*> m_effectObjects;
+
+	// Objects returned by GetObjectsInView, these are the hold objects and the objects in <m_viewBegin, m_viewEnd>
+	//	sorted by render group, within a group the objects are ordered by address which is map order for objects of the same type
+	Vector<ObjectState*> m_viewObjects;
+	// Start of every render group in m_viewObjects, the last entry is the end of the array
+	uint32 m_viewGroups[numRenderGroups + 1] = { 0 };
+	ObjectState** m_viewBegin = nullptr;
+	ObjectState** m_viewEnd = nullptr;
 
 	// Current state of events
 	Map<EventKey, EventData> m_eventMapping;
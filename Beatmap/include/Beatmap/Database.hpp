@@ -17,6 +17,7 @@ public:
 	double DoubleColumn(int32 index = 0) const;
 	String StringColumn(int32 index = 0) const;
 	Buffer BlobColumn(int32 index = 0) const;
+	bool IsNullColumn(int32 index = 0) const;
 	void BindInt(int32 index, const int32& value);
 	void BindInt64(int32 index, const int64& value);
 	void BindDouble(int32 index, const double& value);
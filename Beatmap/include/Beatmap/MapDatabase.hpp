@@ -1,5 +1,6 @@
 #pragma once
 #include "Beatmap.hpp"
+#include <functional>
 
 struct SimpleHitStat
 {
@@ -29,6 +30,16 @@ struct ScoreIndex
 	uint64 timestamp;
 };
 
+// Loudness of the music of a difficulty, measured by the library scan when a loudness analyzer is set
+struct LoudnessInfo
+{
+	// Integrated loudness in LUFS (EBU R128)
+	float integrated = 0.0f;
+	// True peak in dBTP
+	float truePeak = 0.0f;
+	// False until the music was measured
+	bool measured = false;
+};
 
 // Single difficulty of a map
 // a single map may contain multiple difficulties
@@ -44,6 +55,8 @@ struct DifficultyIndex
 	uint64 lwt;
 	// Map metadata
 	BeatmapSettings settings;
+	// Loudness of the music
+	LoudnessInfo loudness;
 	// Map scores
 	Vector<ScoreIndex*> scores;
 
@@ -89,6 +102,13 @@ public:
 	void AddScore(const DifficultyIndex& diff, int score, int crit, int almost, int miss, float gauge, uint32 gameflags, Vector<SimpleHitStat> simpleHitStats, uint64 timestamp);
 	void RemoveSearchPath(const String& path);
 
+	// Decodes an audio file and measures it, returns false if the file can't be decoded
+	//	called from multiple threads at once
+	typedef std::function<bool(const String& audioPath, LoudnessInfo& loudness)> LoudnessAnalyzer;
+	// After scanning, measures the music of every difficulty that wasn't measured yet on <numThreads> threads
+	//	the database doesn't decode audio itself, set this before StartSearching
+	void SetLoudnessAnalyzer(LoudnessAnalyzer analyzer, uint32 numThreads);
+
 
 	Delegate<String> OnSearchStatusUpdated;
 	// (mapId, mapIndex)
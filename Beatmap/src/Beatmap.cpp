@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Beatmap.hpp"
 #include "Shared/Profiling.hpp"
+#include <unordered_map>
 
 static const uint32 c_mapVersion = 1;
 
@@ -9,8 +10,7 @@ Beatmap::~Beatmap()
 	// Perform cleanup
 	for(auto tp : m_timingPoints)
 		delete tp;
-	for(auto obj : m_objectStates)
-		delete obj;
+	m_DeleteObjects();
 	for (auto z : m_zoomControlPoints)
 		delete z;
 	for (auto z : m_laneTogglePoints)
@@ -20,6 +20,11 @@ Beatmap::Beatmap(Beatmap&& other)
 {
 	m_timingPoints = std::move(other.m_timingPoints);
 	m_objectStates = std::move(other.m_objectStates);
+	m_buttonObjects = std::move(other.m_buttonObjects);
+	m_holdObjects = std::move(other.m_holdObjects);
+	m_laserObjects = std::move(other.m_laserObjects);
+	m_eventObjects = std::move(other.m_eventObjects);
+	m_objectsCompacted = other.m_objectsCompacted;
 	m_zoomControlPoints = std::move(other.m_zoomControlPoints);
 	m_laneTogglePoints = std::move(other.m_laneTogglePoints);
 	m_settings = std::move(other.m_settings);
@@ -29,12 +34,16 @@ Beatmap& Beatmap::operator=(Beatmap&& other)
 	// Perform cleanup
 	for(auto tp : m_timingPoints)
 		delete tp;
-	for(auto obj : m_objectStates)
-		delete obj;
+	m_DeleteObjects();
 	for(auto z : m_zoomControlPoints)
 		delete z;
 	m_timingPoints = std::move(other.m_timingPoints);
 	m_objectStates = std::move(other.m_objectStates);
+	m_buttonObjects = std::move(other.m_buttonObjects);
+	m_holdObjects = std::move(other.m_holdObjects);
+	m_laserObjects = std::move(other.m_laserObjects);
+	m_eventObjects = std::move(other.m_eventObjects);
+	m_objectsCompacted = other.m_objectsCompacted;
 	m_zoomControlPoints = std::move(other.m_zoomControlPoints);
 	m_laneTogglePoints = std::move(other.m_laneTogglePoints);
 	m_settings = std::move(other.m_settings);
@@ -52,6 +61,7 @@ bool Beatmap::Load(BinaryStream& input, bool metadataOnly)
 			return false;
 	}
 
+	m_CompactObjects();
 	return true;
 }
 bool Beatmap::Save(BinaryStream& output) const
@@ -61,6 +71,108 @@ bool Beatmap::Save(BinaryStream& output) const
 	return const_cast<Beatmap*>(this)->m_Serialize(output, false);
 }
 
+// Objects are allocated as their own type, so they need to be deleted as that type too
+static void DeleteObject(ObjectState* obj)
+{
+	switch(obj->type)
+	{
+	case ObjectType::Single:
+		delete (ButtonObjectState*)obj;
+		break;
+	case ObjectType::Hold:
+		delete (HoldObjectState*)obj;
+		break;
+	case ObjectType::Laser:
+		delete (LaserObjectState*)obj;
+		break;
+	case ObjectType::Event:
+		delete (EventObjectState*)obj;
+		break;
+	default:
+		delete obj;
+		break;
+	}
+}
+
+void Beatmap::m_CompactObjects()
+{
+	if(m_objectsCompacted)
+		return;
+
+	size_t counts[5] = { 0 };
+	for(ObjectState* obj : m_objectStates)
+		counts[(size_t)obj->type]++;
+	m_buttonObjects.reserve(counts[(size_t)ObjectType::Single]);
+	m_holdObjects.reserve(counts[(size_t)ObjectType::Hold]);
+	m_laserObjects.reserve(counts[(size_t)ObjectType::Laser]);
+	m_eventObjects.reserve(counts[(size_t)ObjectType::Event]);
+
+	// Copy in map order, the arrays are reserved so pointers into them stay valid
+	std::unordered_map<ObjectState*, ObjectState*> moved;
+	moved.reserve(m_objectStates.size());
+	Vector<ObjectState*> objects;
+	objects.reserve(m_objectStates.size());
+	for(ObjectState* obj : m_objectStates)
+	{
+		ObjectState* copy = nullptr;
+		switch(obj->type)
+		{
+		case ObjectType::Single:
+			copy = (ObjectState*)&m_buttonObjects.Add(*(ButtonObjectState*)obj);
+			break;
+		case ObjectType::Hold:
+			copy = (ObjectState*)&m_holdObjects.Add(*(HoldObjectState*)obj);
+			break;
+		case ObjectType::Laser:
+			copy = (ObjectState*)&m_laserObjects.Add(*(LaserObjectState*)obj);
+			break;
+		case ObjectType::Event:
+			copy = (ObjectState*)&m_eventObjects.Add(*(EventObjectState*)obj);
+			break;
+		default:
+			assert(false);
+			break;
+		}
+		moved[obj] = copy;
+		objects.Add(copy);
+	}
+
+	// Point linked holds and lasers to their copies
+	for(HoldObjectState& hold : m_holdObjects)
+	{
+		if(hold.next)
+			hold.next = (HoldObjectState*)moved[(ObjectState*)hold.next];
+		if(hold.prev)
+			hold.prev = (HoldObjectState*)moved[(ObjectState*)hold.prev];
+	}
+	for(LaserObjectState& laser : m_laserObjects)
+	{
+		if(laser.next)
+			laser.next = (LaserObjectState*)moved[(ObjectState*)laser.next];
+		if(laser.prev)
+			laser.prev = (LaserObjectState*)moved[(ObjectState*)laser.prev];
+	}
+
+	for(ObjectState* obj : m_objectStates)
+		DeleteObject(obj);
+	m_objectStates = std::move(objects);
+	m_objectsCompacted = true;
+}
+void Beatmap::m_DeleteObjects()
+{
+	if(!m_objectsCompacted)
+	{
+		for(auto obj : m_objectStates)
+			DeleteObject(obj);
+	}
+	m_objectStates.clear();
+	m_buttonObjects.clear();
+	m_holdObjects.clear();
+	m_laserObjects.clear();
+	m_eventObjects.clear();
+	m_objectsCompacted = false;
+}
+
 const BeatmapSettings& Beatmap::GetMapSettings() const
 {
 	return m_settings;
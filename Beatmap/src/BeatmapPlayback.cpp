@@ -38,6 +38,10 @@ bool BeatmapPlayback::Reset(MapTime startTime)
 	//alertLaserThreshold = (*m_currentTiming)->beatDuration * 6.0;
 	m_hittableObjects.clear();
 	m_holdObjects.clear();
+	m_viewObjects.clear();
+	memset(m_viewGroups, 0, sizeof(m_viewGroups));
+	m_viewBegin = m_currentObj;
+	m_viewEnd = m_currentObj;
 
 	m_barTime = 0;
 	m_beatTime = 0;
@@ -106,7 +110,7 @@ void BeatmapPlayback::Update(MapTime newTime)
 			{
 				if (obj->type == ObjectType::Hold || obj->type == ObjectType::Single)
 				{
-					m_holdObjects.Add(*obj);
+					m_AddHoldObject(it);
 				}
 				m_hittableObjects.Add(*it);
 				OnObjectEntered.Call(*it);
@@ -125,7 +129,7 @@ void BeatmapPlayback::Update(MapTime newTime)
 			MultiObjectState* obj = **it;
 			if (obj->type == ObjectType::Laser)
 			{
-				m_holdObjects.Add(*obj);
+				m_AddHoldObject(it);
 				m_hittableObjects.Add(*it);
 				OnObjectEntered.Call(*it);
 			}
@@ -177,27 +181,28 @@ void BeatmapPlayback::Update(MapTime newTime)
 		m_currentZoomPoint = objEnd;
 	}
 
-	// Check passed hittable objects
+	// Check passed hittable objects, the remaining ones are moved to the front in the same order
 	MapTime objectPassTime = m_playbackTime - hittableObjectLeave;
-	for (auto it = m_hittableObjects.begin(); it != m_hittableObjects.end();)
+	size_t numHittable = 0;
+	for (size_t i = 0; i < m_hittableObjects.size(); i++)
 	{
-		MultiObjectState* obj = **it;
+		ObjectState* it = m_hittableObjects[i];
+		MultiObjectState* obj = *it;
 		if (obj->type == ObjectType::Hold)
 		{
 			MapTime endTime = obj->hold.duration + obj->time;
 			if (endTime < objectPassTime)
 			{
-				OnObjectLeaved.Call(*it);
-				it = m_hittableObjects.erase(it);
+				OnObjectLeaved.Call(it);
 				continue;
 			}
 			if (obj->hold.effectType != EffectType::None && // Hold button with effect
 				obj->time - 100 <= m_playbackTime + audioOffset && endTime - 100 > m_playbackTime + audioOffset) // Hold button in active range
 			{
-				if (!m_effectObjects.Contains(*obj))
+				if (!m_effectObjects.Contains(it))
 				{
-					OnFXBegin.Call((HoldObjectState*)*it);
-					m_effectObjects.Add(*obj);
+					OnFXBegin.Call((HoldObjectState*)it);
+					m_effectObjects.Add(it);
 				}
 			}
 		}
@@ -205,8 +210,7 @@ void BeatmapPlayback::Update(MapTime newTime)
 		{
 			if ((obj->laser.duration + obj->time) < objectPassTime)
 			{
-				OnObjectLeaved.Call(*it);
-				it = m_hittableObjects.erase(it);
+				OnObjectLeaved.Call(it);
 				continue;
 			}
 		}
@@ -214,8 +218,7 @@ void BeatmapPlayback::Update(MapTime newTime)
 		{
 			if (obj->time < objectPassTime)
 			{
-				OnObjectLeaved.Call(*it);
-				it = m_hittableObjects.erase(it);
+				OnObjectLeaved.Call(it);
 				continue;
 			}
 		}
@@ -227,31 +230,33 @@ void BeatmapPlayback::Update(MapTime newTime)
 				// Trigger event
 				OnEventChanged.Call(evt->key, evt->data);
 				m_eventMapping[evt->key] = evt->data;
-				it = m_hittableObjects.erase(it);
 				continue;
 			}
 		}
-		it++;
+		m_hittableObjects[numHittable++] = it;
 	}
+	m_hittableObjects.resize(numHittable);
 
 	// Remove passed hold objects
-	for (auto it = m_holdObjects.begin(); it != m_holdObjects.end();)
+	size_t numHolds = 0;
+	for (size_t i = 0; i < m_holdObjects.size(); i++)
 	{
-		MultiObjectState* obj = **it;
+		ObjectState* it = *m_holdObjects[i];
+		MultiObjectState* obj = *it;
 		if (obj->type == ObjectType::Hold)
 		{
 			MapTime endTime = obj->hold.duration + obj->time;
 			if (endTime < objectPassTime)
 			{
-				it = m_holdObjects.erase(it);
+				m_RemoveHoldFromView(m_holdObjects[i]);
 				continue;
 			}
 			if (endTime < m_playbackTime)
 			{
-				if (m_effectObjects.Contains(*it))
+				if (m_effectObjects.Contains(it))
 				{
-					OnFXEnd.Call((HoldObjectState*)*it);
-					m_effectObjects.erase(*it);
+					OnFXEnd.Call((HoldObjectState*)it);
+					m_effectObjects.Remove(it);
 				}
 			}
 		}
@@ -259,7 +264,7 @@ void BeatmapPlayback::Update(MapTime newTime)
 		{
 			if ((obj->laser.duration + obj->time) < objectPassTime)
 			{
-				it = m_holdObjects.erase(it);
+				m_RemoveHoldFromView(m_holdObjects[i]);
 				continue;
 			}
 		}
@@ -267,15 +272,59 @@ void BeatmapPlayback::Update(MapTime newTime)
 		{
 			if (obj->time < objectPassTime)
 			{
-				it = m_holdObjects.erase(it);
+				m_RemoveHoldFromView(m_holdObjects[i]);
 				continue;
 			}
 		}
-		it++;
+		m_holdObjects[numHolds++] = m_holdObjects[i];
 	}
+	m_holdObjects.resize(numHolds);
 }
 
-Set<ObjectState*>& BeatmapPlayback::GetHittableObjects()
+void BeatmapPlayback::m_AddHoldObject(ObjectState** obj)
+{
+	// Lasers enter earlier than buttons, so this is not always added at the end
+	auto it = std::lower_bound(m_holdObjects.begin(), m_holdObjects.end(), obj);
+	if (it == m_holdObjects.end() || *it != obj)
+		m_holdObjects.insert(it, obj);
+	m_ViewInsert(*obj);
+}
+void BeatmapPlayback::m_RemoveHoldFromView(ObjectState** obj)
+{
+	// Objects in the time range of the view stay
+	if (obj < m_viewBegin || obj >= m_viewEnd)
+		m_ViewRemove(*obj);
+}
+bool BeatmapPlayback::m_IsHoldObject(ObjectState** obj) const
+{
+	return std::binary_search(m_holdObjects.begin(), m_holdObjects.end(), obj);
+}
+void BeatmapPlayback::m_ViewInsert(ObjectState* obj)
+{
+	uint32 group = GetRenderGroup(obj);
+	auto groupBegin = m_viewObjects.begin() + m_viewGroups[group];
+	auto groupEnd = m_viewObjects.begin() + m_viewGroups[group + 1];
+	auto it = std::lower_bound(groupBegin, groupEnd, obj);
+	if (it != groupEnd && *it == obj)
+		return;
+	m_viewObjects.insert(it, obj);
+	for (uint32 i = group + 1; i <= numRenderGroups; i++)
+		m_viewGroups[i]++;
+}
+void BeatmapPlayback::m_ViewRemove(ObjectState* obj)
+{
+	uint32 group = GetRenderGroup(obj);
+	auto groupBegin = m_viewObjects.begin() + m_viewGroups[group];
+	auto groupEnd = m_viewObjects.begin() + m_viewGroups[group + 1];
+	auto it = std::lower_bound(groupBegin, groupEnd, obj);
+	if (it == groupEnd || *it != obj)
+		return;
+	m_viewObjects.erase(it);
+	for (uint32 i = group + 1; i <= numRenderGroups; i++)
+		m_viewGroups[i]--;
+}
+
+Vector<ObjectState*>& BeatmapPlayback::GetHittableObjects()
 {
 	return m_hittableObjects;
 }
@@ -287,14 +336,11 @@ Vector<ObjectState*> BeatmapPlayback::GetObjectsInRange(MapTime range)
 	MapTime end = m_playbackTime + range;
 	MapTime begin = m_playbackTime - earlyVisiblity;
 	Vector<ObjectState*> ret;
+	ret.reserve(m_holdObjects.size() + 64);
 
-	// Add hold objects
-	for (auto& ho : m_holdObjects)
-	{
-		ret.AddUnique(ho);
-	}
-
-	// Iterator
+	// Both the hold objects and the objects after the currently queued one are in map order,
+	//	merge them and skip lasers that are in both
+	auto hold = m_holdObjects.begin();
 	ObjectState** obj = m_currentObj;
 	// Return all objects that lie after the currently queued object and fall within the given range
 	while (!IsEndObject(obj))
@@ -302,13 +348,67 @@ Vector<ObjectState*> BeatmapPlayback::GetObjectsInRange(MapTime range)
 		if ((*obj)->time > end)
 			break; // No more objects
 
-		ret.AddUnique(*obj);
+		for (; hold != m_holdObjects.end() && *hold <= obj; hold++)
+		{
+			if (*hold != obj)
+				ret.Add(**hold);
+		}
+		ret.Add(*obj);
 		obj += 1; // Next
 	}
+	for (; hold != m_holdObjects.end(); hold++)
+		ret.Add(**hold);
 
 	return ret;
 }
 
+ObjectSpan BeatmapPlayback::GetObjectsInView(MapTime range)
+{
+	// Same range as GetObjectsInRange, starting at the currently queued object
+	MapTime end = m_playbackTime + range;
+	ObjectState** newBegin = m_currentObj;
+	ObjectState** newEnd = std::max(m_viewEnd, newBegin);
+	while (!IsEndObject(newEnd) && (*newEnd)->time <= end)
+		newEnd++;
+	// The range can also get shorter when the speed changes
+	while (newEnd > newBegin && (*(newEnd - 1))->time > end)
+		newEnd--;
+
+	// Only the objects that moved in or out of the range are touched
+	//	objects that left the range stay when they are hold objects
+	ObjectState** oldBegin = m_viewBegin;
+	ObjectState** oldEnd = m_viewEnd;
+	m_viewBegin = newBegin;
+	m_viewEnd = newEnd;
+	auto RemoveRange = [&](ObjectState** from, ObjectState** to)
+	{
+		for (ObjectState** obj = from; obj < to; obj++)
+		{
+			if (!m_IsHoldObject(obj))
+				m_ViewRemove(*obj);
+		}
+	};
+	auto AddRange = [&](ObjectState** from, ObjectState** to)
+	{
+		for (ObjectState** obj = from; obj < to; obj++)
+			m_ViewInsert(*obj);
+	};
+	RemoveRange(oldBegin, std::min(oldEnd, newBegin));
+	RemoveRange(std::max(newEnd, oldBegin), oldEnd);
+	AddRange(newBegin, std::min(newEnd, oldBegin));
+	AddRange(std::max(oldEnd, newBegin), newEnd);
+
+	return ObjectSpan(m_viewObjects.data(), m_viewObjects.size());
+}
+uint32 BeatmapPlayback::GetRenderGroup(const ObjectState* obj)
+{
+	if (obj->type == ObjectType::Hold)
+		return (((ButtonObjectState*)obj)->index < 4) ? 1 : 0;
+	else if (obj->type == ObjectType::Single)
+		return (((ButtonObjectState*)obj)->index < 4) ? 3 : 2;
+	return 4;
+}
+
 const TimingPoint& BeatmapPlayback::GetCurrentTimingPoint() const
 {
 	if (!m_currentTiming)
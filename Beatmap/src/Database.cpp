@@ -83,6 +83,11 @@ Buffer DBStatement::BlobColumn(int32 index /*= 0*/) const
 	uint8* data = (uint8*)sqlite3_column_blob(m_stmt, index);
 	return Buffer(data, data + blobLen);
 }
+bool DBStatement::IsNullColumn(int32 index /*= 0*/) const
+{
+	assert(m_stmt && m_queryResult == SQLITE_ROW);
+	return sqlite3_column_type(m_stmt, index) == SQLITE_NULL;
+}
 void DBStatement::BindInt(int32 index, const int32& value)
 {
 	assert(m_stmt);
@@ -4,9 +4,12 @@
 #include "Beatmap.hpp"
 #include "Shared/Profiling.hpp"
 #include "Shared/Files.hpp"
+#include "Shared/FolderScanCache.hpp"
+#include "Shared/DirectoryWatcher.hpp"
 #include <thread>
 #include <mutex>
 #include <chrono>
+#include <atomic>
 using std::thread;
 using std::mutex;
 using namespace std;
@@ -36,13 +39,26 @@ public:
 		{
 			int32 id;
 			uint64 lwt;
+			// Full path of the music when its loudness still has to be measured
+			String unmeasuredAudio;
 		};
 		// Maps file paths to the id's and last write time's for difficulties already in the database
+		//	difficulties added by the search thread have an id of -1 until the database is updated
 		Map<String, ExistingDifficulty> difficulties;
 	} m_searchState;
 
+	// Contents of the searched folders, folders that didn't change are not listed again
+	FolderScanCache m_folderCache;
+	// Folder cache to store in the database on the next update
+	Map<String, FolderScanCache::Folder> m_pendingFolderCache;
+	bool m_folderCacheChanged = false;
+
+	// Measures chart audio after scanning, not set when loudness isn't analyzed
+	MapDatabase::LoudnessAnalyzer m_loudnessAnalyzer;
+	uint32 m_loudnessThreads = 1;
+
 	// Represents an event produced from a scan
-	//	a difficulty can be removed/added/updated
+	//	a difficulty can be removed/added/updated or get its loudness measured
 	//	a BeatmapSettings structure will be provided for added/updated events
 	struct Event
 	{
@@ -50,7 +66,8 @@ public:
 		{
 			Added,
 			Removed,
-			Updated
+			Updated,
+			Measured
 		};
 		Action action;
 		String path;
@@ -60,11 +77,13 @@ public:
 		int32 id;
 		// Scanned map data, for added/updated maps
 		BeatmapSettings* mapData = nullptr;
+		// For measured maps
+		LoudnessInfo loudness;
 	};
 	List<Event> m_pendingChanges;
 	mutex m_pendingChangesLock;
 
-	static const int32 m_version = 10;
+	static const int32 m_version = 12;
 
 public:
 	MapDatabase_Impl(MapDatabase& outer) : m_outer(outer)
@@ -118,12 +137,25 @@ public:
 				m_database.Exec("ALTER TABLE Scores ADD COLUMN timestamp INTEGER");
 				gotVersion = 10;
 			}
+			if (gotVersion == 10)  //upgrade from 10 to 11
+			{
+				m_database.Exec("CREATE TABLE Folders"
+					"(path TEXT, lwt INTEGER, contents BLOB)");
+				gotVersion = 11;
+			}
+			if (gotVersion == 11)  //upgrade from 11 to 12
+			{
+				m_database.Exec("ALTER TABLE Difficulties ADD COLUMN loudness REAL");
+				m_database.Exec("ALTER TABLE Difficulties ADD COLUMN truePeak REAL");
+				gotVersion = 12;
+			}
 			m_database.Exec(Utility::Sprintf("UPDATE Database SET `version`=%d WHERE `rowid`=1", m_version));
 		}
 		else
 		{
 			// Load initial folder tree
 			m_LoadInitialData();
+			m_LoadFolderCache();
 		}
 	}
 	~MapDatabase_Impl()
@@ -137,6 +169,8 @@ public:
 		if(m_searching)
 			return;
 
+		// Stop watching for changes, everything is scanned again
+		m_interruptSearch = true;
 		if(m_thread.joinable())
 			m_thread.join();
 
@@ -171,6 +205,12 @@ public:
 
 		m_searchPaths.erase(path);
 	}
+	void SetLoudnessAnalyzer(MapDatabase::LoudnessAnalyzer analyzer, uint32 numThreads)
+	{
+		assert(!m_thread.joinable());
+		m_loudnessAnalyzer = analyzer;
+		m_loudnessThreads = Math::Max(numThreads, 1U);
+	}
 
 	/* Thread safe event queue functions */
 	// Add a new change to the change queue
@@ -262,13 +302,22 @@ public:
 	// Processes pending database changes
 	void Update()
 	{
+		m_pendingChangesLock.lock();
+		bool folderCacheChanged = m_folderCacheChanged;
+		Map<String, FolderScanCache::Folder> folderCache = std::move(m_pendingFolderCache);
+		m_folderCacheChanged = false;
+		m_pendingChangesLock.unlock();
+		if(folderCacheChanged)
+			m_SaveFolderCache(folderCache);
+
 		List<Event> changes = FlushChanges();
 		if(changes.empty())
 			return;
 
 		DBStatement addDiff = m_database.Query("INSERT INTO Difficulties(path,lwt,metadata,rowid,mapid) VALUES(?,?,?,?,?)");
 		DBStatement addMap = m_database.Query("INSERT INTO Maps(path,artist,title,tags,rowid) VALUES(?,?,?,?,?)");
-		DBStatement update = m_database.Query("UPDATE Difficulties SET lwt=?,metadata=? WHERE rowid=?");
+		DBStatement update = m_database.Query("UPDATE Difficulties SET lwt=?,metadata=?,loudness=NULL,truePeak=NULL WHERE rowid=?");
+		DBStatement setLoudness = m_database.Query("UPDATE Difficulties SET loudness=?,truePeak=? WHERE rowid=?");
 		DBStatement removeDiff = m_database.Query("DELETE FROM Difficulties WHERE rowid=?");
 		DBStatement removeMap = m_database.Query("DELETE FROM Maps WHERE rowid=?");
 
@@ -279,6 +328,24 @@ public:
 		m_database.Exec("BEGIN");
 		for(Event& e : changes)
 		{
+			// Changes found while watching folders don't know the id's of difficulties that were added after the scan started
+			DifficultyIndex* existingDiff = m_FindDifficulty(e.path);
+			if(e.action == Event::Added && existingDiff)
+			{
+				e.action = Event::Updated;
+				e.id = existingDiff->id;
+			}
+			else if(e.action != Event::Added && e.id < 0)
+			{
+				if(!existingDiff)
+				{
+					if(e.mapData)
+						delete e.mapData;
+					continue;
+				}
+				e.id = existingDiff->id;
+			}
+
 			if(e.action == Event::Added)
 			{
 				Buffer metadata;
@@ -366,6 +433,8 @@ public:
 
 				itDiff->second->lwt = e.lwt;
 				itDiff->second->settings = *e.mapData;
+				// The music might have changed, it is measured again
+				itDiff->second->loudness = LoudnessInfo();
 
 				auto itMap = m_maps.find(itDiff->second->mapId);
 				assert(itMap != m_maps.end());
@@ -373,6 +442,18 @@ public:
 				// Send notification
 				updatedEvents.Add(itMap->second);
 			}
+			else if(e.action == Event::Measured)
+			{
+				setLoudness.BindDouble(1, e.loudness.integrated);
+				setLoudness.BindDouble(2, e.loudness.truePeak);
+				setLoudness.BindInt(3, e.id);
+				setLoudness.Step();
+				setLoudness.Rewind();
+
+				auto itDiff = m_difficulties.find(e.id);
+				if(itDiff != m_difficulties.end())
+					itDiff->second->loudness = e.loudness;
+			}
 			else if(e.action == Event::Removed)
 			{
 				auto itDiff = m_difficulties.find(e.id);
@@ -492,24 +573,75 @@ private:
 			delete m.second;
 		}
 		m_maps.clear();
+		m_mapsByPath.clear();
 		m_difficulties.clear();
 	}
+	DifficultyIndex* m_FindDifficulty(const String& path)
+	{
+		auto mapIt = m_mapsByPath.find(Path::RemoveLast(path, nullptr));
+		if(mapIt == m_mapsByPath.end())
+			return nullptr;
+		for(DifficultyIndex* diff : mapIt->second->difficulties)
+		{
+			if(diff->path == path)
+				return diff;
+		}
+		return nullptr;
+	}
 	void m_CreateTables()
 	{
 		m_database.Exec("DROP TABLE IF EXISTS Maps");
 		m_database.Exec("DROP TABLE IF EXISTS Difficulties");
 		m_database.Exec("DROP TABLE IF EXISTS Scores");
+		m_database.Exec("DROP TABLE IF EXISTS Folders");
 
 		m_database.Exec("CREATE TABLE Maps"
 			"(artist TEXT, title TEXT, tags TEXT, path TEXT)");
 
 		m_database.Exec("CREATE TABLE Difficulties"
-			"(metadata BLOB, path TEXT, lwt INTEGER, mapid INTEGER,"
+			"(metadata BLOB, path TEXT, lwt INTEGER, mapid INTEGER, loudness REAL, truePeak REAL,"
 			"FOREIGN KEY(mapid) REFERENCES Maps(rowid))");
 
 		m_database.Exec("CREATE TABLE Scores"
 			"(score INTEGER, crit INTEGER, near INTEGER, miss INTEGER, gauge REAL, gameflags INTEGER, diffid INTEGER, hitstats BLOB, timestamp INTEGER, "
 			"FOREIGN KEY(diffid) REFERENCES Difficulties(rowid))");
+
+		m_database.Exec("CREATE TABLE Folders"
+			"(path TEXT, lwt INTEGER, contents BLOB)");
+	}
+	void m_LoadFolderCache()
+	{
+		m_folderCache.folders.clear();
+		DBStatement folderScan = m_database.Query("SELECT path,lwt,contents FROM Folders");
+		while(folderScan.StepRow())
+		{
+			FolderScanCache::Folder& folder = m_folderCache.folders[folderScan.StringColumn(0)];
+			folder.lastWriteTime = folderScan.Int64Column(1);
+			Buffer contents = folderScan.BlobColumn(2);
+			MemoryReader contentsReader(contents);
+			contentsReader.SerializeObject(folder.subFolders);
+			contentsReader.SerializeObject(folder.files);
+		}
+	}
+	void m_SaveFolderCache(Map<String, FolderScanCache::Folder>& folders)
+	{
+		DBStatement addFolder = m_database.Query("INSERT INTO Folders(path,lwt,contents) VALUES(?,?,?)");
+		m_database.Exec("BEGIN");
+		m_database.Exec("DELETE FROM Folders");
+		for(auto& f : folders)
+		{
+			Buffer contents;
+			MemoryWriter contentsWriter(contents);
+			contentsWriter.SerializeObject(f.second.subFolders);
+			contentsWriter.SerializeObject(f.second.files);
+
+			addFolder.BindString(1, f.first);
+			addFolder.BindInt64(2, f.second.lastWriteTime);
+			addFolder.BindBlob(3, contents);
+			addFolder.Step();
+			addFolder.Rewind();
+		}
+		m_database.Exec("END");
 	}
 	void m_LoadInitialData()
 	{
@@ -535,7 +667,7 @@ private:
 		m_nextMapId = m_maps.empty() ? 1 : (m_maps.rbegin()->first + 1);
 
 		// Select Difficulties
-		DBStatement diffScan = m_database.Query("SELECT rowid,path,lwt,metadata,mapid FROM Difficulties");
+		DBStatement diffScan = m_database.Query("SELECT rowid,path,lwt,metadata,mapid,loudness,truePeak FROM Difficulties");
 		while(diffScan.StepRow())
 		{
 			DifficultyIndex* diff = new DifficultyIndex();
@@ -546,13 +678,22 @@ private:
 			diff->mapId = diffScan.IntColumn(4);
 			MemoryReader metadataReader(metadata);
 			metadataReader.SerializeObject(diff->settings);
+			if(!diffScan.IsNullColumn(5))
+			{
+				diff->loudness.integrated = (float)diffScan.DoubleColumn(5);
+				diff->loudness.truePeak = (float)diffScan.DoubleColumn(6);
+				diff->loudness.measured = true;
+			}
 
 			// Add existing diff
 			m_difficulties.Add(diff->id, diff);
 
+			// Add to search state
 			SearchState::ExistingDifficulty existing;
 			existing.lwt = diff->lwt;
 			existing.id = diff->id;
+			if(!diff->loudness.measured)
+				existing.unmeasuredAudio = m_GetAudioPath(diff->path, diff->settings);
 			m_searchState.difficulties.Add(diff->path, existing);
 
 			// Add difficulty to map and resort difficulties
@@ -560,12 +701,6 @@ private:
 			assert(mapIt != m_maps.end());
 			mapIt->second->difficulties.Add(diff);
 			m_SortDifficulties(mapIt->second);
-
-			// Add to search state
-			SearchState::ExistingDifficulty ed;
-			ed.id = diff->id;
-			ed.lwt = diff->lwt;
-			m_searchState.difficulties.Add(diff->path, ed);
 		}
 
 		// Select Scores
@@ -621,23 +756,79 @@ private:
 		});
 	}
 
+	// Full path of the music used by a chart
+	static String m_GetAudioPath(const String& chartPath, const BeatmapSettings& settings)
+	{
+		String audioPath = Path::RemoveLast(chartPath, nullptr) + Path::sep + settings.audioNoFX;
+		audioPath.TrimBack(' ');
+		return audioPath;
+	}
+
 	// Main search thread
 	void m_SearchThread()
+	{
+		DirectoryWatcher watcher;
+		bool watching = DirectoryWatcher::IsSupported();
+
+		if(!m_ScanFiles(watching ? &watcher : nullptr, watching))
+			return;
+		m_outer.OnSearchStatusUpdated.Call("");
+		m_searching = false;
+
+		if(!watching)
+			return;
+
+		// Keep processing changes to the searched folders instead of rescanning everything
+		Logf("Watching %d chart folders for changes", Logger::Info, (int32)m_folderCache.folders.size());
+		while(!m_interruptSearch)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(250));
+			if(!m_ProcessWatcherChanges(watcher))
+			{
+				Logf("Chart folder watcher lost events, rescanning", Logger::Warning);
+				if(!m_ScanFiles(&watcher, watching))
+					return;
+				m_outer.OnSearchStatusUpdated.Call("");
+			}
+		}
+	}
+
+	// Scans all search paths and queues changes compared to the search state
+	//	returns false if interrupted
+	bool m_ScanFiles(DirectoryWatcher* watcher, bool& watching)
 	{
 		Map<String, FileInfo> fileList;
 
 		{
 			ProfilerScope $("Chart Database - Enumerate Files and Folders");
 			m_outer.OnSearchStatusUpdated.Call("[START] Chart Database - Enumerate Files and Folders");
+			Vector<String> searchPaths;
 			for(String rootSearchPath : m_searchPaths)
+				searchPaths.Add(rootSearchPath);
+
+			size_t previousFolders = m_folderCache.folders.size();
+			Vector<FileInfo> files = m_folderCache.Scan(searchPaths, "ksh", &m_interruptSearch, [&](const String& folder)
 			{
-				Vector<FileInfo> files = Files::ScanFilesRecursive(rootSearchPath, "ksh", &m_interruptSearch);
-				if(m_interruptSearch)
-					return;
-				for(FileInfo& fi : files)
-				{
-					fileList.Add(fi.fullPath, fi);
-				}
+				// Start watching before listing, so no changes are missed
+				if(watching && !watcher->AddFolder(folder))
+					watching = false;
+			});
+			if(m_interruptSearch)
+				return false;
+			for(FileInfo& fi : files)
+			{
+				fileList.Add(fi.fullPath, fi);
+			}
+			Logf("Enumerated %d charts, %d folders listed, %d folders unchanged", Logger::Info,
+				(int32)fileList.size(), m_folderCache.GetListedCount(), m_folderCache.GetCachedCount());
+
+			// Store the folder cache if anything changed
+			if(m_folderCache.GetListedCount() > 0 || m_folderCache.folders.size() != previousFolders)
+			{
+				m_pendingChangesLock.lock();
+				m_pendingFolderCache = m_folderCache.folders;
+				m_folderCacheChanged = true;
+				m_pendingChangesLock.unlock();
 			}
 			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Enumerate Files and Folders");
 		}
@@ -646,6 +837,7 @@ private:
 			ProfilerScope $("Chart Database - Process Removed Files");
 			m_outer.OnSearchStatusUpdated.Call("[START] Chart Database - Process Removed Files");
 			// Process scanned files
+			Vector<String> removed;
 			for(auto f : m_searchState.difficulties)
 			{
 				if(!fileList.Contains(f.first))
@@ -655,8 +847,11 @@ private:
 					evt.path = f.first;
 					evt.id = f.second.id;
 					AddChange(evt);
+					removed.Add(f.first);
 				}
 			}
+			for(String& path : removed)
+				m_searchState.difficulties.erase(path);
 			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Process Removed Files");
 		}
 
@@ -666,73 +861,274 @@ private:
 			// Process scanned files
 			for(auto f : fileList)
 			{
-				if(!m_searching)
-					break;
+				if(m_interruptSearch)
+					return false;
+				m_ProcessFile(f.first, f.second.lastWriteTime);
+			}
+			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Process New Files");
+		}
 
-				uint64 mylwt = f.second.lastWriteTime;
-				Event evt;
-				evt.lwt = mylwt;
+		return m_AnalyzeLoudness();
+	}
 
-				SearchState::ExistingDifficulty* existing = m_searchState.difficulties.Find(f.first);
+	// Measures the music of difficulties in the search state that wasn't measured yet
+	//	every audio file is decoded once for all difficulties that use it, spread over the analyzer threads
+	//	returns false if interrupted
+	bool m_AnalyzeLoudness()
+	{
+		if(!m_loudnessAnalyzer)
+			return true;
+
+		// Difficulties by the music they use
+		Map<String, Vector<String>> difficultiesByAudio;
+		for(auto& f : m_searchState.difficulties)
+		{
+			if(!f.second.unmeasuredAudio.empty())
+				difficultiesByAudio.FindOrAdd(f.second.unmeasuredAudio).Add(f.first);
+		}
+		if(difficultiesByAudio.empty())
+			return true;
+
+		ProfilerScope $("Chart Database - Analyze Loudness");
+		m_outer.OnSearchStatusUpdated.Call("[START] Chart Database - Analyze Loudness");
+		Timer timer;
+
+		Vector<const String*> audioPaths;
+		for(auto& it : difficultiesByAudio)
+			audioPaths.Add(&it.first);
+		Vector<LoudnessInfo> results;
+		results.resize(audioPaths.size());
+
+		// Workers take the next song until all are measured or the search is interrupted
+		std::atomic<size_t> nextSong{ 0 };
+		std::atomic<uint32> numMeasured{ 0 };
+		auto worker = [&]()
+		{
+			size_t i;
+			while(!m_interruptSearch && (i = nextSong.fetch_add(1)) < audioPaths.size())
+			{
+				LoudnessInfo& result = results[i];
+				result.measured = m_loudnessAnalyzer(*audioPaths[i], result);
+				if(result.measured)
+					numMeasured++;
+			}
+		};
+		uint32 numThreads = (uint32)Math::Min<size_t>(m_loudnessThreads, audioPaths.size());
+		Vector<thread> threads;
+		for(uint32 i = 1; i < numThreads; i++)
+			threads.emplace_back(worker);
+		worker();
+		for(thread& t : threads)
+			t.join();
+
+		// Queue results for every difficulty, songs that failed to decode are tried again on the next scan
+		size_t numDone = Math::Min(nextSong.load(), audioPaths.size());
+		for(size_t i = 0; i < numDone; i++)
+		{
+			for(const String& path : difficultiesByAudio[*audioPaths[i]])
+			{
+				SearchState::ExistingDifficulty* existing = m_searchState.difficulties.Find(path);
 				if(existing)
+					existing->unmeasuredAudio.clear();
+				if(!results[i].measured)
+					continue;
+
+				Event evt;
+				evt.action = Event::Measured;
+				evt.path = path;
+				evt.id = existing ? existing->id : -1;
+				evt.loudness = results[i];
+				AddChange(evt);
+			}
+			if(!results[i].measured)
+				Logf("Failed to measure the loudness of [%s]", Logger::Warning, *audioPaths[i]);
+		}
+
+		double seconds = timer.SecondsAsDouble();
+		String status = Utility::Sprintf("Measured the loudness of %d/%d songs in %.1f s (%.1f songs/s on %d threads)",
+			(int32)numMeasured.load(), (int32)audioPaths.size(), seconds, numMeasured.load() / Math::Max(seconds, 0.001), numThreads);
+		Logf("%s", Logger::Info, status);
+		m_outer.OnSearchStatusUpdated.Call(status);
+		m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Analyze Loudness");
+		return !m_interruptSearch;
+	}
+
+	// Checks a single chart file against the search state and queues a change if it was added or updated
+	void m_ProcessFile(const String& path, uint64 mylwt)
+	{
+		Event evt;
+		evt.lwt = mylwt;
+
+		SearchState::ExistingDifficulty* existing = m_searchState.difficulties.Find(path);
+		if(existing)
+		{
+			evt.id = existing->id;
+			if(existing->lwt != mylwt)
+			{
+				// Map Updated
+				evt.action = Event::Updated;
+			}
+			else
+			{
+				// Skip, not changed
+				return;
+			}
+		}
+		else
+		{
+			// Map added
+			evt.action = Event::Added;
+			evt.id = -1;
+		}
+
+		Logf("Discovered Chart [%s]", Logger::Info, path);
+		m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Discovered Chart [%s]", path));
+		// Try to read map metadata
+		bool mapValid = false;
+		File fileStream;
+		Beatmap map;
+		if(fileStream.OpenRead(path))
+		{
+			FileReader reader(fileStream);
+
+			if(map.Load(reader, true))
+			{
+				mapValid = true;
+			}
+		}
+
+		if(mapValid)
+		{
+			evt.mapData = new BeatmapSettings(map.GetMapSettings());
+			if(existing)
+			{
+				existing->lwt = mylwt;
+				existing->unmeasuredAudio = m_GetAudioPath(path, *evt.mapData);
+			}
+			else
+			{
+				SearchState::ExistingDifficulty ed;
+				ed.id = -1;
+				ed.lwt = mylwt;
+				ed.unmeasuredAudio = m_GetAudioPath(path, *evt.mapData);
+				m_searchState.difficulties.Add(path, ed);
+			}
+		}
+		else
+		{
+			if(!existing) // Never added
+			{
+				Logf("Skipping corrupted chart [%s]", Logger::Warning, path);
+				m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Skipping corrupted chart [%s]", path));
+				return;
+			}
+			// Invalid maps get removed from the database
+			evt.action = Event::Removed;
+			m_searchState.difficulties.erase(path);
+		}
+		evt.path = path;
+		AddChange(evt);
+	}
+	void m_RemoveFile(const String& path)
+	{
+		SearchState::ExistingDifficulty* existing = m_searchState.difficulties.Find(path);
+		if(!existing)
+			return;
+
+		Event evt;
+		evt.action = Event::Removed;
+		evt.path = path;
+		evt.id = existing->id;
+		AddChange(evt);
+		m_searchState.difficulties.erase(path);
+	}
+
+	// Turns changes reported by the folder watcher into database changes
+	//	returns false if changes were lost and a full rescan is required
+	bool m_ProcessWatcherChanges(DirectoryWatcher& watcher)
+	{
+		Vector<DirectoryWatcher::Change> changes = watcher.Poll();
+		if(changes.empty())
+			return true;
+
+		// Files are often written multiple times, only check them once
+		Set<String> modified;
+		Set<String> removed;
+		for(DirectoryWatcher::Change& change : changes)
+		{
+			switch(change.action)
+			{
+			case DirectoryWatcher::Action::Overflow:
+				return false;
+			case DirectoryWatcher::Action::Modified:
+				if(Path::GetExtension(change.path) == "ksh")
 				{
-					evt.id = existing->id;
-					if(existing->lwt != mylwt)
-					{
-						// Map Updated
-						evt.action = Event::Updated;
-					}
-					else
-					{
-						// Skip, not changed
-						continue;
-					}
+					modified.Add(change.path);
+					removed.erase(change.path);
 				}
-				else
+				break;
+			case DirectoryWatcher::Action::Removed:
+				if(Path::GetExtension(change.path) == "ksh")
 				{
-					// Map added
-					evt.action = Event::Added;
+					removed.Add(change.path);
+					modified.erase(change.path);
 				}
-
-				Logf("Discovered Chart [%s]", Logger::Info, f.first);
-				m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Discovered Chart [%s]", f.first));
-				// Try to read map metadata
-				bool mapValid = false;
-				File fileStream;
-				Beatmap map;
-				if(fileStream.OpenRead(f.first))
+				break;
+			case DirectoryWatcher::Action::FolderAdded:
+			{
+				// Charts can be moved in together with their folder, these won't generate file events
+				List<String> folderQueue;
+				folderQueue.AddBack(change.path);
+				while(!folderQueue.empty())
 				{
-					FileReader reader(fileStream);
-
-					if(map.Load(reader, true))
+					String folder = folderQueue.front();
+					folderQueue.pop_front();
+					watcher.AddFolder(folder);
+
+					Vector<FileInfo> files;
+					Vector<String> subFolders;
+					Files::ListFolder(folder, "ksh", files, subFolders);
+					for(FileInfo& fi : files)
 					{
-						mapValid = true;
+						modified.Add(fi.fullPath);
+						removed.erase(fi.fullPath);
 					}
+					for(String& subFolder : subFolders)
+						folderQueue.AddBack(subFolder);
 				}
-
-				if(mapValid)
-				{
-					evt.mapData = new BeatmapSettings(map.GetMapSettings());
-				}
-				else
+				break;
+			}
+			case DirectoryWatcher::Action::FolderRemoved:
+			{
+				watcher.RemoveFolder(change.path);
+				String prefix = change.path + Path::sep;
+				for(auto& f : m_searchState.difficulties)
 				{
-					if(!existing) // Never added
+					if(f.first.compare(0, prefix.size(), prefix) == 0)
 					{
-						Logf("Skipping corrupted chart [%s]", Logger::Warning, f.first);
-						m_outer.OnSearchStatusUpdated.Call(Utility::Sprintf("Skipping corrupted chart [%s]", f.first));
-						continue;
+						removed.Add(f.first);
+						modified.erase(f.first);
 					}
-					// Invalid maps get removed from the database
-					evt.action = Event::Removed;
 				}
-				evt.path = f.first;
-				AddChange(evt);
-				continue;
+				break;
+			}
 			}
-			m_outer.OnSearchStatusUpdated.Call("[END] Chart Database - Process New Files");
 		}
-		m_outer.OnSearchStatusUpdated.Call("");
-		m_searching = false;
+
+		for(const String& path : removed)
+		{
+			m_RemoveFile(path);
+		}
+		for(const String& path : modified)
+		{
+			uint64 lwt = Files::GetLastWriteTime(path);
+			if(lwt == 0)
+				m_RemoveFile(path);
+			else
+				m_ProcessFile(path, lwt);
+		}
+		m_AnalyzeLoudness();
+		return true;
 	}
 };
 MapDatabase::MapDatabase()
@@ -780,6 +1176,10 @@ void MapDatabase::RemoveSearchPath(const String& path)
 {
 	m_impl->RemoveSearchPath(path);
 }
+void MapDatabase::SetLoudnessAnalyzer(LoudnessAnalyzer analyzer, uint32 numThreads)
+{
+	m_impl->SetLoudnessAnalyzer(analyzer, numThreads);
+}
 void MapDatabase::AddScore(const DifficultyIndex& diff, int score, int crit, int almost, int miss, float gauge, uint32 gameflags, Vector<SimpleHitStat> simpleHitStats, uint64 timestamp)
 {
 	m_impl->AddScore(diff, score, crit, almost, miss, gauge, gameflags, simpleHitStats, timestamp);
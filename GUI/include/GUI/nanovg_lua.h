@@ -29,6 +29,8 @@ struct GUIState
 	NVGcolor imageTint;
 	Rect scissor;
 	Vector2i resolution;
+	// Maps image handles that skins kept to the image to draw, for images the game can free and load again
+	int(*resolveImage)(int image);
 };
 
 
@@ -183,9 +185,13 @@ static int lCreateImage(lua_State* L /*const char* filename, int imageflags */)
 	}
 	return 0;
 }
+static int ResolveImage(int image)
+{
+	return g_guiState.resolveImage ? g_guiState.resolveImage(image) : image;
+}
 static int lImagePatternFill(lua_State* L /*int image, float alpha*/)
 {
-	int image = luaL_checkinteger(L, 1);
+	int image = ResolveImage(luaL_checkinteger(L, 1));
 	float alpha = luaL_checknumber(L, 2);
 	int w, h;
 	nvgImageSize(g_guiState.vg, image, &w, &h);
@@ -211,12 +217,15 @@ static int lImageRect(lua_State* L /*float x, float y, float w, float h, int ima
 	y = luaL_checknumber(L, 2);
 	w = luaL_checknumber(L, 3);
 	h = luaL_checknumber(L, 4);
-	image = luaL_checkinteger(L, 5);
+	image = ResolveImage(luaL_checkinteger(L, 5));
 	alpha = luaL_checknumber(L, 6);
 	angle = luaL_checknumber(L, 7);
 
 	int imgH, imgW;
 	nvgImageSize(g_guiState.vg, image, &imgW, &imgH);
+	// Nothing to draw for invalid images, like a freed jacket that is loading again
+	if(imgW <= 0 || imgH <= 0)
+		return 0;
 	float scaleX, scaleY;
 	scaleX = w / imgW;
 	scaleY = h / imgH;
@@ -605,7 +614,7 @@ static int lImagePattern(lua_State* L /* float ox, float oy, float ex, float ey,
 	float ex = luaL_checknumber(L, 3);
 	float ey = luaL_checknumber(L, 4);
 	float angle = luaL_checknumber(L, 5);
-	int image = luaL_checkinteger(L, 6);
+	int image = ResolveImage(luaL_checkinteger(L, 6));
 	float alpha = luaL_checknumber(L, 7);
 	NVGpaint paint = nvgImagePattern(g_guiState.vg, ox, oy, ex, ey, angle, image, alpha);
 	g_guiState.paintCache[L].Add(g_guiState.nextPaintId[L], paint);
@@ -742,7 +751,7 @@ static int lFastTextSize(lua_State* L /* char* text */)
 }
 static int lImageSize(lua_State* L /*int image*/)
 {
-		int image = luaL_checkinteger(L, 1);
+		int image = ResolveImage(luaL_checkinteger(L, 1));
 		int w,h;
 		nvgImageSize(g_guiState.vg, image, &w, &h);
 		lua_pushnumber(L,w);
@@ -31,6 +31,8 @@ namespace Graphics
 	public:
 		virtual ~FontRes() = default;
 		static Ref<FontRes> Create(class OpenGL* gl, const String& assetPath);
+		// Create a font from the contents of a font file in memory, the data is copied
+		static Ref<FontRes> Create(class OpenGL* gl, const uint8* data, size_t size);
 	public:
 		// Text rendering options
 		enum TextOptions
@@ -7,6 +7,7 @@
 #include <Graphics/OpenGL.hpp>
 #include <Graphics/Image.hpp>
 #include <Graphics/ImageLoader.hpp>
+#include <Graphics/ImageProcessing.hpp>
 #include <Graphics/Texture.hpp>
 #include <Graphics/Material.hpp>
 #include <Graphics/Mesh.hpp>
@@ -16,4 +17,6 @@
 #include <Graphics/MeshGenerators.hpp>
 #include <Graphics/Font.hpp>
 #include <Graphics/Framebuffer.hpp>
-#include <Graphics/TextureAnimator.hpp>
\ No newline at end of file
+#include <Graphics/ScreenCapture.hpp>
+#include <Graphics/TextureAnimator.hpp>
+#include <Graphics/TextureAtlas.hpp>
\ No newline at end of file
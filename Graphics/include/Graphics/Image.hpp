@@ -1,5 +1,6 @@
 #pragma once
 #include <Graphics/ResourceTypes.hpp>
+#include <Graphics/ImageProcessing.hpp>
 
 namespace Graphics
 {
@@ -12,15 +13,28 @@ namespace Graphics
 	public:
 		virtual ~ImageRes() = default;
 		static Ref<ImageRes> Create(const String& assetPath);
+		// Loads an image that is going to be scaled down to at least minSize
+		//	JPEGs are decoded at a reduced scale when that is still large enough, which is a lot faster than decoding all pixels
+		static Ref<ImageRes> Create(const String& assetPath, Vector2i minSize);
 		static Ref<ImageRes> Create(Vector2i size = Vector2i());
 		static Ref<ImageRes> Screenshot(class OpenGL* gl, Vector2i size = Vector2i(), Vector2i pos = Vector2i());
 	public:
 		virtual void SetSize(Vector2i size) = 0;
-		virtual void ReSize(Vector2i size) = 0;
+		// Resamples the image to a new size
+		virtual void ReSize(Vector2i size, ResizeFilter filter) = 0;
+		void ReSize(Vector2i size) { ReSize(size, ResizeFilter::Lanczos); }
+		// Converts the pixels to premultiplied alpha, e.g. for nanovg images created with NVG_IMAGE_PREMULTIPLIED
+		virtual void PremultiplyAlpha() = 0;
 		virtual Vector2i GetSize() const = 0;
 		virtual Colori* GetBits() = 0;
 		virtual const Colori* GetBits() const = 0;
-		virtual void SavePNG(const String& file) = 0;
+		// Encodes the image as PNG
+		//	compressionLevel is the zlib level (0-9), -1 uses the default
+		//	bottomUp should be set for images read back from OpenGL, loaded images are stored top-down
+		//	does not require an OpenGL context, so it can be used from job threads or headless tools
+		virtual bool SavePNG(const String& file, int32 compressionLevel = -1, bool bottomUp = true) = 0;
+		// Size of the pixel data in bytes
+		virtual size_t GetMemoryUsage() const = 0;
 	};
 
 	/*
@@ -12,6 +12,7 @@ namespace Graphics
 	class ImageLoader
 	{
 	public:
-		static bool Load(ImageRes* outPtr, const String& fullPath);
+		// If minSize is set, JPEGs are decoded at the smallest scale (1/8, 1/4 or 1/2) that is still at least this size
+		static bool Load(ImageRes* outPtr, const String& fullPath, Vector2i minSize = Vector2i());
 	};
 }
\ No newline at end of file
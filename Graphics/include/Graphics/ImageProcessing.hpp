@@ -0,0 +1,35 @@
+#pragma once
+
+namespace Graphics
+{
+	enum class ResizeFilter
+	{
+		// Picks the closest source pixel, only for pixel art or when speed matters more than quality
+		Nearest,
+		// Averages all source pixels covered by a destination pixel
+		Box,
+		// Lanczos with 3 lobes, sharpest result when downscaling
+		Lanczos,
+	};
+
+	/*
+		Pixel operations on RGBA8 images, independent of ImageRes so they can be used on any buffer
+		Resizing is done in two separable passes over the rows, using fixed point weights and SSE2 when available
+	*/
+	class ImageProcessing
+	{
+	public:
+		// Resamples an image into a buffer of a different size
+		//	color is filtered premultiplied by alpha, so fully transparent pixels don't bleed into their neighbours
+		static void Resize(const Colori* src, Vector2i srcSize, Colori* dst, Vector2i dstSize, ResizeFilter filter = ResizeFilter::Lanczos);
+
+		// Converts between straight and premultiplied alpha in place
+		static void PremultiplyAlpha(Colori* pixels, size_t count);
+		static void UnpremultiplyAlpha(Colori* pixels, size_t count);
+		// True if any pixel is not fully opaque
+		static bool HasAlpha(const Colori* pixels, size_t count);
+
+		// True when the SIMD code paths are compiled in
+		static bool IsSIMDEnabled();
+	};
+}
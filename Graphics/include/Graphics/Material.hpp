@@ -92,6 +92,9 @@ namespace Graphics
 
 		// Bind only shaders/pipeline to context
 		virtual void BindToContext() = 0;
+
+		// Checks if any of the assigned shaders uses a parameter with the given name
+		virtual bool HasParameter(const String& name) const = 0;
 	};
 
 	typedef Ref<MaterialRes> Material;
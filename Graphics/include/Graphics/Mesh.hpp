@@ -41,6 +41,8 @@ namespace Graphics
 		virtual void Draw() = 0;
 		// Draws the mesh after if has already been drawn once, reuse of bound objects
 		virtual void Redraw() = 0;
+		// Size of the vertex buffer in bytes
+		virtual size_t GetMemoryUsage() const = 0;
 
 	private:
 		virtual void SetData(const void* pData, size_t vertexCount, const VertexFormatList& desc) = 0;
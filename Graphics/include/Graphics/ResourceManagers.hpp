@@ -38,8 +38,20 @@ namespace Graphics
 
 		static void SuspendGC();
 		static void ContinueGC();
+		// Runs incremental garbage collection, limited to the collection budget
 		static void TickAll();
 
+		// Maximum time spent on garbage collection per frame, in microseconds
+		static void SetGCBudget(uint32 microseconds);
+
+		// Keeps collected GPU resources alive until EndDeferDestruction is called as many times as BeginDeferDestruction
+		//	used during gameplay so objects are only destroyed at safe points like song transitions
+		static void BeginDeferDestruction();
+		static void EndDeferDestruction();
+
+		static ResourceManagerStats GetStats(ResourceType type);
+		static const char* GetTypeName(ResourceType type);
+
 	private:
 	};
 
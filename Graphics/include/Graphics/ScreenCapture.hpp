@@ -0,0 +1,46 @@
+#pragma once
+#include <Graphics/Image.hpp>
+
+namespace Graphics
+{
+	/*
+		Asynchronous screen capture
+		Regions of the last rendered frame are read into pixel buffer objects and mapped on later frames once the GPU has finished copying them,
+		so taking a screenshot doesn't stall the main thread waiting for the GPU
+	*/
+	class ScreenCapture : public Unique
+	{
+	public:
+		ScreenCapture(class OpenGL* gl);
+		~ScreenCapture();
+
+		// Starts reading back a region of the back buffer, in window pixel coordinates (origin at the bottom left)
+		bool Capture(Vector2i pos, Vector2i size);
+
+		// Checks captures that are in flight, should be called once per frame from the OpenGL thread
+		// finished captures are passed to OnCaptured in the order they were started
+		void Update();
+
+		// Number of captures that haven't been read back yet
+		uint32 GetPendingCount() const;
+
+		// Called with the captured image, rows are bottom-up as in OpenGL
+		Delegate<Image> OnCaptured;
+
+		// Number of frames after which the readback is forced, even if the GPU isn't done yet
+		static const uint32 maxLatencyFrames = 4;
+
+	private:
+		struct PendingCapture
+		{
+			uint32 pbo = 0;
+			void* fence = nullptr;
+			Vector2i size;
+			uint32 frames = 0;
+		};
+		void m_Release(PendingCapture& capture);
+
+		class OpenGL* m_gl;
+		Vector<PendingCapture> m_pending;
+	};
+}
@@ -19,6 +19,8 @@ namespace Graphics
 	public:
 		virtual ~ShaderRes() = default;
 		static Ref<ShaderRes> Create(class OpenGL* gl, ShaderType type, const String& assetPath);
+		// Create a shader from source code in memory, the name is used in error messages
+		static Ref<ShaderRes> CreateFromSource(class OpenGL* gl, ShaderType type, const String& source, const String& name);
 		static void Unbind(class OpenGL* gl, ShaderType type);
 		friend class OpenGL;
 	public:
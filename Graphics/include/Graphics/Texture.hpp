@@ -46,6 +46,8 @@ namespace Graphics
 		virtual uint32 Handle() = 0;
 		virtual void SetWrap(TextureWrap u, TextureWrap v) = 0;
 		virtual TextureFormat GetFormat() const = 0;
+		// Approximate amount of video memory used by this texture in bytes
+		virtual size_t GetMemoryUsage() const = 0;
 	};
 
 	typedef Ref<TextureRes> Texture;
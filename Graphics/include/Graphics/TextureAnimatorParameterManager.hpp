@@ -2,6 +2,7 @@
 #include <Graphics/Material.hpp>
 #include <Graphics/Texture.hpp>
 #include <Graphics/TextureAnimatorParameter.hpp>
+#include <Graphics/TextureAtlas.hpp>
 
 namespace Graphics
 {
@@ -16,8 +17,9 @@ namespace Graphics
 		// Material used for the Animaton
 		Material material;
 
-		// Textures to use for the Animaton
-		Vector<Texture> textures;
+		// Frames of the Animaton
+		//	frames packed in an atlas are selected with the texRect parameter of the material, (offset.xy, scale.zw)
+		TextureSequence textures;
 
 		// Animaton location
 		Vector3 position;
@@ -49,6 +51,8 @@ namespace Graphics
 		// Constructed by Texture Animator
 		TextureAnimatorParameterManager(class TextureSystem_Impl* sys);
 		void Render(const class RenderState& rs, float deltaTime);
+		// Binds the material with all parameters and sets its blend mode
+		void m_BindMaterial(const class RenderState& rs, const MaterialParameterSet& params);
 		void m_ReallocatePool(uint32 newCapacity);
 
 		float m_AnimatorTime = 0; //how much time has passed
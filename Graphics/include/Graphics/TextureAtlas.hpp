@@ -0,0 +1,54 @@
+#pragma once
+#include <Graphics/Image.hpp>
+#include <Graphics/Texture.hpp>
+
+namespace Graphics
+{
+	/*
+		Frames of an animation
+		The frames are either packed into a single atlas texture with a UV rectangle for each frame,
+		or separate textures when they were not packed
+	*/
+	struct TextureSequence
+	{
+		// Texture containing all frames, only set when the frames are packed
+		Texture atlas;
+		// UV rectangle of each frame in the atlas
+		Vector<Rect> frames;
+		// Texture for each frame, only set when the frames are not packed
+		Vector<Texture> textures;
+
+		size_t GetFrameCount() const;
+		bool IsValid() const;
+	};
+
+	/*
+		Packs a sequence of images into a single image
+		Packing can be done on a loading thread, the texture is created from the packed image afterwards
+		The packed image and frame coordinates can be saved, so packing only has to be done once
+	*/
+	class TextureAtlas
+	{
+	public:
+		// Packs the images in order, returns false if they don't fit in a maxSize*maxSize image
+		bool Pack(const Vector<Image>& images, int32 maxSize);
+
+		// Saves the packed image as PNG with the frame coordinates in a separate index file
+		bool Save(const String& imagePath, const String& indexPath) const;
+		bool Load(const String& imagePath, const String& indexPath);
+
+		// Creates a single texture for all frames
+		TextureSequence CreateSequence(class OpenGL* gl) const;
+		// Creates a texture for each frame, for materials that can't sample from an atlas
+		TextureSequence CreateTextures(class OpenGL* gl) const;
+
+		bool IsValid() const;
+		Image GetImage() const;
+		// Pixel coordinates of each frame in the packed image
+		const Vector<Recti>& GetFrames() const;
+
+	private:
+		Image m_image;
+		Vector<Recti> m_frames;
+	};
+}
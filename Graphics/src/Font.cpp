@@ -216,6 +216,18 @@ namespace Graphics
 
 			in.Read(&m_data.front(), m_data.size());
 
+			return m_InitFace();
+		}
+		bool Init(const uint8* data, size_t size)
+		{
+			if(size == 0)
+				return false;
+			m_data.resize(size);
+			memcpy(m_data.data(), data, size);
+			return m_InitFace();
+		}
+		bool m_InitFace()
+		{
 			if(FT_New_Memory_Face(library, m_data.data(), (FT_Long)m_data.size(), 0, &m_face) != 0)
 				return false;
 
@@ -355,6 +367,20 @@ namespace Graphics
 		}
 	}
 
+	Font FontRes::Create(OpenGL* gl, const uint8* data, size_t size)
+	{
+		Font_Impl* pImpl = new Font_Impl(gl);
+		if(pImpl->Init(data, size))
+		{
+			return GetResourceManager<ResourceType::Font>().Register(pImpl);
+		}
+		else
+		{
+			delete pImpl;
+			return Font();
+		}
+	}
+
 	bool FontLibrary::LoadFallbackFont()
 	{
 		bool success = true;
@@ -46,27 +46,25 @@ namespace Graphics
 			Clear();
 			Allocate();
 		}
-		void ReSize(Vector2i size)
+		void ReSize(Vector2i size, ResizeFilter filter)
 		{
 			size_t new_DataLength = size.x * size.y;
-			if (new_DataLength == 0){
+			if (new_DataLength == 0 || !m_pData){
 				return;
 			}
 			Colori* new_pData = new Colori[new_DataLength];
-
-			for (int32 ix = 0; ix < size.x; ++ix){
-				for (int32 iy = 0; iy < size.y; ++iy){
-					int32 sampledX = ix * ((double)m_size.x / (double)size.x);
-					int32 sampledY = iy * ((double)m_size.y / (double)size.y);
-					new_pData[size.x * iy + ix] = m_pData[m_size.x * sampledY + sampledX];
-				}
-			}
+			ImageProcessing::Resize(m_pData, m_size, new_pData, size, filter);
 
 			delete[] m_pData;
 			m_pData = new_pData;
 			m_size = size;
 			m_nDataLength = m_size.x * m_size.y;
 		}
+		void PremultiplyAlpha()
+		{
+			if(m_pData)
+				ImageProcessing::PremultiplyAlpha(m_pData, m_nDataLength);
+		}
 		bool Screenshot(OpenGL* gl,Vector2i pos)
 		{
 			GLuint texture;
@@ -114,37 +112,59 @@ namespace Graphics
 			glDeleteTextures(1, &texture);
 			return true;
 		}
-		void SavePNG(const String& file)
+		bool SavePNG(const String& file, int32 compressionLevel, bool bottomUp)
 		{
-			///TODO: Use shared/File.hpp instead?
+			Timer timer;
 			File pngfile;
-			pngfile.OpenWrite(Path::Normalize(file));
+			if(!pngfile.OpenWrite(Path::Normalize(file)))
+			{
+				Logf("Failed to open \"%s\" for writing", Logger::Error, file);
+				return false;
+			}
 
 			png_structp png_ptr = NULL;
 			png_infop info_ptr = NULL;
 			png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 			info_ptr = png_create_info_struct(png_ptr);
+			png_bytep* row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * m_size.y);
 			if (setjmp(png_jmpbuf(png_ptr)))
 			{
 				/* If we get here, we had a problem writing the file */
 				pngfile.Close();
 				png_destroy_write_struct(&png_ptr, &info_ptr);
-				assert(false);
+				free(row_pointers);
+				Logf("Failed to encode PNG \"%s\"", Logger::Error, file);
+				return false;
 			}
 			png_set_IHDR(png_ptr, info_ptr, m_size.x, m_size.y,
 				8, PNG_COLOR_TYPE_RGBA, PNG_INTERLACE_NONE,
 				PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+			if (compressionLevel >= 0)
+			{
+				png_set_compression_level(png_ptr, Math::Min(compressionLevel, 9));
+				// Filtering is wasted time when the data is stored uncompressed
+				if (compressionLevel == 0)
+					png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+			}
 
-			png_bytep* row_pointers = (png_bytep*)malloc(sizeof(png_bytep) * m_size.y);
 			for (size_t i = 0; i < m_size.y; ++i) {
-				row_pointers[m_size.y - i - 1] = (png_bytep)(m_pData + i * m_size.x);
+				size_t row = bottomUp ? m_size.y - i - 1 : i;
+				row_pointers[row] = (png_bytep)(m_pData + i * m_size.x);
 			}
 
 			png_set_write_fn(png_ptr, &pngfile, pngfile_write_data, pngfile_flush);
 			png_set_rows(png_ptr, info_ptr, row_pointers);
 			png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_IDENTITY, NULL);
+			png_destroy_write_struct(&png_ptr, &info_ptr);
 			pngfile.Close();
 			free(row_pointers);
+
+			Logf("Saved %dx%d PNG \"%s\" in %.2f ms", Logger::Info, m_size.x, m_size.y, file, timer.SecondsAsDouble() * 1000.0);
+			return true;
+		}
+		size_t GetMemoryUsage() const
+		{
+			return m_pData ? m_nDataLength * sizeof(Colori) : 0;
 		}
 		Vector2i GetSize() const
 		{
@@ -176,9 +196,13 @@ namespace Graphics
 		return GetResourceManager<ResourceType::Image>().Register(pImpl);
 	}
 	Image ImageRes::Create(const String& assetPath)
+	{
+		return Create(assetPath, Vector2i());
+	}
+	Image ImageRes::Create(const String& assetPath, Vector2i minSize)
 	{
 		Image_Impl* pImpl = new Image_Impl();
-		if(ImageLoader::Load(pImpl, assetPath))
+		if(ImageLoader::Load(pImpl, assetPath, minSize))
 		{
 			return GetResourceManager<ResourceType::Image>().Register(pImpl);
 		}
@@ -46,7 +46,7 @@ namespace Graphics
 		{
 		}
 
-		bool LoadJPEG(ImageRes* pImage, Buffer& in)
+		bool LoadJPEG(ImageRes* pImage, Buffer& in, Vector2i minSize)
 		{
 
 			/* This struct contains the JPEG decompression parameters and pointers to
@@ -68,6 +68,25 @@ namespace Graphics
 				jpeg_mem_src(&cinfo, in.data(), (uint32)in.size());
 				int res = jpeg_read_header(&cinfo, TRUE);
 
+				// Let the decoder skip the DCT coefficients that would be lost by downscaling anyway
+				if(minSize.x > 0 && minSize.y > 0)
+				{
+					for(uint32 denom = 8; denom > 1; denom /= 2)
+					{
+						uint32 w = (cinfo.image_width + denom - 1) / denom;
+						uint32 h = (cinfo.image_height + denom - 1) / denom;
+						if(w >= (uint32)minSize.x && h >= (uint32)minSize.y)
+						{
+							cinfo.scale_num = 1;
+							cinfo.scale_denom = denom;
+							break;
+						}
+					}
+				}
+				// Grayscale images are expanded by the decoder
+				if(cinfo.jpeg_color_space == JCS_GRAYSCALE || cinfo.jpeg_color_space == JCS_YCbCr)
+					cinfo.out_color_space = JCS_RGB;
+
 				jpeg_start_decompress(&cinfo);
 				int row_stride = cinfo.output_width * cinfo.output_components;
 				JSAMPARRAY sample = (*cinfo.mem->alloc_sarray)
@@ -78,16 +97,13 @@ namespace Graphics
 				Colori* pBits = pImage->GetBits();
 
 				size_t pixelSize = cinfo.out_color_components;
-				cinfo.out_color_space = JCS_RGB;
 
 				while(cinfo.output_scanline < cinfo.output_height)
 				{
 					jpeg_read_scanlines(&cinfo, sample, 1);
-					for(size_t i = 0; i < cinfo.output_width; i++)
-					{
-						memcpy(pBits + i, sample[0] + i * pixelSize, pixelSize);
-						pBits[i].w = 0xFF;
-					}
+					const uint8* src = sample[0];
+					for(size_t i = 0; i < cinfo.output_width; i++, src += pixelSize)
+						pBits[i] = Colori(src[0], src[1], src[2], 0xFF);
 
 					pBits += size.x;
 				}
@@ -98,6 +114,7 @@ namespace Graphics
 			}
 			
 			// If we get here, the loading of the jpeg failed
+			jpeg_destroy_decompress(&cinfo);
 			return false;
 		}
 		bool LoadPNG(ImageRes* pImage, Buffer& in)
@@ -125,7 +142,7 @@ namespace Graphics
 			png_image_free(&image);
 			return true;
 		}
-		bool Load(ImageRes* pImage, const String& fullPath)
+		bool Load(ImageRes* pImage, const String& fullPath, Vector2i minSize)
 		{
 			File f;
 			if(!f.OpenRead(fullPath))
@@ -140,7 +157,7 @@ namespace Graphics
 			if(*(uint32*)b.data() == (uint32&)"PNG")
 				return LoadPNG(pImage, b);
 			else // jay-PEG ?
-				return LoadJPEG(pImage, b);
+				return LoadJPEG(pImage, b, minSize);
 		}
 
 		static ImageLoader_Impl& Main()
@@ -151,8 +168,8 @@ namespace Graphics
 	};
 
 
-	bool ImageLoader::Load(ImageRes* pImage, const String& fullPath)
+	bool ImageLoader::Load(ImageRes* pImage, const String& fullPath, Vector2i minSize)
 	{
-		return ImageLoader_Impl::Main().Load(pImage, fullPath);
+		return ImageLoader_Impl::Main().Load(pImage, fullPath, minSize);
 	}
 }
\ No newline at end of file
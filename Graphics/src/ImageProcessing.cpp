@@ -0,0 +1,314 @@
+#include "stdafx.h"
+#include "ImageProcessing.hpp"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Graphics
+{
+	// Weights are stored as 16-bit fixed point, so two taps can be multiplied and added at once with _mm_madd_epi16
+	static const int32 weightBits = 14;
+	static const int32 weightRound = 1 << (weightBits - 1);
+
+	static inline uint8 ClampPixel(int32 acc)
+	{
+		acc >>= weightBits;
+		return (uint8)(acc < 0 ? 0 : (acc > 255 ? 255 : acc));
+	}
+
+	static double FilterBox(double x)
+	{
+		return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+	}
+	static double Sinc(double x)
+	{
+		if(x == 0.0)
+			return 1.0;
+		x *= 3.14159265358979323846;
+		return sin(x) / x;
+	}
+	static double FilterLanczos(double x)
+	{
+		if(x <= -3.0 || x >= 3.0)
+			return 0.0;
+		return Sinc(x) * Sinc(x / 3.0);
+	}
+
+	/*
+		Source pixels and their weights for every destination pixel along one axis
+		Computed once per resize, the passes only do integer multiply-adds
+	*/
+	struct ResizeTaps
+	{
+		Vector<int32> start;
+		Vector<int32> count;
+		// maxTaps weights for each destination pixel
+		Vector<int16> weights;
+		int32 maxTaps = 0;
+
+		void Compute(int32 srcLength, int32 dstLength, ResizeFilter filter)
+		{
+			start.resize(dstLength);
+			count.resize(dstLength);
+			double scale = (double)srcLength / (double)dstLength;
+
+			if(filter == ResizeFilter::Nearest)
+			{
+				maxTaps = 1;
+				weights.assign(dstLength, (int16)(1 << weightBits));
+				for(int32 i = 0; i < dstLength; i++)
+				{
+					start[i] = Math::Min((int32)((i + 0.5) * scale), srcLength - 1);
+					count[i] = 1;
+				}
+				return;
+			}
+
+			// Widen the filter when downscaling so every source pixel contributes
+			double filterScale = Math::Max(scale, 1.0);
+			double radius = filter == ResizeFilter::Box ? 0.5 : 3.0;
+			double support = radius * filterScale;
+			maxTaps = (int32)ceil(support) * 2 + 1;
+			weights.assign((size_t)dstLength * maxTaps, 0);
+
+			Vector<double> w(maxTaps);
+			for(int32 i = 0; i < dstLength; i++)
+			{
+				double center = (i + 0.5) * scale;
+				int32 first = Math::Max((int32)(center - support + 0.5), 0);
+				int32 last = Math::Min((int32)(center + support + 0.5), srcLength);
+				int32 n = Math::Min(last - first, maxTaps);
+
+				double total = 0.0;
+				for(int32 j = 0; j < n; j++)
+				{
+					double x = (first + j - center + 0.5) / filterScale;
+					w[j] = filter == ResizeFilter::Box ? FilterBox(x) : FilterLanczos(x);
+					total += w[j];
+				}
+				// Drop zero weights at the edges, they only cost time
+				while(n > 1 && w[n - 1] == 0.0)
+					n--;
+				int32 skip = 0;
+				while(skip < n - 1 && w[skip] == 0.0)
+					skip++;
+				if(total == 0.0)
+					total = 1.0;
+
+				start[i] = first + skip;
+				count[i] = n - skip;
+				int16* dst = weights.data() + (size_t)i * maxTaps;
+				for(int32 j = skip; j < n; j++)
+					dst[j - skip] = (int16)floor(w[j] / total * (1 << weightBits) + 0.5);
+			}
+		}
+		const int16* GetWeights(int32 i) const
+		{
+			return weights.data() + (size_t)i * maxTaps;
+		}
+	};
+
+	// Resamples one row of pixels
+	static void ResizeRow(const uint32* src, uint32* dst, int32 dstLength, const ResizeTaps& taps)
+	{
+		for(int32 x = 0; x < dstLength; x++)
+		{
+			const uint32* in = src + taps.start[x];
+			const int16* w = taps.GetWeights(x);
+			int32 n = taps.count[x];
+#ifdef IMAGE_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			__m128i acc = _mm_set1_epi32(weightRound);
+			int32 j = 0;
+			for(; j + 1 < n; j += 2)
+			{
+				// r0 r1 g0 g1 b0 b1 a0 a1, multiplied with w0 w1 and added in pairs
+				__m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int32)in[j]), zero);
+				__m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int32)in[j + 1]), zero);
+				__m128i weight = _mm_set1_epi32((int32)(((uint32)(uint16)w[j + 1] << 16) | (uint16)w[j]));
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weight));
+			}
+			if(j < n)
+			{
+				__m128i a = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int32)in[j]), zero);
+				__m128i weight = _mm_set1_epi32((int32)(uint16)w[j]);
+				acc = _mm_add_epi32(acc, _mm_madd_epi16(_mm_unpacklo_epi16(a, zero), weight));
+			}
+			acc = _mm_srai_epi32(acc, weightBits);
+			acc = _mm_packs_epi32(acc, acc);
+			dst[x] = (uint32)_mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+#else
+			int32 acc[4] = { weightRound, weightRound, weightRound, weightRound };
+			for(int32 j = 0; j < n; j++)
+			{
+				const uint8* p = (const uint8*)(in + j);
+				acc[0] += p[0] * w[j];
+				acc[1] += p[1] * w[j];
+				acc[2] += p[2] * w[j];
+				acc[3] += p[3] * w[j];
+			}
+			uint8* out = (uint8*)(dst + x);
+			out[0] = ClampPixel(acc[0]);
+			out[1] = ClampPixel(acc[1]);
+			out[2] = ClampPixel(acc[2]);
+			out[3] = ClampPixel(acc[3]);
+#endif
+		}
+	}
+
+	// Combines rows into one, every channel of a row is independent so this works on bytes
+	static void ResizeColumn(const uint8* const* rows, const int16* w, int32 n, uint8* dst, int32 numBytes)
+	{
+		int32 i = 0;
+#ifdef IMAGE_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		for(; i + 16 <= numBytes; i += 16)
+		{
+			__m128i acc0 = _mm_set1_epi32(weightRound);
+			__m128i acc1 = acc0, acc2 = acc0, acc3 = acc0;
+			int32 j = 0;
+			for(; j < n; j += 2)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i*)(rows[j] + i));
+				// Odd number of rows, the last one is paired with zeros
+				__m128i b = j + 1 < n ? _mm_loadu_si128((const __m128i*)(rows[j + 1] + i)) : zero;
+				uint16 w1 = j + 1 < n ? (uint16)w[j + 1] : 0;
+				__m128i weight = _mm_set1_epi32((int32)(((uint32)w1 << 16) | (uint16)w[j]));
+				__m128i alo = _mm_unpacklo_epi8(a, zero);
+				__m128i ahi = _mm_unpackhi_epi8(a, zero);
+				__m128i blo = _mm_unpacklo_epi8(b, zero);
+				__m128i bhi = _mm_unpackhi_epi8(b, zero);
+				acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(_mm_unpacklo_epi16(alo, blo), weight));
+				acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(_mm_unpackhi_epi16(alo, blo), weight));
+				acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(_mm_unpacklo_epi16(ahi, bhi), weight));
+				acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(_mm_unpackhi_epi16(ahi, bhi), weight));
+			}
+			__m128i lo = _mm_packs_epi32(_mm_srai_epi32(acc0, weightBits), _mm_srai_epi32(acc1, weightBits));
+			__m128i hi = _mm_packs_epi32(_mm_srai_epi32(acc2, weightBits), _mm_srai_epi32(acc3, weightBits));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(lo, hi));
+		}
+#endif
+		for(; i < numBytes; i++)
+		{
+			int32 acc = weightRound;
+			for(int32 j = 0; j < n; j++)
+				acc += rows[j][i] * w[j];
+			dst[i] = ClampPixel(acc);
+		}
+	}
+
+	void ImageProcessing::Resize(const Colori* src, Vector2i srcSize, Colori* dst, Vector2i dstSize, ResizeFilter filter)
+	{
+		if(srcSize.x <= 0 || srcSize.y <= 0 || dstSize.x <= 0 || dstSize.y <= 0)
+			return;
+		if(srcSize.x == dstSize.x && srcSize.y == dstSize.y)
+		{
+			memcpy(dst, src, (size_t)srcSize.x * srcSize.y * sizeof(Colori));
+			return;
+		}
+
+		// Filtering straight alpha would mix the color of invisible pixels into the visible ones
+		Vector<Colori> premultiplied;
+		bool alpha = filter != ResizeFilter::Nearest && HasAlpha(src, (size_t)srcSize.x * srcSize.y);
+		if(alpha)
+		{
+			premultiplied.assign(src, src + (size_t)srcSize.x * srcSize.y);
+			PremultiplyAlpha(premultiplied.data(), premultiplied.size());
+			src = premultiplied.data();
+		}
+
+		ResizeTaps horizontal, vertical;
+		horizontal.Compute(srcSize.x, dstSize.x, filter);
+		vertical.Compute(srcSize.y, dstSize.y, filter);
+
+		// Only the source rows used by the vertical pass are resized horizontally
+		int32 firstRow = vertical.start[0];
+		int32 lastRow = vertical.start[dstSize.y - 1] + vertical.count[dstSize.y - 1];
+		Vector<Colori> columns;
+		const Colori* rowSource = src;
+		int32 rowStride = srcSize.x;
+		if(srcSize.x != dstSize.x)
+		{
+			columns.resize((size_t)dstSize.x * (lastRow - firstRow));
+			for(int32 y = firstRow; y < lastRow; y++)
+			{
+				ResizeRow((const uint32*)(src + (size_t)y * srcSize.x), (uint32*)(columns.data() + (size_t)(y - firstRow) * dstSize.x),
+					dstSize.x, horizontal);
+			}
+			rowSource = columns.data() - (size_t)firstRow * dstSize.x;
+			rowStride = dstSize.x;
+		}
+
+		if(srcSize.y != dstSize.y)
+		{
+			Vector<const uint8*> rows(vertical.maxTaps);
+			for(int32 y = 0; y < dstSize.y; y++)
+			{
+				int32 n = vertical.count[y];
+				for(int32 j = 0; j < n; j++)
+					rows[j] = (const uint8*)(rowSource + (size_t)(vertical.start[y] + j) * rowStride);
+				ResizeColumn(rows.data(), vertical.GetWeights(y), n, (uint8*)(dst + (size_t)y * dstSize.x), dstSize.x * 4);
+			}
+		}
+		else
+		{
+			memcpy(dst, rowSource, (size_t)dstSize.x * dstSize.y * sizeof(Colori));
+		}
+
+		if(alpha)
+			UnpremultiplyAlpha(dst, (size_t)dstSize.x * dstSize.y);
+	}
+
+	void ImageProcessing::PremultiplyAlpha(Colori* pixels, size_t count)
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			Colori& p = pixels[i];
+			uint32 a = p.w;
+			// Exact division by 255 with rounding
+			uint32 r = p.x * a + 128, g = p.y * a + 128, b = p.z * a + 128;
+			p.x = (uint8)((r + (r >> 8)) >> 8);
+			p.y = (uint8)((g + (g >> 8)) >> 8);
+			p.z = (uint8)((b + (b >> 8)) >> 8);
+		}
+	}
+	void ImageProcessing::UnpremultiplyAlpha(Colori* pixels, size_t count)
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			Colori& p = pixels[i];
+			uint32 a = p.w;
+			if(a == 255)
+				continue;
+			if(a == 0)
+			{
+				p.x = p.y = p.z = 0;
+				continue;
+			}
+			p.x = (uint8)Math::Min<uint32>((p.x * 255 + a / 2) / a, 255);
+			p.y = (uint8)Math::Min<uint32>((p.y * 255 + a / 2) / a, 255);
+			p.z = (uint8)Math::Min<uint32>((p.z * 255 + a / 2) / a, 255);
+		}
+	}
+	bool ImageProcessing::HasAlpha(const Colori* pixels, size_t count)
+	{
+		for(size_t i = 0; i < count; i++)
+		{
+			if(pixels[i].w != 255)
+				return true;
+		}
+		return false;
+	}
+
+	bool ImageProcessing::IsSIMDEnabled()
+	{
+#ifdef IMAGE_SSE2
+		return true;
+#else
+		return false;
+#endif
+	}
+}
@@ -269,6 +269,11 @@ namespace Graphics
 			glBindProgramPipeline(m_pipeline);
 		}
 
+		virtual bool HasParameter(const String& name) const override
+		{
+			return m_mappedParameters.Contains(name);
+		}
+
 		BoundParameterInfo* GetBoundParameters(const String& name, uint32& count)
 		{
 			uint32* mappedID = m_mappedParameters.Find(name);
@@ -20,6 +20,7 @@ namespace Graphics
 		PrimitiveType m_type;
 		uint32 m_glType;
 		size_t m_vertexCount;
+		size_t m_bufferSize = 0;
 		bool m_bDynamic = true;
 	public:
 		Mesh_Impl()
@@ -76,6 +77,7 @@ namespace Graphics
 				index++;
 			}
 			glBufferData(GL_ARRAY_BUFFER, totalVertexSize * vertexCount, pData, m_bDynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+			m_bufferSize = totalVertexSize * vertexCount;
 
 			glBindVertexArray(0);
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -99,6 +101,10 @@ namespace Graphics
 		{
 			return m_type;
 		}
+		virtual size_t GetMemoryUsage() const override
+		{
+			return m_bufferSize;
+		}
 	};
 
 	Mesh MeshRes::Create(class OpenGL* gl)
@@ -266,6 +266,8 @@ namespace Graphics
 		{
 			params.SetParameter("mainTex", texture);
 		}
+		// Uses the whole texture, the material may be shared with atlas animations
+		params.SetParameter("texRect", Vector4(0.0f, 0.0f, 1.0f, 1.0f));
 		material->Bind(rs, params);
 
 		// Select blending mode based on material
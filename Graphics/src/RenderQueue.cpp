@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "RenderQueue.hpp"
 #include "OpenGL.hpp"
+#include <Shared/Profiling.hpp>
 using Utility::Cast;
 
 namespace Graphics
@@ -32,6 +33,7 @@ namespace Graphics
 	}
 	void RenderQueue::Process(bool clearQueue)
 	{
+		ProfileScope("RenderQueue::Process");
 		assert(m_ogl);
 
 		bool scissorEnabled = false;
@@ -8,6 +8,10 @@ namespace Graphics
 	static Timer gcTimer;
 	static Timer cleanupTimer;
 	static int disabled = 0;
+	static int deferDestruction = 0;
+	static uint32 gcBudget = 500;
+	// Manager currently being collected, _Length if no collection is running
+	static size_t gcCurrentManager = (size_t)ResourceType::_Length;
 
 	static ResourceManagers inst;
 	static IResourceManager* managers[(size_t)ResourceType::_Length] = { nullptr };
@@ -18,6 +22,12 @@ namespace Graphics
 		CreateResourceManager<ResourceType::Image>();
 		CreateResourceManager<ResourceType::SpriteMap>();
 	}
+	// Resources that only use system memory are not deferred
+	static bool IsGPUResource(ResourceType type)
+	{
+		return type != ResourceType::Image && type != ResourceType::SpriteMap;
+	}
+
 	ResourceManagers::~ResourceManagers()
 	{
 		for(size_t i = 0; i < (size_t)ResourceType::_Length; i++)
@@ -46,6 +56,8 @@ namespace Graphics
 		size_t idx = (size_t)type;
 		assert(managers[idx] == nullptr);
 		managers[idx] = mgr;
+		if(deferDestruction > 0 && IsGPUResource(type))
+			mgr->SetDeferDestruction(true);
 	}
 
 	IResourceManager* ResourceManagers::GetResourceManager(ResourceType type)
@@ -69,16 +81,82 @@ namespace Graphics
 	{
 		inst.m_TickAll();
 	}
+	void ResourceManagers::SetGCBudget(uint32 microseconds)
+	{
+		gcBudget = microseconds;
+	}
+	void ResourceManagers::BeginDeferDestruction()
+	{
+		if(deferDestruction++ > 0)
+			return;
+		for(size_t i = 0; i < (size_t)ResourceType::_Length; i++)
+		{
+			if(managers[i] && IsGPUResource((ResourceType)i))
+				managers[i]->SetDeferDestruction(true);
+		}
+	}
+	void ResourceManagers::EndDeferDestruction()
+	{
+		if(deferDestruction == 0 || --deferDestruction > 0)
+			return;
+		for(size_t i = 0; i < (size_t)ResourceType::_Length; i++)
+		{
+			if(managers[i])
+				managers[i]->SetDeferDestruction(false);
+		}
+	}
+	ResourceManagerStats ResourceManagers::GetStats(ResourceType type)
+	{
+		size_t idx = (size_t)type;
+		if(managers[idx])
+			return managers[idx]->GetStats();
+		return ResourceManagerStats();
+	}
+	const char* ResourceManagers::GetTypeName(ResourceType type)
+	{
+		static const char* names[] =
+		{
+			"Image",
+			"SpriteMap",
+			"Texture",
+			"Framebuffer",
+			"Font",
+			"Mesh",
+			"Shader",
+			"Material",
+			"TextureAnimator",
+			"ParticleSystem",
+		};
+		static_assert(sizeof(names) / sizeof(names[0]) == (size_t)ResourceType::_Length, "Missing resource type names");
+		return names[(size_t)type];
+	}
 	void ResourceManagers::m_TickAll()
 	{
-		if(gcTimer.Milliseconds() > 250 && disabled == 0)
+		if(disabled > 0)
+			return;
+
+		// Start a new collection pass over all managers every 250ms
+		if(gcCurrentManager == (size_t)ResourceType::_Length)
 		{
-			for(auto rm : managers)
-			{
-				if(rm)
-					rm->GarbageCollect();
-			}
+			if(gcTimer.Milliseconds() <= 250)
+				return;
+			gcCurrentManager = 0;
 			gcTimer.Restart();
 		}
+
+		// Continue the pass, spread over multiple frames if it doesn't fit in the budget
+		Timer frameTimer;
+		for(; gcCurrentManager < (size_t)ResourceType::_Length; gcCurrentManager++)
+		{
+			IResourceManager* rm = managers[gcCurrentManager];
+			if(!rm)
+				continue;
+			// A budget of 0 means no limit
+			uint32 elapsed = (uint32)frameTimer.Microseconds();
+			if(gcBudget > 0 && elapsed >= gcBudget)
+				return;
+			if(!rm->GarbageCollect(gcBudget > 0 ? gcBudget - elapsed : 0))
+				return;
+		}
 	}
 }
@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include "ScreenCapture.hpp"
+#include "OpenGL.hpp"
+
+namespace Graphics
+{
+	ScreenCapture::ScreenCapture(OpenGL* gl) : m_gl(gl)
+	{
+	}
+	ScreenCapture::~ScreenCapture()
+	{
+		for(PendingCapture& capture : m_pending)
+			m_Release(capture);
+	}
+
+	bool ScreenCapture::Capture(Vector2i pos, Vector2i size)
+	{
+		if(size.x <= 0 || size.y <= 0)
+			return false;
+
+		PendingCapture capture;
+		capture.size = size;
+		glGenBuffers(1, &capture.pbo);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pbo);
+		glBufferData(GL_PIXEL_PACK_BUFFER, size.x * size.y * sizeof(Colori), nullptr, GL_STREAM_READ);
+
+		// Copy into the buffer, this returns without waiting for the GPU
+		m_gl->BlitFramebuffer();
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+		glReadBuffer(GL_BACK);
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		glReadPixels(pos.x, pos.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		capture.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		GLenum err;
+		if((err = glGetError()) != GL_NO_ERROR)
+		{
+			Logf("OpenGL Error while starting screen capture: 0x%p", Logger::Severity::Error, err);
+			m_Release(capture);
+			return false;
+		}
+
+		m_pending.Add(capture);
+		return true;
+	}
+
+	void ScreenCapture::Update()
+	{
+		while(!m_pending.empty())
+		{
+			PendingCapture& capture = m_pending.front();
+			capture.frames++;
+
+			// Make sure the commands get submitted on the first check, otherwise the fence might never signal
+			GLbitfield flags = capture.frames == 1 ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+			GLuint64 timeout = capture.frames >= maxLatencyFrames ? 1000000000 : 0;
+			GLenum status = glClientWaitSync((GLsync)capture.fence, flags, timeout);
+			if(status == GL_TIMEOUT_EXPIRED)
+				return;
+
+			Image image;
+			if(status != GL_WAIT_FAILED)
+			{
+				size_t numBytes = capture.size.x * capture.size.y * sizeof(Colori);
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pbo);
+				void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, numBytes, GL_MAP_READ_BIT);
+				if(data)
+				{
+					image = ImageRes::Create(capture.size);
+					memcpy(image->GetBits(), data, numBytes);
+					glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+				}
+				glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			}
+
+			if(image)
+				Logf("Screen capture of %dx%d read back after %d frame(s)", Logger::Info, capture.size.x, capture.size.y, capture.frames);
+			else
+				Logf("Failed to read back screen capture", Logger::Error);
+
+			m_Release(capture);
+			m_pending.erase(m_pending.begin());
+
+			if(image)
+				OnCaptured.Call(image);
+		}
+	}
+
+	uint32 ScreenCapture::GetPendingCount() const
+	{
+		return (uint32)m_pending.size();
+	}
+
+	void ScreenCapture::m_Release(PendingCapture& capture)
+	{
+		if(capture.fence)
+			glDeleteSync((GLsync)capture.fence);
+		if(capture.pbo)
+			glDeleteBuffers(1, &capture.pbo);
+		capture.fence = nullptr;
+		capture.pbo = 0;
+	}
+}
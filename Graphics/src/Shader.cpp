@@ -25,6 +25,8 @@ namespace Graphics
 		OpenGL* m_gl;
 
 		String m_sourcePath;
+		// Source code when the shader was not loaded from a file
+		String m_source;
 
 		// Hot Reload detection on windows
 #ifdef _WIN32
@@ -67,15 +69,18 @@ namespace Graphics
 		bool LoadProgram(uint32& programOut)
 		{
 			File in;
-			if(!in.OpenRead(m_sourcePath))
-				return false;
+			String sourceStr = m_source;
+			if(sourceStr.empty())
+			{
+				if(!in.OpenRead(m_sourcePath))
+					return false;
 
-			String sourceStr;
-			sourceStr.resize(in.GetSize());
-			if(sourceStr.size() == 0)
-				return false;
+				sourceStr.resize(in.GetSize());
+				if(sourceStr.size() == 0)
+					return false;
 
-			in.Read(&sourceStr.front(), sourceStr.size());
+				in.Read(&sourceStr.front(), sourceStr.size());
+			}
 
 			const char* pChars = *sourceStr;
 			programOut = glCreateShaderProgramv(typeMap[(size_t)m_type], 1, &pChars);
@@ -96,9 +101,12 @@ namespace Graphics
 
 			// Shader hot-reload in debug mode
 #if defined(_DEBUG) && defined(_WIN32)
-			// Store last write time
-			m_lwt = in.GetLastWriteTime();
-			SetupChangeHandler();
+			if(m_source.empty())
+			{
+				// Store last write time
+				m_lwt = in.GetLastWriteTime();
+				SetupChangeHandler();
+			}
 #endif
 			return true;
 		}
@@ -135,6 +143,13 @@ namespace Graphics
 			m_type = type;
 			return LoadProgram(m_prog);
 		}
+		bool InitFromSource(ShaderType type, const String& source, const String& name)
+		{
+			m_sourcePath = name;
+			m_source = source;
+			m_type = type;
+			return !m_source.empty() && LoadProgram(m_prog);
+		}
 
 		virtual void Bind()
 		{
@@ -225,6 +240,19 @@ namespace Graphics
 			return GetResourceManager<ResourceType::Shader>().Register(pImpl);
 		}
 	}
+	Shader ShaderRes::CreateFromSource(class OpenGL* gl, ShaderType type, const String& source, const String& name)
+	{
+		Shader_Impl* pImpl = new Shader_Impl(gl);
+		if(!pImpl->InitFromSource(type, source, name))
+		{
+			delete pImpl;
+			return Shader();
+		}
+		else
+		{
+			return GetResourceManager<ResourceType::Shader>().Register(pImpl);
+		}
+	}
 	void ShaderRes::Unbind(class OpenGL* gl, ShaderType type)
 	{
 		if(gl->m_activeShaders[(size_t)type] != 0)
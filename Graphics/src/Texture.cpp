@@ -181,6 +181,16 @@ namespace Graphics
 		{
 			return m_format;
 		}
+		size_t GetMemoryUsage() const
+		{
+			// Both formats use 4 bytes per pixel, mipmaps add about a third
+			if(m_format == TextureFormat::Invalid)
+				return 0;
+			size_t size = (size_t)m_size.x * (size_t)m_size.y * 4;
+			if(m_mipmaps)
+				size += size / 3;
+			return size;
+		}
 	};
 
 	Texture TextureRes::Create(OpenGL* gl)
@@ -23,11 +23,17 @@ namespace Graphics
 	public:
 		OpenGL* gl;
 
+		// Material and atlas that are currently bound, consecutive sequences that share them only update texRect
+		Material boundMaterial;
+		Texture boundAtlas;
+
 	public:
 		virtual void Render(const class RenderState& rs, float deltaTime) override
 		{
 			// Enable blending for all particles
 			glEnable(GL_BLEND);
+			boundMaterial = Material();
+			boundAtlas = Texture();
 
 			// Tick all emitters and remove old ones
 			for(auto it = m_managers.begin(); it != m_managers.end();)
@@ -110,11 +116,11 @@ namespace Graphics
 		{
 			life -= deltaTime;
 			lastlife += deltaTime;
-			if (lastlife >= manager->m_param_Lifetime->Sample(1)/manager->textures.size()) {
+			if (lastlife >= manager->m_param_Lifetime->Sample(1)/manager->textures.GetFrameCount()) {
 				idx++;
 				lastlife = 0.0f;
 			}
-			if (idx >= manager->textures.size()) {
+			if (idx >= manager->textures.GetFrameCount()) {
 				idx--;
 			}
 			if (life - deltaTime <= 0.0f) {
@@ -174,7 +180,7 @@ namespace Graphics
 		if (m_finished)
 			return;
 		uint32 maxSpawns = (uint32)ceilf(m_param_SpawnRate->GetMax());
-		uint32 maxFrames = textures.size() - 1;
+		uint32 maxFrames = (uint32)textures.GetFrameCount() - 1;
 
 		if (m_poolSize == 0)
 			m_ReallocatePool(1);
@@ -209,24 +215,34 @@ namespace Graphics
 			{
 				verts.Add({ Animation.pos, Animation.color.WithAlpha(Animation.alpha), Vector4(Animation.Size, Animation.rotation, 0.0f, 0.0f) });
 				MaterialParameterSet params;
-				if (textures[Animation.idx])
+				uint32 frame = (uint32)Animation.idx;
+				if (textures.atlas)
 				{
-					params.SetParameter("mainTex", textures[Animation.idx]);
+					// All frames are in the same texture, only the UV rectangle changes
+					const Rect& frameRect = textures.frames[frame];
+					params.SetParameter("texRect", Vector4(frameRect.pos.x, frameRect.pos.y, frameRect.size.x, frameRect.size.y));
+					if (m_system->boundMaterial == material && m_system->boundAtlas == textures.atlas)
+					{
+						material->BindParameters(params, rs.worldTransform);
+					}
+					else
+					{
+						params.SetParameter("mainTex", textures.atlas);
+						m_BindMaterial(rs, params);
+						m_system->boundMaterial = material;
+						m_system->boundAtlas = textures.atlas;
+					}
 				}
-				material->Bind(rs, params);
-
-				// Select blending mode based on material
-				switch (material->blendMode)
+				else
 				{
-				case MaterialBlendMode::Normal:
-					glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-					break;
-				case MaterialBlendMode::Additive:
-					glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-					break;
-				case MaterialBlendMode::Multiply:
-					glBlendFunc(GL_SRC_ALPHA, GL_SRC_COLOR);
-					break;
+					if (textures.textures[frame])
+					{
+						params.SetParameter("mainTex", textures.textures[frame]);
+					}
+					params.SetParameter("texRect", Vector4(0.0f, 0.0f, 1.0f, 1.0f));
+					m_BindMaterial(rs, params);
+					m_system->boundMaterial = Material();
+					m_system->boundAtlas = Texture();
 				}
 				// Create vertex buffer
 				Mesh mesh = MeshRes::Create(m_system->gl);
@@ -243,6 +259,25 @@ namespace Graphics
 		}
 	}
 
+	void TextureAnimatorParameterManager::m_BindMaterial(const class RenderState& rs, const MaterialParameterSet& params)
+	{
+		material->Bind(rs, params);
+
+		// Select blending mode based on material
+		switch (material->blendMode)
+		{
+		case MaterialBlendMode::Normal:
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			break;
+		case MaterialBlendMode::Additive:
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+			break;
+		case MaterialBlendMode::Multiply:
+			glBlendFunc(GL_SRC_ALPHA, GL_SRC_COLOR);
+			break;
+		}
+	}
+
 	void TextureAnimatorParameterManager::Reset()
 	{
 		m_deactivated = false;
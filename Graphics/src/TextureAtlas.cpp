@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "TextureAtlas.hpp"
+#include <Shared/File.hpp>
+#include <Shared/FileStream.hpp>
+
+namespace Graphics
+{
+	// Increase this when the layout of the index file changes
+	static const uint32 indexVersion = 1;
+
+	size_t TextureSequence::GetFrameCount() const
+	{
+		return atlas ? frames.size() : textures.size();
+	}
+	bool TextureSequence::IsValid() const
+	{
+		return GetFrameCount() > 0;
+	}
+
+	bool TextureAtlas::Pack(const Vector<Image>& images, int32 maxSize)
+	{
+		m_image.Release();
+		m_frames.clear();
+		if(images.empty())
+			return false;
+
+		// The sprite map leaves a transparent gap between images, so frames don't bleed into each other when filtered
+		SpriteMap spriteMap = SpriteMapRes::Create();
+		Vector<uint32> segments;
+		for(const Image& image : images)
+		{
+			if(!image)
+				return false;
+			Vector2i size = image->GetSize();
+			if(size.x > maxSize || size.y > maxSize)
+				return false;
+			segments.Add(spriteMap->AddSegment(image));
+			Vector2i packedSize = spriteMap->GetImage()->GetSize();
+			if(packedSize.x > maxSize || packedSize.y > maxSize)
+				return false;
+		}
+
+		m_image = spriteMap->GetImage();
+		for(uint32 segment : segments)
+			m_frames.Add(spriteMap->GetCoords(segment));
+		return true;
+	}
+
+	bool TextureAtlas::Save(const String& imagePath, const String& indexPath) const
+	{
+		if(!IsValid())
+			return false;
+		Image image = m_image;
+		if(!image->SavePNG(imagePath, 1, false))
+			return false;
+
+		File file;
+		if(!file.OpenWrite(indexPath))
+			return false;
+		FileWriter writer(file);
+		uint32 version = indexVersion;
+		uint32 count = (uint32)m_frames.size();
+		writer << version << count;
+		for(const Recti& frame : m_frames)
+		{
+			int32 coords[4] = { frame.pos.x, frame.pos.y, frame.size.x, frame.size.y };
+			writer.Serialize(coords, sizeof(coords));
+		}
+		return true;
+	}
+	bool TextureAtlas::Load(const String& imagePath, const String& indexPath)
+	{
+		m_image.Release();
+		m_frames.clear();
+
+		File file;
+		if(!file.OpenRead(indexPath))
+			return false;
+		FileReader reader(file);
+		uint32 version = 0, count = 0;
+		reader << version << count;
+		if(version != indexVersion || count == 0 || file.GetSize() != sizeof(uint32) * 2 + count * sizeof(int32) * 4)
+			return false;
+
+		Image image = ImageRes::Create(imagePath);
+		if(!image)
+			return false;
+		Vector2i imageSize = image->GetSize();
+		for(uint32 i = 0; i < count; i++)
+		{
+			int32 coords[4];
+			reader.Serialize(coords, sizeof(coords));
+			Recti frame(Vector2i(coords[0], coords[1]), Vector2i(coords[2], coords[3]));
+			if(frame.pos.x < 0 || frame.pos.y < 0 || frame.size.x <= 0 || frame.size.y <= 0 ||
+				frame.pos.x + frame.size.x > imageSize.x || frame.pos.y + frame.size.y > imageSize.y)
+			{
+				m_frames.clear();
+				return false;
+			}
+			m_frames.Add(frame);
+		}
+		m_image = image;
+		return true;
+	}
+
+	TextureSequence TextureAtlas::CreateSequence(class OpenGL* gl) const
+	{
+		TextureSequence sequence;
+		if(!IsValid())
+			return sequence;
+		sequence.atlas = TextureRes::Create(gl, m_image);
+		if(!sequence.atlas)
+			return sequence;
+		sequence.atlas->SetWrap(TextureWrap::Clamp, TextureWrap::Clamp);
+
+		Vector2 atlasSize = Vector2(m_image->GetSize());
+		for(const Recti& frame : m_frames)
+		{
+			sequence.frames.Add(Rect(Vector2(frame.pos) / atlasSize, Vector2(frame.size) / atlasSize));
+		}
+		return sequence;
+	}
+	TextureSequence TextureAtlas::CreateTextures(class OpenGL* gl) const
+	{
+		TextureSequence sequence;
+		if(!IsValid())
+			return sequence;
+		int32 pitch = m_image->GetSize().x;
+		for(const Recti& frame : m_frames)
+		{
+			Image image = ImageRes::Create(frame.size);
+			const Colori* src = m_image->GetBits() + frame.pos.x + frame.pos.y * pitch;
+			Colori* dst = image->GetBits();
+			for(int32 y = 0; y < frame.size.y; y++)
+			{
+				memcpy(dst + y * frame.size.x, src + y * pitch, frame.size.x * sizeof(Colori));
+			}
+			sequence.textures.Add(TextureRes::Create(gl, image));
+		}
+		return sequence;
+	}
+
+	bool TextureAtlas::IsValid() const
+	{
+		return m_image && !m_frames.empty();
+	}
+	Image TextureAtlas::GetImage() const
+	{
+		return m_image;
+	}
+	const Vector<Recti>& TextureAtlas::GetFrames() const
+	{
+		return m_frames;
+	}
+}
@@ -14,6 +14,10 @@
 #include "GameConfig.hpp"
 #include "Input.hpp"
 #include "TransitionScreen.hpp"
+#include "JacketCache.hpp"
+#include "AudioSummaryCache.hpp"
+#include <Audio/AudioSummary.hpp>
+#include "SkinBundle.hpp"
 #include "GUI/HealthGauge.hpp"
 #include "lua.hpp"
 #include "nanovg.h"
@@ -21,6 +25,7 @@
 #include "cpr/cpr.h"
 #include "jansson.h"
 #include "Shared/Files.hpp"
+#include <Shared/Time.hpp>
 #define NANOVG_GL3_IMPLEMENTATION
 #include "nanovg_gl.h"
 #include "GUI/nanovg_lua.h"
@@ -99,6 +104,12 @@ int32 Application::Run()
 	if(!m_Init())
 		return 1;
 
+	if(m_commandLine.Contains("-bundleskin"))
+	{
+		// Only builds the bundle, the OpenGL context from m_Init is used to check the shaders
+		return m_BuildSkinBundle() ? 0 : 1;
+	}
+
 	if(m_commandLine.Contains("-test")) 
 	{
 		// Create test scene
@@ -274,6 +285,23 @@ bool Application::m_Init()
 		Logf("Failed to load config file", Logger::Warning);
 	}
 
+	// Apply log filtering from the config
+	switch(g_gameConfig.GetEnum<Enum_LogLevel>(GameConfigKeys::LogLevel))
+	{
+	case LogLevel::Normal:
+		Logger::Get().SetLogLevel(Logger::Normal);
+		break;
+	case LogLevel::Warning:
+		Logger::Get().SetLogLevel(Logger::Warning);
+		break;
+	case LogLevel::Error:
+		Logger::Get().SetLogLevel(Logger::Error);
+		break;
+	default:
+		Logger::Get().SetLogLevel(Logger::Info);
+		break;
+	}
+
 	// Job sheduler
 	g_jobSheduler = new JobSheduler();
 
@@ -296,6 +324,12 @@ bool Application::m_Init()
 			{
 				fullscreenMonitor = atol(*v);
 			}
+			else if(k == "-profile")
+			{
+				// Capture a fixed number of frames
+				m_profilerFrames = atol(*v);
+				m_ToggleProfiler();
+			}
 		}
 		else
 		{
@@ -311,6 +345,10 @@ bool Application::m_Init()
 			{
 				startFullscreen = true;
 			}
+			else if(cl == "-profile")
+			{
+				m_ToggleProfiler();
+			}
 		}
 	}
 
@@ -331,9 +369,10 @@ bool Application::m_Init()
 
 	// Set skin variable
 	m_skin = g_gameConfig.GetString(GameConfigKeys::Skin);
+	m_OpenSkinBundle();
 
 	// Window cursor
-	Image cursorImg = ImageRes::Create("skins/" + m_skin + "/textures/cursor.png");
+	Image cursorImg = LoadImage("cursor.png");
 	g_gameWindow->SetCursor(cursorImg, Vector2i(5, 5));
 
 	if(startFullscreen)
@@ -354,13 +393,19 @@ bool Application::m_Init()
 		// Init audio
 		new Audio();
 		bool exclusive = g_gameConfig.GetBool(GameConfigKeys::WASAPI_Exclusive);
-		if(!g_audio->Init(exclusive))
+		AudioBufferSettings bufferSettings;
+		bufferSettings.bufferSize = (uint32)Math::Max(g_gameConfig.GetInt(GameConfigKeys::AudioBufferSize), 0);
+		bufferSettings.blockSize = (uint32)Math::Max(g_gameConfig.GetInt(GameConfigKeys::AudioBlockSize), 1);
+		bufferSettings.adaptive = g_gameConfig.GetBool(GameConfigKeys::AdaptiveAudioBuffer);
+		bufferSettings.renderThreads = (uint32)Math::Max(g_gameConfig.GetInt(GameConfigKeys::AudioRenderThreads), 0);
+		bufferSettings.parallelRender = bufferSettings.renderThreads > 0;
+		if(!g_audio->Init(exclusive, bufferSettings))
 		{
 			if (exclusive)
 			{
 				Log("Failed to open in WASAPI Exclusive mode, attempting shared mode.", Logger::Warning);
 				g_gameWindow->ShowMessageBox("WASAPI Exclusive mode error.", "Failed to open in WASAPI Exclusive mode, attempting shared mode.", 1);
-				if (!g_audio->Init(false))
+				if (!g_audio->Init(false, bufferSettings))
 				{
 					Log("Audio initialization failed", Logger::Error);
 					delete g_audio;
@@ -400,8 +445,17 @@ bool Application::m_Init()
 		g_guiState.vg = nvgCreateGL3(0);
 #endif
 		nvgCreateFont(g_guiState.vg, "fallback", "fonts/fallbackfont.otf");
+
+		m_jacketCache = new JacketCache();
+		m_jacketCache->SetContext(g_guiState.vg);
+		g_guiState.resolveImage = [](int image) { return g_application->GetJacketCache()->Resolve(image); };
+		m_jacketCache->SetBudget((size_t)g_gameConfig.GetInt(GameConfigKeys::JacketCacheMemory) * 1024 * 1024,
+			g_gameConfig.GetInt(GameConfigKeys::JacketCacheCount));
 	}
 
+	m_audioSummaryCache = new AudioSummaryCache();
+	m_audioSummaryCache->SetBudget((uint32)Math::Max(g_gameConfig.GetInt(GameConfigKeys::AudioSummaryCacheCount), 1));
+
 	if(g_gameConfig.GetBool(GameConfigKeys::CheckForUpdates))
 	{
 		m_updateThread = Thread(__updateChecker);
@@ -427,6 +481,7 @@ bool Application::m_Init()
 }
 void Application::m_MainLoop()
 {
+	ProfileThreadName("Main");
 	Timer appTimer;
 	m_lastRenderTime = 0.0f;
 	while(true)
@@ -505,6 +560,8 @@ void Application::m_MainLoop()
 		float timeSinceRender = currentTime - m_lastRenderTime;
 		if(timeSinceRender > targetRenderTime)
 		{
+			ProfileScope("Frame");
+
 			// Calculate actual deltatime for timing calculations
 			currentTime = appTimer.SecondsAsFloat();
 			float actualDeltaTime = currentTime - m_lastRenderTime;
@@ -521,10 +578,31 @@ void Application::m_MainLoop()
 				return;
 
 			m_Tick();
+
+			if(!m_startupLogged)
+			{
+				// Everything the first screen needs is loaded by now
+				Logf("Startup took %.1f ms, %d skin assets loaded from the skin bundle and %d from files in %.1f ms", Logger::Info,
+					m_startupTimer.SecondsAsDouble() * 1000.0, m_bundleLoads, m_fileLoads, m_skinLoadTime * 1000.0);
+				m_startupLogged = true;
+			}
 			timeSinceRender = 0.0f;
 
+			// Free jackets that haven't been used for a while, once per frame so the ones drawn last frame are kept
+			if(m_jacketCache)
+				m_jacketCache->Update();
+			if(m_audioSummaryCache)
+				m_audioSummaryCache->Update();
+
 			// Garbage collect resources
-			ResourceManagers::TickAll();
+			{
+				ProfileScope("ResourceManagers::TickAll");
+				ResourceManagers::TickAll();
+			}
+
+			// Stop timed profiler captures
+			if(m_profilerFrames > 0 && --m_profilerFrames == 0)
+				m_ToggleProfiler();
 		}
 
 		// Tick job sheduler
@@ -544,11 +622,15 @@ void Application::m_Tick()
 {
 	// Handle input first
 	g_input.Update(m_deltaTime);
+	g_audio->Update();
 
 	// Tick all items
-	for(auto& tickable : g_tickables)
 	{
-		tickable->Tick(m_deltaTime);
+		ProfileScope("Application::Tick");
+		for(auto& tickable : g_tickables)
+		{
+			tickable->Tick(m_deltaTime);
+		}
 	}
 
 	// Not minimized / Valid resolution
@@ -566,9 +648,12 @@ void Application::m_Tick()
 		g_guiState.scissor = Rect(0,0,-1,-1);
 		g_guiState.imageTint = nvgRGB(255, 255, 255);
 		// Render all items
-		for(auto& tickable : g_tickables)
 		{
-			tickable->Render(m_deltaTime);
+			ProfileScope("Application::Render");
+			for(auto& tickable : g_tickables)
+			{
+				tickable->Render(m_deltaTime);
+			}
 		}
 		m_renderStateBase.projectionTransform = GetGUIProjection();
 		nvgReset(g_guiState.vg);
@@ -583,6 +668,7 @@ void Application::m_Tick()
 		m_renderQueueBase.Process();
 		glCullFace(GL_FRONT);
 		// Swap buffers
+		ProfileScope("SwapBuffers");
 		g_gl->SwapBuffers();
 	}
 }
@@ -591,18 +677,37 @@ void Application::m_Cleanup()
 {
 	ProfilerScope $("Application Cleanup");
 
+	// Write out any profiler capture still in progress
+	if(Profiler::IsCapturing())
+		m_ToggleProfiler();
+
 	for(auto it : g_tickables)
 	{
 		delete it;
 	}
 	g_tickables.clear();
 
+	if(m_audioSummaryCache)
+	{
+		delete m_audioSummaryCache;
+		m_audioSummaryCache = nullptr;
+	}
+
 	if(g_audio)
 	{
 		delete g_audio;
 		g_audio = nullptr;
 	}
 
+	if(m_jacketCache)
+	{
+		g_guiState.resolveImage = nullptr;
+		delete m_jacketCache;
+		m_jacketCache = nullptr;
+	}
+
+	m_skinBundle.Close();
+
 	if(g_gl)
 	{
 		delete g_gl;
@@ -632,6 +737,9 @@ void Application::m_Cleanup()
 
 	// Finally, save config
 	m_SaveConfig();
+
+	// Make sure all queued log messages are written
+	Logger::Get().Flush();
 }
 
 class Game* Application::LaunchMap(const String& mapPath)
@@ -684,23 +792,190 @@ RenderQueue* Application::GetRenderQueueBase()
 	return &m_renderQueueBase;
 }
 
+// Creates an image from an AssetType::Image asset
+static Graphics::Image ImageFromAsset(const AssetBundle::Asset* asset)
+{
+	if(asset->type != AssetType::Image || asset->size < sizeof(int32) * 2)
+		return Graphics::Image();
+	Vector2i size;
+	memcpy(&size.x, asset->data, sizeof(int32));
+	memcpy(&size.y, asset->data + sizeof(int32), sizeof(int32));
+	if(asset->size != sizeof(int32) * 2 + (size_t)size.x * size.y * 4)
+		return Graphics::Image();
+	Graphics::Image image = ImageRes::Create(size);
+	memcpy(image->GetBits(), asset->data + sizeof(int32) * 2, image->GetMemoryUsage());
+	return image;
+}
+
+const AssetBundle::Asset* Application::FindSkinAsset(const String& path)
+{
+	if(!m_skinBundle.IsOpen())
+		return nullptr;
+	const AssetBundle::Asset* asset = m_skinBundle.Find(path);
+	if(!asset)
+		return nullptr;
+	// Changed files are used over the bundled version, so skins can be edited without rebuilding the bundle every time
+	uint64 lastWriteTime = Files::GetLastWriteTime(Path::Normalize("skins/" + m_skin + "/" + path));
+	if(lastWriteTime != 0 && lastWriteTime != asset->lastWriteTime)
+		return nullptr;
+	return asset;
+}
+
+void Application::m_OpenSkinBundle()
+{
+	m_skinBundle.Close();
+	if(!g_gameConfig.GetBool(GameConfigKeys::UseSkinBundle))
+		return;
+	String path = SkinBundle::GetPath(m_skin);
+	if(!Path::FileExists(path))
+		return;
+	if(m_skinBundle.Open(path))
+		Logf("Using skin bundle %s (%d assets)", Logger::Info, path, (int32)m_skinBundle.GetAssetCount());
+	else
+		Logf("Failed to open skin bundle %s, loading skin files instead", Logger::Warning, path);
+}
+
+bool Application::m_BuildSkinBundle()
+{
+	// The bundle is replaced, so it can't stay mapped
+	m_skinBundle.Close();
+	return SkinBundle::Build(m_skin);
+}
+
 Graphics::Image Application::LoadImage(const String& name)
 {
-	String path = String("skins/") + m_skin + String("/textures/") + name;
-	return ImageRes::Create(path);
+	Timer timer;
+	Graphics::Image image;
+	const AssetBundle::Asset* asset = FindSkinAsset("textures/" + name);
+	if(asset && (image = ImageFromAsset(asset)))
+		m_bundleLoads++;
+	else
+	{
+		String path = String("skins/") + m_skin + String("/textures/") + name;
+		image = ImageRes::Create(path);
+		m_fileLoads++;
+	}
+	m_skinLoadTime += timer.SecondsAsDouble();
+	return image;
+}
+// Frames are named in order, the order files are listed in depends on the platform
+static void SortFrames(Vector<FileInfo>& files)
+{
+	std::sort(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b)
+	{
+		return a.fullPath < b.fullPath;
+	});
 }
 Vector<Graphics::Image> Application::LoadImages(const String& name)
 {
+	if(m_skinBundle.IsOpen())
+	{
+		Timer timer;
+		Vector<Graphics::Image> images;
+		for(const AssetBundle::Asset* asset : m_skinBundle.List("textures/" + name))
+		{
+			Graphics::Image image;
+			if(!FindSkinAsset(asset->path) || !(image = ImageFromAsset(asset)))
+			{
+				images.clear();
+				break;
+			}
+			images.Add(image);
+		}
+		if(!images.empty())
+		{
+			m_bundleLoads += (uint32)images.size();
+			m_skinLoadTime += timer.SecondsAsDouble();
+			return images;
+		}
+	}
+
+	Timer timer;
 	Vector<FileInfo> path = file.ScanFiles(String("skins/") + m_skin + String("/textures/") + name);
+	SortFrames(path);
 	Vector<Graphics::Image> Images;
 
 	for (int i = 0 ; i < path.size() ; i++) 
 	{
 		Images.push_back(ImageRes::Create(path[i].fullPath));
 	}
+	m_fileLoads += (uint32)Images.size();
+	m_skinLoadTime += timer.SecondsAsDouble();
 	return Images;
 }
 
+// Increase this when the way atlases are packed changes, so old cached atlases are not used anymore
+static const uint32 atlasVersion = 1;
+static const int32 maxAtlasSize = 4096;
+bool Application::LoadImageAtlas(const String& name, Graphics::TextureAtlas& atlas)
+{
+	// Frames come from the skin bundle if all of them are up to date in there
+	Vector<const AssetBundle::Asset*> assets;
+	if(m_skinBundle.IsOpen())
+	{
+		assets = m_skinBundle.List("textures/" + name);
+		for(const AssetBundle::Asset* asset : assets)
+		{
+			if(asset->type != AssetType::Image || !FindSkinAsset(asset->path))
+			{
+				assets.clear();
+				break;
+			}
+		}
+	}
+	Vector<FileInfo> files;
+	if(assets.empty())
+	{
+		files = file.ScanFiles(String("skins/") + m_skin + String("/textures/") + name);
+		if(files.empty())
+			return false;
+		SortFrames(files);
+	}
+
+	// The key covers every frame, so changing, adding or removing one packs the sequence again
+	String key = Utility::Sprintf("%d", atlasVersion);
+	for(const AssetBundle::Asset* frame : assets)
+		key += Utility::Sprintf("|%s/%s|%llu", m_skin, frame->path, frame->lastWriteTime);
+	for(const FileInfo& frame : files)
+		key += Utility::Sprintf("|%s|%llu", frame.fullPath, frame.lastWriteTime);
+	String cachePath = Path::GetCacheFilePath(Path::GetCacheFolder("atlases"), key);
+
+	Timer timer;
+	if(atlas.Load(cachePath + ".png", cachePath + ".atlas"))
+	{
+		Logf("Loaded cached atlas for %s (%d frames) in %.1f ms", Logger::Info, name, (int32)atlas.GetFrames().size(), timer.SecondsAsDouble() * 1000.0);
+		return true;
+	}
+
+	Vector<Graphics::Image> images;
+	for(const AssetBundle::Asset* frame : assets)
+	{
+		Graphics::Image image = ImageFromAsset(frame);
+		if(!image)
+			return false;
+		images.Add(image);
+	}
+	for(const FileInfo& frame : files)
+	{
+		Graphics::Image image = ImageRes::Create(frame.fullPath);
+		if(!image)
+			return false;
+		images.Add(image);
+	}
+	if(!atlas.Pack(images, maxAtlasSize))
+	{
+		Logf("Frames of %s don't fit in a %dx%d atlas, using separate textures", Logger::Warning, name, maxAtlasSize, maxAtlasSize);
+		return false;
+	}
+
+	Path::CreateDirRecursive(Path::GetCacheFolder("atlases"));
+	if(!atlas.Save(cachePath + ".png", cachePath + ".atlas"))
+		Logf("Failed to save atlas cache for %s", Logger::Warning, name);
+	Vector2i atlasSize = atlas.GetImage()->GetSize();
+	Logf("Packed %d frames of %s into a %dx%d atlas in %.1f ms", Logger::Info, (int32)images.size(), name, atlasSize.x, atlasSize.y, timer.SecondsAsDouble() * 1000.0);
+	return true;
+}
+
 Graphics::Image Application::LoadImageExternal(const String& name)
 {
 	return ImageRes::Create(name);
@@ -726,6 +1001,27 @@ Texture Application::LoadTexture(const String& name, const bool& external)
 }
 Material Application::LoadMaterial(const String& name)
 {
+	const AssetBundle::Asset* vertexAsset = FindSkinAsset("shaders/" + name + ".vs");
+	const AssetBundle::Asset* fragmentAsset = FindSkinAsset("shaders/" + name + ".fs");
+	if(vertexAsset && fragmentAsset)
+	{
+		Timer timer;
+		Material ret = MaterialRes::Create(g_gl);
+		ret->AssignShader(ShaderType::Vertex, ShaderRes::CreateFromSource(g_gl, ShaderType::Vertex,
+			String((const char*)vertexAsset->data, vertexAsset->size), vertexAsset->path));
+		ret->AssignShader(ShaderType::Fragment, ShaderRes::CreateFromSource(g_gl, ShaderType::Fragment,
+			String((const char*)fragmentAsset->data, fragmentAsset->size), fragmentAsset->path));
+		if(const AssetBundle::Asset* geometryAsset = FindSkinAsset("shaders/" + name + ".gs"))
+		{
+			ret->AssignShader(ShaderType::Geometry, ShaderRes::CreateFromSource(g_gl, ShaderType::Geometry,
+				String((const char*)geometryAsset->data, geometryAsset->size), geometryAsset->path));
+		}
+		m_bundleLoads++;
+		m_skinLoadTime += timer.SecondsAsDouble();
+		return ret;
+	}
+
+	Timer timer;
 	String pathV = String("skins/") + m_skin + String("/shaders/") + name + ".vs";
 	String pathF = String("skins/") + m_skin + String("/shaders/") + name + ".fs";
 	String pathG = String("skins/") + m_skin + String("/shaders/") + name + ".gs";
@@ -738,18 +1034,42 @@ Material Application::LoadMaterial(const String& name)
 		ret->AssignShader(ShaderType::Geometry, gshader);
 	}
 	assert(ret);
+	m_fileLoads++;
+	m_skinLoadTime += timer.SecondsAsDouble();
 	return ret;
 }
 Sample Application::LoadSample(const String& name, const bool& external)
 {
+	if(!external)
+	{
+		const AssetBundle::Asset* asset = FindSkinAsset("audio/" + name + ".wav");
+		if(asset)
+		{
+			Timer timer;
+			Sample ret = SampleRes::Create(g_audio, asset->data, asset->size, "audio/" + name + ".wav");
+			if(ret)
+			{
+				m_bundleLoads++;
+				m_skinLoadTime += timer.SecondsAsDouble();
+				return ret;
+			}
+		}
+	}
+
     String path;
     if(external)
 	    path = name;
     else
         path = String("skins/") + m_skin + String("/audio/") + name + ".wav";
 
+	Timer timer;
 	Sample ret = g_audio->CreateSample(Path::Normalize(path));
 	assert(ret);
+	if(!external)
+	{
+		m_fileLoads++;
+		m_skinLoadTime += timer.SecondsAsDouble();
+	}
 	return ret;
 }
 
@@ -765,39 +1085,34 @@ Graphics::Font Application::LoadFont(const String & name, const bool & external)
 	else
 		path = String("skins/") + m_skin + String("/fonts/") + name;
 
-	Graphics::Font newFont = FontRes::Create(g_gl, path);
+	Timer timer;
+	Graphics::Font newFont;
+	const AssetBundle::Asset* asset = external ? nullptr : FindSkinAsset("fonts/" + name);
+	if(asset && (newFont = FontRes::Create(g_gl, asset->data, asset->size)))
+		m_bundleLoads++;
+	else
+	{
+		newFont = FontRes::Create(g_gl, path);
+		if(!external)
+			m_fileLoads++;
+	}
+	if(!external)
+		m_skinLoadTime += timer.SecondsAsDouble();
 	m_fonts.Add(name, newFont);
 	return newFont;
 }
 
 int Application::LoadImageJob(const String & path, Vector2i size, int placeholder)
 {
-	int ret = placeholder;
-	auto it = m_jacketImages.find(path);
-	if (it == m_jacketImages.end() || !it->second)
-	{
-		CachedJacketImage* newImage = new CachedJacketImage();
-		JacketLoadingJob* job = new JacketLoadingJob();
-		job->imagePath = path;
-		job->target = newImage;
-		job->w = size.x;
-		job->h = size.y;
-		newImage->loadingJob = Ref<JobBase>(job);
-		newImage->lastUsage = m_jobTimer.SecondsAsFloat();
-		g_jobSheduler->Queue(newImage->loadingJob);
-
-		m_jacketImages.Add(path, newImage);
-	}
-	else
-	{
-		it->second->lastUsage = m_jobTimer.SecondsAsFloat();
-		// If loaded set texture
-		if (it->second->loaded)
-		{
-			ret = it->second->texture;
-		}
-	}
-	return ret;
+	return m_jacketCache->Get(path, size, placeholder);
+}
+JacketCache* Application::GetJacketCache()
+{
+	return m_jacketCache;
+}
+AudioSummaryCache* Application::GetAudioSummaryCache()
+{
+	return m_audioSummaryCache;
 }
 
 lua_State* Application::LoadScript(const String & name)
@@ -832,18 +1147,20 @@ void Application::ReloadScript(const String& name, lua_State* L)
 void Application::ReloadSkin()
 {
 	m_skin = g_gameConfig.GetString(GameConfigKeys::Skin);
+	m_OpenSkinBundle();
 	g_guiState.fontCahce.clear();
 	g_guiState.textCache.clear();
 	g_guiState.nextTextId.clear();
 	g_guiState.nextPaintId.clear();
 	g_guiState.paintCache.clear();
-	m_jacketImages.clear();
+	m_jacketCache->Clear();
 	nvgDeleteGL3(g_guiState.vg);
 #ifdef _DEBUG
 	g_guiState.vg = nvgCreateGL3(NVG_DEBUG);
 #else
 	g_guiState.vg = nvgCreateGL3(0);
 #endif
+	m_jacketCache->SetContext(g_guiState.vg);
 
 	nvgCreateFont(g_guiState.vg, "fallback", "fonts/fallbackfont.otf");
 }
@@ -959,8 +1276,28 @@ void Application::StopNamedSample(String name)
 {
 	m_samples[name]->Stop();
 }
+void Application::m_ToggleProfiler()
+{
+	if(!Profiler::IsCapturing())
+	{
+		Profiler::BeginCapture();
+		return;
+	}
+
+	m_profilerFrames = 0;
+	if(!Path::IsDirectory("profiles"))
+		Path::CreateDir("profiles");
+	Profiler::EndCapture("profiles/" + Shared::Time::Now().ToString() + ".json");
+}
 void Application::m_OnKeyPressed(int32 key)
 {
+	// Start/Stop profiler capture
+	if(key == SDLK_F7)
+	{
+		m_ToggleProfiler();
+		return;
+	}
+
 	// Fullscreen toggle
 	if(key == SDLK_RETURN)
 	{
@@ -1118,12 +1455,124 @@ static int lGetUpdateAvailable(lua_State* L)
 	return 2;
 }
 
+static int lGetResourceStats(lua_State* L)
+{
+	// Table of resource types with their counters
+	lua_newtable(L);
+	for(size_t i = 0; i < (size_t)ResourceType::_Length; i++)
+	{
+		ResourceType type = (ResourceType)i;
+		ResourceManagerStats stats = ResourceManagers::GetStats(type);
+		lua_pushstring(L, ResourceManagers::GetTypeName(type));
+		lua_newtable(L);
+		lua_pushstring(L, "live");
+		lua_pushinteger(L, stats.liveObjects);
+		lua_settable(L, -3);
+		lua_pushstring(L, "memory");
+		lua_pushinteger(L, (lua_Integer)stats.memoryUsage);
+		lua_settable(L, -3);
+		lua_pushstring(L, "pending");
+		lua_pushinteger(L, stats.pendingDestruction);
+		lua_settable(L, -3);
+		lua_pushstring(L, "collectedPerSecond");
+		lua_pushinteger(L, stats.collectedPerSecond);
+		lua_settable(L, -3);
+		lua_settable(L, -3);
+	}
+	return 1;
+}
+
+static int lGetJacketCacheStats(lua_State* L)
+{
+	const JacketCacheStats& stats = g_application->GetJacketCache()->GetStats();
+	auto pushNumber = [L](const char* name, lua_Number value)
+	{
+		lua_pushstring(L, name);
+		lua_pushnumber(L, value);
+		lua_settable(L, -3);
+	};
+	lua_newtable(L);
+	pushNumber("hits", stats.hits);
+	pushNumber("misses", stats.misses);
+	pushNumber("diskHits", stats.diskHits);
+	pushNumber("prefetchHits", stats.prefetchHits);
+	pushNumber("evictions", stats.evictions);
+	pushNumber("loaded", stats.numLoaded);
+	pushNumber("memory", (lua_Number)stats.memoryUsage);
+	pushNumber("pending", stats.pendingLoads);
+	pushNumber("averageLatency", stats.averageLatency);
+	pushNumber("maxLatency", stats.maxLatency);
+	return 1;
+}
+
+static int lGetWaveform(lua_State* L /* char* audioPath, int columns */)
+{
+	const char* path = luaL_checkstring(L, 1);
+	int columns = (int)luaL_checkinteger(L, 2);
+	const AudioSummary* summary = g_application->GetAudioSummaryCache()->Get(path);
+	if(!summary || columns <= 0)
+		return 0;
+
+	Vector<float> min, max, rms;
+	summary->GetWaveform((uint32)columns, min, max, rms);
+	auto pushArray = [L](const char* name, const Vector<float>& values)
+	{
+		lua_pushstring(L, name);
+		lua_createtable(L, (int)values.size(), 0);
+		for(size_t i = 0; i < values.size(); i++)
+		{
+			lua_pushnumber(L, values[i]);
+			lua_rawseti(L, -2, (lua_Integer)i + 1);
+		}
+		lua_settable(L, -3);
+	};
+	lua_newtable(L);
+	pushArray("min", min);
+	pushArray("max", max);
+	pushArray("rms", rms);
+	return 1;
+}
+
+static int lGetSpectrum(lua_State* L /* char* audioPath, int columns */)
+{
+	const char* path = luaL_checkstring(L, 1);
+	int columns = (int)luaL_checkinteger(L, 2);
+	const AudioSummary* summary = g_application->GetAudioSummaryCache()->Get(path);
+	if(!summary || columns <= 0)
+		return 0;
+
+	Vector<float> levels;
+	summary->GetSpectrum((uint32)columns, levels);
+	lua_createtable(L, (int)levels.size(), 0);
+	for(size_t i = 0; i < levels.size(); i++)
+	{
+		lua_pushnumber(L, levels[i]);
+		lua_rawseti(L, -2, (lua_Integer)i + 1);
+	}
+	lua_pushinteger(L, AudioSummary::numBands);
+	return 2;
+}
+
 static int lCreateSkinImage(lua_State* L /*const char* filename, int imageflags */)
 {
 	const char* filename = luaL_checkstring(L, 1);
 	int imageflags = luaL_checkinteger(L, 2);
-	String path = "skins/" + g_application->GetCurrentSkin() + "/textures/" + filename;
-	int handle = nvgCreateImage(g_guiState.vg, path.c_str(), imageflags);
+	int handle = 0;
+	if(g_application->FindSkinAsset(String("textures/") + filename))
+	{
+		Graphics::Image image = g_application->LoadImage(filename);
+		if(image)
+		{
+			Vector2i size = image->GetSize();
+			handle = nvgCreateImageRGBA(g_guiState.vg, size.x, size.y, imageflags, (unsigned char*)image->GetBits());
+		}
+	}
+	// Files outside the bundle are loaded by nanovg, which also reads formats the image loader doesn't, like BMP, TGA and GIF
+	if(handle == 0)
+	{
+		String path = "skins/" + g_application->GetCurrentSkin() + "/textures/" + filename;
+		handle = nvgCreateImage(g_guiState.vg, path.c_str(), imageflags);
+	}
 	if (handle != 0)
 	{
 		g_guiState.vgImages[L].Add(handle);
@@ -1352,6 +1801,10 @@ void Application::m_SetNvgLuaBindings(lua_State * state)
 		pushFuncToTable("GetButton", lGetButton);
 		pushFuncToTable("GetKnob", lGetKnob);
 		pushFuncToTable("UpdateAvailable", lGetUpdateAvailable);
+		pushFuncToTable("GetResourceStats", lGetResourceStats);
+		pushFuncToTable("GetJacketCacheStats", lGetJacketCacheStats);
+		pushFuncToTable("GetWaveform", lGetWaveform);
+		pushFuncToTable("GetSpectrum", lGetSpectrum);
 
 		//constants
 		pushIntToTable("LOGGER_INFO", Logger::Severity::Info);
@@ -1369,24 +1822,3 @@ void Application::m_SetNvgLuaBindings(lua_State * state)
 		lua_setglobal(state, "game");
 	}
 }
-
-bool JacketLoadingJob::Run()
-{
-	// Create loading task
-	loadedImage = ImageRes::Create(imagePath);
-	if (loadedImage.IsValid()) {
-		if (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h) {
-			loadedImage->ReSize({ w,h });
-		}
-	}
-	return loadedImage.IsValid();
-}
-void JacketLoadingJob::Finalize()
-{
-	if (IsSuccessfull())
-	{
-		///TODO: Maybe do the nvgCreateImage in Run() instead
-		target->texture = nvgCreateImageRGBA(g_guiState.vg, loadedImage->GetSize().x, loadedImage->GetSize().y, 0, (unsigned char*)loadedImage->GetBits());
-		target->loaded = true;
-	}
-}
@@ -2,6 +2,7 @@
 #include <Audio/Sample.hpp>
 #include <Shared/Jobs.hpp>
 #include <Shared/Thread.hpp>
+#include <Shared/AssetBundle.hpp>
 #define DISCORD_APPLICATION_ID "514489760568573952"
 extern class OpenGL* g_gl;
 extern class GUIState g_guiState;
@@ -22,14 +23,6 @@ public:
 	Application();
 	~Application();
 
-	struct CachedJacketImage
-	{
-		float lastUsage;
-		int texture;
-		bool loaded = false;
-		Job loadingJob;
-	};
-
 	// Runs the application
 	int32 Run();
 	
@@ -60,6 +53,9 @@ public:
 #endif
 	Image LoadImage(const String& name);
 	Vector<Graphics::Image> LoadImages(const String& name);
+	// Packs all images in a folder into an atlas, packed atlases are cached on disk
+	//	returns false if the images don't fit in a single atlas
+	bool LoadImageAtlas(const String& name, Graphics::TextureAtlas& atlas);
 	Graphics::Image LoadImageExternal(const String & name);
 	Texture LoadTexture(const String& name);
 	Texture LoadTexture(const String & name, const bool& external);
@@ -67,6 +63,11 @@ public:
 	Sample LoadSample(const String& name, const bool& external = false);
 	Graphics::Font LoadFont(const String& name, const bool& external = false);
 	int LoadImageJob(const String& path, Vector2i size, int placeholder);
+	class JacketCache* GetJacketCache();
+	class AudioSummaryCache* GetAudioSummaryCache();
+	// Finds an asset of the current skin in the skin bundle, by its path relative to the skin folder
+	//	returns null if there is no bundle or the file in the skin folder was changed after the bundle was built
+	const AssetBundle::Asset* FindSkinAsset(const String& path);
 	class lua_State* LoadScript(const String& name);
 	void ReloadScript(const String& name, lua_State* L);
 	void LoadGauge(bool hard);
@@ -103,6 +104,12 @@ private:
 	void m_OnKeyReleased(int32 key);
 	void m_OnWindowResized(const Vector2i& newSize);
 	void m_SetNvgLuaBindings(class lua_State* state);
+	// Starts a profiler capture or writes the current one to the profiles folder
+	void m_ToggleProfiler();
+	// Maps the bundle of the current skin, if there is one and it's enabled
+	void m_OpenSkinBundle();
+	// Builds the bundle for the current skin (-bundleskin)
+	bool m_BuildSkinBundle();
 
 	RenderState m_renderStateBase;
 	RenderQueue m_renderQueueBase;
@@ -112,7 +119,15 @@ private:
 	Material m_fontMaterial;
 	Material m_fillMaterial;
 	class HealthGauge* m_gauge;
-	Map<String, CachedJacketImage*> m_jacketImages;
+	class JacketCache* m_jacketCache = nullptr;
+	class AudioSummaryCache* m_audioSummaryCache = nullptr;
+	AssetBundle m_skinBundle;
+	// Skin assets loaded from the bundle and from separate files, and the time spent loading them
+	uint32 m_bundleLoads = 0;
+	uint32 m_fileLoads = 0;
+	double m_skinLoadTime = 0.0;
+	Timer m_startupTimer;
+	bool m_startupLogged = false;
 	String m_lastMapPath;
 	Thread m_updateThread;
 	class Beatmap* m_currentMap = nullptr;
@@ -125,19 +140,8 @@ private:
 	String m_updateVersion;
 	String m_currentVersion;
 	String m_skin;
-	Timer m_jobTimer;
+	// Remaining frames for a profiler capture started with -profile=<frames>
+	int32 m_profilerFrames = 0;
 	//gauge colors, 0 = normal fail, 1 = normal clear, 2 = hard lower, 3 = hard upper
 	Color m_gaugeColors[4] = { Colori(0, 204, 255), Colori(255, 102, 255), Colori(200, 50, 0), Colori(255, 100, 0) };
 };
-
-class JacketLoadingJob : public JobBase
-{
-public:
-	virtual bool Run();
-	virtual void Finalize();
-
-	Image loadedImage;
-	String imagePath;
-	int w = 0, h = 0;
-	Application::CachedJacketImage* target;
-};
\ No newline at end of file
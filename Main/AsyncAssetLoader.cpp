@@ -48,6 +48,42 @@ struct AsyncTexturesLoadOperation : public AsyncLoadOperation
 		return target[0].IsValid();
 	}
 };
+struct AsyncTextureSequenceLoadOperation : public AsyncLoadOperation
+{
+	TextureSequence& target;
+	Material* material;
+	TextureAtlas atlas;
+	Vector<Image> images;
+	AsyncTextureSequenceLoadOperation(TextureSequence& target, const String& path, Material* material) : target(target), material(material)
+	{
+		name = path;
+	}
+	bool AsyncLoad()
+	{
+		if(g_application->LoadImageAtlas(name, atlas))
+			return true;
+		// Too big for an atlas
+		images = g_application->LoadImages(name);
+		return !images.empty() && images[0].IsValid();
+	}
+	bool AsyncFinalize()
+	{
+		if(atlas.IsValid())
+		{
+			if(material && !(*material && (*material)->HasParameter("texRect")))
+				target = atlas.CreateTextures(g_gl);
+			else
+				target = atlas.CreateSequence(g_gl);
+		}
+		else
+		{
+			target = TextureSequence();
+			for(Image& image : images)
+				target.textures.Add(TextureRes::Create(g_gl, image));
+		}
+		return target.IsValid();
+	}
+};
 struct AsyncMeshLoadOperation : public AsyncLoadOperation
 {
 	Mesh& target;
@@ -128,6 +164,10 @@ void AsyncAssetLoader::AddTextures(Vector<Texture>& out, const String& path)
 {
 	m_impl->loadables.Add(new AsyncTexturesLoadOperation(out, path));
 }
+void AsyncAssetLoader::AddTextureSequence(TextureSequence& out, const String& path, Material* material)
+{
+	m_impl->loadables.Add(new AsyncTextureSequenceLoadOperation(out, path, material));
+}
 void AsyncAssetLoader::AddMesh(Mesh& out, const String& path)
 {
 	m_impl->loadables.Add(new AsyncMeshLoadOperation(out, path));
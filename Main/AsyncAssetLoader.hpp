@@ -16,6 +16,10 @@ public:
 	void AddTexture(Texture& out, const String& path);
 	// Add textures to be loaded
 	void AddTextures(Vector<Texture>& out, const String& path);
+	// Add an animation to be loaded, the frames are packed into an atlas
+	//	if a material is given, the atlas is only used if the material supports it (has a texRect parameter)
+	//	the material has to be added before the sequence
+	void AddTextureSequence(TextureSequence& out, const String& path, Material* material = nullptr);
 	// Add a mesh to be loaded
 	void AddMesh(Mesh& out, const String& path);
 	// Add a mesh to be loaded
@@ -10,48 +10,170 @@ AudioPlayback::AudioPlayback()
 }
 AudioPlayback::~AudioPlayback()
 {
-	m_CleanupDSP(m_buttonDSPs[0]);
-	m_CleanupDSP(m_buttonDSPs[1]);
-	m_CleanupDSP(m_laserDSP);
+	m_DestroyEffects();
 }
 bool AudioPlayback::Init(class BeatmapPlayback& playback, const String& mapRootPath)
+{
+	AudioStream music, fxTrack;
+	if(!LoadStreams(playback.GetBeatmap().GetMapSettings(), mapRootPath, music, fxTrack))
+		return false;
+	return Init(playback, mapRootPath, music, fxTrack);
+}
+bool AudioPlayback::Init(class BeatmapPlayback& playback, const String& mapRootPath, AudioStream music, AudioStream fxTrack)
 {
 	// Cleanup exising DSP's
 	m_currentHoldEffects[0] = nullptr;
 	m_currentHoldEffects[1] = nullptr;
-	m_CleanupDSP(m_buttonDSPs[0]);
-	m_CleanupDSP(m_buttonDSPs[1]);
-	m_CleanupDSP(m_laserDSP);
+	m_DestroyEffects();
 
 	m_playback = &playback;
 	m_beatmap = &playback.GetBeatmap();
 	m_beatmapRootPath = mapRootPath;
 	assert(m_beatmap != nullptr);
+	assert(music);
+
+	// Highest true peak in dBTP a boost may reach
+	const float maxTruePeak = -1.0f;
+	m_gain = 1.0f;
+	if(m_loudness.measured)
+	{
+		float gain = m_loudnessTarget - m_loudness.integrated;
+		if(gain > 0.0f)
+			gain = Math::Min(gain, Math::Max(0.0f, maxTruePeak - m_loudness.truePeak));
+		m_gain = powf(10.0f, gain / 20.0f);
+		Logf("Music loudness %.1f LUFS, true peak %.1f dBTP, applying %+.1f dB", Logger::Info, m_loudness.integrated, m_loudness.truePeak, gain);
+	}
+
+	const BeatmapSettings& mapSettings = m_beatmap->GetMapSettings();
+	m_music = music;
+	m_music->SetVolume(mapSettings.musicVolume * m_gain);
+	m_fxtrack = fxTrack;
+	if(m_fxtrack)
+	{
+		// Initially mute normal track if fx is enabled
+		m_music->SetVolume(0.0f);
+		m_fxtrack->SetVolume(m_gain);
+	}
+
+	m_CreateEffects();
 
 	// Set default effect type
+	m_laserEffectType = EffectType::None;
 	SetLaserEffect(EffectType::PeakingFilter);
 
-	const BeatmapSettings& mapSettings = m_beatmap->GetMapSettings();
-	String audioPath = Path::Normalize(m_beatmapRootPath + Path::sep + mapSettings.audioNoFX);
+	return true;
+}
+void AudioPlayback::m_CreateEffects()
+{
+	Timer timer;
+
+	// Effect durations are relative to the timing, so size everything for the slowest timing point
+	double maxNoteDuration = 0.0;
+	for(const TimingPoint* tp : m_beatmap->GetLinearTimingPoints())
+		maxNoteDuration = Math::Max(maxNoteDuration, tp->GetWholeNoteLength());
+	maxNoteDuration /= m_tempo;
+
+	// Longest duration of each effect type
+	Map<EffectType, uint32> buttonEffects;
+	Map<EffectType, uint32> laserEffects;
+	laserEffects.Add(EffectType::PeakingFilter, 0);
+	for(ObjectState* obj : m_beatmap->GetLinearObjects())
+	{
+		if(obj->type == ObjectType::Hold)
+		{
+			HoldObjectState* hold = (HoldObjectState*)obj;
+			if(hold->index < 4 || hold->effectType == EffectType::None || m_fxtrack)
+				continue;
+			uint32& maxLength = buttonEffects[hold->effectType];
+			GameAudioEffect effect = m_beatmap->GetEffect(hold->effectType);
+			maxLength = Math::Max(maxLength, effect.GetMaxLength(maxNoteDuration, hold));
+		}
+		else if(obj->type == ObjectType::Event)
+		{
+			EventObjectState* evt = (EventObjectState*)obj;
+			if(evt->key == EventKey::LaserEffectType)
+				laserEffects[evt->data.effectVal] = 0;
+		}
+	}
+
+	AudioBase* track = m_GetDSPTrack().GetData();
+	// An effect can start again before the audio thread has stopped the previous use, one spare instance covers that
+	const uint32 numButtonInstances = 3;
+	const uint32 numLaserInstances = 2;
+	for(auto& it : buttonEffects)
+	{
+		GameAudioEffect effect = m_beatmap->GetEffect(it.first);
+		for(uint32 i = 0; i < numButtonInstances; i++)
+		{
+			DSP* dsp = effect.CreateDSP(track, it.second);
+			if(!dsp)
+				break;
+			m_buttonEffectInstances.Add({ it.first, effect, dsp });
+		}
+	}
+	for(auto& it : laserEffects)
+	{
+		// Don't use Bitcrush effects over FX track
+		GameAudioEffect effect = m_beatmap->GetFilter(it.first);
+		if(effect.type == EffectType::None || (m_fxtrack && effect.type == EffectType::Bitcrush))
+			continue;
+		uint32 maxLength = effect.GetMaxLength(maxNoteDuration);
+		for(uint32 i = 0; i < numLaserInstances; i++)
+		{
+			DSP* dsp = effect.CreateDSP(track, maxLength);
+			if(!dsp)
+				break;
+			m_laserEffectInstances.Add({ it.first, effect, dsp });
+		}
+	}
+
+	Logf("Created %d effect instances for %d FX hold and %d laser effect types in %.1f ms", Logger::Info,
+		(int32)(m_buttonEffectInstances.size() + m_laserEffectInstances.size()), (int32)buttonEffects.size(), (int32)laserEffects.size(), timer.SecondsAsDouble() * 1000.0);
+}
+void AudioPlayback::m_DestroyEffects()
+{
+	m_buttonDSPs[0] = nullptr;
+	m_buttonDSPs[1] = nullptr;
+	m_laserDSP = nullptr;
+	for(Vector<EffectInstance>* instances : { &m_buttonEffectInstances, &m_laserEffectInstances })
+	{
+		for(EffectInstance& instance : *instances)
+		{
+			if(instance.dsp->audioBase)
+				instance.dsp->audioBase->RemoveDSP(instance.dsp);
+			delete instance.dsp;
+		}
+		instances->clear();
+	}
+}
+AudioPlayback::EffectInstance* AudioPlayback::m_FindIdleEffect(Vector<EffectInstance>& instances, EffectType key)
+{
+	for(EffectInstance& instance : instances)
+	{
+		if(instance.key == key && instance.dsp->IsIdle())
+			return &instance;
+	}
+	return nullptr;
+}
+bool AudioPlayback::LoadStreams(const BeatmapSettings& mapSettings, const String& mapRootPath, AudioStream& music, AudioStream& fxTrack)
+{
+	String audioPath = Path::Normalize(mapRootPath + Path::sep + mapSettings.audioNoFX);
 	audioPath.TrimBack(' ');
-	WString audioPathUnicode = Utility::ConvertToWString(audioPath);
 	if(!Path::FileExists(audioPath))
 	{
 		Logf("Audio file for beatmap does not exists at: \"%s\"", Logger::Error, audioPath);
 		return false;
 	}
-	m_music = g_audio->CreateStream(audioPath, true);
-	if(!m_music)
+	music = g_audio->CreateStream(audioPath, true);
+	if(!music)
 	{
 		Logf("Failed to load any audio for beatmap \"%s\"", Logger::Error, audioPath);
 		return false;
 	}
-	m_music->SetVolume(mapSettings.musicVolume);
 
 	// Load FX track
-	audioPath = Path::Normalize(m_beatmapRootPath + Path::sep + mapSettings.audioFX);
+	audioPath = Path::Normalize(mapRootPath + Path::sep + mapSettings.audioFX);
 	audioPath.TrimBack(' ');
-	audioPathUnicode = Utility::ConvertToWString(audioPath);
 	if(!audioPath.empty())
 	{
 		if(!Path::FileExists(audioPath) || Path::IsDirectory(audioPath))
@@ -60,12 +182,7 @@ bool AudioPlayback::Init(class BeatmapPlayback& playback, const String& mapRootP
 		}
 		else
 		{
-			m_fxtrack = g_audio->CreateStream(audioPath, true);
-			if(m_fxtrack)
-			{
-				// Initially mute normal track if fx is enabled
-				m_music->SetVolume(0.0f);
-			}
+			fxTrack = g_audio->CreateStream(audioPath, true);
 		}
 	}
 
@@ -122,28 +239,28 @@ void AudioPlayback::SetEffect(uint32 index, HoldObjectState* object, class Beatm
 		return;
 
 	assert(index >= 0 && index <= 1);
-	m_CleanupDSP(m_buttonDSPs[index]);
+	m_BypassDSP(m_buttonDSPs[index]);
 	m_currentHoldEffects[index] = object;
 
-	// For Time based effects
-	const TimingPoint* timingPoint = playback.GetTimingPointAt(object->time);
-	// Duration of a single bar
-	double barDelay = timingPoint->numerator * timingPoint->beatDuration;
-
-	DSP*& dsp = m_buttonDSPs[index];
-
-	m_buttonEffects[index] = m_beatmap->GetEffect(object->effectType);
-	dsp = m_buttonEffects[index].CreateDSP(m_GetDSPTrack().GetData(), *this);
-
-	if(dsp)
+	EffectInstance* instance = m_FindIdleEffect(m_buttonEffectInstances, object->effectType);
+	if(!instance)
 	{
-		m_buttonEffects[index].SetParams(dsp, *this, object);
-		// Initialize mix value to previous value
-		dsp->mix = m_effectMix[index];
-		dsp->startTime = object->time;
-		dsp->chartOffset = playback.GetBeatmap().GetMapSettings().offset;
-		dsp->lastTimingPoint = playback.GetCurrentTimingPoint().time;
+		if(object->effectType != EffectType::None)
+			Logf("No idle instance of effect %d for FX hold at %d", Logger::Warning, (int32)object->effectType, object->time);
+		return;
 	}
+
+	DSP* dsp = instance->dsp;
+	m_buttonEffects[index] = instance->effect;
+	m_buttonEffects[index].InitDSP(dsp, *this);
+	m_buttonEffects[index].SetParams(dsp, *this, object);
+	// Initialize mix value to previous value
+	dsp->mix = m_effectMix[index];
+	dsp->startTime = object->time;
+	dsp->chartOffset = playback.GetBeatmap().GetMapSettings().offset;
+	dsp->lastTimingPoint = playback.GetCurrentTimingPoint().time;
+	dsp->Enable();
+	m_buttonDSPs[index] = dsp;
 }
 void AudioPlayback::SetEffectEnabled(uint32 index, bool enabled)
 {
@@ -159,7 +276,7 @@ void AudioPlayback::ClearEffect(uint32 index, HoldObjectState* object)
 	assert(index >= 0 && index <= 1);
 	if(m_currentHoldEffects[index] == object)
 	{
-		m_CleanupDSP(m_buttonDSPs[index]);
+		m_BypassDSP(m_buttonDSPs[index]);
 		m_currentHoldEffects[index] = nullptr;
 	}
 }
@@ -167,7 +284,7 @@ void AudioPlayback::SetLaserEffect(EffectType type)
 {
 	if(type != m_laserEffectType)
 	{
-		m_CleanupDSP(m_laserDSP);
+		m_BypassDSP(m_laserDSP);
 		m_laserEffectType = type;
 		m_laserEffect = m_beatmap->GetFilter(type);
 	}
@@ -176,19 +293,20 @@ void AudioPlayback::SetLaserFilterInput(float input, bool active)
 {
 	if(m_laserEffect.type != EffectType::None && (active || (input != 0.0f)))
 	{
-		// Create DSP
+		// Start the effect
 		if(!m_laserDSP)
 		{
-			// Don't use Bitcrush effects over FX track
-			if(m_fxtrack.IsValid() && m_laserEffectType == EffectType::Bitcrush)
+			// Bitcrush effects aren't created when there is an FX track
+			EffectInstance* instance = m_FindIdleEffect(m_laserEffectInstances, m_laserEffectType);
+			if(!instance)
 				return;
 
-			m_laserDSP = m_laserEffect.CreateDSP(m_GetDSPTrack().GetData(), *this);
-			if(!m_laserDSP)
-			{
-				Logf("Failed to create laser DSP with type %d", Logger::Warning, m_laserEffect.type);
-				return;
-			}
+			m_laserInput = input;
+			m_laserEffect.InitDSP(instance->dsp, *this);
+			m_laserDSP = instance->dsp;
+			m_SetLaserEffectParameter(input);
+			m_laserDSP->Enable();
+			return;
 		}
 
 		// Set params
@@ -197,7 +315,7 @@ void AudioPlayback::SetLaserFilterInput(float input, bool active)
 	}
 	else
 	{
-		m_CleanupDSP(m_laserDSP);
+		m_BypassDSP(m_laserDSP);
 		m_laserInput = 0.0f;
 	}
 }
@@ -227,13 +345,13 @@ void AudioPlayback::SetFXTrackEnabled(bool enabled)
 	{
 		if(enabled)
 		{
-			m_fxtrack->SetVolume(1.0f);
+			m_fxtrack->SetVolume(m_gain);
 			m_music->SetVolume(0.0f);
 		}
 		else
 		{
 			m_fxtrack->SetVolume(0.0f);
-			m_music->SetVolume(1.0f);
+			m_music->SetVolume(m_gain);
 		}
 	}
 	m_fxtrackEnabled = enabled;
@@ -260,18 +378,68 @@ float AudioPlayback::GetPlaybackSpeed() const
 {
 	return m_music->PlaybackSpeed;
 }
+bool AudioPlayback::SetTempo(float tempo)
+{
+	if(tempo == m_tempo)
+		return true;
+	if(!m_music->SetTempo(tempo))
+		return false;
+	if(m_fxtrack)
+		m_fxtrack->SetTempo(tempo);
+	m_tempo = tempo;
+
+	// Effect lengths follow the played audio, so their buffers have to fit the new tempo
+	m_DestroyEffects();
+	m_CreateEffects();
+	return true;
+}
+float AudioPlayback::GetTempo() const
+{
+	return m_tempo;
+}
+bool AudioPlayback::SetLoop(MapTime start, MapTime end)
+{
+	if(!m_music->SetLoop(start, end))
+		return false;
+	if(m_fxtrack)
+		m_fxtrack->SetLoop(start, end);
+	return true;
+}
+uint32 AudioPlayback::GetLoopCount() const
+{
+	return m_music->GetLoopCount();
+}
+float AudioPlayback::GetTimeStretchLoad() const
+{
+	float load = m_music->GetTimeStretchLoad();
+	if(m_fxtrack)
+		load += m_fxtrack->GetTimeStretchLoad();
+	return load;
+}
+double AudioPlayback::GetWholeNoteLength() const
+{
+	return m_playback->GetCurrentTimingPoint().GetWholeNoteLength() / m_tempo;
+}
 void AudioPlayback::SetVolume(float volume)
 {
-	m_music->SetVolume(volume);
+	m_music->SetVolume(volume * m_gain);
 	if (m_fxtrack)
-		m_fxtrack->SetVolume(volume);
+		m_fxtrack->SetVolume(volume * m_gain);
+}
+void AudioPlayback::SetLoudness(const LoudnessInfo& loudness, float target)
+{
+	m_loudness = loudness;
+	m_loudnessTarget = target;
+}
+float AudioPlayback::GetLoudnessGain() const
+{
+	return m_gain;
 }
-void AudioPlayback::m_CleanupDSP(DSP*& ptr)
+void AudioPlayback::m_BypassDSP(DSP*& ptr)
 {
 	if(ptr)
 	{
-		m_GetDSPTrack()->RemoveDSP(ptr);
-		delete ptr;
+		ptr->Bypass();
 		ptr = nullptr;
 	}
 }
@@ -283,7 +451,7 @@ void AudioPlayback::m_SetLaserEffectParameter(float input)
 
 	// Mix float biquad filters, these are applied manualy by changing the filter parameters (gain,q,freq,etc.)
 	float mix = m_laserEffectMix;
-	double noteDuration = m_playback->GetCurrentTimingPoint().GetWholeNoteLength();
+	double noteDuration = GetWholeNoteLength();
 	uint32 actualLength = m_laserEffect.duration.Sample(input).Absolute(noteDuration);
 
 	if(input < 0.1f)
@@ -1,5 +1,6 @@
 #pragma once
 #include <Beatmap/Beatmap.hpp>
+#include <Beatmap/MapDatabase.hpp>
 #include <Beatmap/AudioEffects.hpp>
 #include <Audio/AudioStream.hpp>
 
@@ -13,8 +14,13 @@ public:
 	GameAudioEffect() = default;
 	GameAudioEffect(const AudioEffect& other);
 
-	// Creates a DSP matching this effect
-	DSP* CreateDSP(class AudioBase* audioTrack, AudioPlayback& playback);
+	// Creates a DSP matching this effect and adds it bypassed to the track
+	//	buffers are allocated for effect durations up to maxLength milliseconds
+	DSP* CreateDSP(class AudioBase* audioTrack, uint32 maxLength);
+	// Longest duration in milliseconds this effect uses at the given whole note length, including the parameters of a hold when given
+	uint32 GetMaxLength(double noteDuration, HoldObjectState* object = nullptr);
+	// Sets the parameters of this effect for the current laser input and timing, the DSP has to be idle
+	void InitDSP(DSP* dsp, AudioPlayback& playback);
 	// Applies the given parameters overriding some settings for this effect (depending on the effect)
 	void SetParams(DSP* dsp, AudioPlayback& playback, HoldObjectState* object);
 };
@@ -22,6 +28,9 @@ public:
 /* 
 	Handles playback of map audio
 	keeps track of the state of sound effects
+
+	Every effect the chart uses is created when it is loaded and stays on the DSP track bypassed,
+	during gameplay effects are only enabled, bypassed and given new parameters so neither the game nor the audio thread allocates or locks
 */
 class AudioPlayback : Unique
 {
@@ -31,6 +40,11 @@ public:
 	// Loads audio for beatmap
 	//	specify the root path for the map in order to let this class find the audio files
 	bool Init(class BeatmapPlayback& playback, const String& mapRootPath);
+	// Same as above, with the music and FX track already loaded by LoadStreams
+	bool Init(class BeatmapPlayback& playback, const String& mapRootPath, AudioStream music, AudioStream fxTrack);
+	// Opens and decodes the music and FX track of a map, fxTrack is left empty when the map has none
+	//	doesn't touch any playback state, so this can run on a job thread
+	static bool LoadStreams(const BeatmapSettings& mapSettings, const String& mapRootPath, AudioStream& music, AudioStream& fxTrack);
 
 	// Updates effects
 	void Tick(float deltaTime);
@@ -74,10 +88,42 @@ public:
 	float GetPlaybackSpeed() const;
 	void SetVolume(float volume);
 
+	// Loudness of the music measured by the library scan, the next Init applies a static gain that brings it to <target> LUFS
+	//	boosts are limited so the true peak stays below the limiter, which then only has to catch overs the measurement didn't predict
+	void SetLoudness(const LoudnessInfo& loudness, float target);
+	// Static gain applied to the music and FX track, 1 when there is no measurement
+	float GetLoudnessGain() const;
+
+	// Practice mode speed, stretches the music and FX track without changing the pitch
+	//	effects are created again for the new tempo, returns false when the audio can't be stretched
+	bool SetTempo(float tempo);
+	float GetTempo() const;
+	// Loops the audio between two map times, an end at or before the start disables it
+	bool SetLoop(MapTime start, MapTime end);
+	// Increases every time the loop jumps back
+	uint32 GetLoopCount() const;
+	float GetTimeStretchLoad() const;
+	// Length of a whole note at the current timing point in milliseconds of audio as it is played, longer when slowed down
+	double GetWholeNoteLength() const;
+
 private:
+	// Effect created when the chart is loaded
+	struct EffectInstance
+	{
+		// Effect type used in the chart, can be a user defined one
+		EffectType key;
+		GameAudioEffect effect;
+		class DSP* dsp;
+	};
+
 	// Returns the track that should have effects applied to them
 	AudioStream m_GetDSPTrack();
-	void m_CleanupDSP(class DSP*& ptr);
+	// Creates the effects for every FX hold and laser effect in the chart
+	void m_CreateEffects();
+	void m_DestroyEffects();
+	// Finds an instance of an effect the audio thread is not using, nullptr if there is none
+	EffectInstance* m_FindIdleEffect(Vector<EffectInstance>& instances, EffectType key);
+	void m_BypassDSP(class DSP*& ptr);
 	void m_SetLaserEffectParameter(float input);
 
 	// Map player
@@ -90,6 +136,10 @@ private:
 	AudioStream m_fxtrack;
 	bool m_paused = false;
 	bool m_fxtrackEnabled = true;
+	float m_tempo = 1.0f;
+	LoudnessInfo m_loudness;
+	float m_loudnessTarget = 0.0f;
+	float m_gain = 1.0f;
 
 	EffectType m_laserEffectType = EffectType::None;
 	GameAudioEffect m_laserEffect;
@@ -97,6 +147,10 @@ private:
 	float m_laserEffectMix = 1.0f;
 	float m_laserInput = 0.0f;
 
+	// Instances of each effect used on FX holds and lasers, a few of each so an effect can start again while the audio thread is still finishing the last block of the previous one
+	Vector<EffectInstance> m_buttonEffectInstances;
+	Vector<EffectInstance> m_laserEffectInstances;
+
 	GameAudioEffect m_buttonEffects[2];
 	class DSP* m_buttonDSPs[2] = { nullptr };
 	HoldObjectState* m_currentHoldEffects[2] = { nullptr };
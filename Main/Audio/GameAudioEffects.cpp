@@ -4,33 +4,121 @@
 #include <Audio/DSP.hpp>
 #include <Audio/Audio.hpp>
 
-DSP* GameAudioEffect::CreateDSP(class AudioBase* audioTrack, AudioPlayback& playback)
+DSP* GameAudioEffect::CreateDSP(class AudioBase* audioTrack, uint32 maxLength)
 {
 	DSP* ret = nullptr;
+	switch(type)
+	{
+	case EffectType::Bitcrush:
+		ret = new BitCrusherDSP();
+		break;
+	case EffectType::Echo:
+		ret = new EchoDSP();
+		break;
+	case EffectType::PeakingFilter:
+	case EffectType::LowPassFilter:
+	case EffectType::HighPassFilter:
+		ret = new BQFDSP();
+		break;
+	case EffectType::Gate:
+		ret = new GateDSP();
+		break;
+	case EffectType::TapeStop:
+		ret = new TapeStopDSP();
+		break;
+	case EffectType::Retrigger:
+		ret = new RetriggerDSP();
+		break;
+	case EffectType::Wobble:
+		ret = new WobbleDSP();
+		break;
+	case EffectType::Phaser:
+		ret = new PhaserDSP();
+		break;
+	case EffectType::Flanger:
+		ret = new FlangerDSP();
+		break;
+	case EffectType::SideChain:
+		ret = new SidechainDSP();
+		break;
+	case EffectType::PitchShift:
+		ret = new PitchShiftDSP();
+		break;
+	}
+
+	if(!ret)
+	{
+		Logf("Failed to create game audio effect for type \"%s\"", Logger::Warning, Enum_EffectType::ToString(type));
+		return nullptr;
+	}
 
-	const TimingPoint& tp = playback.GetBeatmapPlayback().GetCurrentTimingPoint();
-	double noteDuration = tp.GetWholeNoteLength();
+	ret->Bypass();
+	audioTrack->AddDSP(ret);
+
+	// Allocate buffers for the longest use in the chart
+	switch(type)
+	{
+	case EffectType::Echo:
+		((EchoDSP*)ret)->SetMaxLength(maxLength);
+		break;
+	case EffectType::TapeStop:
+		((TapeStopDSP*)ret)->SetMaxLength(maxLength);
+		break;
+	case EffectType::Retrigger:
+		((RetriggerDSP*)ret)->SetMaxLength(maxLength);
+		break;
+	case EffectType::Flanger:
+	{
+		// FX holds use a 10-40 range
+		uint32 maxDelay = Math::Max<uint32>(40, Math::Max(flanger.depth.Sample(0.f), flanger.depth.Sample(1.f)));
+		((FlangerDSP*)ret)->SetDelayRange(0, maxDelay);
+		break;
+	}
+	}
+
+	return ret;
+}
+uint32 GameAudioEffect::GetMaxLength(double noteDuration, HoldObjectState* object)
+{
+	uint32 length = Math::Max(duration.Sample(0.f).Absolute(noteDuration), duration.Sample(1.f).Absolute(noteDuration));
+	if(!object)
+		return length;
+
+	// Lengths set by SetParams
+	int16 division = Math::Max(object->effectParams[0], (int16)1);
+	switch(type)
+	{
+	case EffectType::TapeStop:
+		length = Math::Max(length, (uint32)(1000 * 16 / division));
+		break;
+	case EffectType::Gate:
+	case EffectType::Retrigger:
+	case EffectType::Echo:
+	case EffectType::Wobble:
+		length = Math::Max(length, (uint32)(noteDuration / division));
+		break;
+	}
+	return length;
+}
+void GameAudioEffect::InitDSP(DSP* dsp, AudioPlayback& playback)
+{
+	double noteDuration = playback.GetWholeNoteLength();
 
 	float filterInput = playback.GetLaserFilterInput();
 	uint32 actualLength = duration.Sample(filterInput).Absolute(noteDuration);
-	uint32 maxLength = Math::Max(duration.Sample(0.f).Absolute(noteDuration), duration.Sample(1.f).Absolute(noteDuration));
 	switch(type)
 	{
 	case EffectType::Bitcrush:
 	{
-		BitCrusherDSP* bcDSP = new BitCrusherDSP();
-		audioTrack->AddDSP(bcDSP);
+		BitCrusherDSP* bcDSP = (BitCrusherDSP*)dsp;
 		bcDSP->SetPeriod((float)bitcrusher.reduction.Sample(filterInput));
-		ret = bcDSP;
 		break;
 	}
 	case EffectType::Echo:
 	{
-		EchoDSP* echoDSP = new EchoDSP();
-		audioTrack->AddDSP(echoDSP);
+		EchoDSP* echoDSP = (EchoDSP*)dsp;
 		echoDSP->feedback = echo.feedback.Sample(filterInput) / 100.0f;
 		echoDSP->SetLength(actualLength);
-		ret = echoDSP;
 		break;
 	}
 	case EffectType::PeakingFilter:
@@ -38,102 +126,74 @@ DSP* GameAudioEffect::CreateDSP(class AudioBase* audioTrack, AudioPlayback& play
 	case EffectType::HighPassFilter:
 	{
 		// Don't set anthing for biquad Filters
-		BQFDSP* bqfDSP = new BQFDSP();
-		audioTrack->AddDSP(bqfDSP);
-		ret = bqfDSP;
 		break;
 	}
 	case EffectType::Gate:
 	{
-		GateDSP* gateDSP = new GateDSP();
-		audioTrack->AddDSP(gateDSP);
+		GateDSP* gateDSP = (GateDSP*)dsp;
 		gateDSP->SetLength(actualLength);
 		gateDSP->SetGating(gate.gate.Sample(filterInput));
-		ret = gateDSP;
 		break;
 	}
 	case EffectType::TapeStop:
 	{
-		TapeStopDSP* tapestopDSP = new TapeStopDSP();
-		audioTrack->AddDSP(tapestopDSP);
+		TapeStopDSP* tapestopDSP = (TapeStopDSP*)dsp;
 		tapestopDSP->SetLength(actualLength);
-		ret = tapestopDSP;
 		break;
 	}
 	case EffectType::Retrigger:
 	{
-		RetriggerDSP* retriggerDSP = new RetriggerDSP();
-		audioTrack->AddDSP(retriggerDSP);
-		retriggerDSP->SetMaxLength(maxLength);
+		RetriggerDSP* retriggerDSP = (RetriggerDSP*)dsp;
 		retriggerDSP->SetLength(actualLength);
 		retriggerDSP->SetGating(retrigger.gate.Sample(filterInput));
 		retriggerDSP->SetResetDuration(retrigger.reset.Sample(filterInput).Absolute(noteDuration));
-		ret = retriggerDSP;
 		break;
 	}
 	case EffectType::Wobble:
 	{
-		WobbleDSP* wb = new WobbleDSP();
-		audioTrack->AddDSP(wb);
+		WobbleDSP* wb = (WobbleDSP*)dsp;
 		wb->SetLength(actualLength);
 		wb->q = wobble.q.Sample(filterInput);
 		wb->fmax = wobble.max.Sample(filterInput);
 		wb->fmin = wobble.min.Sample(filterInput);
-		ret = wb;
 		break;
 	}
 	case EffectType::Phaser:
 	{
-		PhaserDSP* phs = new PhaserDSP();
-		audioTrack->AddDSP(phs);
+		PhaserDSP* phs = (PhaserDSP*)dsp;
 		phs->SetLength(actualLength);
 		phs->dmin = phaser.min.Sample(filterInput);
 		phs->dmax = phaser.max.Sample(filterInput);
 		phs->fb = phaser.feedback.Sample(filterInput);
-		ret = phs;
 		break;
 	}
 	case EffectType::Flanger:
 	{
-		FlangerDSP* fl = new FlangerDSP();
-		audioTrack->AddDSP(fl);
+		FlangerDSP* fl = (FlangerDSP*)dsp;
 		fl->SetLength(actualLength);
 		fl->SetDelayRange(flanger.offset.Sample(filterInput),
 			flanger.depth.Sample(filterInput));
-		ret = fl;
 		break;
 	}
 	case EffectType::SideChain:
 	{
-		SidechainDSP* sc = new SidechainDSP();
-		audioTrack->AddDSP(sc);
+		SidechainDSP* sc = (SidechainDSP*)dsp;
 		sc->SetLength(actualLength);
 		sc->amount = 1.0f;
 		sc->curve = Interpolation::CubicBezier(0.39, 0.575, 0.565, 1);
-		ret = sc;
 		break;
 	}
 	case EffectType::PitchShift:
 	{
-		PitchShiftDSP* ps = new PitchShiftDSP();
-		audioTrack->AddDSP(ps);
+		PitchShiftDSP* ps = (PitchShiftDSP*)dsp;
 		ps->amount = pitchshift.amount.Sample(filterInput);
-		ret = ps;
 		break;
 	}
 	}
-
-	if(!ret)
-	{
-		Logf("Failed to create game audio effect for type \"%s\"", Logger::Warning, Enum_EffectType::ToString(type));
-	}
-
-	return ret;
 }
 void GameAudioEffect::SetParams(DSP* dsp, AudioPlayback& playback, HoldObjectState* object)
 {
-	const TimingPoint& tp = playback.GetBeatmapPlayback().GetCurrentTimingPoint();
-	double noteDuration = tp.GetWholeNoteLength();
+	double noteDuration = playback.GetWholeNoteLength();
 
 	switch(type)
 	{
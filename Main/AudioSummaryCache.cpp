@@ -0,0 +1,124 @@
+#include "stdafx.h"
+#include "AudioSummaryCache.hpp"
+#include "Application.hpp"
+#include "Shared/Files.hpp"
+#include <Audio/Audio.hpp>
+#include <Audio/AudioSummary.hpp>
+
+const char* AudioSummaryCache::summaryFolder = "summaries";
+
+static String GetSummaryPath(const String& audioPath, uint64 lastWriteTime)
+{
+	String key = Utility::Sprintf("%s|%llu", audioPath, lastWriteTime);
+	return Path::GetCacheFilePath(Path::GetCacheFolder(AudioSummaryCache::summaryFolder), key, "summary");
+}
+
+AudioSummaryCache::AudioSummaryCache()
+{
+	Path::CreateDirRecursive(Path::GetCacheFolder(summaryFolder));
+}
+AudioSummaryCache::~AudioSummaryCache()
+{
+	Clear();
+}
+
+const AudioSummary* AudioSummaryCache::Get(const String& path)
+{
+	Entry* entry = m_entries.Find(path);
+	if(!entry)
+	{
+		entry = m_entries.Add(path);
+		AudioSummaryJob* job = new AudioSummaryJob();
+		job->audioPath = path;
+		job->cache = this;
+		job->jobFlags = JobFlags::IO;
+		entry->job = Ref<AudioSummaryJob>(job);
+		g_jobSheduler->Queue(entry->job.As<JobBase>());
+	}
+	else
+	{
+		m_entries.Touch(entry);
+	}
+	return entry->summary;
+}
+
+void AudioSummaryCache::Update()
+{
+	// Summaries that are still loading are skipped, so a slow build doesn't keep the ones in front of it loaded
+	m_entries.Evict(
+		[&]() { return m_entries.GetSize() > m_maxSummaries; },
+		[](Entry*) { return false; },
+		[](Entry* entry) { delete entry->summary; });
+}
+void AudioSummaryCache::Clear()
+{
+	m_entries.Clear([](Entry* entry) { delete entry->summary; });
+}
+void AudioSummaryCache::SetBudget(uint32 maxSummaries)
+{
+	m_maxSummaries = maxSummaries;
+}
+
+void AudioSummaryCache::m_OnLoaded(AudioSummaryJob* job)
+{
+	Entry* entry = m_entries.FindLoading(job->audioPath, job);
+	if(!entry)
+		return;
+
+	if(job->IsSuccessfull())
+	{
+		entry->summary = job->summary;
+		job->summary = nullptr;
+		Logf("%s audio summary for \"%s\" in %.1f ms", Logger::Info, job->fromDisk ? "Loaded" : "Built", job->audioPath, job->time);
+	}
+	// Failed summaries stay in the cache so they are not built again every frame
+	entry->job.Release();
+}
+
+AudioSummaryJob::~AudioSummaryJob()
+{
+	delete summary;
+}
+bool AudioSummaryJob::Run()
+{
+	Timer timer;
+	summary = new AudioSummary();
+
+	String summaryPath;
+	uint64 lastWriteTime = Files::GetLastWriteTime(audioPath);
+	if(lastWriteTime != 0)
+	{
+		summaryPath = GetSummaryPath(audioPath, lastWriteTime);
+		File file;
+		if(Path::FileExists(summaryPath) && file.OpenRead(summaryPath))
+		{
+			FileReader reader(file);
+			if(summary->Serialize(reader))
+			{
+				fromDisk = true;
+				time = timer.SecondsAsDouble() * 1000.0;
+				return true;
+			}
+		}
+	}
+
+	if(!summary->Build(g_audio, audioPath))
+		return false;
+
+	if(!summaryPath.empty())
+	{
+		File file;
+		if(file.OpenWrite(summaryPath))
+		{
+			FileWriter writer(file);
+			summary->Serialize(writer);
+		}
+	}
+	time = timer.SecondsAsDouble() * 1000.0;
+	return true;
+}
+void AudioSummaryJob::Finalize()
+{
+	if(cache)
+		cache->m_OnLoaded(this);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <Shared/Jobs.hpp>
+#include "LoadingCache.hpp"
+
+class AudioSummary;
+
+/*
+	Waveform and spectrum overviews of chart audio for skins, see AudioSummary
+	A summary is built on a job thread the first time an audio file is requested and saved in a cache folder,
+	keyed on the path and modification time of the audio file, so later requests only read the stored summary
+	Loaded summaries are kept up to a count budget, the least recently used ones are freed first
+*/
+class AudioSummaryCache : public Unique
+{
+public:
+	AudioSummaryCache();
+	~AudioSummaryCache();
+
+	// Returns the summary of an audio file, nullptr while it is being loaded or if it can't be built
+	const AudioSummary* Get(const String& path);
+
+	// Frees summaries while over budget, call once per frame
+	void Update();
+	void Clear();
+	void SetBudget(uint32 maxSummaries);
+
+	// Folder in the cache folder containing the stored summaries
+	static const char* summaryFolder;
+
+private:
+	struct Entry
+	{
+		AudioSummary* summary = nullptr;
+		Ref<class AudioSummaryJob> job;
+		List<String>::iterator lruIt;
+	};
+
+	void m_OnLoaded(class AudioSummaryJob* job);
+	friend class AudioSummaryJob;
+
+	LoadingCache<Entry> m_entries;
+	uint32 m_maxSummaries = 32;
+};
+
+class AudioSummaryJob : public JobBase
+{
+public:
+	~AudioSummaryJob();
+	virtual bool Run();
+	virtual void Finalize();
+
+	String audioPath;
+	// Handed to the cache by Finalize
+	AudioSummary* summary = nullptr;
+	bool fromDisk = false;
+	double time = 0.0;
+	AudioSummaryCache* cache = nullptr;
+};
@@ -0,0 +1,90 @@
+#include "stdafx.h"
+#include "ChartPreparation.hpp"
+#include "Game.hpp"
+#include "AudioPlayback.hpp"
+#include <Beatmap/Beatmap.hpp>
+
+PreparedChart::PreparedChart(const String& mapPath)
+{
+	m_mapPath = Path::Normalize(mapPath);
+	m_mapRootPath = Path::RemoveLast(m_mapPath, nullptr);
+	m_cancelled = false;
+	jobFlags = JobFlags::IO;
+}
+
+bool PreparedChart::Run()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if(m_cancelled || m_claimed)
+			return false;
+		m_started = true;
+	}
+
+	Timer timer;
+	Ref<Beatmap> beatmap = TryLoadMap(m_mapPath);
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_beatmap = beatmap;
+		parseTime = timer.SecondsAsDouble() * 1000.0;
+		m_chartLoaded = true;
+	}
+	m_loaded.notify_all();
+
+	// The chart might be in use by the game already, it is only read from here on
+	timer.Restart();
+	AudioStream music, fxTrack;
+	bool loaded = beatmap && !m_cancelled && AudioPlayback::LoadStreams(beatmap->GetMapSettings(), m_mapRootPath, music, fxTrack);
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if(loaded)
+		{
+			m_music = music;
+			m_fxTrack = fxTrack;
+			audioTime = timer.SecondsAsDouble() * 1000.0;
+		}
+		m_audioLoaded = true;
+	}
+	m_loaded.notify_all();
+	return loaded;
+}
+
+bool PreparedChart::ClaimChart(Ref<Beatmap>& beatmap)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	// Nothing is loaded after this, the game loads the chart itself when it didn't start yet
+	m_claimed = true;
+	if(!m_started)
+		return false;
+
+	m_loaded.wait(lock, [this]() { return m_chartLoaded; });
+	beatmap = m_beatmap;
+	m_beatmap.Release();
+	return (bool)beatmap;
+}
+
+bool PreparedChart::ClaimAudio(AudioStream& music, AudioStream& fxTrack)
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	if(!m_started)
+		return false;
+
+	m_loaded.wait(lock, [this]() { return m_audioLoaded; });
+	if(!m_music)
+		return false;
+	music = m_music;
+	fxTrack = m_fxTrack;
+	m_music.Release();
+	m_fxTrack.Release();
+	return true;
+}
+
+void PreparedChart::Cancel()
+{
+	m_cancelled = true;
+}
+
+const String& PreparedChart::GetMapPath() const
+{
+	return m_mapPath;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <Shared/Jobs.hpp>
+#include <Audio/Audio.hpp>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class Beatmap;
+
+/*
+	Chart and audio of a difficulty, loaded on a job thread while the transition screen loads the game
+	Song select starts preparing the difficulty when it is confirmed and hands the job to the game,
+	the game takes the chart first and the audio once it loaded the skin assets, so decoding the audio overlaps with loading them
+*/
+class PreparedChart : public JobBase
+{
+public:
+	PreparedChart(const String& mapPath);
+
+	virtual bool Run() override;
+
+	// Takes the loaded chart, waits when it is still being parsed
+	//	returns false when preparation didn't start yet or failed, it doesn't start anymore after this
+	bool ClaimChart(Ref<Beatmap>& beatmap);
+	// Takes the loaded audio after the chart was claimed, waits when it is still being decoded
+	bool ClaimAudio(AudioStream& music, AudioStream& fxTrack);
+	// Stops a preparation that didn't start yet or skips the audio when only the chart is loaded
+	void Cancel();
+
+	// Normalized path of the chart file
+	const String& GetMapPath() const;
+
+	// Time in milliseconds spent parsing the chart and decoding the audio
+	double parseTime = 0.0;
+	double audioTime = 0.0;
+
+private:
+	String m_mapPath;
+	String m_mapRootPath;
+	// Guards the results, claiming waits on m_loaded until the part it takes is done
+	std::mutex m_lock;
+	std::condition_variable m_loaded;
+	std::atomic<bool> m_cancelled;
+	bool m_started = false;
+	bool m_claimed = false;
+	bool m_chartLoaded = false;
+	bool m_audioLoaded = false;
+
+	Ref<Beatmap> m_beatmap;
+	AudioStream m_music;
+	AudioStream m_fxTrack;
+};
@@ -5,6 +5,7 @@
 #include <random>
 #include <Beatmap/BeatmapPlayback.hpp>
 #include <Shared/Profiling.hpp>
+#include <Graphics/ResourceManagers.hpp>
 #include "Scoring.hpp"
 #include <Audio/Audio.hpp>
 #include "Track.hpp"
@@ -17,6 +18,8 @@
 #include "TransitionScreen.hpp"
 #include "AsyncAssetLoader.hpp"
 #include "GameConfig.hpp"
+#include <Shared/LuaBindings.hpp>
+#include "ChartPreparation.hpp"
 #include <Shared/Time.hpp>
 
 #ifdef _WIN32
@@ -120,11 +123,26 @@ private:
 
 	// Lua state
 	lua_State* m_lua = nullptr;
+	// Tables updated in place every frame, instead of creating new ones
+	LuaRef m_luaGameplay;
+	LuaRef m_luaScoreReplays;
+	LuaRef m_luaCritLine;
+	LuaRef m_luaCursors[2];
+	// Script functions, bound again when the script is reloaded
+	LuaRef m_luaRender;
+	LuaRef m_luaRenderCritBase;
+	LuaRef m_luaRenderCritOverlay;
+	LuaRef m_luaRenderIntro;
+	LuaRef m_luaRenderOutro;
+	LuaRef m_luaForceRender;
+	LuaRef m_luaNearHit;
+	LuaRef m_luaUpdateCombo;
+	LuaRef m_luaUpdateScore;
+	LuaRef m_luaLaserAlert;
+	LuaGarbageCollector m_luaGC;
 
 	// Currently active timing point
 	const TimingPoint* m_currentTiming;
-	// Currently visible gameplay objects
-	Vector<ObjectState*> m_currentObjectSet;
 	MapTime m_lastMapTime;
 
 	// Rate to sample gauge;
@@ -148,15 +166,15 @@ private:
 	Texture VoltRParticleTexture;
 	Texture VoltLParticleTexture;
 	Texture BTParticleTexture;
-	Vector<Texture> scoreHitTexturestest[3];
-	Vector<Texture> VoltLCorner;
-	Vector<Texture> VoltLloop;
-	Vector<Texture> VoltLloop2;
-	Vector<Texture> VoltRCorner;
-	Vector<Texture> VoltRloop;
-	Vector<Texture> VoltRloop2;
-	Vector<Texture> Holdinital;
-	Vector<Texture> Holdloop;
+	TextureSequence scoreHitTexturestest[3];
+	TextureSequence VoltLCorner;
+	TextureSequence VoltLloop;
+	TextureSequence VoltLloop2;
+	TextureSequence VoltRCorner;
+	TextureSequence VoltRloop;
+	TextureSequence VoltRloop2;
+	TextureSequence Holdinital;
+	TextureSequence Holdloop;
 	ParticleSystem m_particleSystem;
 	Ref<ParticleEmitter> m_laserFollowEmitters[2];
 	Ref<TextureAnimatorParameterManager> m_laserCornerAnimator[2];
@@ -172,12 +190,29 @@ private:
 	TextureAnimator m_TextureAnimator;
 
 	bool m_manualExit = false;
+	// Practice mode speed and A-B loop in map time, scores aren't saved once either was used
+	float m_practiceSpeed = 1.0f;
+	MapTime m_loopStart = -1;
+	MapTime m_loopEnd = -1;
+	uint32 m_loopCount = 0;
+	bool m_practiced = false;
+	// Set while resources released during gameplay are kept until the game ends
+	bool m_deferringResources = false;
 
 	float m_shakeAmount = 3;
 	float m_shakeDuration = 0.083;
 
 	Map<ScoreIndex*, ScoreReplay> m_scoreReplays;
 
+	// Chart and audio loaded on a job thread since the song was confirmed, held until the audio is claimed
+	Ref<PreparedChart> m_preparedChart;
+	bool m_usedPreparedChart = false;
+	// Started when the game is created, which is when the song is confirmed in song select
+	Timer m_launchTimer;
+	// Time from confirming the song until loading finished and until the first gameplay tick, in milliseconds
+	double m_loadTime = 0.0;
+	double m_launchTime = 0.0;
+
 public:
 	Game_Impl(const String& mapPath, GameFlags flags)
 	{
@@ -209,6 +244,10 @@ public:
         m_usecMod = g_gameConfig.GetBool(GameConfigKeys::UseCMod);
         m_modSpeed = g_gameConfig.GetFloat(GameConfigKeys::ModSpeed);
 	}
+	Game_Impl(const DifficultyIndex& difficulty, GameFlags flags, Ref<PreparedChart> prepared) : Game_Impl(difficulty, flags)
+	{
+		m_preparedChart = prepared;
+	}
 	~Game_Impl()
 	{
 		if(m_track)
@@ -218,7 +257,13 @@ public:
 		if (m_foreground)
 			delete m_foreground;
 		if (m_lua)
+		{
+			m_luaGC.Detach();
 			g_application->DisposeLua(m_lua);
+		}
+		// Loading stopped before the prepared audio was claimed
+		if(m_preparedChart)
+			m_preparedChart->Cancel();
 		// Save hispeed
 		g_gameConfig.Set(GameConfigKeys::HiSpeed, m_hispeed);
 
@@ -227,6 +272,10 @@ public:
 		// In case the cursor was still hidden
 		g_gameWindow->SetCursorVisible(true); 
 		g_input.OnButtonPressed.RemoveAll(this);
+
+		// Destroy resources that were released during gameplay
+		if(m_deferringResources)
+			ResourceManagers::EndDeferDestruction();
 	}
 
 	AsyncAssetLoader loader;
@@ -240,7 +289,16 @@ public:
 			return false;
 		}
 
-		m_beatmap = TryLoadMap(m_mapPath);
+		// The chart might be prepared on a job thread already, its audio is decoded there while the assets below load
+		if(m_preparedChart && m_preparedChart->GetMapPath() == m_mapPath)
+			m_usedPreparedChart = m_preparedChart->ClaimChart(m_beatmap);
+		if(!m_usedPreparedChart)
+		{
+			if(m_preparedChart)
+				m_preparedChart->Cancel();
+			m_preparedChart.Release();
+			m_beatmap = TryLoadMap(m_mapPath);
+		}
 
 		// Check failure of above loading attempts
 		if(!m_beatmap)
@@ -326,15 +384,9 @@ public:
 		if(!InitGameplay())
 			return false;
 
-		// Load beatmap audio
-		if(!m_audioPlayback.Init(m_playback, m_mapRootPath))
-			return false;
-
 		// Get fps limit
 		m_fpsTarget = g_gameConfig.GetInt(GameConfigKeys::FPSTarget);
 
-		ApplyAudioLeadin();
-
 		// Load audio offset
 		m_audioOffset = g_gameConfig.GetInt(GameConfigKeys::GlobalOffset);
 		m_playback.audioOffset = m_audioOffset;
@@ -355,17 +407,17 @@ public:
 		loader.AddTexture(VoltRParticleTexture, "eff_vol_r.png");
 		loader.AddTexture(BTParticleTexture, "particle_glow_03.png");
 		loader.AddMaterial(particleMaterial, "particle");
-		loader.AddTextures(Holdinital, "Hold_init");
-		loader.AddTextures(Holdloop, "Hold_loop");
-		loader.AddTextures(VoltLCorner, "L_Corner");
-		loader.AddTextures(VoltLloop, "L_Loop");
-		loader.AddTextures(VoltLloop2, "L_Loop2");
-		loader.AddTextures(VoltRCorner, "R_Corner");
-		loader.AddTextures(VoltRloop, "R_Loop");
-		loader.AddTextures(VoltRloop2, "R_Loop2");
+		loader.AddTextureSequence(Holdinital, "Hold_init", &particleMaterial);
+		loader.AddTextureSequence(Holdloop, "Hold_loop", &particleMaterial);
+		loader.AddTextureSequence(VoltLCorner, "L_Corner", &particleMaterial);
+		loader.AddTextureSequence(VoltLloop, "L_Loop", &particleMaterial);
+		loader.AddTextureSequence(VoltLloop2, "L_Loop2", &particleMaterial);
+		loader.AddTextureSequence(VoltRCorner, "R_Corner", &particleMaterial);
+		loader.AddTextureSequence(VoltRloop, "R_Loop", &particleMaterial);
+		loader.AddTextureSequence(VoltRloop2, "R_Loop2", &particleMaterial);
 		for (uint32 i = 0; i < 3; i++)
 		{
-			loader.AddTextures(scoreHitTexturestest[i], Utility::Sprintf("score%d", i));
+			loader.AddTextureSequence(scoreHitTexturestest[i], Utility::Sprintf("score%d", i), &particleMaterial);
 		}
 		if(!InitHUD())
 			return false;
@@ -373,6 +425,23 @@ public:
 		if(!loader.Load())
 			return false;
 
+		// Load beatmap audio, a prepared chart decoded it while the assets were loading
+		if(g_gameConfig.GetBool(GameConfigKeys::NormalizeLoudness))
+			m_audioPlayback.SetLoudness(m_diffIndex.loudness, g_gameConfig.GetFloat(GameConfigKeys::LoudnessTarget));
+		AudioStream preparedMusic, preparedFxTrack;
+		if(m_preparedChart && m_preparedChart->ClaimAudio(preparedMusic, preparedFxTrack))
+		{
+			Logf("Prepared [%s] in %.2f ms (%.2f ms chart, %.2f ms audio)", Logger::Info,
+				m_mapPath, m_preparedChart->parseTime + m_preparedChart->audioTime, m_preparedChart->parseTime, m_preparedChart->audioTime);
+			if(!m_audioPlayback.Init(m_playback, m_mapRootPath, preparedMusic, preparedFxTrack))
+				return false;
+		}
+		else if(!m_audioPlayback.Init(m_playback, m_mapRootPath))
+			return false;
+		m_preparedChart.Release();
+
+		ApplyAudioLeadin();
+
 
 
 		// Load particle material
@@ -394,6 +463,11 @@ public:
 		if (!m_lua)
 			return false;
 
+		// Hit effects declared by the skin
+		uint32 numSkinEffects = m_track->hitEffects.AddTypesFromLua(m_lua);
+		if (numSkinEffects > 0)
+			Logf("Added %d hit effects from the skin", Logger::Info, numSkinEffects);
+
 		auto pushStringToTable = [&](const char* name, String data)
 		{
 			lua_pushstring(m_lua, name);
@@ -418,28 +492,48 @@ public:
 		{
 			lua_newtable(m_lua);
 			pushStringToTable("jacketPath", jacketPath);
+			pushStringToTable("audioPath", Path::Normalize(m_mapRootPath + Path::sep + mapSettings.audioNoFX));
 			pushStringToTable("title", mapSettings.title);
 			pushStringToTable("artist", mapSettings.artist);
 			pushIntToTable("difficulty", mapSettings.difficulty);
 			pushIntToTable("level", mapSettings.level);
 			lua_pushstring(m_lua, "scoreReplays");
 			lua_newtable(m_lua);
+			{
+				// One entry per score, updated every frame
+				for (int i = 1; i <= (int)m_diffIndex.scores.size(); i++)
+				{
+					lua_newtable(m_lua);
+					lua_pushnumber(m_lua, m_diffIndex.scores[i - 1]->score);
+					lua_setfield(m_lua, -2, "maxScore");
+					lua_pushnumber(m_lua, 0);
+					lua_setfield(m_lua, -2, "currentScore");
+					lua_seti(m_lua, -2, i);
+				}
+			}
+			m_luaScoreReplays.Set(m_lua, -1);
 			lua_settable(m_lua, -3);
 			lua_pushstring(m_lua, "critLine");
 			lua_newtable(m_lua);
+			m_luaCritLine.Set(m_lua, -1);
 			lua_pushstring(m_lua, "cursors");
 			lua_newtable(m_lua);
 			{
 				lua_newtable(m_lua);
+				m_luaCursors[0].Set(m_lua, -1);
 				lua_seti(m_lua, -2, 0);
 
 				lua_newtable(m_lua);
+				m_luaCursors[1].Set(m_lua, -1);
 				lua_seti(m_lua, -2, 1);
 			}
 			lua_settable(m_lua, -3); // cursors -> critLine
 			lua_settable(m_lua, -3); // critLine -> gameplay
+			m_luaGameplay.Set(m_lua, -1);
 			lua_setglobal(m_lua, "gameplay");
 		}
+		m_BindLuaFunctions();
+		m_luaGC.Attach(m_lua, g_gameConfig.GetInt(GameConfigKeys::LuaGCBudget));
 
 		// Background 
 		/// TODO: Load this async
@@ -529,11 +623,14 @@ public:
 			}
 		}
 
-
+		m_loadTime = m_launchTimer.SecondsAsDouble() * 1000.0;
 		return true;
 	}
 	virtual bool Init() override
 	{
+		// Don't destroy GPU resources in the middle of gameplay
+		ResourceManagers::BeginDeferDestruction();
+		m_deferringResources = true;
 		return true;
 	}
 
@@ -589,6 +686,8 @@ public:
 	}
 	virtual void Tick(float deltaTime) override
 	{
+		ProfileScope("Game::Tick");
+
 		// Lock mouse to screen when playing
 		if(g_gameConfig.GetEnum<Enum_InputDevice>(GameConfigKeys::LaserInputDevice) == InputDevice::Mouse)
 		{
@@ -608,9 +707,17 @@ public:
 
 		if(!m_paused)
 			TickGameplay(deltaTime);
+
+		// Scripts also run from Tick, so spend part of the frame's budget collecting here
+		{
+			ProfileScope("Lua GC");
+			m_luaGC.Step();
+		}
 	}
 	virtual void Render(float deltaTime) override
 	{
+		ProfileScope("Game::Render");
+
 		// 8 beats (2 measures) in view at 1x hi-speed
 		if (m_usecMod)
 			m_track->SetViewRange(1.0 / m_playback.cModSpeed);
@@ -647,32 +754,16 @@ public:
 		{
 			msViewRange = 480000.0 / m_playback.cModSpeed;
 		}
-		m_currentObjectSet = m_playback.GetObjectsInRange(msViewRange);
-		// Sort objects to draw
-		// fx holds -> bt holds -> fx chips -> bt chips
-		m_currentObjectSet.Sort([](const TObjectState<void>* a, const TObjectState<void>* b)
-		{
-			auto ObjectRenderPriorty = [](const TObjectState<void>* a)
-			{
-				if (a->type == ObjectType::Single)
-					return (((ButtonObjectState*)a)->index < 4) ? 1 : 2;
-				else if (a->type == ObjectType::Hold)
-					return (((ButtonObjectState*)a)->index < 4) ? 3 : 4;
-				else
-					return 0;
-			};
-			uint32 renderPriorityA = ObjectRenderPriorty(a);
-			uint32 renderPriorityB = ObjectRenderPriorty(b);
-			return renderPriorityA > renderPriorityB;
-		});
+		// Already in drawing order: fx holds -> bt holds -> fx chips -> bt chips
+		ObjectSpan currentObjects = m_playback.GetObjectsInView(msViewRange);
 
 		/// TODO: Performance impact analysis.
-		m_track->DrawLaserBase(renderQueue, m_playback, m_currentObjectSet);
+		m_track->DrawLaserBase(renderQueue, m_playback, currentObjects);
 
 		// Draw the base track + time division ticks
 		m_track->DrawBase(renderQueue);
 
-		for(auto& object : m_currentObjectSet)
+		for(ObjectState* object : currentObjects)
 		{
 			m_track->DrawObjectState(renderQueue, m_playback, object, m_scoring.IsObjectHeld(object));
 		}
@@ -805,27 +896,26 @@ public:
 		*/
 		// BUT OTHERWISE HERE DOES THE SAME THING BUT WITH LUA
 #define NVG_FLUSH() do { \
-		lua_getglobal(m_lua, "gfx"); \
-		lua_getfield(m_lua, -1, "ForceRender"); \
-		if (lua_pcall(m_lua, 0, 0, 0) != 0) { \
-			Logf("Lua error: %s", Logger::Error, lua_tostring(m_lua, -1)); \
-			g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(m_lua, -1), 0); \
+		m_luaForceRender.Push(); \
+		if (!m_luaGC.Call(0, 0)) { \
+			m_OnLuaError(true); \
 			assert(false); \
 		} \
-		lua_pop(m_lua, 1); \
 		} while (0)
 
 		// Render Critical Line Base
-		lua_getglobal(m_lua, "render_crit_base");
-		lua_pushnumber(m_lua, deltaTime);
-		if (lua_pcall(m_lua, 1, 0, 0) != 0)
 		{
-			Logf("Lua error: %s", Logger::Error, lua_tostring(m_lua, -1));
-			g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(m_lua, -1), 0);
-			assert(false);
+			ProfileScope("Lua render_crit_base");
+			m_luaRenderCritBase.Push();
+			lua_pushnumber(m_lua, deltaTime);
+			if (!m_luaGC.Call(1, 0))
+			{
+				m_OnLuaError(true);
+				assert(false);
+			}
+			// flush NVG
+			NVG_FLUSH();
 		}
-		// flush NVG
-		NVG_FLUSH();
 		
 		RemderAnimation(rs, deltaTime);
 
@@ -834,32 +924,40 @@ public:
 		glFlush();
 
 		// Render Critical Line Overlay
-		lua_getglobal(m_lua, "render_crit_overlay");
-		lua_pushnumber(m_lua, deltaTime);
 		// only flush if the overlay exists. overlay isn't required, only one crit function is required.
-		if (lua_pcall(m_lua, 1, 0, 0) == 0)
-			NVG_FLUSH();
+		if (m_luaRenderCritOverlay.IsValid())
+		{
+			ProfileScope("Lua render_crit_overlay");
+			m_luaRenderCritOverlay.Push();
+			lua_pushnumber(m_lua, deltaTime);
+			if (m_luaGC.Call(1, 0))
+				NVG_FLUSH();
+			else
+				m_OnLuaError(false);
+		}
 
 		// Render foreground
 		m_foreground->Render(deltaTime);
 
 		// Render Lua HUD
-		lua_getglobal(m_lua, "render");
-		lua_pushnumber(m_lua, deltaTime);
-		if (lua_pcall(m_lua, 1, 0, 0) != 0)
 		{
-			Logf("Lua error: %s", Logger::Error, lua_tostring(m_lua, -1));
-			g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(m_lua, -1), 0);
-			assert(false);
+			ProfileScope("Lua render");
+			m_luaRender.Push();
+			lua_pushnumber(m_lua, deltaTime);
+			if (!m_luaGC.Call(1, 0))
+			{
+				m_OnLuaError(true);
+				assert(false);
+			}
 		}
 		if (!m_introCompleted)
 		{
 			// Render Lua Intro
-			lua_getglobal(m_lua, "render_intro");
-			if (lua_isfunction(m_lua, -1))
+			if (m_luaRenderIntro.IsValid())
 			{
+				m_luaRenderIntro.Push();
 				lua_pushnumber(m_lua, deltaTime);
-				if (lua_pcall(m_lua, 1, 1, 0) != 0)
+				if (!m_luaGC.Call(1, 1))
 				{
 					Logf("Lua error: %s", Logger::Error, lua_tostring(m_lua, -1));
 					g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(m_lua, -1), 0);
@@ -876,12 +974,12 @@ public:
 		if (m_ended)
 		{
 			// Render Lua Outro
-			lua_getglobal(m_lua, "render_outro");
-			if (lua_isfunction(m_lua, -1))
+			if (m_luaRenderOutro.IsValid())
 			{
+				m_luaRenderOutro.Push();
 				lua_pushnumber(m_lua, deltaTime);
 				lua_pushnumber(m_lua, m_getClearState());
-				if (lua_pcall(m_lua, 2, 2, 0) != 0)
+				if (!m_luaGC.Call(2, 2))
 				{
 					Logf("Lua error: %s", Logger::Error, lua_tostring(m_lua, -1));
 					g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(m_lua, -1), 0);
@@ -902,6 +1000,13 @@ public:
 			lua_settop(m_lua, 0);
 		}
 
+		// Collect garbage created by the scripts this frame within a fixed budget
+		{
+			ProfileScope("Lua GC");
+			m_luaGC.Step();
+			m_luaGC.EndFrame();
+		}
+
 		// Render debug hud if enabled
 		if(m_renderDebugHUD)
 		{
@@ -1011,6 +1116,15 @@ public:
 	// Processes input and Updates scoring, also handles audio timing management
 	void TickGameplay(float deltaTime)
 	{
+		ProfileScope("Game::TickGameplay");
+
+		if(m_launchTime == 0.0)
+		{
+			m_launchTime = m_launchTimer.SecondsAsDouble() * 1000.0;
+			Logf("Game started %.1f ms after confirming the song (%.1f ms loading, chart %s)", Logger::Info,
+				m_launchTime, m_loadTime, m_usedPreparedChart ? "prepared on confirm" : "loaded on start");
+		}
+
 		if(!m_started && m_introCompleted)
 		{
 			// Start playback of audio in first gameplay tick
@@ -1025,9 +1139,20 @@ public:
 
 		const BeatmapSettings& beatmapSettings = m_beatmap->GetMapSettings();
 
+		// The practice loop jumped back, play the section again from its start
+		uint32 loopCount = m_audioPlayback.GetLoopCount();
+		if(loopCount != m_loopCount)
+		{
+			m_loopCount = loopCount;
+			m_RestartSection();
+		}
+
 		// Update beatmap playback
 		MapTime playbackPositionMs = m_audioPlayback.GetPosition() - m_audioOffset;
-		m_playback.Update(playbackPositionMs);
+		{
+			ProfileScope("BeatmapPlayback::Update");
+			m_playback.Update(playbackPositionMs);
+		}
 
 		MapTime delta = playbackPositionMs - m_lastMapTime;
 		int32 beatStart = 0;
@@ -1064,7 +1189,8 @@ public:
 		// Update scoring
 		if (!m_ended)
 		{
-			m_scoring.Tick(deltaTime);
+			// Laser timing runs at the practice speed like the map does
+			m_scoring.Tick(deltaTime * m_practiceSpeed);
 			// Update scoring gauge
 			int32 gaugeSampleSlot = playbackPositionMs;
 			gaugeSampleSlot /= m_gaugeSampleRate;
@@ -1102,11 +1228,12 @@ public:
 
 
 		//set lua
-		lua_getglobal(m_lua, "gameplay");
-
+		ProfileScope("Lua gameplay table");
+		Timer luaTimer;
+		m_luaGameplay.Push();
 
 		// Update score replays
-		lua_getfield(m_lua, -1, "scoreReplays");
+		m_luaScoreReplays.Push();
 		int replayCounter = 1;
 		for (ScoreIndex* index : m_diffIndex.scores)
 		{
@@ -1124,67 +1251,55 @@ public:
 					m_scoreReplays[index].nextHitStat++;
 				}
 			}
-			lua_pushnumber(m_lua, replayCounter);
-			lua_newtable(m_lua);
-
-			lua_pushstring(m_lua, "maxScore");
+			// Entries were created in Init, only the values change
+			lua_geti(m_lua, -1, replayCounter);
 			lua_pushnumber(m_lua, index->score);
-			lua_settable(m_lua, -3);
-
-			lua_pushstring(m_lua, "currentScore");
+			lua_setfield(m_lua, -2, "maxScore");
 			lua_pushnumber(m_lua, m_scoring.CalculateScore(m_scoreReplays[index].currentScore));
-			lua_settable(m_lua, -3);
-
-			lua_settable(m_lua, -3);
+			lua_setfield(m_lua, -2, "currentScore");
+			lua_pop(m_lua, 1);
 			replayCounter++;
 		}
-		lua_setfield(m_lua, -1, "scoreReplays");
-
+		lua_pop(m_lua, 1);
 
 		//progress
-		lua_pushstring(m_lua, "progress");
 		lua_pushnumber(m_lua, Math::Clamp((float)playbackPositionMs / m_endTime,0.f,1.f));
-		lua_settable(m_lua, -3);
+		lua_setfield(m_lua, -2, "progress");
 		//hispeed
-		lua_pushstring(m_lua, "hispeed");
 		lua_pushnumber(m_lua, m_hispeed);
-		lua_settable(m_lua, -3);
+		lua_setfield(m_lua, -2, "hispeed");
 		//bpm
-		lua_pushstring(m_lua, "bpm");
 		lua_pushnumber(m_lua, m_currentTiming->GetBPM());
-		lua_settable(m_lua, -3);
+		lua_setfield(m_lua, -2, "bpm");
 		//gauge
-		lua_pushstring(m_lua, "gauge");
 		lua_pushnumber(m_lua, m_scoring.currentGauge);
-		lua_settable(m_lua, -3);
+		lua_setfield(m_lua, -2, "gauge");
 		//combo state
-		lua_pushstring(m_lua, "comboState");
 		lua_pushnumber(m_lua, m_scoring.comboState);
-		lua_settable(m_lua, -3);
+		lua_setfield(m_lua, -2, "comboState");
+		lua_pop(m_lua, 1);
 		//critLine
 		{
-			lua_getfield(m_lua, -1, "critLine");
+			m_luaCritLine.Push();
 
 			Vector2 critPos = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3(0, 0, 0)));
 			Vector2 leftPos = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3(-1, 0, 0)));
 			Vector2 rightPos = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3(1, 0, 0)));
 			Vector2 line = rightPos - leftPos;
 
-			lua_pushstring(m_lua, "x"); // x screen position
-			lua_pushnumber(m_lua, critPos.x);
-			lua_settable(m_lua, -3);
+			lua_pushnumber(m_lua, critPos.x); // x screen position
+			lua_setfield(m_lua, -2, "x");
 
-			lua_pushstring(m_lua, "y"); // y screen position
-			lua_pushnumber(m_lua, critPos.y);
-			lua_settable(m_lua, -3);
+			lua_pushnumber(m_lua, critPos.y); // y screen position
+			lua_setfield(m_lua, -2, "y");
 
-			lua_pushstring(m_lua, "rotation"); // rotation based on laser roll
-			lua_pushnumber(m_lua, -atan2f(line.y, line.x));
-			lua_settable(m_lua, -3);
+			lua_pushnumber(m_lua, -atan2f(line.y, line.x)); // rotation based on laser roll
+			lua_setfield(m_lua, -2, "rotation");
+			lua_pop(m_lua, 1);
 
 			auto setCursorData = [&](int ci)
 			{
-				lua_geti(m_lua, -1, ci);
+				m_luaCursors[ci].Push();
 
 #define TPOINT(name, y) Vector2 name = m_camera.Project(m_camera.critOrigin.TransformPoint(Vector3((m_scoring.laserPositions[ci] - Track::trackWidth * 0.5f) * (5.0f / 6), y, 0)))
 				TPOINT(cPos, 0);
@@ -1198,29 +1313,22 @@ public:
 				float skewAngle = -atan2f(cursorAngleVector.y, cursorAngleVector.x) + 3.1415 / 2;
 				float alpha = (1.0f - Math::Clamp<float>(m_scoring.timeSinceLaserUsed[ci] / 0.5f - 1.0f, 0, 1));
 
-				lua_pushstring(m_lua, "pos");
 				lua_pushnumber(m_lua, distFromCritCenter * (m_scoring.lasersAreExtend[ci] ? 2 : 1));
-				lua_settable(m_lua, -3);
+				lua_setfield(m_lua, -2, "pos");
 
-				lua_pushstring(m_lua, "alpha");
 				lua_pushnumber(m_lua, alpha);
-				lua_settable(m_lua, -3);
+				lua_setfield(m_lua, -2, "alpha");
 
-				lua_pushstring(m_lua, "skew");
 				lua_pushnumber(m_lua, skewAngle);
-				lua_settable(m_lua, -3);
+				lua_setfield(m_lua, -2, "skew");
 
 				lua_pop(m_lua, 1);
 			};
 
-			lua_getfield(m_lua, -1, "cursors");
 			setCursorData(0);
 			setCursorData(1);
-
-			lua_pop(m_lua, 2); // cursors, critLine
 		}
-
-		lua_setglobal(m_lua, "gameplay");
+		m_luaGC.AddScriptTime(luaTimer.SecondsAsDouble() * 1000.0);
 
 		m_lastMapTime = playbackPositionMs;
 		
@@ -1351,7 +1459,7 @@ public:
 		emitter->position.y = 0.0f;
 		return emitter;
 	}
-	Ref<TextureAnimatorParameterManager> CreateHitAnimation(Vector<Texture> tex)
+	Ref<TextureAnimatorParameterManager> CreateHitAnimation(const TextureSequence& tex)
 	{
 		Ref<TextureAnimatorParameterManager> AnimationManager = m_TextureAnimator->AddManager();
 		AnimationManager->material = particleMaterial;
@@ -1367,7 +1475,7 @@ public:
 		AnimationManager->loops = 1;
 		return AnimationManager;
 	}
-	Ref<TextureAnimatorParameterManager> CreateCornerAnimation(Vector<Texture> tex)
+	Ref<TextureAnimatorParameterManager> CreateCornerAnimation(const TextureSequence& tex)
 	{
 		Ref<TextureAnimatorParameterManager> AnimationManager = m_TextureAnimator->AddManager();
 		AnimationManager->material = particleMaterial;
@@ -1383,7 +1491,7 @@ public:
 		AnimationManager->loops = 0;
 		return AnimationManager;
 	}
-	Ref<TextureAnimatorParameterManager> CreateLoopAnimation(Vector<Texture> tex)
+	Ref<TextureAnimatorParameterManager> CreateLoopAnimation(const TextureSequence& tex)
 	{
 		Ref<TextureAnimatorParameterManager> AnimationManager = m_TextureAnimator->AddManager();
 		AnimationManager->material = particleMaterial;
@@ -1399,6 +1507,33 @@ public:
 		AnimationManager->loops = 0;
 		return AnimationManager;
 	}
+	// Looks up the script functions that are called every frame
+	void m_BindLuaFunctions()
+	{
+		m_luaRender.SetGlobal(m_lua, "render");
+		m_luaRenderCritBase.SetGlobal(m_lua, "render_crit_base");
+		m_luaRenderCritOverlay.SetGlobal(m_lua, "render_crit_overlay");
+		m_luaRenderIntro.SetGlobal(m_lua, "render_intro");
+		m_luaRenderOutro.SetGlobal(m_lua, "render_outro");
+		m_luaNearHit.SetGlobal(m_lua, "near_hit");
+		m_luaUpdateCombo.SetGlobal(m_lua, "update_combo");
+		m_luaUpdateScore.SetGlobal(m_lua, "update_score");
+		m_luaLaserAlert.SetGlobal(m_lua, "laser_alert");
+
+		lua_getglobal(m_lua, "gfx");
+		lua_getfield(m_lua, -1, "ForceRender");
+		m_luaForceRender.Set(m_lua, -1);
+		lua_pop(m_lua, 2);
+	}
+	// Reports the error message on top of the stack and removes it
+	void m_OnLuaError(bool showMessage)
+	{
+		Logf("Lua error: %s", Logger::Error, lua_tostring(m_lua, -1));
+		if (showMessage)
+			g_gameWindow->ShowMessageBox("Lua Error", lua_tostring(m_lua, -1), 0);
+		lua_pop(m_lua, 1);
+	}
+
 	// Main GUI/HUD Rendering loop
 	virtual void RenderDebugHUD(float deltaTime)
 	{
@@ -1423,6 +1558,18 @@ public:
 		textPos.y += RenderText(bms.artist, textPos).y;
 		textPos.y += RenderText(Utility::Sprintf("%.2f FPS", g_application->GetRenderFPS()), textPos).y;
 		textPos.y += RenderText(Utility::Sprintf("Audio Offset: %d ms", g_audio->audioLatency), textPos).y;
+		AudioStats audioStats = g_audio->GetStats();
+		textPos.y += RenderText(Utility::Sprintf("Audio Buffer: %d samples, block %d, %d underruns, worst callback %.2f ms",
+			audioStats.bufferSize, audioStats.blockSize, audioStats.underruns, audioStats.worstCallbackTime), textPos).y;
+		textPos.y += RenderText(Utility::Sprintf("Audio Render: %d voices, %d worker threads, costliest voice %.2f ms, deadline slack %.2f ms",
+			audioStats.voices, audioStats.renderThreads, audioStats.costliestVoice, audioStats.deadlineSlack), textPos).y;
+		if(m_practiced)
+		{
+			textPos.y += RenderText(Utility::Sprintf("Practice: %d%% speed, loop %d - %d ms, stretching %.1f%% CPU", (int32)(m_practiceSpeed * 100.0f),
+				m_loopStart, m_loopEnd, m_audioPlayback.GetTimeStretchLoad() * 100.0f), textPos).y;
+		}
+		textPos.y += RenderText(Utility::Sprintf("Launch: %.1f ms (load %.1f ms%s)", m_launchTime, m_loadTime, m_usedPreparedChart ? ", prepared" : ""), textPos).y;
+		textPos.y += RenderText(Utility::Sprintf("Hit effects: %d (%d draws)", m_track->hitEffects.GetActiveCount(), m_track->hitEffects.GetDrawCount()), textPos).y;
 
 		float currentBPM = (float)(60000.0 / tp.beatDuration);
 		textPos.y += RenderText(Utility::Sprintf("BPM: %.1f", currentBPM), textPos).y;
@@ -1444,6 +1591,18 @@ public:
 		Vector2 buttonStateTextPos = Vector2(g_resolution.x - 200.0f, 100.0f);
 		RenderText(g_input.GetControllerStateString(), buttonStateTextPos);
 
+		// Resource counters (live objects, memory, collected per second, waiting for destruction)
+		Vector2 resourceTextPos = Vector2(g_resolution.x - 300.0f, 200.0f);
+		for(size_t i = 0; i < (size_t)ResourceType::_Length; i++)
+		{
+			ResourceManagerStats stats = ResourceManagers::GetStats((ResourceType)i);
+			resourceTextPos.y += RenderText(Utility::Sprintf("%s: %d (%.1f MB) %d/s, %d pending", ResourceManagers::GetTypeName((ResourceType)i),
+				stats.liveObjects, (double)stats.memoryUsage / (1024.0 * 1024.0), stats.collectedPerSecond, stats.pendingDestruction), resourceTextPos).y;
+		}
+		const LuaFrameStats& luaStats = m_luaGC.GetStats();
+		resourceTextPos.y += RenderText(Utility::Sprintf("Lua: %.2f ms, GC: %.2f ms, %.0f KB (%d cycles)",
+			luaStats.scriptTime, luaStats.gcTime, (double)luaStats.memoryUsage / 1024.0, luaStats.gcCycles), resourceTextPos).y;
+
 		if(m_scoring.autoplay)
 			textPos.y += RenderText("Autoplay enabled", textPos, Color::Blue).y;
 
@@ -1536,10 +1695,9 @@ public:
 	{
 		ButtonObjectState* st = (ButtonObjectState*)hitObject;
 		uint32 buttonIdx = (uint32)button;
-		Color c = m_track->hitColors[(size_t)rating];
 
 		// The color effect in the button lane
-		m_track->AddEffect(new ButtonHitEffect(buttonIdx, c));
+		m_track->SpawnHitEffects(buttonIdx, rating, true);
 
 		if (st != nullptr && st->hasSample)
 		{
@@ -1549,18 +1707,16 @@ public:
 
 		if(rating != ScoreHitRating::Idle)
 		{
-			// Floating text effect
-			m_track->AddEffect(new ButtonHitRatingEffect(buttonIdx, rating));
-
 			if (rating == ScoreHitRating::Good)
 			{
 				//m_track->timedHitEffect->late = late;
 				//m_track->timedHitEffect->Reset(0.75f);
-				lua_getglobal(m_lua, "near_hit");
+				m_luaNearHit.Push();
 				lua_pushboolean(m_lua, late);
-				if (lua_pcall(m_lua, 1, 0, 0) != 0)
+				if (!m_luaGC.Call(1, 0))
 				{
 					Logf("Lua error on calling near_hit: %s", Logger::Error, lua_tostring(m_lua, -1));
+					lua_pop(m_lua, 1);
 				}
 				// Create hit effect particle
 				if (m_HitRatingAnimation[1]) {
@@ -1594,12 +1750,7 @@ public:
 	void OnButtonMiss(Input::Button button, bool hitEffect)
 	{
 		uint32 buttonIdx = (uint32)button;
-		if (hitEffect)
-		{
-			Color c = m_track->hitColors[0];
-			m_track->AddEffect(new ButtonHitEffect(buttonIdx, c));
-		}
-		m_track->AddEffect(new ButtonHitRatingEffect(buttonIdx, ScoreHitRating::Miss));
+		m_track->SpawnHitEffects(buttonIdx, ScoreHitRating::Miss, hitEffect);
 		// Create hit effect particle
 		Color hitColor = (buttonIdx < 4) ? Color::Black : Color::FromHSV(20, 0.7f, 1.0f);
 		float hitWidth = (buttonIdx < 4) ? m_track->buttonWidth : m_track->fxbuttonWidth;
@@ -1620,20 +1771,22 @@ public:
 	void OnComboChanged(uint32 newCombo)
 	{
 		m_comboAnimation.Restart();
-		lua_getglobal(m_lua, "update_combo");
+		m_luaUpdateCombo.Push();
 		lua_pushinteger(m_lua, newCombo);
-		if (lua_pcall(m_lua, 1, 0, 0) != 0)
+		if (!m_luaGC.Call(1, 0))
 		{
 			Logf("Lua error on calling update_combo: %s", Logger::Error, lua_tostring(m_lua, -1));
+			lua_pop(m_lua, 1);
 		}
 	}
 	void OnScoreChanged(uint32 newScore)
 	{
-		lua_getglobal(m_lua, "update_score");
+		m_luaUpdateScore.Push();
 		lua_pushinteger(m_lua, newScore);
-		if (lua_pcall(m_lua, 1, 0, 0) != 0)
+		if (!m_luaGC.Call(1, 0))
 		{
 			Logf("Lua error on calling update_score: %s", Logger::Error, lua_tostring(m_lua, -1));
+			lua_pop(m_lua, 1);
 		}
 	};
 
@@ -1735,11 +1888,12 @@ public:
 		if (m_scoring.timeSinceLaserUsed[object->index] > 3.0f)
 		{
 			m_track->SendLaserAlert(object->index);
-			lua_getglobal(m_lua, "laser_alert");
+			m_luaLaserAlert.Push();
 			lua_pushboolean(m_lua, object->index == 1);
-			if (lua_pcall(m_lua, 1, 0, 0) != 0)
+			if (!m_luaGC.Call(1, 0))
 			{
 				Logf("Lua error on calling laser_alert: %s", Logger::Error, lua_tostring(m_lua, -1));
+				lua_pop(m_lua, 1);
 			}
 		}
 	}
@@ -1786,8 +1940,66 @@ public:
 		else if(key == SDLK_F9)
 		{
 			g_application->ReloadScript("gameplay", m_lua);
+			m_BindLuaFunctions();
+		}
+		else if(key == SDLK_MINUS || key == SDLK_EQUALS) // Practice speed
+		{
+			float speed = Math::Clamp(m_practiceSpeed + (key == SDLK_MINUS ? -0.05f : 0.05f), 0.5f, 1.0f);
+			SetPracticeSpeed(speed);
+		}
+		else if(key == SDLK_LEFTBRACKET) // Practice loop start
+		{
+			m_loopStart = m_lastMapTime;
+			if(m_loopEnd > m_loopStart)
+				SetPracticeLoop(m_loopStart, m_loopEnd);
+		}
+		else if(key == SDLK_RIGHTBRACKET) // Practice loop end
+		{
+			if(m_lastMapTime > m_loopStart && m_loopStart >= 0)
+				SetPracticeLoop(m_loopStart, m_lastMapTime);
+		}
+		else if(key == SDLK_BACKSLASH) // Stop looping
+		{
+			SetPracticeLoop(-1, -1);
 		}
 	}
+
+	// Plays the map slower without changing the pitch of the audio
+	void SetPracticeSpeed(float speed)
+	{
+		speed = Math::Round(speed * 20.0f) / 20.0f;
+		if(speed == m_practiceSpeed)
+			return;
+		if(!m_audioPlayback.SetTempo(speed))
+			return;
+		m_practiceSpeed = speed;
+		m_practiced = true;
+		Logf("Practice speed %d%%", Logger::Info, (int32)(speed * 100.0f));
+	}
+	// Loops a section of the map in map time, an end at or before the start stops looping
+	void SetPracticeLoop(MapTime start, MapTime end)
+	{
+		bool looping = end > start;
+		if(!m_audioPlayback.SetLoop(start + m_audioOffset, end + m_audioOffset))
+			return;
+		m_loopStart = start;
+		m_loopEnd = end;
+		if(!looping)
+			return;
+		m_practiced = true;
+		Logf("Practice loop %d - %d ms", Logger::Info, start, end);
+		// Start at the beginning of the section right away
+		m_audioPlayback.SetPosition(start + m_audioOffset);
+		m_RestartSection();
+	}
+	// Resets the map state to the start of the practice loop
+	void m_RestartSection()
+	{
+		m_lastMapTime = m_loopStart;
+		m_playback.Reset(m_loopStart);
+		m_scoring.Reset();
+		m_scoring.SetInput(&g_input);
+	}
 	void m_OnButtonPressed(Input::Button buttonCode)
 	{
 		if (buttonCode == Input::Button::BT_S)
@@ -1905,7 +2117,11 @@ public:
 	}
 	virtual float GetPlaybackSpeed() override
 	{
-		return m_audioPlayback.GetPlaybackSpeed();
+		return m_audioPlayback.GetPlaybackSpeed() * m_practiceSpeed;
+	}
+	virtual bool IsPractice() override
+	{
+		return m_practiced;
 	}
 	virtual const String& GetMapRootPath() const
 	{
@@ -1928,6 +2144,12 @@ Game* Game::Create(const DifficultyIndex& difficulty, GameFlags flags)
 	return impl;
 }
 
+Game* Game::Create(const DifficultyIndex& difficulty, GameFlags flags, Ref<PreparedChart> prepared)
+{
+	Game_Impl* impl = new Game_Impl(difficulty, flags, prepared);
+	return impl;
+}
+
 Game* Game::Create(const String& difficulty, GameFlags flags)
 {
 	Game_Impl* impl = new Game_Impl(difficulty, flags);
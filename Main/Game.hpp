@@ -30,6 +30,9 @@ GameFlags operator|(const GameFlags& a, const GameFlags& b);
 GameFlags operator&(const GameFlags& a, const GameFlags& b);
 GameFlags operator~(const GameFlags& a);
 
+// Loads a chart file, returns an empty reference when it can't be loaded
+Ref<class Beatmap> TryLoadMap(const String& path);
+
 /*
 	Main game scene / logic manager
 */
@@ -41,6 +44,8 @@ public:
 	virtual ~Game() = default;
 	static Game* Create(const DifficultyIndex& mapPath, GameFlags flags);
 	static Game* Create(const String& mapPath, GameFlags flags);
+	// Takes the chart and audio from a preparation that is running on a job thread, loads them as usual when it didn't start yet
+	static Game* Create(const DifficultyIndex& mapPath, GameFlags flags, Ref<class PreparedChart> prepared);
 
 public:
 	// When the game is still going, false when the map is done, all ending sequences have played, etc.
@@ -63,6 +68,8 @@ public:
 	// Song was manually ended
 	virtual bool GetManualExit() = 0;
 	virtual float GetPlaybackSpeed() = 0;
+	// Practice mode speed or looping was used, the score isn't saved
+	virtual bool IsPractice() = 0;
 	// The folder that contians the map
 	virtual const String& GetMapRootPath() const = 0;
 	// Full path to map
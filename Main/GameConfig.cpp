@@ -104,6 +104,30 @@ void GameConfig::InitDefaults()
 	Set(GameConfigKeys::EditorPath, "PathToEditor");
 	Set(GameConfigKeys::EditorParamsFormat, "%s");
 	Set(GameConfigKeys::WASAPI_Exclusive, false);
+	Set(GameConfigKeys::AudioBufferSize, 0);
+	Set(GameConfigKeys::AudioBlockSize, 384);
+	Set(GameConfigKeys::AdaptiveAudioBuffer, false);
+	Set(GameConfigKeys::AudioRenderThreads, 0);
+	Set(GameConfigKeys::NormalizeLoudness, false);
+	Set(GameConfigKeys::LoudnessTarget, -12.0f);
+	Set(GameConfigKeys::LoudnessAnalysisThreads, 2);
 
 	Set(GameConfigKeys::CheckForUpdates, true);
+
+	SetEnum<Enum_LogLevel>(GameConfigKeys::LogLevel, LogLevel::Info);
+
+	Set(GameConfigKeys::ScreenshotCompression, 6);
+
+	Set(GameConfigKeys::JacketCacheMemory, 64);
+	Set(GameConfigKeys::JacketCacheCount, 500);
+	Set(GameConfigKeys::JacketPrefetchCount, 8);
+	Set(GameConfigKeys::AudioSummaryCacheCount, 32);
+
+	Set(GameConfigKeys::PreviewCacheSize, 4);
+
+	Set(GameConfigKeys::LuaGCBudget, 500);
+
+	Set(GameConfigKeys::UseSkinBundle, true);
+
+	Set(GameConfigKeys::PrepareChart, true);
 }
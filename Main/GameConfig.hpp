@@ -2,6 +2,13 @@
 #include "Shared/Config.hpp"
 #include "Input.hpp"
 
+// Minimum severity of messages written to the log
+DefineEnum(LogLevel,
+	Info,
+	Normal,
+	Warning,
+	Error);
+
 DefineEnum(GameConfigKeys,
 	// Screen settings
 	ScreenWidth,
@@ -89,8 +96,45 @@ DefineEnum(GameConfigKeys,
 	EditorParamsFormat,
 
 	WASAPI_Exclusive,
+	// Audio device buffer in samples (0 for the driver default) and the number of samples the mixer renders at once
+	AudioBufferSize,
+	AudioBlockSize,
+	// Grow the audio buffer after underruns and shrink it back when playback is stable
+	AdaptiveAudioBuffer,
+	// Render streams and samples with their effects on this many worker threads next to the audio thread, 0 renders on the audio thread only
+	AudioRenderThreads,
+	// Measure the loudness of chart audio while scanning the library and play every chart at the target loudness in LUFS
+	NormalizeLoudness,
+	LoudnessTarget,
+	// Number of threads decoding chart audio for the loudness measurement
+	LoudnessAnalysisThreads,
+
+	CheckForUpdates,
+
+	LogLevel,
+
+	// zlib compression level (0-9) used for screenshots, lower is faster to save
+	ScreenshotCompression,
+
+	// Budget for loaded jacket images in MiB and number of images
+	JacketCacheMemory,
+	JacketCacheCount,
+	// Number of songs ahead of the selection in song select to load jackets for
+	JacketPrefetchCount,
+	// Number of waveform and spectrum summaries of chart audio kept loaded for skins
+	AudioSummaryCacheCount,
+
+	// Number of recently played song previews to keep ready for playback, 0 to disable
+	PreviewCacheSize,
+
+	// Time in microseconds the Lua garbage collector may run per frame during gameplay, 0 for no limit
+	LuaGCBudget,
+
+	// Load skin assets from skin.bundle in the skin folder when it exists, built with the -bundleskin command line option
+	UseSkinBundle,
 
-	CheckForUpdates
+	// Load the chart and its audio on a job thread while the transition screen loads the skin assets for the game
+	PrepareChart
 	);
 
 // Config for game settings
@@ -0,0 +1,283 @@
+#include "stdafx.h"
+#include "HitEffects.hpp"
+#include "Application.hpp"
+#include "Track.hpp"
+#include "lua.hpp"
+
+void HitEffectSystem::SetMaterials(Material normal, Material additive)
+{
+	m_materials[0] = normal;
+	m_materials[1] = additive;
+}
+
+uint32 HitEffectSystem::AddType(const HitEffectType& type)
+{
+	m_pools.emplace_back();
+	Pool& pool = m_pools.back();
+	pool.type = type;
+	pool.type.capacity = Math::Max(type.capacity, 1u);
+	// Everything is allocated up front, spawning and drawing only reuse these
+	pool.time.resize(pool.type.capacity);
+	pool.lane.resize(pool.type.capacity);
+	pool.color.resize(pool.type.capacity);
+	pool.vertices.reserve(pool.type.capacity * 6);
+	pool.mesh = MeshRes::Create(g_gl);
+	pool.mesh->SetPrimitiveType(PrimitiveType::TriangleList);
+	if(type.texture)
+		pool.aspectRatio = pool.type.texture->CalculateHeight(1.0f);
+	return (uint32)m_pools.size() - 1;
+}
+
+static float GetNumberField(lua_State* L, const char* name, float defaultValue)
+{
+	lua_getfield(L, -1, name);
+	float value = lua_isnumber(L, -1) ? (float)lua_tonumber(L, -1) : defaultValue;
+	lua_pop(L, 1);
+	return value;
+}
+static bool GetBoolField(lua_State* L, const char* name, bool defaultValue)
+{
+	lua_getfield(L, -1, name);
+	bool value = lua_isboolean(L, -1) ? lua_toboolean(L, -1) != 0 : defaultValue;
+	lua_pop(L, 1);
+	return value;
+}
+static String GetStringField(lua_State* L, const char* name)
+{
+	lua_getfield(L, -1, name);
+	String value = lua_isstring(L, -1) ? lua_tostring(L, -1) : "";
+	lua_pop(L, 1);
+	return value;
+}
+
+uint32 HitEffectSystem::AddTypesFromLua(lua_State* L)
+{
+	uint32 numAdded = 0;
+	lua_getglobal(L, "hit_effects");
+	if(!lua_istable(L, -1))
+	{
+		lua_pop(L, 1);
+		return 0;
+	}
+
+	static const char* ratingNames[] = { "miss", "near", "crit", "idle" };
+	lua_Integer numTypes = luaL_len(L, -1);
+	for(lua_Integer i = 1; i <= numTypes; i++)
+	{
+		lua_geti(L, -1, i);
+		if(!lua_istable(L, -1))
+		{
+			lua_pop(L, 1);
+			continue;
+		}
+
+		HitEffectType type;
+		type.name = GetStringField(L, "name");
+		String texture = GetStringField(L, "texture");
+		if(!texture.empty())
+			type.texture = g_application->LoadTexture(texture);
+		if(!type.texture)
+		{
+			Logf("Hit effect %d (%s) has no valid texture, skipping it", Logger::Warning, (int32)i, type.name);
+			lua_pop(L, 1);
+			continue;
+		}
+		type.texture->SetWrap(TextureWrap::Clamp, TextureWrap::Clamp);
+
+		lua_getfield(L, -1, "ratings");
+		if(lua_istable(L, -1))
+		{
+			lua_Integer numRatings = luaL_len(L, -1);
+			for(lua_Integer j = 1; j <= numRatings; j++)
+			{
+				lua_geti(L, -1, j);
+				String rating = lua_isstring(L, -1) ? lua_tostring(L, -1) : "";
+				for(uint32 k = 0; k < 4; k++)
+				{
+					if(rating == ratingNames[k])
+						type.ratings |= 1 << k;
+				}
+				lua_pop(L, 1);
+			}
+		}
+		lua_pop(L, 1);
+
+		String lanes = GetStringField(L, "lanes");
+		if(lanes == "bt")
+			type.lanes = (uint8)HitEffectLanes::Buttons;
+		else if(lanes == "fx")
+			type.lanes = (uint8)HitEffectLanes::FX;
+
+		type.duration = Math::Max(GetNumberField(L, "duration", type.duration), 0.01f);
+		type.pressedOnly = GetBoolField(L, "pressedOnly", type.pressedOnly);
+		type.width = GetNumberField(L, "width", type.width);
+		type.heightScale = GetNumberField(L, "height", type.heightScale);
+		type.offset.x = GetNumberField(L, "x", 0.0f);
+		type.offset.y = GetNumberField(L, "y", 0.0f);
+		type.offset.z = GetNumberField(L, "z", 0.0f);
+		type.startScale = GetNumberField(L, "startScale", type.startScale);
+		type.endScale = GetNumberField(L, "endScale", type.endScale);
+		type.alpha = GetNumberField(L, "alpha", type.alpha);
+		type.fade = GetBoolField(L, "fade", type.fade);
+		type.flicker = GetNumberField(L, "flicker", type.flicker);
+		type.useHitColor = GetBoolField(L, "hitColor", type.useHitColor);
+		type.additive = GetBoolField(L, "additive", type.additive);
+		type.capacity = (uint32)Math::Max(GetNumberField(L, "capacity", (float)type.capacity), 1.0f);
+		AddType(type);
+		numAdded++;
+
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 1);
+	return numAdded;
+}
+
+int32 HitEffectSystem::FindType(const String& name) const
+{
+	for(size_t i = 0; i < m_pools.size(); i++)
+	{
+		if(m_pools[i].type.name == name)
+			return (int32)i;
+	}
+	return -1;
+}
+uint32 HitEffectSystem::GetTypeCount() const
+{
+	return (uint32)m_pools.size();
+}
+
+void HitEffectSystem::Spawn(uint32 lane, ScoreHitRating rating, bool pressed, const Color* hitColors)
+{
+	uint8 laneMask = (uint8)(lane < 4 ? HitEffectLanes::Buttons : HitEffectLanes::FX);
+	uint8 ratingMask = 1 << (uint32)rating;
+	for(uint32 i = 0; i < m_pools.size(); i++)
+	{
+		const HitEffectType& type = m_pools[i].type;
+		if((type.ratings & ratingMask) == 0 || (type.lanes & laneMask) == 0 || (type.pressedOnly && !pressed))
+			continue;
+		Spawn(i, lane, type.useHitColor ? hitColors[(size_t)rating] : Color::White);
+	}
+}
+void HitEffectSystem::Spawn(uint32 typeIndex, uint32 lane, Color color)
+{
+	assert(typeIndex < m_pools.size() && lane < 6);
+	Pool& pool = m_pools[typeIndex];
+	uint32 index = pool.count;
+	if(pool.count < pool.type.capacity)
+	{
+		pool.count++;
+	}
+	else
+	{
+		// Full, replace the one closest to ending
+		index = 0;
+		for(uint32 i = 1; i < pool.count; i++)
+		{
+			if(pool.time[i] < pool.time[index])
+				index = i;
+		}
+	}
+	pool.time[index] = pool.type.duration;
+	pool.lane[index] = (uint8)lane;
+	pool.color[index] = color;
+}
+
+void HitEffectSystem::Tick(float deltaTime)
+{
+	for(Pool& pool : m_pools)
+	{
+		float* time = pool.time.data();
+		for(uint32 i = 0; i < pool.count; i++)
+			time[i] -= deltaTime;
+
+		// Move the last effect into the place of ended ones
+		for(uint32 i = 0; i < pool.count;)
+		{
+			if(time[i] > 0.0f)
+			{
+				i++;
+				continue;
+			}
+			pool.count--;
+			time[i] = time[pool.count];
+			pool.lane[i] = pool.lane[pool.count];
+			pool.color[i] = pool.color[pool.count];
+		}
+	}
+}
+
+void HitEffectSystem::Draw(RenderQueue& rq, Track& track)
+{
+	m_drawCount = 0;
+	for(Pool& pool : m_pools)
+	{
+		if(pool.count == 0)
+			continue;
+		const HitEffectType& type = pool.type;
+		Material material = m_materials[type.additive ? 1 : 0];
+
+		pool.vertices.clear();
+		for(uint32 i = 0; i < pool.count; i++)
+		{
+			float rate = pool.time[i] / type.duration;
+			if(type.flicker > 0.0f && (uint32)((type.duration - pool.time[i]) * type.flicker * 2.0f) % 2 == 1)
+				continue;
+
+			uint32 lane = pool.lane[i];
+			float laneWidth = lane < 4 ? track.buttonWidth : track.fxbuttonWidth;
+			float scale = type.endScale + (type.startScale - type.endScale) * rate;
+			Vector2 size;
+			size.x = laneWidth * type.width;
+			size.y = size.x * pool.aspectRatio * type.heightScale;
+			size *= scale;
+			Vector3 center = Vector3(track.GetButtonPlacement(lane), size.y * 0.5f, 0.0f) + type.offset;
+
+			Color color = pool.color[i];
+			color.w = type.alpha * (type.fade ? rate : 1.0f);
+
+			if(!material)
+			{
+				track.DrawSprite(rq, center, size, type.texture, color);
+				m_drawCount++;
+				continue;
+			}
+
+			// Same layout as MeshGenerators::Quad
+			Vector4 c = color;
+			float l = center.x - size.x * 0.5f, r = center.x + size.x * 0.5f;
+			float b = center.y - size.y * 0.5f, t = center.y + size.y * 0.5f;
+			pool.vertices.push_back({ { l, t, center.z }, { 0.0f, 0.0f }, c });
+			pool.vertices.push_back({ { r, b, center.z }, { 1.0f, 1.0f }, c });
+			pool.vertices.push_back({ { r, t, center.z }, { 1.0f, 0.0f }, c });
+			pool.vertices.push_back({ { l, t, center.z }, { 0.0f, 0.0f }, c });
+			pool.vertices.push_back({ { l, b, center.z }, { 0.0f, 1.0f }, c });
+			pool.vertices.push_back({ { r, b, center.z }, { 1.0f, 1.0f }, c });
+		}
+
+		if(!material || pool.vertices.empty())
+			continue;
+		pool.mesh->SetData(pool.vertices);
+		MaterialParameterSet params;
+		params.SetParameter("mainTex", type.texture);
+		rq.Draw(track.trackOrigin, pool.mesh, material, params);
+		m_drawCount++;
+	}
+}
+
+void HitEffectSystem::Clear()
+{
+	for(Pool& pool : m_pools)
+		pool.count = 0;
+}
+
+uint32 HitEffectSystem::GetActiveCount() const
+{
+	uint32 count = 0;
+	for(const Pool& pool : m_pools)
+		count += pool.count;
+	return count;
+}
+uint32 HitEffectSystem::GetDrawCount() const
+{
+	return m_drawCount;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "HitStat.hpp"
+
+struct lua_State;
+
+// Lanes a hit effect is spawned on
+enum class HitEffectLanes : uint8
+{
+	Buttons = 1,
+	FX = 2,
+	All = 3,
+};
+
+/*
+	Description of a kind of hit effect
+	Track registers the built-in ones, skins can add their own with the hit_effects table in gameplay.lua
+*/
+struct HitEffectType
+{
+	String name;
+	Texture texture;
+	float duration = 0.2f;
+	// Ratings that spawn this effect, bit (1 << ScoreHitRating)
+	uint8 ratings = 0;
+	uint8 lanes = (uint8)HitEffectLanes::All;
+	// Only spawned when the button was pressed, not for notes that passed the crit line
+	bool pressedOnly = true;
+	// Width relative to the lane, the height follows the aspect ratio of the texture times heightScale
+	float width = 1.0f;
+	float heightScale = 1.0f;
+	// Offset of the bottom center of the effect from the lane on the crit line, in track units
+	Vector3 offset;
+	// Scale at the start and end of the effect
+	float startScale = 1.0f;
+	float endScale = 1.0f;
+	float alpha = 1.0f;
+	// Fades out over the duration
+	bool fade = true;
+	// Blinks this many times per second, 0 to disable
+	float flicker = 0.0f;
+	// Tinted with the hit color of the rating, white otherwise
+	bool useHitColor = true;
+	bool additive = false;
+	// Maximum number of effects of this type at once, the oldest one is replaced when full
+	uint32 capacity = 32;
+};
+
+/*
+	Hit effects on the track
+	Effects are stored in a fixed size pool per type, with each property in its own array, and every type is drawn as a single mesh
+	so a burst of judgements doesn't allocate or issue a draw call per effect
+*/
+class HitEffectSystem : Unique
+{
+public:
+	// Materials for batched drawing, without them every effect is drawn as a separate sprite
+	void SetMaterials(Material normal, Material additive);
+
+	uint32 AddType(const HitEffectType& type);
+	// Adds the types described in the hit_effects global of a skin script, returns the number of types added
+	uint32 AddTypesFromLua(lua_State* L);
+	int32 FindType(const String& name) const;
+	uint32 GetTypeCount() const;
+
+	// Spawns every type that matches a judgement in a lane
+	void Spawn(uint32 lane, ScoreHitRating rating, bool pressed, const Color* hitColors);
+	// Spawns a single effect
+	void Spawn(uint32 typeIndex, uint32 lane, Color color);
+
+	void Tick(float deltaTime);
+	void Draw(RenderQueue& rq, class Track& track);
+	void Clear();
+
+	// Number of live effects and draw calls issued by the last Draw
+	uint32 GetActiveCount() const;
+	uint32 GetDrawCount() const;
+
+private:
+	struct Vertex : public VertexFormat<Vector3, Vector2, Vector4>
+	{
+		Vertex() = default;
+		Vertex(Vector3 pos, Vector2 tex, Vector4 color) : pos(pos), tex(tex), color(color) {};
+		Vector3 pos;
+		Vector2 tex;
+		Vector4 color;
+	};
+	struct Pool
+	{
+		HitEffectType type;
+		uint32 count = 0;
+		// Remaining time, lane and color of each live effect
+		Vector<float> time;
+		Vector<uint8> lane;
+		Vector<Color> color;
+		Vector<Vertex> vertices;
+		Mesh mesh;
+		float aspectRatio = 1.0f;
+	};
+
+	Vector<Pool> m_pools;
+	// Normal and additive blending
+	Material m_materials[2];
+	uint32 m_drawCount = 0;
+};
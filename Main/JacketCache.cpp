@@ -0,0 +1,213 @@
+#include "stdafx.h"
+#include "JacketCache.hpp"
+#include "Application.hpp"
+#include "Shared/Files.hpp"
+#include "nanovg.h"
+
+const char* JacketCache::thumbnailFolder = "jackets";
+
+// Increase this when the way thumbnails are generated changes, so old thumbnails are not used anymore
+static const uint32 thumbnailVersion = 2;
+// Prefetches are skipped while this many jackets are loading, requested jackets are always loaded
+static const uint32 maxPendingPrefetches = 16;
+
+static String GetThumbnailPath(const String& imagePath, uint64 lastWriteTime, int w, int h)
+{
+	String key = Utility::Sprintf("%s|%llu|%dx%d|%d", imagePath, lastWriteTime, w, h, thumbnailVersion);
+	return Path::GetCacheFilePath(Path::GetCacheFolder(JacketCache::thumbnailFolder), key, "png");
+}
+
+JacketCache::JacketCache()
+{
+	Path::CreateDirRecursive(Path::GetCacheFolder(thumbnailFolder));
+}
+JacketCache::~JacketCache()
+{
+	Clear();
+}
+
+int JacketCache::Get(const String& path, Vector2i size, int placeholder)
+{
+	m_lastSize = size;
+	Entry* entry = m_Get(path, size);
+	if(!entry->loaded)
+		return placeholder;
+	entry->returned = true;
+	return entry->texture;
+}
+int JacketCache::Resolve(int image)
+{
+	if(m_freedTextures.empty())
+		return image;
+	FreedTexture* freed = m_freedTextures.Find(image);
+	if(!freed)
+		return image;
+	Entry* entry = m_Get(freed->path, freed->size);
+	return entry->loaded ? entry->texture : 0;
+}
+
+void JacketCache::Prefetch(const String& path)
+{
+	if(m_entries.Find(path) || m_stats.pendingLoads >= maxPendingPrefetches)
+		return;
+	Entry* entry = m_Load(path, m_lastSize);
+	entry->prefetched = true;
+	// Not used yet, so keep it at the back of the LRU list
+	m_entries.MoveToBack(entry);
+}
+
+void JacketCache::Update()
+{
+	m_frame++;
+
+	m_stats.evictions += m_entries.Evict(
+		[&]() { return m_stats.memoryUsage > m_maxMemory || m_entries.GetSize() > m_maxImages; },
+		// Everything that's left was drawn recently, the budget is too small for what's on screen
+		[&](Entry* entry) { return entry->lastUsed + 1 >= m_frame && !entry->prefetched; },
+		[&](Entry* entry) { m_Free(entry); });
+}
+
+void JacketCache::Clear()
+{
+	m_entries.Clear([&](Entry* entry) { m_Free(entry); });
+	// Handles from before are invalid once the skin is reloaded
+	m_freedTextures.clear();
+	m_stats.pendingLoads = 0;
+}
+void JacketCache::SetContext(NVGcontext* vg)
+{
+	m_vg = vg;
+}
+
+void JacketCache::SetBudget(size_t maxMemory, uint32 maxImages)
+{
+	m_maxMemory = maxMemory;
+	m_maxImages = maxImages;
+}
+const JacketCacheStats& JacketCache::GetStats() const
+{
+	return m_stats;
+}
+
+JacketCache::Entry* JacketCache::m_Get(const String& path, Vector2i size)
+{
+	Entry* entry = m_entries.Find(path);
+	if(!entry)
+	{
+		m_stats.misses++;
+		entry = m_Load(path, size);
+	}
+	else if(entry->loaded)
+	{
+		// Count a prefetched jacket only the first time it's used
+		if(entry->prefetched)
+			m_stats.prefetchHits++;
+		else
+			m_stats.hits++;
+		entry->prefetched = false;
+	}
+	m_Touch(entry);
+	return entry;
+}
+JacketCache::Entry* JacketCache::m_Load(const String& path, Vector2i size)
+{
+	Entry* entry = m_entries.Add(path);
+	JacketLoadingJob* job = new JacketLoadingJob();
+	job->imagePath = path;
+	job->w = size.x;
+	job->h = size.y;
+	job->requestTime = m_timer.SecondsAsFloat();
+	job->cache = this;
+	entry->size = size;
+	entry->job = Ref<JacketLoadingJob>(job);
+	entry->lastUsed = m_frame;
+	m_stats.pendingLoads++;
+	g_jobSheduler->Queue(entry->job.As<JobBase>());
+	return entry;
+}
+void JacketCache::m_Touch(Entry* entry)
+{
+	entry->lastUsed = m_frame;
+	m_entries.Touch(entry);
+}
+void JacketCache::m_Free(Entry* entry)
+{
+	if(entry->loaded)
+	{
+		if(m_vg)
+			nvgDeleteImage(m_vg, entry->texture);
+		// Skins that kept the handle get the jacket loaded again when they draw it
+		if(entry->returned)
+			m_freedTextures.Add(entry->texture, { *entry->lruIt, entry->size });
+		m_stats.numLoaded--;
+		m_stats.memoryUsage -= entry->memoryUsage;
+	}
+}
+void JacketCache::m_OnLoaded(JacketLoadingJob* job)
+{
+	Entry* entry = m_entries.FindLoading(job->imagePath, job);
+	if(!entry)
+		return;
+
+	m_stats.pendingLoads--;
+	float latency = (m_timer.SecondsAsFloat() - job->requestTime) * 1000.0f;
+	m_stats.averageLatency = m_stats.averageLatency == 0.0f ? latency : (m_stats.averageLatency * 0.9f + latency * 0.1f);
+	m_stats.maxLatency = Math::Max(m_stats.maxLatency, latency);
+
+	if(job->IsSuccessfull() && m_vg)
+	{
+		Vector2i imageSize = job->loadedImage->GetSize();
+		entry->texture = nvgCreateImageRGBA(m_vg, imageSize.x, imageSize.y, 0, (unsigned char*)job->loadedImage->GetBits());
+		entry->memoryUsage = job->loadedImage->GetMemoryUsage();
+		entry->loaded = true;
+		m_stats.numLoaded++;
+		m_stats.memoryUsage += entry->memoryUsage;
+		if(job->fromThumbnail)
+			m_stats.diskHits++;
+	}
+	// Failed jackets stay in the cache so they are not loaded again every frame
+	entry->job.Release();
+}
+
+bool JacketLoadingJob::Run()
+{
+	// Only downscaled jackets are cached, others are loaded from the original image anyway
+	String thumbnailPath;
+	if(w > 0 && h > 0)
+	{
+		uint64 lastWriteTime = Files::GetLastWriteTime(imagePath);
+		if(lastWriteTime != 0)
+		{
+			thumbnailPath = GetThumbnailPath(imagePath, lastWriteTime, w, h);
+			if(Path::FileExists(thumbnailPath))
+			{
+				loadedImage = ImageRes::Create(thumbnailPath);
+				if(loadedImage.IsValid())
+				{
+					fromThumbnail = true;
+					return true;
+				}
+			}
+		}
+	}
+
+	// JPEGs are decoded at a lower resolution when they are scaled down anyway
+	loadedImage = ImageRes::Create(imagePath, Vector2i(Math::Max(w, 0), Math::Max(h, 0)));
+	if(!loadedImage.IsValid())
+		return false;
+
+	if(w > 0 && h > 0 && (loadedImage->GetSize().x > w || loadedImage->GetSize().y > h))
+	{
+		loadedImage->ReSize({ w,h });
+		if(!thumbnailPath.empty())
+			loadedImage->SavePNG(thumbnailPath, 1, false);
+	}
+	return true;
+}
+void JacketLoadingJob::Finalize()
+{
+	if(cache)
+		cache->m_OnLoaded(this);
+	// Pixels are in the nanovg image now
+	loadedImage.Release();
+}
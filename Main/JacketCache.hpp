@@ -0,0 +1,119 @@
+#pragma once
+#include <Shared/Jobs.hpp>
+#include "LoadingCache.hpp"
+
+struct NVGcontext;
+
+struct JacketCacheStats
+{
+	// Requests for jackets that were already loaded
+	uint32 hits = 0;
+	// Requests that had to start loading a jacket
+	uint32 misses = 0;
+	// Jackets loaded from the thumbnail cache instead of the original image
+	uint32 diskHits = 0;
+	// Jackets that were loaded by a prefetch before they were requested
+	uint32 prefetchHits = 0;
+	uint32 evictions = 0;
+	// Number of loaded jackets and the memory used by their images
+	uint32 numLoaded = 0;
+	size_t memoryUsage = 0;
+	uint32 pendingLoads = 0;
+	// Time from request until the jacket is available, in milliseconds
+	float averageLatency = 0.0f;
+	float maxLatency = 0.0f;
+};
+
+/*
+	Cache for jacket images shown in song select and gameplay
+	Loaded jackets are kept as nanovg images within a memory and image count budget, the least recently used ones are freed first
+	Downscaled jackets are also saved in a thumbnail cache on disk, keyed on the path and modification time of the original image,
+	so big jackets only have to be decoded once
+*/
+class JacketCache : public Unique
+{
+public:
+	JacketCache();
+	~JacketCache();
+
+	// Returns the nanovg image for a jacket, or the placeholder while it is loading
+	//	if size is not zero, the jacket is scaled down to fit in it
+	int Get(const String& path, Vector2i size, int placeholder);
+
+	// Image to draw for a handle a skin got from Get, skins may keep handles after the jacket was freed
+	//	those load the jacket again and return the placeholder or the new image, other handles are returned as they are
+	int Resolve(int image);
+
+	// Starts loading a jacket that is likely to be requested soon, using the size of the last request
+	void Prefetch(const String& path);
+
+	// Frees jackets while over budget, call once per frame
+	void Update();
+
+	// Frees all jackets, should be called before the nanovg context is destroyed
+	void Clear();
+	// Sets the nanovg context to create jacket images in
+	void SetContext(NVGcontext* vg);
+
+	void SetBudget(size_t maxMemory, uint32 maxImages);
+	const JacketCacheStats& GetStats() const;
+
+	// Folder in the cache folder containing the thumbnails
+	static const char* thumbnailFolder;
+
+private:
+	struct Entry
+	{
+		int texture = 0;
+		bool loaded = false;
+		bool prefetched = false;
+		// The texture was returned to a skin, which might still draw it after it's freed
+		bool returned = false;
+		Vector2i size;
+		size_t memoryUsage = 0;
+		// Frame this jacket was last requested on
+		uint64 lastUsed = 0;
+		Ref<class JacketLoadingJob> job;
+		List<String>::iterator lruIt;
+	};
+
+	// Jacket a freed texture that was returned to a skin showed
+	struct FreedTexture
+	{
+		String path;
+		Vector2i size;
+	};
+
+	Entry* m_Get(const String& path, Vector2i size);
+	Entry* m_Load(const String& path, Vector2i size);
+	void m_Touch(Entry* entry);
+	// Deletes the image of a jacket that is about to be freed
+	void m_Free(Entry* entry);
+	void m_OnLoaded(class JacketLoadingJob* job);
+	friend class JacketLoadingJob;
+
+	NVGcontext* m_vg = nullptr;
+	LoadingCache<Entry> m_entries;
+	// nanovg doesn't reuse image handles, so these stay unique until the context is recreated by a skin reload
+	Map<int, FreedTexture> m_freedTextures;
+	size_t m_maxMemory = 64 * 1024 * 1024;
+	uint32 m_maxImages = 500;
+	uint64 m_frame = 0;
+	Vector2i m_lastSize;
+	Timer m_timer;
+	JacketCacheStats m_stats;
+};
+
+class JacketLoadingJob : public JobBase
+{
+public:
+	virtual bool Run();
+	virtual void Finalize();
+
+	Image loadedImage;
+	String imagePath;
+	int w = 0, h = 0;
+	bool fromThumbnail = false;
+	float requestTime = 0.0f;
+	JacketCache* cache = nullptr;
+};
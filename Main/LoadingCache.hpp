@@ -0,0 +1,101 @@
+#pragma once
+
+/*
+	Entries of a cache that are loaded by jobs, kept in least recently used order, used by the jacket and audio summary caches
+	TEntry needs a List<String>::iterator lruIt and a Ref to its loading job named job, which is released once loading is done,
+	the job needs a cache pointer that is cleared when the entry is freed before the job finishes
+*/
+template<typename TEntry>
+class LoadingCache
+{
+public:
+	TEntry* Find(const String& path)
+	{
+		TEntry** found = m_entries.Find(path);
+		return found ? *found : nullptr;
+	}
+	// Returns the entry <job> is loading, nullptr if the entry was freed or another job is loading it
+	template<typename TJob>
+	TEntry* FindLoading(const String& path, const TJob* job)
+	{
+		TEntry* entry = Find(path);
+		if(!entry || !entry->job || entry->job.GetData() != job)
+			return nullptr;
+		return entry;
+	}
+
+	// Adds an entry as the most recently used one
+	TEntry* Add(const String& path)
+	{
+		TEntry* entry = new TEntry();
+		entry->lruIt = m_lru.insert(m_lru.begin(), path);
+		m_entries.Add(path, entry);
+		return entry;
+	}
+	// Makes an entry the most recently used one
+	void Touch(TEntry* entry)
+	{
+		if(entry->lruIt != m_lru.begin())
+			m_lru.splice(m_lru.begin(), m_lru, entry->lruIt);
+	}
+	// Makes an entry the least recently used one
+	void MoveToBack(TEntry* entry)
+	{
+		m_lru.splice(m_lru.end(), m_lru, entry->lruIt);
+	}
+
+	// Frees the least recently used entries while <overBudget> returns true, entries that are still loading are skipped
+	//	stops at the first entry <keep> returns true for, <onFree> is called before an entry is deleted
+	//	returns the number of freed entries
+	template<typename OverBudget, typename Keep, typename OnFree>
+	uint32 Evict(OverBudget overBudget, Keep keep, OnFree onFree)
+	{
+		uint32 numFreed = 0;
+		// Walks from the least recently used entry, next is the first of the skipped ones behind it
+		auto next = m_lru.end();
+		while(next != m_lru.begin() && overBudget())
+		{
+			auto it = std::prev(next);
+			TEntry* entry = m_entries[*it];
+			if(keep(entry))
+				break;
+			if(entry->job)
+			{
+				// Still loading, can't free this one yet but the ones in front of it can be
+				next = it;
+				continue;
+			}
+			onFree(entry);
+			m_entries.erase(*it);
+			m_lru.erase(it);
+			delete entry;
+			numFreed++;
+		}
+		return numFreed;
+	}
+	// Frees all entries, jobs that are still running won't report back
+	template<typename OnFree>
+	void Clear(OnFree onFree)
+	{
+		for(auto& it : m_entries)
+		{
+			TEntry* entry = it.second;
+			if(entry->job)
+				entry->job->cache = nullptr;
+			onFree(entry);
+			delete entry;
+		}
+		m_entries.clear();
+		m_lru.clear();
+	}
+
+	size_t GetSize() const
+	{
+		return m_entries.size();
+	}
+
+private:
+	Map<String, TEntry*> m_entries;
+	// Most recently used entries at the front
+	List<String> m_lru;
+};
@@ -15,6 +15,27 @@
 #endif
 #include "lua.hpp"
 #include "Shared/Time.hpp"
+#include "Shared/Jobs.hpp"
+#include <Graphics/ScreenCapture.hpp>
+
+// Encodes a captured screenshot on a job thread
+class ScreenshotSaveJob : public JobBase
+{
+public:
+	Image image;
+	String path;
+	int32 compressionLevel = -1;
+	// Time spent encoding and writing the file, in milliseconds
+	double encodeTime = 0.0;
+
+	virtual bool Run() override
+	{
+		Timer timer;
+		bool success = image->SavePNG(path, compressionLevel);
+		encodeTime = timer.SecondsAsDouble() * 1000.0;
+		return success;
+	}
+};
 
 class ScoreScreen_Impl : public ScoreScreen
 {
@@ -36,6 +57,7 @@ private:
 	float m_finalGaugeValue;
 	float* m_gaugeSamples;
 	String m_jacketPath;
+	String m_audioPath;
 	uint32 m_timedHits[2];
 	float m_meanHitDelta;
 	MapTime m_medianHitDelta;
@@ -49,6 +71,11 @@ private:
 	Texture m_graphTex;
 	GameFlags m_flags;
 
+	// Screenshots are read back over the next few frames and then encoded on a job thread
+	Graphics::ScreenCapture* m_screenCapture = nullptr;
+	Vector<String> m_pendingScreenshots;
+	Vector<Ref<ScreenshotSaveJob>> m_screenshotJobs;
+
 	void m_PushStringToTable(const char* name, String data)
 	{
 		lua_pushstring(m_lua, name);
@@ -123,8 +150,8 @@ public:
 		}
 
 		// Don't save the score if autoplay was on or if the song was launched using command line
-		// also don't save the score if the song was manually exited
-		if (!m_autoplay && !m_autoButtons && game->GetDifficultyIndex().mapId != -1 && !game->GetManualExit())
+		// also don't save the score if the song was manually exited or practiced
+		if (!m_autoplay && !m_autoButtons && game->GetDifficultyIndex().mapId != -1 && !game->GetManualExit() && !game->IsPractice())
 		{
 			m_mapDatabase.AddScore(game->GetDifficultyIndex(),
 				m_score,
@@ -143,6 +170,7 @@ public:
 		
 		m_beatmapSettings = game->GetBeatmap()->GetMapSettings();
 		m_jacketPath = Path::Normalize(game->GetMapRootPath() + Path::sep + m_beatmapSettings.jacketPath);
+		m_audioPath = Path::Normalize(game->GetMapRootPath() + Path::sep + m_beatmapSettings.audioNoFX);
 		m_jacketImage = game->GetJacketImage();
 
 		// Make texture for performance graph samples
@@ -159,6 +187,11 @@ public:
 	}
 	~ScoreScreen_Impl()
 	{
+		// Jobs that are still running finish writing their file, but the callbacks are no longer needed
+		for(auto& job : m_screenshotJobs)
+			job->OnFinished.RemoveAll(this);
+		if (m_screenCapture)
+			delete m_screenCapture;
 		if (m_lua)
 			g_application->DisposeLua(m_lua);
 	}
@@ -192,6 +225,7 @@ public:
 		m_PushStringToTable("effector", m_beatmapSettings.effector);
 		m_PushStringToTable("bpm", m_beatmapSettings.bpm);
 		m_PushStringToTable("jacketPath", m_jacketPath);
+		m_PushStringToTable("audioPath", m_audioPath);
 		m_PushIntToTable("medianHitDelta", m_medianHitDelta);
 		m_PushFloatToTable("meanHitDelta", m_meanHitDelta);
 		m_PushIntToTable("earlies", m_timedHits[0]);
@@ -278,18 +312,13 @@ public:
 				w = g_resolution.x;
 				h = g_resolution.y;
 			}
-			Vector2i size(w, h);
-			Image screenshot = ImageRes::Screenshot(g_gl, size, { x,y });
-			String screenshotPath = "screenshots/" + Shared::Time::Now().ToString() + ".png";
-			screenshot->SavePNG(screenshotPath);
-			screenshot.Release();
-
-			lua_getglobal(m_lua, "screenshot_captured");
-			if (lua_isfunction(m_lua, -1))
+			if (!m_screenCapture)
 			{
-				lua_pushstring(m_lua, *screenshotPath);
-				lua_call(m_lua, 1, 0);
+				m_screenCapture = new Graphics::ScreenCapture(g_gl);
+				m_screenCapture->OnCaptured.Add(this, &ScoreScreen_Impl::m_OnScreenCaptured);
 			}
+			if (m_screenCapture->Capture({ x, y }, { w, h }))
+				m_pendingScreenshots.Add("screenshots/" + Shared::Time::Now().ToString() + ".png");
 		}
 		if (key == SDLK_F9)
 		{
@@ -311,8 +340,47 @@ public:
 			assert(false);
 		}
 	}
+	void m_OnScreenCaptured(Image image)
+	{
+		Ref<ScreenshotSaveJob> job = Ref<ScreenshotSaveJob>(new ScreenshotSaveJob());
+		job->image = image;
+		job->path = m_pendingScreenshots.front();
+		job->compressionLevel = g_gameConfig.GetInt(GameConfigKeys::ScreenshotCompression);
+		job->jobFlags = JobFlags::IO;
+		job->OnFinished.Add(this, &ScoreScreen_Impl::m_OnScreenshotSaved);
+		m_pendingScreenshots.erase(m_pendingScreenshots.begin());
+		m_screenshotJobs.Add(job);
+		g_jobSheduler->Queue(job.As<JobBase>());
+	}
+	void m_OnScreenshotSaved(Job job)
+	{
+		Ref<ScreenshotSaveJob> saveJob = job.As<ScreenshotSaveJob>();
+		m_screenshotJobs.Remove(saveJob);
+		if (!job->IsSuccessfull())
+			return;
+
+		Logf("Screenshot saved to \"%s\" (encoded in %.2f ms)", Logger::Normal, saveJob->path, saveJob->encodeTime);
+		lua_getglobal(m_lua, "screenshot_captured");
+		if (lua_isfunction(m_lua, -1))
+		{
+			lua_pushstring(m_lua, *saveJob->path);
+			if (lua_pcall(m_lua, 1, 0, 0) != 0)
+			{
+				Logf("Lua error: %s", Logger::Error, lua_tostring(m_lua, -1));
+				lua_pop(m_lua, 1);
+			}
+		}
+		else
+		{
+			lua_pop(m_lua, 1);
+		}
+	}
+
 	virtual void Tick(float deltaTime) override
 	{
+		if (m_screenCapture)
+			m_screenCapture->Update();
+
 		// Check for button pressed here instead of adding to onbuttonpressed for stability reasons
 		//TODO: Change to onbuttonpressed
 		if(m_startPressed && !g_input.GetButton(Input::Button::BT_S))
@@ -3,6 +3,7 @@
 #include <Beatmap/BeatmapPlayback.hpp>
 #include <math.h>
 #include "GameConfig.hpp"
+#include <Shared/Profiling.hpp>
 
 const MapTime Scoring::missHitTime = 275;
 const MapTime Scoring::goodHitTime = 100;
@@ -188,6 +189,7 @@ void Scoring::FinishGame()
 
 void Scoring::Tick(float deltaTime)
 {
+	ProfileScope("Scoring::Tick");
 	m_UpdateLasers(deltaTime);
 	m_UpdateTicks();
 	if (autoplay | autoplayButtons)
@@ -0,0 +1,112 @@
+#include "stdafx.h"
+#include "SkinBundle.hpp"
+#include "Application.hpp"
+#include <Shared/AssetBundle.hpp>
+#include <Shared/Files.hpp>
+
+const char* SkinBundle::folders[4] = { "textures", "shaders", "audio", "fonts" };
+
+String SkinBundle::GetPath(const String& skin)
+{
+	return Path::Normalize("skins/" + skin + "/skin.bundle");
+}
+
+static bool ReadFile(const String& path, Buffer& out)
+{
+	File file;
+	if(!file.OpenRead(path))
+		return false;
+	out.resize(file.GetSize());
+	return out.empty() || file.Read(out.data(), out.size()) == out.size();
+}
+
+bool SkinBundle::Build(const String& skin)
+{
+	Timer timer;
+	String skinFolder = Path::Normalize("skins/" + skin);
+	String bundlePath = GetPath(skin);
+	String tempPath = bundlePath + ".tmp";
+
+	AssetBundleWriter writer;
+	if(!writer.Open(tempPath))
+	{
+		Logf("Failed to create skin bundle %s", Logger::Error, tempPath);
+		return false;
+	}
+
+	bool success = true;
+	uint32 numImages = 0, numShaders = 0;
+	for(const char* folder : folders)
+	{
+		Vector<FileInfo> files = Files::ScanFilesRecursive(skinFolder + Path::sep + folder);
+		for(const FileInfo& file : files)
+		{
+			if(file.type != FileType::Regular)
+				continue;
+
+			String relativePath = AssetBundle::NormalizePath(Path::RemoveBase(file.fullPath, skinFolder));
+			relativePath.TrimFront('/');
+			String extension = Path::GetExtension(file.fullPath);
+			extension.ToLower();
+
+			Buffer data;
+			if(!ReadFile(file.fullPath, data))
+			{
+				Logf("Failed to read %s", Logger::Error, file.fullPath);
+				success = false;
+				break;
+			}
+
+			AssetType type = AssetType::Raw;
+			if(String(folder) == "textures" && (extension == "png" || extension == "jpg" || extension == "jpeg"))
+			{
+				// Stored decoded, so loading only has to copy the pixels
+				Image image = ImageRes::Create(file.fullPath);
+				if(image)
+				{
+					Vector2i size = image->GetSize();
+					data.resize(sizeof(int32) * 2 + image->GetMemoryUsage());
+					memcpy(data.data(), &size.x, sizeof(int32));
+					memcpy(data.data() + sizeof(int32), &size.y, sizeof(int32));
+					memcpy(data.data() + sizeof(int32) * 2, image->GetBits(), image->GetMemoryUsage());
+					type = AssetType::Image;
+					numImages++;
+				}
+			}
+			else if(String(folder) == "shaders" && (extension == "vs" || extension == "fs" || extension == "gs"))
+			{
+				ShaderType shaderType = extension == "vs" ? ShaderType::Vertex : (extension == "fs" ? ShaderType::Fragment : ShaderType::Geometry);
+				String source((const char*)data.data(), data.size());
+				if(!ShaderRes::CreateFromSource(g_gl, shaderType, source, file.fullPath))
+				{
+					Logf("Shader %s failed to compile, not building the skin bundle", Logger::Error, file.fullPath);
+					success = false;
+					break;
+				}
+				numShaders++;
+			}
+
+			if(!writer.Add(relativePath, type, file.lastWriteTime, data.data(), data.size()))
+			{
+				Logf("Failed to write %s to the skin bundle", Logger::Error, relativePath);
+				success = false;
+				break;
+			}
+		}
+		if(!success)
+			break;
+	}
+
+	if(success)
+		success = writer.Finish();
+	if(!success || !Path::Rename(tempPath, bundlePath, true))
+	{
+		Path::Delete(tempPath);
+		Logf("Failed to build skin bundle for %s", Logger::Error, skin);
+		return false;
+	}
+
+	Logf("Built skin bundle %s: %d assets (%d textures, %d shaders), %.1f MB in %.1f s", Logger::Info, bundlePath,
+		(int32)writer.GetAssetCount(), numImages, numShaders, (double)writer.GetSize() / (1024.0 * 1024.0), timer.SecondsAsDouble());
+	return true;
+}
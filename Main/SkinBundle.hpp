@@ -0,0 +1,21 @@
+#pragma once
+
+/*
+	Packs the assets of a skin into a single asset bundle, which is memory mapped when the skin is loaded
+	so starting the game doesn't have to open and decode hundreds of small files
+
+	Textures are stored decoded, shaders are compiled before they are added so a bundle never contains broken shaders
+	Scripts are not included, they are loaded from the skin folder by Lua
+*/
+class SkinBundle
+{
+public:
+	// Path of the bundle file of a skin
+	static String GetPath(const String& skin);
+
+	// Builds the bundle for a skin, requires an OpenGL context to check the shaders
+	static bool Build(const String& skin);
+
+	// Folders of a skin that are included in the bundle
+	static const char* folders[4];
+};
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "SongSelect.hpp"
+#include "JacketCache.hpp"
 #include "TitleScreen.hpp"
 #include "Application.hpp"
 #include <Shared/Profiling.hpp>
@@ -9,7 +10,9 @@
 #include "TransitionScreen.hpp"
 #include "GameConfig.hpp"
 #include "SongFilter.hpp"
+#include "ChartPreparation.hpp"
 #include <Audio/Audio.hpp>
+#include <Audio/LoudnessMeter.hpp>
 #ifdef _WIN32
 #include "SDL_keycode.h"
 #else
@@ -18,6 +21,7 @@
 #include "lua.hpp"
 #include <iterator>
 #include <mutex>
+#include <atomic>
 
 
 class TextInput
@@ -121,7 +125,7 @@ public:
 		{
 			if(m_currentStream)
 			{
-				m_currentStream.Destroy();
+				m_RemoveStream(m_currentStream);
 			}
 			m_currentStream = m_nextStream;
 		}
@@ -143,7 +147,7 @@ public:
 			{
 				if(m_currentStream)
 				{
-					m_currentStream.Destroy();
+					m_RemoveStream(m_currentStream);
 				}
 				m_currentStream = m_nextStream;
 				if(m_currentStream)
@@ -177,7 +181,23 @@ public:
 			m_currentStream->Play();
 	}
 
+	// Called with streams that are no longer playing, instead of destroying them
+	Delegate<AudioStream> OnStreamRemoved;
+
 private:
+	void m_RemoveStream(AudioStream& stream)
+	{
+		if(OnStreamRemoved.IsHandled())
+		{
+			OnStreamRemoved.Call(stream);
+			stream.Release();
+		}
+		else
+		{
+			stream.Destroy();
+		}
+	}
+
 	static const float m_fadeDuration;
 	float m_fadeTimer = 0.0f;
 	AudioStream m_nextStream;
@@ -186,6 +206,48 @@ private:
 };
 const float PreviewPlayer::m_fadeDuration = 0.5f;
 
+/*
+	Opens, seeks and pre-buffers preview audio on a job thread
+	so scrolling through the song wheel doesn't stall on file I/O or building seek tables
+*/
+class PreviewLoadJob : public JobBase
+{
+public:
+	PreviewLoadJob()
+	{
+		cancelled = false;
+	}
+	virtual bool Run() override
+	{
+		if(cancelled)
+			return false;
+
+		Timer timer;
+		// Streams from the preview cache are already open
+		if(!stream)
+		{
+			stream = g_audio->CreateStream(audioPath);
+			openTime = timer.SecondsAsDouble() * 1000.0;
+			if(!stream || cancelled)
+				return false;
+		}
+		timer.Restart();
+		stream->SetPosition(offset);
+		stream->PreBuffer();
+		seekTime = timer.SecondsAsDouble() * 1000.0;
+		return true;
+	}
+
+	String audioPath;
+	int32 offset = 0;
+	AudioStream stream;
+	// Set when the selection moved on before the stream was ready
+	std::atomic<bool> cancelled;
+	// Time spent opening the file and seeking + decoding, in milliseconds
+	double openTime = 0.0;
+	double seekTime = 0.0;
+};
+
 /*
 	Song selection wheel
 */
@@ -344,8 +406,13 @@ public:
 			m_OnMapSelected(it->second);
 
 			//set index in lua
+			uint32 lastLuaMapIndex = m_currentlySelectedLuaMapIndex;
 			m_currentlySelectedLuaMapIndex = std::distance(srcCollection.begin(), it);
 			m_SetLuaMapIndex();
+
+			// Load jackets for the songs the wheel is moving towards
+			int32 direction = m_currentlySelectedLuaMapIndex >= lastLuaMapIndex ? 1 : -1;
+			m_PrefetchJackets(it, direction);
 		}
 		m_currentlySelectedId = newIndex;
 	}
@@ -514,6 +581,35 @@ private:
 		lua_pushinteger(m_lua, data);
 		lua_settable(m_lua, -3);
 	}
+	void m_PrefetchJackets(Map<int32, SongSelectIndex>::const_iterator it, int32 direction)
+	{
+		auto& srcCollection = m_SourceCollection();
+		JacketCache* jacketCache = g_application->GetJacketCache();
+		int32 count = g_gameConfig.GetInt(GameConfigKeys::JacketPrefetchCount);
+		for(int32 i = 0; i < count; i++)
+		{
+			if(direction > 0)
+			{
+				if(++it == srcCollection.end())
+					break;
+			}
+			else
+			{
+				if(it == srcCollection.begin())
+					break;
+				--it;
+			}
+
+			// Same jacket the song wheel shows for the selected difficulty
+			Vector<DifficultyIndex*> diffs = it->second.GetDifficulties();
+			if(diffs.empty())
+				continue;
+			DifficultyIndex* diff = diffs[Math::Min<int32>(m_currentlySelectedDiff, (int32)diffs.size() - 1)];
+			if(diff->settings.jacketPath.empty())
+				continue;
+			jacketCache->Prefetch(Path::Normalize(it->second.GetMap()->path + "/" + diff->settings.jacketPath));
+		}
+	}
 	void m_SetLuaDiffIndex()
 	{
 		lua_getglobal(m_lua, "set_diff");
@@ -560,6 +656,7 @@ private:
 				lua_newtable(m_lua);
 				auto settings = diff->settings;
 				m_PushStringToTable("jacketPath", Path::Normalize(song.second.GetMap()->path + "/" + settings.jacketPath).c_str());
+				m_PushStringToTable("audioPath", Path::Normalize(song.second.GetMap()->path + Path::sep + settings.audioNoFX).c_str());
 				m_PushIntToTable("level", settings.level);
 				m_PushIntToTable("difficulty", settings.difficulty);
 				m_PushIntToTable("id", diff->id);
@@ -991,6 +1088,14 @@ private:
 
 	// Current map that has music being preview played
 	MapIndex* m_currentPreviewAudio;
+	// Job loading the preview for the current map
+	Ref<PreviewLoadJob> m_previewJob;
+	// Audio path and preview offset of streams that are playing
+	Map<AudioStreamRes*, std::pair<String, int32>> m_previewStreams;
+	// Recently played previews, opened and seeked to their preview offset, most recent first
+	List<std::pair<String, AudioStream>> m_previewCache;
+	// Jobs seeking streams back to their preview offset before they go into the cache
+	Vector<Ref<PreviewLoadJob>> m_previewCacheJobs;
 
 	// Select sound
 	Sample m_selectSound;
@@ -1027,6 +1132,8 @@ public:
 		m_filterSelection->SetMapDB(&m_mapDatabase);
 		m_selectionWheel->OnMapSelected.Add(this, &SongSelect_Impl::OnMapSelected);
 		m_selectionWheel->OnDifficultySelected.Add(this, &SongSelect_Impl::OnDifficultySelected);
+		if (g_gameConfig.GetInt(GameConfigKeys::PreviewCacheSize) > 0)
+			m_previewPlayer.OnStreamRemoved.Add(this, &SongSelect_Impl::m_OnPreviewRemoved);
 		// Setup the map database
 		m_mapDatabase.AddSearchPath(g_gameConfig.GetString(GameConfigKeys::SongFolder));
 
@@ -1034,6 +1141,13 @@ public:
 		m_mapDatabase.OnMapsUpdated.Add(m_selectionWheel.GetData(), &SelectionWheel::OnMapsUpdated);
 		m_mapDatabase.OnMapsCleared.Add(m_selectionWheel.GetData(), &SelectionWheel::OnMapsCleared);
 		m_mapDatabase.OnSearchStatusUpdated.Add(m_selectionWheel.GetData(), &SelectionWheel::OnSearchStatusUpdated);
+		if (g_gameConfig.GetBool(GameConfigKeys::NormalizeLoudness))
+		{
+			m_mapDatabase.SetLoudnessAnalyzer([](const String& audioPath, LoudnessInfo& loudness)
+			{
+				return LoudnessMeter::Measure(g_audio, audioPath, loudness.integrated, loudness.truePeak);
+			}, (uint32)Math::Max(g_gameConfig.GetInt(GameConfigKeys::LoudnessAnalysisThreads), 1));
+		}
 		m_mapDatabase.StartSearching();
 
 		m_filterSelection->SetFiltersByIndex(g_gameConfig.GetInt(GameConfigKeys::LevelFilter), g_gameConfig.GetInt(GameConfigKeys::FolderFilter));
@@ -1055,6 +1169,16 @@ public:
 		g_input.OnButtonPressed.RemoveAll(this);
 		g_input.OnButtonReleased.RemoveAll(this);
 		g_gameWindow->OnMouseScroll.RemoveAll(this);
+		// Streams still loading are released when their job finishes
+		if (m_previewJob)
+		{
+			m_previewJob->cancelled = true;
+			m_previewJob->OnFinished.RemoveAll(this);
+		}
+		for (auto& job : m_previewCacheJobs)
+			job->OnFinished.RemoveAll(this);
+		m_previewPlayer.OnStreamRemoved.RemoveAll(this);
+		m_previewCache.clear();
 		m_selectionWheel.Destroy();
 		m_filterSelection.Destroy();
 		if (m_lua)
@@ -1070,29 +1194,130 @@ public:
 			}else if (!m_previewLoaded){
 				// Set current preview audio
 				DifficultyIndex* previewDiff = m_currentPreviewAudio->difficulties[0];
-				String audioPath = m_currentPreviewAudio->path + Path::sep + previewDiff->settings.audioNoFX;
+				String audioPath = m_GetPreviewPath(m_currentPreviewAudio);
 
-				AudioStream previewAudio = g_audio->CreateStream(audioPath);
-				if (previewAudio)
+				Ref<PreviewLoadJob> job = Ref<PreviewLoadJob>(new PreviewLoadJob());
+				job->audioPath = audioPath;
+				job->offset = previewDiff->settings.previewOffset;
+				job->jobFlags = JobFlags::IO;
+
+				// Recently played previews are ready to go
+				for (auto it = m_previewCache.begin(); it != m_previewCache.end(); it++)
 				{
-					previewAudio->SetPosition(previewDiff->settings.previewOffset);
-					m_previewPlayer.FadeTo(previewAudio);
+					if (it->first == audioPath)
+					{
+						job->stream = it->second;
+						m_previewCache.erase(it);
+						break;
+					}
+				}
+				m_previewLoaded = true;
+				if (job->stream)
+				{
+					m_StartPreview(job.GetData());
 				}
 				else
 				{
-					Logf("Failed to load preview audio from [%s]", Logger::Warning, audioPath);
-					m_previewPlayer.FadeTo(AudioStream());
+					m_previewJob = job;
+					m_previewJob->OnFinished.Add(this, &SongSelect_Impl::m_OnPreviewLoaded);
+					g_jobSheduler->Queue(m_previewJob.As<JobBase>());
 				}
-				m_previewLoaded = true;
-				// m_previewPlayer.Restore();
 			}
 		} else{
 			// Wait at least 15 ticks before attempting to load song to prevent loading songs while scrolling very fast
-			m_previewDelayTicks = 15;
+			//	cached previews don't need to load anything, so they can start right away
+			m_previewDelayTicks = m_IsPreviewCached(map) ? 0 : 15;
 			m_currentPreviewAudio = map;
 			m_previewLoaded = false;
+			// The stream that is still loading is not needed anymore
+			if (m_previewJob)
+			{
+				m_previewJob->cancelled = true;
+				m_previewJob.Release();
+			}
 		}
 	}
+	String m_GetPreviewPath(MapIndex* map)
+	{
+		DifficultyIndex* previewDiff = map->difficulties[0];
+		return map->path + Path::sep + previewDiff->settings.audioNoFX;
+	}
+	bool m_IsPreviewCached(MapIndex* map)
+	{
+		if (!map || m_previewCache.empty())
+			return false;
+		String audioPath = m_GetPreviewPath(map);
+		for (auto& cached : m_previewCache)
+		{
+			if (cached.first == audioPath)
+				return true;
+		}
+		return false;
+	}
+	void m_OnPreviewLoaded(Job job)
+	{
+		Ref<PreviewLoadJob> previewJob = job.As<PreviewLoadJob>();
+		if (previewJob != m_previewJob)
+			return; // Cancelled, the stream is freed with the job
+		m_previewJob.Release();
+
+		if (previewJob->IsSuccessfull())
+		{
+			Logf("Preview audio for [%s] ready in %.2f ms (%.2f ms open, %.2f ms seek, %.2f ms open to first sample)", Logger::Info,
+				previewJob->audioPath, previewJob->openTime + previewJob->seekTime, previewJob->openTime, previewJob->seekTime,
+				previewJob->stream->GetFirstSampleLatency());
+			m_StartPreview(previewJob.GetData());
+		}
+		else
+		{
+			Logf("Failed to load preview audio from [%s]", Logger::Warning, previewJob->audioPath);
+			m_previewPlayer.FadeTo(AudioStream());
+		}
+	}
+	void m_StartPreview(PreviewLoadJob* job)
+	{
+		// Only needed to put the stream in the cache once it stops playing
+		if (m_previewPlayer.OnStreamRemoved.IsHandled())
+			m_previewStreams.Add(job->stream.GetData(), std::make_pair(job->audioPath, job->offset));
+		m_previewPlayer.FadeTo(job->stream);
+	}
+	// Keeps a stream that was faded out around, seeked back to its preview offset
+	void m_OnPreviewRemoved(AudioStream stream)
+	{
+		auto it = m_previewStreams.find(stream.GetData());
+		if (it == m_previewStreams.end())
+			return;
+		stream->Pause();
+
+		Ref<PreviewLoadJob> job = Ref<PreviewLoadJob>(new PreviewLoadJob());
+		job->audioPath = it->second.first;
+		job->offset = it->second.second;
+		job->stream = stream;
+		job->jobFlags = JobFlags::IO;
+		job->OnFinished.Add(this, &SongSelect_Impl::m_OnPreviewCached);
+		m_previewStreams.erase(it);
+		m_previewCacheJobs.Add(job);
+		g_jobSheduler->Queue(job.As<JobBase>());
+	}
+	void m_OnPreviewCached(Job job)
+	{
+		Ref<PreviewLoadJob> previewJob = job.As<PreviewLoadJob>();
+		m_previewCacheJobs.Remove(previewJob);
+		if (!previewJob->IsSuccessfull())
+			return;
+
+		for (auto it = m_previewCache.begin(); it != m_previewCache.end(); it++)
+		{
+			if (it->first == previewJob->audioPath)
+			{
+				m_previewCache.erase(it);
+				break;
+			}
+		}
+		m_previewCache.AddFront(std::make_pair(previewJob->audioPath, previewJob->stream));
+		while (m_previewCache.size() > (size_t)g_gameConfig.GetInt(GameConfigKeys::PreviewCacheSize))
+			m_previewCache.pop_back();
+	}
 	// When a difficulty is selected in the song wheel
 	void OnDifficultySelected(DifficultyIndex* diff)
 	{
@@ -1140,7 +1365,14 @@ public:
 				{
 					DifficultyIndex* diff = m_selectionWheel->GetSelectedDifficulty();
 
-					Game* game = Game::Create(*diff, m_settingsWheel->GetGameFlags());
+					// Chart and audio load on a job thread while the transition screen loads the game, which waits for them when it needs them
+					Ref<PreparedChart> prepared;
+					if (g_gameConfig.GetBool(GameConfigKeys::PrepareChart))
+					{
+						prepared = Ref<PreparedChart>(new PreparedChart(diff->path));
+						g_jobSheduler->Queue(prepared.As<JobBase>());
+					}
+					Game* game = Game::Create(*diff, m_settingsWheel->GetGameFlags(), prepared);
 					if (!game)
 					{
 						Logf("Failed to start game", Logger::Error);
@@ -1400,6 +1632,7 @@ public:
 		if (IsSuspended())
 			return;
 
+		ProfileScope("SongSelect::Render");
 		lua_getglobal(m_lua, "render");
 		lua_pushnumber(m_lua, deltaTime);
 		if (lua_pcall(m_lua, 1, 0, 0) != 0)
@@ -32,10 +32,6 @@ Track::~Track()
 		if (m_laserTrackBuilder[i])
 			delete m_laserTrackBuilder[i];
 	}
-	for (auto it = m_hitEffects.begin(); it != m_hitEffects.end(); it++)
-	{
-		delete *it;
-	}
 	if (timedHitEffect)
 		delete timedHitEffect;
 }
@@ -53,7 +49,7 @@ bool Track::AsyncLoad()
 
 	// Load hit effect colors
 	Image hitColorPalette;
-	CheckedLoad(hitColorPalette = ImageRes::Create("skins/" + skin + "/textures/hitcolors.png"));
+	CheckedLoad(hitColorPalette = g_application->LoadImage("hitcolors.png"));
 	assert(hitColorPalette->GetSize().x >= 4);
 	for (uint32 i = 0; i < 4; i++)
 		hitColors[i] = hitColorPalette->GetBits()[i];
@@ -173,6 +169,36 @@ bool Track::AsyncFinalize()
 	timedHitEffect->time = 0;
 	timedHitEffect->track = this;
 
+	// Batching hit effects needs a shader with vertex colors, skins without it draw every effect as a sprite
+	String skin = g_gameConfig.GetString(GameConfigKeys::Skin);
+	if (Path::FileExists(Path::Normalize("skins/" + skin + "/shaders/hitEffect.vs")) || g_application->FindSkinAsset("shaders/hitEffect.vs"))
+	{
+		Material normal = g_application->LoadMaterial("hitEffect");
+		Material additive = g_application->LoadMaterial("hitEffect");
+		if (normal && additive)
+		{
+			normal->opaque = false;
+			additive->opaque = false;
+			additive->blendMode = MaterialBlendMode::Additive;
+			hitEffects.SetMaterials(normal, additive);
+		}
+	}
+
+	// Colored flash in the lane of every pressed button, taller and fainter on BT lanes than on FX lanes
+	HitEffectType buttonHit;
+	buttonHit.name = "button";
+	buttonHit.texture = scoreHitTexture;
+	buttonHit.duration = 0.2f;
+	buttonHit.ratings = 0xF;
+	buttonHit.lanes = (uint8)HitEffectLanes::Buttons;
+	buttonHit.heightScale = 2.0f;
+	hitEffects.AddType(buttonHit);
+	buttonHit.name = "fx";
+	buttonHit.lanes = (uint8)HitEffectLanes::FX;
+	buttonHit.heightScale = 1.0f;
+	buttonHit.alpha = 0.5f;
+	hitEffects.AddType(buttonHit);
+
 	return success;
 }
 void Track::Tick(class BeatmapPlayback& playback, float deltaTime)
@@ -187,17 +213,7 @@ void Track::Tick(class BeatmapPlayback& playback, float deltaTime)
 	uint8 portrait = g_aspectRatio > 1.0f ? 0 : 1;
 
 	// Button Hit FX
-	for (auto it = m_hitEffects.begin(); it != m_hitEffects.end();)
-	{
-		(*it)->Tick(deltaTime);
-		if ((*it)->time <= 0.0f)
-		{
-			delete *it;
-			it = m_hitEffects.erase(it);
-			continue;
-		}
-		it++;
-	}
+	hitEffects.Tick(deltaTime);
 	timedHitEffect->Tick(deltaTime);
 
 	MapTime currentTime = playback.GetLastTime();
@@ -275,7 +291,7 @@ void Track::Tick(class BeatmapPlayback& playback, float deltaTime)
 
 }
 
-void Track::DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, const Vector<ObjectState*>& objects)
+void Track::DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, ObjectSpan objects)
 {
 	for (auto obj : objects)
 	{
@@ -452,10 +468,7 @@ void Track::DrawObjectState(RenderQueue& rq, class BeatmapPlayback& playback, Ob
 void Track::DrawOverlays(class RenderQueue& rq)
 {
 	// Draw button hit effect sprites
-	for (auto& hfx : m_hitEffects)
-	{
-		hfx->Draw(rq);
-	}
+	hitEffects.Draw(rq, *this);
 	if (timedHitEffect->time > 0.0f)
 		timedHitEffect->Draw(rq);
 }
@@ -517,22 +530,16 @@ Vector3 Track::TransformPoint(const Vector3 & p)
 	return trackOrigin.TransformPoint(p);
 }
 
-TimedEffect* Track::AddEffect(TimedEffect* effect)
+void Track::SpawnHitEffects(uint32 buttonIdx, ScoreHitRating rating, bool pressed)
 {
-	m_hitEffects.Add(effect);
-	effect->track = this;
-	return effect;
+	hitEffects.Spawn(buttonIdx, rating, pressed, hitColors);
 }
 void Track::ClearEffects()
 {
 	m_trackHide = 0.0f;
 	m_trackHideSpeed = 0.0f;
 
-	for (auto it = m_hitEffects.begin(); it != m_hitEffects.end(); it++)
-	{
-		delete *it;
-	}
-	m_hitEffects.clear();
+	hitEffects.Clear();
 }
 
 void Track::SetViewRange(float newRange)
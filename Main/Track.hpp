@@ -1,6 +1,7 @@
 #pragma once
 #include "Scoring.hpp"
 #include "AsyncLoadable.hpp"
+#include "HitEffects.hpp"
 
 /*
 	The object responsible for drawing the track.
@@ -40,7 +41,7 @@ public:
 	void Tick(class BeatmapPlayback& playback, float deltaTime);
 
 	// Draw black laser underlays for wide lasers or all lasers if lane is hidden
-	void DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, const Vector<ObjectState*>& objects);
+	void DrawLaserBase(RenderQueue& rq, class BeatmapPlayback& playback, ObjectSpan objects);
 	// Just the board with tick lines
 	void DrawBase(RenderQueue& rq);
 	// Draws an object
@@ -55,8 +56,9 @@ public:
 
 	Vector3 TransformPoint(const Vector3& p);
 
-	// Adds a sprite effect to the track
-	struct TimedEffect* AddEffect(struct TimedEffect* effect);
+	// Spawns the hit effects for a judgement in a button lane
+	//	pressed is false for notes that were missed without pressing the button
+	void SpawnHitEffects(uint32 buttonIdx, ScoreHitRating rating, bool pressed);
 	void ClearEffects();
 
 	void SetViewRange(float newRange);
@@ -123,6 +125,9 @@ public:
 	// Early/Late indicator
 	struct TimedHitEffect* timedHitEffect = nullptr;
 
+	// Button hit effects, skins can add their own types after the track is loaded
+	HitEffectSystem hitEffects;
+
 	// Track Origin position
 	Transform trackOrigin;
 
@@ -135,9 +140,6 @@ private:
 	// Bar tick locations
 	Vector<float> m_barTicks;
 
-	// Active effects
-	Vector<struct TimedEffect*> m_hitEffects;
-
 	// Distance of seen objects on the track
 	float m_viewRange;
 
@@ -172,25 +174,6 @@ struct TimedEffect
 	float time;
 };
 
-// Button hit effect
-struct ButtonHitEffect : public TimedEffect
-{
-	ButtonHitEffect(uint32 buttonCode, Color color);;
-	virtual void Draw(class RenderQueue& rq) override;
-
-	uint32 buttonCode;
-	Color color;
-};
-// Button hit rating effect
-struct ButtonHitRatingEffect : public TimedEffect
-{
-	ButtonHitRatingEffect(uint32 buttonCode, ScoreHitRating rating);;
-	virtual void Draw(class RenderQueue& rq) override;
-
-	uint32 buttonCode;
-	ScoreHitRating rating;
-};
-
 struct TimedHitEffect : public TimedEffect
 {
 	TimedHitEffect(bool late);
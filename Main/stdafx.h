@@ -27,6 +27,7 @@
 #include <Graphics/OpenGL.hpp>
 #include <Graphics/Image.hpp>
 #include <Graphics/ImageLoader.hpp>
+#include <Graphics/ImageProcessing.hpp>
 #include <Graphics/Texture.hpp>
 #include <Graphics/Material.hpp>
 #include <Graphics/Mesh.hpp>
@@ -37,6 +38,7 @@
 #include <Graphics/Font.hpp>
 #include <Graphics/Framebuffer.hpp>
 #include <Graphics/TextureAnimator.hpp>
+#include <Graphics/TextureAtlas.hpp>
 using namespace Graphics;
 
 // Asset loading macro
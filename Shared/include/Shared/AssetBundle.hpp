@@ -0,0 +1,85 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+#include "Shared/Map.hpp"
+#include "Shared/Vector.hpp"
+#include "Shared/File.hpp"
+#include "Shared/MappedFile.hpp"
+
+enum class AssetType : uint32
+{
+	// Contents of the source file
+	Raw = 0,
+	// Decoded RGBA8 image, int32 width and height followed by the pixels
+	Image,
+};
+
+/*
+	Read-only archive of assets that is memory mapped, so assets are only read from disk when they are used
+	Assets are identified by their path relative to the root folder the bundle was built from, using '/' as separator
+
+	File layout:
+		header (magic, version, asset count, index offset)
+		asset data, each asset aligned to 16 bytes
+		index, for each asset: offset, size, type, last write time of the source file, path length and path
+*/
+class AssetBundle : Unique
+{
+public:
+	struct Asset
+	{
+		String path;
+		AssetType type = AssetType::Raw;
+		// Last write time of the file the asset was built from
+		uint64 lastWriteTime = 0;
+		const uint8* data = nullptr;
+		size_t size = 0;
+	};
+
+	// Increase this when the layout of the file changes
+	static const uint32 version;
+
+	bool Open(const String& path);
+	void Close();
+	bool IsOpen() const;
+
+	const Asset* Find(const String& path) const;
+	// Assets directly in a folder, sorted by path
+	Vector<const Asset*> List(const String& folder) const;
+	size_t GetAssetCount() const;
+
+	// Converts a path to the form used in bundles
+	static String NormalizePath(const String& path);
+
+private:
+	MappedFile m_file;
+	Map<String, Asset> m_assets;
+};
+
+/*
+	Writes assets into a new bundle
+*/
+class AssetBundleWriter : Unique
+{
+public:
+	bool Open(const String& path);
+	bool Add(const String& path, AssetType type, uint64 lastWriteTime, const void* data, size_t size);
+	// Writes the index, the bundle can't be used before this is called
+	bool Finish();
+
+	size_t GetAssetCount() const;
+	size_t GetSize() const;
+
+private:
+	struct IndexEntry
+	{
+		String path;
+		AssetType type;
+		uint64 lastWriteTime;
+		uint64 offset;
+		uint64 size;
+	};
+	File m_file;
+	Vector<IndexEntry> m_index;
+	uint64 m_offset = 0;
+};
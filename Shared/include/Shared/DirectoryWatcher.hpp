@@ -0,0 +1,47 @@
+#pragma once
+#include "Shared/String.hpp"
+#include "Shared/Vector.hpp"
+#include "Shared/Unique.hpp"
+
+/*
+	Watches folders for changes to the files inside of them
+	currently only implemented on Linux (inotify), IsSupported returns false on other platforms
+*/
+class DirectoryWatcher : Unique
+{
+public:
+	enum class Action
+	{
+		// File written/created or moved into a watched folder
+		Modified,
+		// File deleted or moved out of a watched folder
+		Removed,
+		// Folder created or moved into a watched folder, it's contents should be scanned
+		FolderAdded,
+		// Folder deleted or moved out of a watched folder
+		FolderRemoved,
+		// Events were lost, everything should be rescanned
+		Overflow,
+	};
+	struct Change
+	{
+		Action action;
+		String path;
+	};
+
+	DirectoryWatcher();
+	~DirectoryWatcher();
+	static bool IsSupported();
+
+	// Watches a single folder (not it's sub-folders)
+	// returns false if the folder could not be watched (e.g. the system watch limit was reached)
+	bool AddFolder(const String& folder);
+	// Stops watching a folder and all the folders inside it
+	void RemoveFolder(const String& folder);
+
+	// Returns all changes since the last call, does not block
+	Vector<Change> Poll();
+
+private:
+	class DirectoryWatcher_Impl* m_impl;
+};
@@ -34,4 +34,13 @@ public:
 	// uses the given extension filter if specified
 	// Additional interruptible flag can contain a boolean which can interrupt the search when set to true
 	static Vector<FileInfo> ScanFilesRecursive(const String& folder, String extFilter = String(), bool* interrupt = nullptr);
+
+	// Lists the contents of a single folder
+	// sub-folders are always returned, files only if they match the extension filter (if specified)
+	// only the returned files have their last write time read
+	static bool ListFolder(const String& folder, String extFilter, Vector<FileInfo>& outFiles, Vector<String>& outFolders);
+
+	// Last write time of a file or folder, 0 if it doesn't exist
+	// the last write time of a folder changes when entries are added, removed or renamed in it
+	static uint64 GetLastWriteTime(const String& path);
 };
\ No newline at end of file
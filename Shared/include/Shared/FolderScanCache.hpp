@@ -0,0 +1,40 @@
+#pragma once
+#include "Shared/Files.hpp"
+#include "Shared/Map.hpp"
+#include <functional>
+
+/*
+	Remembers the contents of folders between recursive file scans
+	folders that still have the same last write time as in the previous scan are not listed again,
+	only the files in them that matched the extension filter are checked for their last write time
+*/
+class FolderScanCache
+{
+public:
+	struct Folder
+	{
+		uint64 lastWriteTime = 0;
+		Vector<String> subFolders;
+		// Files that matched the extension filter
+		Vector<String> files;
+	};
+
+	// Recursive scan that returns the same files as Files::ScanFilesRecursive and updates the cache
+	// onFolder is called for every folder, before its contents are read
+	// the cache is only updated if the scan was not interrupted
+	Vector<FileInfo> Scan(const Vector<String>& rootFolders, String extFilter, bool* interrupt = nullptr,
+		std::function<void(const String&)> onFolder = nullptr);
+
+	// Forces a folder to be listed again on the next scan
+	void Invalidate(const String& folder);
+
+	// Number of folders that were listed/reused from the cache in the last scan
+	uint32 GetListedCount() const { return m_listed; }
+	uint32 GetCachedCount() const { return m_cached; }
+
+	Map<String, Folder> folders;
+
+private:
+	uint32 m_listed = 0;
+	uint32 m_cached = 0;
+};
@@ -2,10 +2,13 @@
 #include "Shared/String.hpp"
 #include "Shared/Unique.hpp"
 
-/* 
+/*
 	Logging utility class
 	formats loggin messages with time stamps and module names
 	allows message coloring on platforms that support it
+
+	Messages are queued in a lock-free queue and written to the console and log file by a background thread,
+	so logging never blocks the calling thread on I/O (e.g. from the audio thread)
 */
 class Logger : Unique
 {
@@ -36,7 +39,7 @@ public:
 
 	// Sets the foreground color of the output, if applicable
 	void SetColor(Color color);
-	// Log a string to the logging output, 
+	// Log a string to the logging output,
 	void Log(const String& msg, Logger::Severity severity);
 
 	// Write log message header, (timestamp, etc..)
@@ -44,6 +47,24 @@ public:
 	// Writes string without newline
 	void Write(const String& msg);
 
+	// Blocks until all queued messages are written
+	void Flush();
+
+	// Messages less important than this level are discarded (Info < Normal < Warning < Error)
+	void SetLogLevel(Logger::Severity level);
+	bool IsEnabled(Logger::Severity severity) const;
+
+	// Maximum number of messages per second that are logged with the same format string through Logf, 0 to disable
+	void SetRateLimit(uint32 messagesPerSecond);
+	// Checks the log level and rate limit for a message logged with a given format string
+	bool ShouldLog(Logger::Severity severity, const char* format);
+
+	// Enable/Disable writing to the console, the log file is always written
+	void SetConsoleOutput(bool enabled);
+
+	// Number of messages that were discarded because the queue was full
+	uint64 GetDroppedCount() const;
+
 private:
 	class Logger_Impl* m_impl;
 };
@@ -52,6 +73,9 @@ private:
 template<typename... Args>
 void Logf(const char* format, Logger::Severity severity, Args... args)
 {
+	// Filter before formatting
+	if(!Logger::Get().ShouldLog(severity, format))
+		return;
 	String msg = Utility::Sprintf<Args...>(format, args...);
 	Logger::Get().Log(msg, severity);
 }
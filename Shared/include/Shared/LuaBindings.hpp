@@ -0,0 +1,77 @@
+#pragma once
+#include "Shared/Types.hpp"
+
+struct lua_State;
+
+/*
+	Reference to a Lua value stored in the registry
+	used to push tables and functions that are accessed every frame without looking them up by name
+	references are not released on destruction since they live as long as the lua state they belong to
+*/
+class LuaRef
+{
+public:
+	// Stores the value at the given stack index
+	void Set(lua_State* L, int index);
+	// Stores the value of a global, returns false if it is nil
+	bool SetGlobal(lua_State* L, const char* name);
+	void Release();
+
+	// Pushes the referenced value on the stack
+	void Push() const;
+	bool IsValid() const;
+
+private:
+	lua_State* m_L = nullptr;
+	int m_ref = -1;
+};
+
+// Lua time spent during a frame
+struct LuaFrameStats
+{
+	// Time spent in scripts and updating bindings, in milliseconds
+	double scriptTime = 0.0;
+	// Time spent collecting garbage, in milliseconds
+	double gcTime = 0.0;
+	// Memory used by the lua state in bytes
+	size_t memoryUsage = 0;
+	// Number of completed garbage collection cycles
+	uint32 gcCycles = 0;
+};
+
+/*
+	Runs Lua's incremental garbage collector in steps with a fixed time budget every frame,
+	instead of letting it run whenever scripts allocate, which causes random pauses in the middle of a frame
+*/
+class LuaGarbageCollector
+{
+public:
+	// Stops the automatic collector of the state, a budget of 0 leaves it running
+	void Attach(lua_State* L, uint32 budgetMicroseconds);
+	// Restores automatic collection
+	void Detach();
+
+	// Performs collection steps until the budget left for this frame is used up or a cycle completes
+	//	can be called several times per frame, e.g. from both Tick and Render
+	void Step();
+	// Publishes the stats of the current frame and resets the budget
+	void EndFrame();
+
+	// Calls a function that is on the stack and adds the time it took to the frame stats
+	//	returns false and leaves the error message on the stack if the call failed
+	bool Call(int nargs, int nresults);
+	// Adds time spent updating bindings to the frame stats
+	void AddScriptTime(double milliseconds);
+
+	// Stats of the last completed frame
+	const LuaFrameStats& GetStats() const;
+
+private:
+	lua_State* m_L = nullptr;
+	uint32 m_budget = 500;
+	// Memory in use after the last completed cycle, in KB
+	int m_lastCycleMemory = 0;
+	uint32 m_cycles = 0;
+	LuaFrameStats m_frame;
+	LuaFrameStats m_lastFrame;
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include "Shared/Unique.hpp"
+#include "Shared/String.hpp"
+
+/*
+	Read-only memory mapped file
+	Pages are only read from disk when they are accessed, so opening a big file is cheap
+*/
+class MappedFile : Unique
+{
+private:
+	class MappedFile_Impl* m_impl = nullptr;
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const String& path);
+	void Close();
+	bool IsOpen() const;
+
+	// Contents of the file, valid until the file is closed
+	const uint8* GetData() const;
+	size_t GetSize() const;
+};
@@ -53,6 +53,13 @@ public:
 
 	static Vector<String> GetSubDirs(const String& path);
 
+	// Folder for data derived from other files, like thumbnails or seek indices, in the cache folder of the game
+	static String GetCacheFolder(const String& name);
+	// Path of a file in a cache folder named after a hash of <key>
+	//	the key should contain everything the cached data depends on, like the source path, its modification time and a format version
+	//	an empty extension leaves the file name without one
+	static String GetCacheFilePath(const String& folder, const String& key, const String& extension = String());
+
 	// Check if the given path points to a directory
 	static bool IsDirectory(const String& path);
 	// Check if a file/folder exists at given location
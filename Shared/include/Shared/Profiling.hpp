@@ -1,5 +1,13 @@
 #pragma once
+#include "Shared/String.hpp"
+#include "Shared/Timer.hpp"
+#include "Shared/Macro.hpp"
+#include "Shared/Log.hpp"
 
+/*
+	Logs the duration of a task when it goes out of scope,
+	meant for one-off tasks like loading, use ProfileScope for per-frame code
+*/
 class ProfilerScope
 {
 public:
@@ -14,4 +22,67 @@ public:
 private:
 	Timer t;
 	String name;
-};
\ No newline at end of file
+};
+
+// Event buffer of a thread, see Profiler::ReserveThread
+typedef struct ProfilerThreadBuffer* ProfilerThread;
+
+/*
+	Low overhead frame profiler
+	Events are written into a lock-free ring buffer owned by the thread that emits them,
+	nothing is recorded unless a capture is active.
+	A capture can be exported to the chrome trace event format (chrome://tracing or https://ui.perfetto.dev)
+*/
+class Profiler
+{
+public:
+	// Number of events kept per thread, older events are overwritten
+	static const uint32 bufferSize = 1 << 16;
+
+	// Start recording events on all threads
+	static void BeginCapture();
+	// Stop recording and write all events recorded since BeginCapture to a trace file
+	static bool EndCapture(const String& path);
+	static bool IsCapturing();
+	// Number of events of the last capture that were overwritten because a thread wrote more than bufferSize events
+	static uint64 GetDroppedEvents();
+
+	// Name used for the calling thread in exported traces
+	static void SetThreadName(const char* name);
+	// Creates the event buffer for a thread ahead of time, for threads that must not allocate or lock like the audio thread
+	//	that thread then only calls AttachThread with the result
+	static ProfilerThread ReserveThread(const char* name);
+	static void AttachThread(ProfilerThread thread);
+
+	// Begin/End a named event on the calling thread
+	//	the name must be a string that lives for the duration of the program (a literal)
+	static void BeginEvent(const char* name);
+	static void EndEvent(const char* name);
+};
+
+/* Scoped event marker, use the ProfileScope macro instead of using this directly */
+class ProfilerEventScope
+{
+public:
+	ProfilerEventScope(const char* name) : m_name(name)
+	{
+		Profiler::BeginEvent(m_name);
+	}
+	~ProfilerEventScope()
+	{
+		Profiler::EndEvent(m_name);
+	}
+private:
+	const char* m_name;
+};
+
+// Instrumentation macros, these compile to nothing unless the profiler is enabled (-DEMBED_PROFILER=ON)
+#ifdef PROFILER_ENABLED
+#define ProfileScope(__name) ProfilerEventScope CONCAT(__profilerScope, __LINE__)(__name)
+#define ProfileThreadName(__name) Profiler::SetThreadName(__name)
+#define ProfileAttachThread(__thread) Profiler::AttachThread(__thread)
+#else
+#define ProfileScope(__name)
+#define ProfileThreadName(__name)
+#define ProfileAttachThread(__thread)
+#endif
@@ -6,26 +6,79 @@
 #include "Shared/Unique.hpp"
 #include "Shared/Log.hpp"
 #include "Shared/Thread.hpp"
+#include "Shared/Timer.hpp"
+
+// Counters of a single resource manager
+struct ResourceManagerStats
+{
+	// Number of registered objects that are still referenced
+	uint32 liveObjects = 0;
+	// Memory used by live objects in bytes, only for types that implement GetMemoryUsage
+	//	updated every time a collection pass finishes
+	uint64 memoryUsage = 0;
+	// Collected objects waiting to be destroyed while destruction is deferred
+	uint32 pendingDestruction = 0;
+	// Total number of objects collected
+	uint64 totalCollected = 0;
+	// Number of objects collected during the last second
+	uint32 collectedPerSecond = 0;
+};
 
 class IResourceManager
 {
 public:
-	// Collects unused object
-	virtual void GarbageCollect() = 0;
+	// Collects unused objects, incrementally if a time budget (in microseconds) is given
+	//	returns true when all objects have been checked, false if the budget ran out first,
+	//	in which case the next call continues where this one stopped
+	virtual bool GarbageCollect(uint32 budgetMicroseconds = 0) = 0;
+	// When enabled, collected objects are kept until ReleaseDeferred or until deferring is disabled
+	//	used to keep (GPU) object destruction out of gameplay
+	virtual void SetDeferDestruction(bool defer) = 0;
+	// Destroys all collected objects that were deferred
+	virtual void ReleaseDeferred() = 0;
 	// Forcefully releases all objects from this resource manager
 	virtual void ReleaseAll() = 0;
+	virtual ResourceManagerStats GetStats() = 0;
 	virtual ~IResourceManager() = default;
 };
 
+namespace Utility
+{
+	// Resource types can implement "size_t GetMemoryUsage() const" to have their memory usage tracked
+	template<typename T>
+	auto GetResourceMemoryUsage(const T& obj, int) -> decltype((size_t)obj.GetMemoryUsage())
+	{
+		return obj.GetMemoryUsage();
+	}
+	template<typename T>
+	size_t GetResourceMemoryUsage(const T& obj, long)
+	{
+		return 0;
+	}
+}
+
 /*
 	Templated resource managed that keeps Ref<> objects
 	the GarbageCollect function checks these and cleans up unused ones
+	Objects are stored in slots, released slots are reused so registering and collecting objects doesn't move other objects
 */
 template<typename T>
 class ResourceManager : public IResourceManager, Unique
 {
-	// List of managed object
+	// Object slots, empty slots are in the free list
 	Vector<Ref<T>> m_objects;
+	Vector<uint32> m_freeSlots;
+	// Collected objects that are kept alive until they can be destroyed
+	Vector<Ref<T>> m_deferred;
+	bool m_deferDestruction = false;
+
+	// Next slot to check by the incremental collection
+	size_t m_gcCursor = 0;
+	uint64 m_passMemoryUsage = 0;
+
+	ResourceManagerStats m_stats;
+	uint32 m_collectedThisSecond = 0;
+	Timer m_statsTimer;
 	Mutex m_lock;
 public:
 	ResourceManager()
@@ -40,44 +93,125 @@ public:
 	{
 		Ref<T> ret = Utility::MakeRef(pObject);
 		m_lock.lock();
-		m_objects.push_back(ret);
+		if(!m_freeSlots.empty())
+		{
+			m_objects[m_freeSlots.back()] = ret;
+			m_freeSlots.pop_back();
+		}
+		else
+		{
+			m_objects.push_back(ret);
+		}
+		m_stats.liveObjects++;
 		m_lock.unlock();
 		return ret;
 	}
-	virtual void GarbageCollect() override
+	virtual bool GarbageCollect(uint32 budgetMicroseconds = 0) override
 	{
-		size_t numCleanedUp = 0;
+		Timer timer;
+		Vector<Ref<T>> collected;
+		bool finished = false;
+
 		m_lock.lock();
-		for(auto it = m_objects.begin(); it != m_objects.end();)
+		while(true)
 		{
-			if(it->GetRefCount() <= 1)
+			if(m_gcCursor >= m_objects.size())
 			{
-				numCleanedUp++;
-				it = m_objects.erase(it);
-				continue;
+				// Finished checking all objects
+				m_stats.memoryUsage = m_passMemoryUsage;
+				m_passMemoryUsage = 0;
+				m_gcCursor = 0;
+				finished = true;
+				break;
 			}
-			it++;
+
+			Ref<T>& obj = m_objects[m_gcCursor];
+			if(obj)
+			{
+				if(obj.GetRefCount() <= 1)
+				{
+					collected.push_back(std::move(obj));
+					obj = Ref<T>();
+					m_freeSlots.push_back((uint32)m_gcCursor);
+				}
+				else
+				{
+					m_passMemoryUsage += Utility::GetResourceMemoryUsage(*obj, 0);
+				}
+			}
+			m_gcCursor++;
+
+			// Checking the time is relatively expensive, so only do it every few objects
+			if(budgetMicroseconds > 0 && (m_gcCursor % 64) == 0 && timer.Microseconds() >= budgetMicroseconds)
+				break;
 		}
-		m_lock.unlock();
-		if(numCleanedUp > 0)
+
+		m_stats.liveObjects -= (uint32)collected.size();
+		m_stats.totalCollected += collected.size();
+		m_collectedThisSecond += (uint32)collected.size();
+		if(m_statsTimer.Milliseconds() >= 1000)
+		{
+			m_stats.collectedPerSecond = m_collectedThisSecond;
+			m_collectedThisSecond = 0;
+			m_statsTimer.Restart();
+		}
+		if(m_deferDestruction)
 		{
-			//Logf("Cleaned up %d resource(s) of %s", Logger::Info, numCleanedUp, Utility::TypeInfo<T>::name);
+			for(auto& obj : collected)
+				m_deferred.push_back(std::move(obj));
+			collected.clear();
+			m_stats.pendingDestruction = (uint32)m_deferred.size();
 		}
+		m_lock.unlock();
+
+		// Collected objects are destroyed here, outside of the lock
+		return finished;
 	}
-	virtual void ReleaseAll()
+	virtual void SetDeferDestruction(bool defer) override
 	{
 		m_lock.lock();
-		size_t numCleanedUp = m_objects.size();
+		m_deferDestruction = defer;
+		m_lock.unlock();
+		if(!defer)
+			ReleaseDeferred();
+	}
+	virtual void ReleaseDeferred() override
+	{
+		Vector<Ref<T>> deferred;
+		m_lock.lock();
+		std::swap(deferred, m_deferred);
+		m_stats.pendingDestruction = 0;
+		m_lock.unlock();
+	}
+	virtual void ReleaseAll() override
+	{
+		m_lock.lock();
+		size_t numCleanedUp = 0;
 		for(auto it = m_objects.begin(); it != m_objects.end(); it++)
 		{
 			if(*it)
+			{
 				it->Destroy();
+				numCleanedUp++;
+			}
 		}
 		m_objects.clear();
+		m_freeSlots.clear();
+		m_deferred.clear();
+		m_gcCursor = 0;
+		m_passMemoryUsage = 0;
+		m_stats = ResourceManagerStats();
 		m_lock.unlock();
 		if(numCleanedUp > 0)
 		{
 			Logf("Cleaned up %d resource(s) of %s", Logger::Info, numCleanedUp, Utility::TypeInfo<T>::name);
 		}
 	}
-};
\ No newline at end of file
+	virtual ResourceManagerStats GetStats() override
+	{
+		m_lock.lock();
+		ResourceManagerStats stats = m_stats;
+		m_lock.unlock();
+		return stats;
+	}
+};
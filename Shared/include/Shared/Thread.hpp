@@ -3,7 +3,7 @@
 #include <mutex>
 
 /*
-	std::thread extension that allows affinity setting
+	std::thread extension that allows affinity and priority setting
 */
 class Thread : public std::thread
 {
@@ -11,6 +11,8 @@ public:
 	using std::thread::thread;
 	size_t SetAffinityMask(size_t affinityMask);
 	static size_t SetCurrentThreadAffinityMask(size_t affinityMask);
+	// Gives the calling thread the priority used for audio, returns false if the system doesn't allow it
+	static bool SetCurrentThreadRealtimePriority();
 };
 
 /* 
@@ -51,4 +51,17 @@ namespace Utility
 		a = b;
 		b = tmp;
 	}
+
+	// 64-bit FNV-1a hash, stable between runs and platforms unlike std::hash
+	inline uint64 Hash64(const void* data, size_t size)
+	{
+		const uint8* bytes = (const uint8*)data;
+		uint64 hash = 14695981039346656037ULL;
+		for(size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "stdafx.h"
+#include "AssetBundle.hpp"
+#include "Log.hpp"
+
+const uint32 AssetBundle::version = 1;
+
+static const char bundleMagic[4] = { 'U', 'S', 'C', 'B' };
+static const uint64 dataAlignment = 16;
+
+struct BundleHeader
+{
+	char magic[4];
+	uint32 version;
+	uint64 assetCount;
+	uint64 indexOffset;
+};
+struct BundleIndexEntry
+{
+	uint64 offset;
+	uint64 size;
+	uint32 type;
+	uint32 pathLength;
+	uint64 lastWriteTime;
+};
+
+bool AssetBundle::Open(const String& path)
+{
+	Close();
+	if(!m_file.Open(path))
+		return false;
+
+	const uint8* data = m_file.GetData();
+	size_t fileSize = m_file.GetSize();
+	BundleHeader header;
+	if(fileSize < sizeof(header))
+	{
+		Close();
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if(memcmp(header.magic, bundleMagic, sizeof(bundleMagic)) != 0 || header.version != version)
+	{
+		Logf("Asset bundle %s is not compatible with this version, it needs to be built again", Logger::Warning, path);
+		Close();
+		return false;
+	}
+
+	size_t cursor = (size_t)header.indexOffset;
+	for(uint64 i = 0; i < header.assetCount; i++)
+	{
+		BundleIndexEntry entry;
+		if(cursor + sizeof(entry) > fileSize)
+			break;
+		memcpy(&entry, data + cursor, sizeof(entry));
+		cursor += sizeof(entry);
+		if(cursor + entry.pathLength > fileSize || entry.offset + entry.size > header.indexOffset)
+			break;
+
+		Asset asset;
+		asset.path = String((const char*)data + cursor, entry.pathLength);
+		asset.type = (AssetType)entry.type;
+		asset.lastWriteTime = entry.lastWriteTime;
+		asset.data = data + entry.offset;
+		asset.size = (size_t)entry.size;
+		cursor += entry.pathLength;
+		m_assets.Add(asset.path, asset);
+	}
+
+	if(m_assets.size() != header.assetCount)
+	{
+		Logf("Asset bundle %s is damaged", Logger::Warning, path);
+		Close();
+		return false;
+	}
+	return true;
+}
+void AssetBundle::Close()
+{
+	m_assets.clear();
+	m_file.Close();
+}
+bool AssetBundle::IsOpen() const
+{
+	return m_file.IsOpen();
+}
+
+const AssetBundle::Asset* AssetBundle::Find(const String& path) const
+{
+	auto it = m_assets.find(NormalizePath(path));
+	return it == m_assets.end() ? nullptr : &it->second;
+}
+Vector<const AssetBundle::Asset*> AssetBundle::List(const String& folder) const
+{
+	Vector<const Asset*> assets;
+	String prefix = NormalizePath(folder);
+	if(!prefix.empty())
+		prefix += "/";
+	// Paths are sorted, so all assets in the folder come after the prefix
+	for(auto it = m_assets.lower_bound(prefix); it != m_assets.end(); it++)
+	{
+		const String& path = it->first;
+		if(path.compare(0, prefix.size(), prefix) != 0)
+			break;
+		// Skip assets in sub folders
+		if(path.find('/', prefix.size()) != String::npos)
+			continue;
+		assets.Add(&it->second);
+	}
+	return assets;
+}
+size_t AssetBundle::GetAssetCount() const
+{
+	return m_assets.size();
+}
+
+String AssetBundle::NormalizePath(const String& path)
+{
+	String normalized = path;
+	for(char& c : normalized)
+	{
+		if(c == '\\')
+			c = '/';
+	}
+	while(!normalized.empty() && normalized.back() == '/')
+		normalized.pop_back();
+	return normalized;
+}
+
+bool AssetBundleWriter::Open(const String& path)
+{
+	m_index.clear();
+	if(!m_file.OpenWrite(path))
+		return false;
+
+	// Written again with the final values in Finish
+	BundleHeader header = {};
+	m_file.Write(&header, sizeof(header));
+	m_offset = sizeof(header);
+	return true;
+}
+bool AssetBundleWriter::Add(const String& path, AssetType type, uint64 lastWriteTime, const void* data, size_t size)
+{
+	// Align the start of each asset, so decoded data can be used directly
+	static const uint8 padding[dataAlignment] = { 0 };
+	uint64 paddingSize = (dataAlignment - m_offset % dataAlignment) % dataAlignment;
+	if(m_file.Write(padding, (size_t)paddingSize) != paddingSize)
+		return false;
+	m_offset += paddingSize;
+
+	if(size > 0 && m_file.Write(data, size) != size)
+		return false;
+
+	IndexEntry entry;
+	entry.path = AssetBundle::NormalizePath(path);
+	entry.type = type;
+	entry.lastWriteTime = lastWriteTime;
+	entry.offset = m_offset;
+	entry.size = size;
+	m_index.Add(entry);
+	m_offset += size;
+	return true;
+}
+bool AssetBundleWriter::Finish()
+{
+	uint64 indexOffset = m_offset;
+	for(const IndexEntry& entry : m_index)
+	{
+		BundleIndexEntry indexEntry = {};
+		indexEntry.offset = entry.offset;
+		indexEntry.size = entry.size;
+		indexEntry.type = (uint32)entry.type;
+		indexEntry.pathLength = (uint32)entry.path.size();
+		indexEntry.lastWriteTime = entry.lastWriteTime;
+		if(m_file.Write(&indexEntry, sizeof(indexEntry)) != sizeof(indexEntry))
+			return false;
+		if(m_file.Write(entry.path.data(), entry.path.size()) != entry.path.size())
+			return false;
+		m_offset += sizeof(indexEntry) + entry.path.size();
+	}
+
+	BundleHeader header;
+	memcpy(header.magic, bundleMagic, sizeof(bundleMagic));
+	header.version = AssetBundle::version;
+	header.assetCount = m_index.size();
+	header.indexOffset = indexOffset;
+	m_file.Seek(0);
+	if(m_file.Write(&header, sizeof(header)) != sizeof(header))
+		return false;
+	m_file.Close();
+	return true;
+}
+
+size_t AssetBundleWriter::GetAssetCount() const
+{
+	return m_index.size();
+}
+size_t AssetBundleWriter::GetSize() const
+{
+	return (size_t)m_offset;
+}
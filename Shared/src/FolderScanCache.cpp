@@ -0,0 +1,83 @@
+#include "stdafx.h"
+#include "FolderScanCache.hpp"
+#include "Path.hpp"
+#include "Log.hpp"
+#include "List.hpp"
+
+Vector<FileInfo> FolderScanCache::Scan(const Vector<String>& rootFolders, String extFilter, bool* interrupt,
+	std::function<void(const String&)> onFolder)
+{
+	Vector<FileInfo> ret;
+	Map<String, Folder> newFolders;
+	m_listed = 0;
+	m_cached = 0;
+
+	List<String> folderQueue;
+	for(const String& root : rootFolders)
+	{
+		if(!Path::IsDirectory(root))
+		{
+			Logf("Can't run ScanFiles, \"%s\" is not a folder", Logger::Warning, root);
+			continue;
+		}
+		folderQueue.AddBack(root);
+	}
+
+	while(!folderQueue.empty())
+	{
+		if(interrupt && *interrupt)
+			return ret;
+
+		String folderPath = folderQueue.front();
+		folderQueue.pop_front();
+		if(newFolders.Contains(folderPath))
+			continue;
+
+		if(onFolder)
+			onFolder(folderPath);
+
+		// Read the time before listing, so changes made while listing are picked up next time
+		uint64 lastWriteTime = Files::GetLastWriteTime(folderPath);
+		Folder* cached = folders.Find(folderPath);
+		if(cached && lastWriteTime != 0 && cached->lastWriteTime == lastWriteTime)
+		{
+			// Folder entries didn't change, but files can still be modified in place
+			for(const String& file : cached->files)
+			{
+				FileInfo info;
+				info.fullPath = file;
+				info.lastWriteTime = Files::GetLastWriteTime(file);
+				info.type = FileType::Regular;
+				if(info.lastWriteTime != 0)
+					ret.Add(info);
+			}
+			for(const String& subFolder : cached->subFolders)
+				folderQueue.AddBack(subFolder);
+			newFolders.Add(folderPath, std::move(*cached));
+			m_cached++;
+			continue;
+		}
+
+		Folder& folder = newFolders[folderPath];
+		folder.lastWriteTime = lastWriteTime;
+		Vector<FileInfo> files;
+		Files::ListFolder(folderPath, extFilter, files, folder.subFolders);
+		for(FileInfo& info : files)
+		{
+			folder.files.Add(info.fullPath);
+			ret.Add(info);
+		}
+		for(const String& subFolder : folder.subFolders)
+			folderQueue.AddBack(subFolder);
+		m_listed++;
+	}
+
+	folders = std::move(newFolders);
+	return ret;
+}
+void FolderScanCache::Invalidate(const String& folder)
+{
+	Folder* cached = folders.Find(folder);
+	if(cached)
+		cached->lastWriteTime = 0;
+}
@@ -6,6 +6,7 @@
 #include "Thread.hpp"
 #include <thread>
 #include "Timer.hpp"
+#include "Profiling.hpp"
 
 JobFlags operator|(JobFlags a, JobFlags b)
 {
@@ -105,6 +106,7 @@ public:
 
 	void Update()
 	{
+		ProfileScope("JobSheduler::Update");
 		m_lock.lock();
 		List<Job> finished = m_finishedJobs;
 		m_finishedJobs.clear();
@@ -134,6 +136,7 @@ private:
 	// Single job thread
 	void m_JobThread(JobThread* myThread)
 	{
+		ProfileThreadName(("Job Thread " + std::to_string(myThread->index)).c_str());
 		while(!myThread->terminate)
 		{
 			if(!m_jobQueue.empty())
@@ -151,7 +154,10 @@ private:
 						m_lock.unlock();
 
 						// Run
-						myThread->activeJob->m_ret = myThread->activeJob->Run();
+						{
+							ProfileScope("Job");
+							myThread->activeJob->m_ret = myThread->activeJob->Run();
+						}
 						myThread->activeJob->m_finished = true;
 
 						// Add to finished queue
@@ -0,0 +1,149 @@
+#include "stdafx.h"
+#include "DirectoryWatcher.hpp"
+#include "Map.hpp"
+#include "Path.hpp"
+#include "Log.hpp"
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+class DirectoryWatcher_Impl
+{
+public:
+	int fd = -1;
+	Map<int, String> pathsByWatch;
+	Map<String, int> watchesByPath;
+	bool reportedLimit = false;
+
+	DirectoryWatcher_Impl()
+	{
+		fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(fd < 0)
+			Logf("Failed to initialize inotify: %s", Logger::Warning, strerror(errno));
+	}
+	~DirectoryWatcher_Impl()
+	{
+		if(fd >= 0)
+			close(fd);
+	}
+};
+
+DirectoryWatcher::DirectoryWatcher()
+{
+	m_impl = new DirectoryWatcher_Impl();
+}
+DirectoryWatcher::~DirectoryWatcher()
+{
+	delete m_impl;
+}
+bool DirectoryWatcher::IsSupported()
+{
+	return true;
+}
+bool DirectoryWatcher::AddFolder(const String& folder)
+{
+	if(m_impl->fd < 0)
+		return false;
+	if(m_impl->watchesByPath.Contains(folder))
+		return true;
+
+	const uint32 mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+	int wd = inotify_add_watch(m_impl->fd, *folder, mask);
+	if(wd < 0)
+	{
+		if(!m_impl->reportedLimit)
+		{
+			Logf("Failed to watch folder \"%s\": %s (see /proc/sys/fs/inotify/max_user_watches)", Logger::Warning, folder, strerror(errno));
+			m_impl->reportedLimit = true;
+		}
+		return false;
+	}
+	m_impl->pathsByWatch[wd] = folder;
+	m_impl->watchesByPath[folder] = wd;
+	return true;
+}
+void DirectoryWatcher::RemoveFolder(const String& folder)
+{
+	String prefix = folder + Path::sep;
+	for(auto it = m_impl->watchesByPath.begin(); it != m_impl->watchesByPath.end();)
+	{
+		if(it->first == folder || it->first.compare(0, prefix.size(), prefix) == 0)
+		{
+			// The watch might already be gone if the folder was deleted
+			inotify_rm_watch(m_impl->fd, it->second);
+			m_impl->pathsByWatch.erase(it->second);
+			it = m_impl->watchesByPath.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+}
+Vector<DirectoryWatcher::Change> DirectoryWatcher::Poll()
+{
+	Vector<Change> changes;
+	if(m_impl->fd < 0)
+		return changes;
+
+	alignas(inotify_event) char buffer[16 * 1024];
+	while(true)
+	{
+		ssize_t len = read(m_impl->fd, buffer, sizeof(buffer));
+		if(len <= 0)
+			break;
+
+		for(char* ptr = buffer; ptr < buffer + len;)
+		{
+			const inotify_event* evt = (const inotify_event*)ptr;
+			ptr += sizeof(inotify_event) + evt->len;
+
+			if(evt->mask & IN_Q_OVERFLOW)
+			{
+				changes.Add({ Action::Overflow, String() });
+				continue;
+			}
+			if(evt->mask & IN_IGNORED)
+			{
+				// Watch removed by the system because the folder was deleted
+				String* path = m_impl->pathsByWatch.Find(evt->wd);
+				if(path)
+				{
+					m_impl->watchesByPath.erase(*path);
+					m_impl->pathsByWatch.erase(evt->wd);
+				}
+				continue;
+			}
+
+			String* folder = m_impl->pathsByWatch.Find(evt->wd);
+			if(!folder || evt->len == 0)
+				continue;
+
+			Change change;
+			change.path = Path::Normalize(*folder + Path::sep + evt->name);
+			if(evt->mask & IN_ISDIR)
+			{
+				if(evt->mask & (IN_CREATE | IN_MOVED_TO))
+					change.action = Action::FolderAdded;
+				else if(evt->mask & (IN_DELETE | IN_MOVED_FROM))
+					change.action = Action::FolderRemoved;
+				else
+					continue;
+			}
+			else
+			{
+				// Created files are reported when they are closed after writing
+				if(evt->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+					change.action = Action::Modified;
+				else if(evt->mask & (IN_DELETE | IN_MOVED_FROM))
+					change.action = Action::Removed;
+				else
+					continue;
+			}
+			changes.Add(change);
+		}
+	}
+	return changes;
+}
@@ -31,3 +31,11 @@ size_t Thread::SetCurrentThreadAffinityMask(size_t affinityMask)
 	pthread_setaffinity_np(h, sizeof(cpu_set_t), &cpuset);
 	return 0;
 }
+
+bool Thread::SetCurrentThreadRealtimePriority()
+{
+	// Needs permission to use real-time scheduling, usually through rtprio in limits.conf
+	sched_param param;
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
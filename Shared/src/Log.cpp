@@ -2,20 +2,98 @@
 #include "Log.hpp"
 #include "Path.hpp"
 #include "File.hpp"
-#include "FileStream.hpp"
-#include "TextStream.hpp"
+#include "Thread.hpp"
+#include "Math.hpp"
 #include <ctime>
 #include <map>
+#include <atomic>
+#include <chrono>
 
+enum class LogRecordKind : uint8
+{
+	Message,
+	Header,
+	Text,
+	Color,
+};
+
+/*
+	Single slot in the log queue
+	messages that don't fit in a single slot are split over multiple consecutive slots
+*/
+struct LogRecord
+{
+	static const size_t textSize = 232;
+
+	std::atomic<uint64> sequence;
+	time_t time;
+	LogRecordKind kind;
+	// Severity or color, depending on kind
+	uint8 value;
+	// Set if the text continues in the next slot
+	bool more;
+	uint16 length;
+	char text[textSize];
+};
+
+// Tracks the number of messages logged for a single format string in the current second
+struct LogRateEntry
+{
+	std::atomic<const char*> format;
+	std::atomic<uint32> window;
+	std::atomic<uint32> count;
+	std::atomic<uint32> suppressed;
+};
+
+/*
+	Bounded multi-producer single-consumer queue of log records (based on Dmitry Vyukov's bounded queue)
+	producers never block, if the queue is full the message is dropped
+	a single writer thread formats the messages and writes them to the console and log file
+*/
 class Logger_Impl
 {
+public:
+	static const uint64 queueSize = 4096;
+	// Maximum number of slots a single message can take
+	static const uint64 maxRecordSlots = 16;
+	static const size_t rateTableSize = 64;
+
 private:
 	File m_logFile;
-	FileWriter m_writer;
+	LogRecord m_records[queueSize];
+	std::atomic<uint64> m_enqueuePos;
+	uint64 m_dequeuePos = 0;
+	std::atomic<uint64> m_writtenPos;
+	std::atomic<uint64> m_dropped;
+	std::atomic<bool> m_exit;
+	Thread m_thread;
+
+	// Writer thread state
+	String m_pending;
+	String m_fileBuffer;
+	uint64 m_reportedDrops = 0;
 
 public:
 	Logger_Impl()
 	{
+		for(uint64 i = 0; i < queueSize; i++)
+			m_records[i].sequence.store(i, std::memory_order_relaxed);
+		m_enqueuePos = 0;
+		m_writtenPos = 0;
+		m_dropped = 0;
+		m_exit = false;
+		logLevel = 0;
+		rateLimit = 100;
+		consoleOutput = true;
+		for(size_t i = 0; i < rateTableSize; i++)
+		{
+			rateTable[i].format = nullptr;
+			rateTable[i].window = 0;
+			rateTable[i].count = 0;
+			rateTable[i].suppressed = 0;
+		}
+		epoch = std::chrono::steady_clock::now();
+
 		// Store the name of the executable
 		moduleName = Path::GetModuleName();
 
@@ -26,10 +104,128 @@ public:
 
 		// Log to file
 		m_logFile.OpenWrite(Utility::Sprintf("log_%s.txt", moduleName));
-		m_writer = FileWriter(m_logFile);
+
+		m_thread = Thread(&Logger_Impl::m_WriterThread, this);
+	}
+	~Logger_Impl()
+	{
+		// Writer thread drains the queue before exiting
+		m_exit.store(true, std::memory_order_release);
+		if(m_thread.joinable())
+			m_thread.join();
 	}
 
-	void WriteHeader(Logger::Severity severity)
+	// Adds a record to the queue, returns false if it was dropped
+	bool Push(LogRecordKind kind, uint8 value, const char* text = nullptr, size_t length = 0)
+	{
+		uint64 numSlots = Math::Clamp<uint64>((length + LogRecord::textSize - 1) / LogRecord::textSize, 1, maxRecordSlots);
+		length = Math::Min<size_t>(length, numSlots * LogRecord::textSize);
+
+		// Reserve consecutive slots, the consumer frees slots in order so if the last slot is free all of them are
+		uint64 pos = m_enqueuePos.load(std::memory_order_relaxed);
+		while(true)
+		{
+			uint64 last = pos + numSlots - 1;
+			LogRecord& lastRecord = m_records[last % queueSize];
+			int64 diff = (int64)lastRecord.sequence.load(std::memory_order_acquire) - (int64)last;
+			if(diff == 0)
+			{
+				if(m_enqueuePos.compare_exchange_weak(pos, pos + numSlots, std::memory_order_relaxed))
+					break;
+			}
+			else if(diff < 0)
+			{
+				// Full
+				m_dropped.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+			else
+			{
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		time_t now = time(0);
+		for(uint64 i = 0; i < numSlots; i++)
+		{
+			LogRecord& record = m_records[(pos + i) % queueSize];
+			size_t offset = (size_t)i * LogRecord::textSize;
+			size_t slotLength = Math::Min(length - offset, LogRecord::textSize);
+			record.time = now;
+			record.kind = kind;
+			record.value = value;
+			record.more = i + 1 < numSlots;
+			record.length = (uint16)slotLength;
+			if(slotLength > 0)
+				memcpy(record.text, text + offset, slotLength);
+			record.sequence.store(pos + i + 1, std::memory_order_release);
+		}
+		return true;
+	}
+
+	// Blocks until every record queued before this call is written
+	void Flush()
+	{
+		uint64 target = m_enqueuePos.load(std::memory_order_acquire);
+		while(m_writtenPos.load(std::memory_order_acquire) < target)
+		{
+			if(!m_thread.joinable())
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	uint64 GetDropped() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+	uint32 GetSeconds() const
+	{
+		return (uint32)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	// Only used from the writer thread
+	void SetColor(Logger::Color color)
+	{
+		if(!consoleOutput.load(std::memory_order_relaxed))
+			return;
+#ifdef _WIN32
+		if(consoleHandle)
+		{
+			static uint8 params[] =
+			{
+				FOREGROUND_INTENSITY | FOREGROUND_RED,
+				FOREGROUND_INTENSITY | FOREGROUND_GREEN,
+				FOREGROUND_INTENSITY | FOREGROUND_BLUE,
+				FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_GREEN, // Yellow,
+				FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_RED, // Cyan,
+				FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_RED, // Magenta,
+				FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY, // White
+				FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN, // Gray
+			};
+			// Console attributes apply immediately, so previously printed text needs to be flushed first
+			fflush(stdout);
+			SetConsoleTextAttribute(consoleHandle, params[(size_t)color]);
+		}
+#else
+		static std::map<Logger::Color, const char*> params = {
+			{Logger::Color::Red,     "200;0;0"},
+			{Logger::Color::Green,   "0;200;0"},
+			{Logger::Color::Blue,    "0;70;200"},
+			{Logger::Color::Yellow,  "200;180;0"},
+			{Logger::Color::Cyan,    "0;200;200"},
+			{Logger::Color::Magenta, "200;0;200"},
+			{Logger::Color::Gray,    "140;140;140"}
+		};
+		if(color == Logger::Color::White)
+			printf("\x1b[39m");
+		else
+			printf("\x1b[38;2;%sm", params[color]);
+#endif
+	}
+
+	void WriteHeader(Logger::Severity severity, time_t currentTime)
 	{
 		// Severity strings
 		const char* severityNames[] =
@@ -42,7 +238,6 @@ public:
 
 		// Format a timestamp string
 		char timeStr[64];
-		time_t currentTime = time(0);
 		tm* currentLocalTime = localtime(&currentTime);
 		strftime(timeStr, sizeof(timeStr), "%T", currentLocalTime);
 
@@ -51,30 +246,151 @@ public:
 	}
 	void Write(const String& msg)
 	{
+		if(consoleOutput.load(std::memory_order_relaxed))
+		{
 #ifdef _WIN32
-		OutputDebugStringA(*msg);
+			OutputDebugStringA(*msg);
 #endif
-		printf("%s", msg.c_str());
-		TextStream::Write(m_writer, msg);
+			printf("%s", msg.c_str());
+		}
+		m_fileBuffer += msg;
 	}
 
+	Logger::Color GetSeverityColor(Logger::Severity severity)
+	{
+		switch(severity)
+		{
+		case Logger::Info:
+			return Logger::Gray;
+		case Logger::Warning:
+			return Logger::Yellow;
+		case Logger::Error:
+			return Logger::Red;
+		default:
+			return Logger::White;
+		}
+	}
+
+	void WriteMessage(Logger::Severity severity, time_t currentTime, const String& msg)
+	{
+		SetColor(GetSeverityColor(severity));
+		WriteHeader(severity, currentTime);
+		Write(msg);
+		Write("\n");
+	}
+
+private:
+	// Writes all published records, returns the number of records processed
+	size_t m_Drain()
+	{
+		size_t processed = 0;
+		while(true)
+		{
+			LogRecord& record = m_records[m_dequeuePos % queueSize];
+			if(record.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+				break;
+
+			m_pending.append(record.text, record.length);
+			if(!record.more)
+			{
+				switch(record.kind)
+				{
+				case LogRecordKind::Message:
+					WriteMessage((Logger::Severity)record.value, record.time, m_pending);
+					break;
+				case LogRecordKind::Header:
+					WriteHeader((Logger::Severity)record.value, record.time);
+					break;
+				case LogRecordKind::Text:
+					Write(m_pending);
+					break;
+				case LogRecordKind::Color:
+					SetColor((Logger::Color)record.value);
+					break;
+				}
+				m_pending.clear();
+			}
+
+			// Free the slot for the next time around the ring
+			record.sequence.store(m_dequeuePos + queueSize, std::memory_order_release);
+			m_dequeuePos++;
+			processed++;
+		}
+
+		uint64 dropped = m_dropped.load(std::memory_order_relaxed);
+		if(dropped != m_reportedDrops && m_pending.empty())
+		{
+			WriteMessage(Logger::Warning, time(0), Utility::Sprintf("Log queue full, dropped %d messages", (int32)(dropped - m_reportedDrops)));
+			m_reportedDrops = dropped;
+		}
+
+		// Write everything in a single call
+		if(!m_fileBuffer.empty())
+		{
+			m_logFile.Write(m_fileBuffer.data(), m_fileBuffer.size());
+			m_fileBuffer.clear();
+		}
+		if(processed > 0)
+			fflush(stdout);
+
+		m_writtenPos.store(m_dequeuePos, std::memory_order_release);
+		return processed;
+	}
+	void m_WriterThread()
+	{
+		while(true)
+		{
+			bool exit = m_exit.load(std::memory_order_acquire);
+			if(m_Drain() == 0)
+			{
+				if(exit)
+					break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+		}
+	}
+
+public:
 #ifdef _WIN32
 	HANDLE consoleHandle;
 #endif
 	String moduleName;
+
+	std::atomic<int32> logLevel;
+	std::atomic<uint32> rateLimit;
+	std::atomic<bool> consoleOutput;
+	LogRateEntry rateTable[rateTableSize];
+	std::chrono::steady_clock::time_point epoch;
 };
 
+// Filtering priority for each severity, Info is the least important
+static int32 GetSeverityLevel(Logger::Severity severity)
+{
+	switch(severity)
+	{
+	case Logger::Info:
+		return 0;
+	case Logger::Normal:
+		return 1;
+	case Logger::Warning:
+		return 2;
+	case Logger::Error:
+		return 3;
+	}
+	return 0;
+}
+
 Logger::Logger()
 {
 	m_impl = new Logger_Impl;
 }
 Logger::~Logger()
 {
+	delete m_impl;
 #ifndef _WIN32
 	// Reset terminal colors
 	printf("\x1b[39m\x1b[0m");
 #endif
-	delete m_impl;
 }
 Logger& Logger::Get()
 {
@@ -83,67 +399,77 @@ Logger& Logger::Get()
 }
 void Logger::SetColor(Color color)
 {
-#ifdef _WIN32
-	if(m_impl->consoleHandle)
-	{
-		static uint8 params[] =
-		{
-			FOREGROUND_INTENSITY | FOREGROUND_RED,
-			FOREGROUND_INTENSITY | FOREGROUND_GREEN,
-			FOREGROUND_INTENSITY | FOREGROUND_BLUE,
-			FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_GREEN, // Yellow,
-			FOREGROUND_INTENSITY | FOREGROUND_BLUE | FOREGROUND_RED, // Cyan,
-			FOREGROUND_INTENSITY | FOREGROUND_GREEN | FOREGROUND_RED, // Magenta,
-			FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_INTENSITY, // White
-			FOREGROUND_BLUE | FOREGROUND_RED | FOREGROUND_GREEN, // Gray
-		};
-		SetConsoleTextAttribute(m_impl->consoleHandle, params[(size_t)color]);
-	}
-#else
-	static std::map<Color, const char*> params = {
-		{Color::Red,     "200;0;0"},
-		{Color::Green,   "0;200;0"},
-		{Color::Blue,    "0;70;200"},
-		{Color::Yellow,  "200;180;0"},
-		{Color::Cyan,    "0;200;200"},
-		{Color::Magenta, "200;0;200"},
-		{Color::Gray,    "140;140;140"}
-	};
-	if(color == Color::White)
-		printf("\x1b[39m");
-	else
-		printf("\x1b[38;2;%sm", params[color]);
-#endif
+	m_impl->Push(LogRecordKind::Color, (uint8)color);
 }
 void Logger::Log(const String& msg, Logger::Severity severity)
 {
-	switch(severity)
+	if(!IsEnabled(severity))
+		return;
+	m_impl->Push(LogRecordKind::Message, (uint8)severity, msg.data(), msg.size());
+}
+void Logger::WriteHeader(Severity severity)
+{
+	m_impl->Push(LogRecordKind::Header, (uint8)severity);
+}
+void Logger::Write(const String& msg)
+{
+	m_impl->Push(LogRecordKind::Text, 0, msg.data(), msg.size());
+}
+void Logger::Flush()
+{
+	m_impl->Flush();
+}
+void Logger::SetLogLevel(Logger::Severity level)
+{
+	m_impl->logLevel.store(GetSeverityLevel(level), std::memory_order_relaxed);
+}
+bool Logger::IsEnabled(Logger::Severity severity) const
+{
+	return GetSeverityLevel(severity) >= m_impl->logLevel.load(std::memory_order_relaxed);
+}
+void Logger::SetRateLimit(uint32 messagesPerSecond)
+{
+	m_impl->rateLimit.store(messagesPerSecond, std::memory_order_relaxed);
+}
+bool Logger::ShouldLog(Logger::Severity severity, const char* format)
+{
+	if(!IsEnabled(severity))
+		return false;
+	uint32 limit = m_impl->rateLimit.load(std::memory_order_relaxed);
+	if(limit == 0)
+		return true;
+
+	// Format strings are literals, so the pointer identifies the call site
+	LogRateEntry& entry = m_impl->rateTable[((size_t)format >> 3) % Logger_Impl::rateTableSize];
+	uint32 now = m_impl->GetSeconds();
+	const char* previousFormat = entry.format.exchange(format, std::memory_order_relaxed);
+	if(previousFormat != format)
+	{
+		// Collision or first use, this is approximate so just start counting again
+		entry.window.store(now, std::memory_order_relaxed);
+		entry.count.store(0, std::memory_order_relaxed);
+		entry.suppressed.store(0, std::memory_order_relaxed);
+	}
+	else if(entry.window.exchange(now, std::memory_order_relaxed) != now)
 	{
-	case Normal:
-		SetColor(White);
-		break;
-	case Info:
-		SetColor(Gray);
-		break;
-	case Warning:
-		SetColor(Yellow);
-		break;
-	case Error:
-		SetColor(Red);
-		break;
+		entry.count.store(0, std::memory_order_relaxed);
+		uint32 suppressed = entry.suppressed.exchange(0, std::memory_order_relaxed);
+		if(suppressed > 0)
+			Log(Utility::Sprintf("Suppressed %d similar messages (\"%s\")", suppressed, format), Logger::Warning);
 	}
 
-	m_impl->WriteHeader(severity);
-	m_impl->Write(msg);
-	m_impl->Write("\n");
+	if(entry.count.fetch_add(1, std::memory_order_relaxed) < limit)
+		return true;
+	entry.suppressed.fetch_add(1, std::memory_order_relaxed);
+	return false;
 }
-void Logger::WriteHeader(Severity severity)
+void Logger::SetConsoleOutput(bool enabled)
 {
-	m_impl->WriteHeader(severity);
+	m_impl->consoleOutput.store(enabled, std::memory_order_relaxed);
 }
-void Logger::Write(const String& msg)
+uint64 Logger::GetDroppedCount() const
 {
-	m_impl->Write(msg);
+	return m_impl->GetDropped();
 }
 void Log(const String& msg, Logger::Severity severity)
 {
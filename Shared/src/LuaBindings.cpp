@@ -0,0 +1,115 @@
+#include "stdafx.h"
+#include "LuaBindings.hpp"
+#include "Timer.hpp"
+#include "lua.hpp"
+
+void LuaRef::Set(lua_State* L, int index)
+{
+	lua_pushvalue(L, index);
+	Release();
+	m_L = L;
+	m_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+bool LuaRef::SetGlobal(lua_State* L, const char* name)
+{
+	lua_getglobal(L, name);
+	bool isNil = lua_isnil(L, -1);
+	if(isNil)
+	{
+		Release();
+		m_L = L;
+	}
+	else
+	{
+		Set(L, -1);
+	}
+	lua_pop(L, 1);
+	return !isNil;
+}
+void LuaRef::Release()
+{
+	if(m_L && m_ref != LUA_NOREF && m_ref != LUA_REFNIL)
+		luaL_unref(m_L, LUA_REGISTRYINDEX, m_ref);
+	m_ref = LUA_NOREF;
+}
+void LuaRef::Push() const
+{
+	if(IsValid())
+		lua_rawgeti(m_L, LUA_REGISTRYINDEX, m_ref);
+	else if(m_L)
+		lua_pushnil(m_L);
+}
+bool LuaRef::IsValid() const
+{
+	return m_L && m_ref != LUA_NOREF && m_ref != LUA_REFNIL;
+}
+
+void LuaGarbageCollector::Attach(lua_State* L, uint32 budgetMicroseconds)
+{
+	m_L = L;
+	m_budget = budgetMicroseconds;
+	// Start from a clean state, so the first frames don't have to deal with garbage from loading the scripts
+	lua_gc(m_L, LUA_GCCOLLECT, 0);
+	// Without a budget the automatic collector keeps running
+	if(m_budget > 0)
+		lua_gc(m_L, LUA_GCSTOP, 0);
+	m_lastCycleMemory = lua_gc(m_L, LUA_GCCOUNT, 0);
+	m_frame = LuaFrameStats();
+	m_lastFrame = LuaFrameStats();
+}
+void LuaGarbageCollector::Detach()
+{
+	if(m_L)
+		lua_gc(m_L, LUA_GCRESTART, 0);
+	m_L = nullptr;
+}
+
+void LuaGarbageCollector::Step()
+{
+	if(!m_L)
+		return;
+
+	Timer timer;
+	double usedBudget = m_frame.gcTime * 1000.0;
+	int memory = lua_gc(m_L, LUA_GCCOUNT, 0);
+	// Collect without a budget if garbage piles up faster than it is collected, to keep memory bounded
+	bool overBudget = memory > m_lastCycleMemory * 4 + 8 * 1024;
+	while(m_budget > 0 && (overBudget || usedBudget + timer.Microseconds() < m_budget))
+	{
+		if(lua_gc(m_L, LUA_GCSTEP, 0))
+		{
+			m_cycles++;
+			m_lastCycleMemory = lua_gc(m_L, LUA_GCCOUNT, 0);
+			break;
+		}
+	}
+
+	m_frame.gcTime += timer.SecondsAsDouble() * 1000.0;
+}
+void LuaGarbageCollector::EndFrame()
+{
+	if(!m_L)
+		return;
+
+	m_frame.memoryUsage = (size_t)lua_gc(m_L, LUA_GCCOUNT, 0) * 1024 + lua_gc(m_L, LUA_GCCOUNTB, 0);
+	m_frame.gcCycles = m_cycles;
+	m_lastFrame = m_frame;
+	m_frame = LuaFrameStats();
+}
+
+bool LuaGarbageCollector::Call(int nargs, int nresults)
+{
+	Timer timer;
+	bool success = lua_pcall(m_L, nargs, nresults, 0) == 0;
+	m_frame.scriptTime += timer.SecondsAsDouble() * 1000.0;
+	return success;
+}
+void LuaGarbageCollector::AddScriptTime(double milliseconds)
+{
+	m_frame.scriptTime += milliseconds;
+}
+
+const LuaFrameStats& LuaGarbageCollector::GetStats() const
+{
+	return m_lastFrame;
+}
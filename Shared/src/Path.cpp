@@ -59,8 +59,10 @@ String Path::RemoveBase(String path, String base)
 }
 String Path::GetExtension(const String& path)
 {
-	size_t dotPos = path.find(".");
-	if(dotPos == -1)
+	// Only look at the last path component, folder names can contain dots too
+	size_t dotPos = path.find_last_of(".");
+	size_t sepPos = path.find_last_of("\\/");
+	if(dotPos == -1 || (sepPos != -1 && dotPos < sepPos))
 		return String();
 	return path.substr(dotPos + 1);
 }
@@ -139,6 +141,19 @@ Vector<String> Path::SplitCommandLine(int argc, char** argv)
 	return res;
 }
 
+String Path::GetCacheFolder(const String& name)
+{
+	// Not normalized, that only works for paths that exist
+	return String("cache") + sep + name;
+}
+String Path::GetCacheFilePath(const String& folder, const String& key, const String& extension)
+{
+	String path = Utility::Sprintf("%s%c%016llx", folder, sep, Utility::Hash64(key.data(), key.size()));
+	if(!extension.empty())
+		path += "." + extension;
+	return path;
+}
+
 String Path::GetModuleName()
 {
 	String moduleName = Path::GetExecutablePath();
@@ -0,0 +1,277 @@
+#include "stdafx.h"
+#include "Profiling.hpp"
+#include "Vector.hpp"
+#include "File.hpp"
+#include "Thread.hpp"
+#include "Math.hpp"
+#include <atomic>
+#include <chrono>
+
+enum class ProfilerEventType : uint8
+{
+	Begin,
+	End,
+};
+
+struct ProfilerEvent
+{
+	const char* name;
+	// Nanoseconds since the profiler epoch
+	uint64 time;
+	ProfilerEventType type;
+};
+
+/*
+	Event storage for a single thread
+	only the owning thread writes to this, the head is published with release semantics so the exporting thread can read it
+*/
+struct ProfilerThreadBuffer
+{
+	uint32 threadId;
+	String name;
+	ProfilerEvent events[Profiler::bufferSize];
+	// Total number of events written
+	std::atomic<uint64> head;
+	// Total number of events started, one ahead of head while an event is being written
+	std::atomic<uint64> reserved;
+	// Head when the current capture started
+	uint64 captureHead = 0;
+};
+
+// Buffer of the calling thread, created on the first event or set by AttachThread
+static thread_local ProfilerThreadBuffer* threadBuffer = nullptr;
+
+class Profiler_Impl
+{
+public:
+	Mutex lock;
+	Vector<ProfilerThreadBuffer*> buffers;
+	std::atomic<bool> capturing;
+	uint64 captureStart = 0;
+	uint64 droppedEvents = 0;
+	std::chrono::steady_clock::time_point epoch;
+
+	Profiler_Impl()
+	{
+		capturing = false;
+		epoch = std::chrono::steady_clock::now();
+	}
+	~Profiler_Impl()
+	{
+		for(ProfilerThreadBuffer* b : buffers)
+			delete b;
+	}
+
+	uint64 Now() const
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+	}
+
+	ProfilerThreadBuffer* CreateThreadBuffer(const String& name)
+	{
+		ProfilerThreadBuffer* buffer = new ProfilerThreadBuffer();
+		buffer->head = 0;
+		buffer->reserved = 0;
+		lock.lock();
+		buffer->threadId = (uint32)buffers.size();
+		buffer->name = name.empty() ? String("Thread " + std::to_string(buffer->threadId)) : name;
+		buffers.Add(buffer);
+		lock.unlock();
+		return buffer;
+	}
+	ProfilerThreadBuffer* GetThreadBuffer()
+	{
+		if(!threadBuffer)
+			threadBuffer = CreateThreadBuffer(String());
+		return threadBuffer;
+	}
+
+	void Write(const char* name, ProfilerEventType type)
+	{
+		ProfilerThreadBuffer* buffer = GetThreadBuffer();
+		uint64 head = buffer->head.load(std::memory_order_relaxed);
+		// Marks the slot as in use before writing it, so a reader copying the old event in it knows it was overwritten
+		buffer->reserved.store(head + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		ProfilerEvent& evt = buffer->events[head % Profiler::bufferSize];
+		evt.name = name;
+		evt.time = Now();
+		evt.type = type;
+		buffer->head.store(head + 1, std::memory_order_release);
+	}
+
+	// Copies all events recorded between start and end from a thread buffer
+	//	returns the number of events of the capture that were overwritten before they could be copied
+	uint64 CollectEvents(ProfilerThreadBuffer* buffer, uint64 start, uint64 end, Vector<ProfilerEvent>& out)
+	{
+		// Only events below the published head are complete
+		uint64 head = buffer->head.load(std::memory_order_acquire);
+		uint64 first = Math::Max(buffer->captureHead, head > Profiler::bufferSize ? head - Profiler::bufferSize : 0);
+		Vector<ProfilerEvent> copied;
+		copied.reserve((size_t)(head - first));
+		for(uint64 i = first; i < head; i++)
+			copied.Add(buffer->events[i % Profiler::bufferSize]);
+
+		// Slots that were reused while copying hold newer events than the ones that were expected in them
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64 reserved = buffer->reserved.load(std::memory_order_relaxed);
+		uint64 valid = Math::Min(head, Math::Max(first, reserved > Profiler::bufferSize ? reserved - Profiler::bufferSize : 0));
+		for(uint64 i = valid; i < head; i++)
+		{
+			const ProfilerEvent& evt = copied[(size_t)(i - first)];
+			if(evt.time >= start && evt.time <= end)
+				out.Add(evt);
+		}
+		return valid - buffer->captureHead;
+	}
+
+	static void EscapeJSON(const String& in, String& out)
+	{
+		for(char c : in)
+		{
+			if(c == '"' || c == '\\')
+				out.push_back('\\');
+			if((uint8)c < 0x20)
+				continue;
+			out.push_back(c);
+		}
+	}
+};
+
+static Profiler_Impl& GetProfiler()
+{
+	static Profiler_Impl impl;
+	return impl;
+}
+
+void Profiler::BeginCapture()
+{
+	Profiler_Impl& impl = GetProfiler();
+	if(impl.capturing)
+		return;
+#ifndef PROFILER_ENABLED
+	Logf("Profiler capture started, but instrumentation was not compiled in (EMBED_PROFILER)", Logger::Warning);
+#endif
+	impl.lock.lock();
+	for(ProfilerThreadBuffer* buffer : impl.buffers)
+		buffer->captureHead = buffer->head.load(std::memory_order_acquire);
+	impl.lock.unlock();
+	impl.captureStart = impl.Now();
+	impl.capturing.store(true, std::memory_order_release);
+	Logf("Profiler capture started", Logger::Info);
+}
+bool Profiler::EndCapture(const String& path)
+{
+	Profiler_Impl& impl = GetProfiler();
+	if(!impl.capturing)
+		return false;
+	impl.capturing.store(false, std::memory_order_release);
+	uint64 captureEnd = impl.Now();
+
+	String json = "{\"traceEvents\":[\n";
+	bool first = true;
+	auto AddEvent = [&](const String& evt)
+	{
+		if(!first)
+			json += ",\n";
+		json += evt;
+		first = false;
+	};
+
+	impl.lock.lock();
+	Vector<ProfilerThreadBuffer*> buffers = impl.buffers;
+	impl.lock.unlock();
+
+	size_t numEvents = 0;
+	impl.droppedEvents = 0;
+	Vector<ProfilerEvent> events;
+	Vector<const char*> stack;
+	for(ProfilerThreadBuffer* buffer : buffers)
+	{
+		events.clear();
+		impl.droppedEvents += impl.CollectEvents(buffer, impl.captureStart, captureEnd, events);
+		if(events.empty())
+			continue;
+
+		String threadName;
+		Profiler_Impl::EscapeJSON(buffer->name, threadName);
+		AddEvent(Utility::Sprintf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", buffer->threadId, threadName));
+
+		// Only write balanced events, scopes that were already open when the capture started are skipped
+		//	and scopes still open at the end are closed at the end of the capture
+		stack.clear();
+		for(const ProfilerEvent& evt : events)
+		{
+			double ts = (double)(evt.time - impl.captureStart) / 1000.0;
+			if(evt.type == ProfilerEventType::Begin)
+			{
+				stack.Add(evt.name);
+				AddEvent(Utility::Sprintf("{\"name\":\"%s\",\"ph\":\"B\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", evt.name, buffer->threadId, ts));
+			}
+			else if(!stack.empty())
+			{
+				stack.pop_back();
+				AddEvent(Utility::Sprintf("{\"ph\":\"E\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", buffer->threadId, ts));
+			}
+		}
+		double endTs = (double)(captureEnd - impl.captureStart) / 1000.0;
+		for(size_t i = 0; i < stack.size(); i++)
+		{
+			AddEvent(Utility::Sprintf("{\"ph\":\"E\",\"pid\":0,\"tid\":%d,\"ts\":%.3f}", buffer->threadId, endTs));
+		}
+		numEvents += events.size();
+	}
+	json += "\n]}\n";
+
+	File file;
+	if(!file.OpenWrite(path))
+	{
+		Logf("Failed to write profiler capture to \"%s\"", Logger::Error, path);
+		return false;
+	}
+	file.Write(json.data(), json.size());
+	Logf("Profiler capture of %.2f ms (%d events, %d dropped) written to \"%s\"", Logger::Info, (double)(captureEnd - impl.captureStart) / 1000000.0,
+		(int32)numEvents, (int32)impl.droppedEvents, path);
+	return true;
+}
+bool Profiler::IsCapturing()
+{
+	return GetProfiler().capturing.load(std::memory_order_relaxed);
+}
+uint64 Profiler::GetDroppedEvents()
+{
+	return GetProfiler().droppedEvents;
+}
+ProfilerThread Profiler::ReserveThread(const char* name)
+{
+	return GetProfiler().CreateThreadBuffer(name);
+}
+void Profiler::AttachThread(ProfilerThread thread)
+{
+	threadBuffer = thread;
+}
+void Profiler::SetThreadName(const char* name)
+{
+	Profiler_Impl& impl = GetProfiler();
+	ProfilerThreadBuffer* buffer = impl.GetThreadBuffer();
+	// Only the owning thread changes the name, so this check doesn't need the lock
+	if(buffer->name == name)
+		return;
+	impl.lock.lock();
+	buffer->name = name;
+	impl.lock.unlock();
+}
+void Profiler::BeginEvent(const char* name)
+{
+	Profiler_Impl& impl = GetProfiler();
+	if(!impl.capturing.load(std::memory_order_relaxed))
+		return;
+	impl.Write(name, ProfilerEventType::Begin);
+}
+void Profiler::EndEvent(const char* name)
+{
+	Profiler_Impl& impl = GetProfiler();
+	if(!impl.capturing.load(std::memory_order_relaxed))
+		return;
+	impl.Write(name, ProfilerEventType::End);
+}
@@ -30,10 +30,8 @@ bool TextStream::ReadLine(BinaryStream& stream, String& out, const String& lineE
 }
 void TextStream::Write(BinaryStream& stream, const String& out)
 {
-	for(char c : out)
-	{
-		stream << c;
-	}
+	if(!out.empty())
+		stream.Serialize((void*)out.data(), out.size());
 }
 void TextStream::WriteLine(BinaryStream& stream, const String& out, const String& lineEnding /*= "\r\n"*/)
 {
@@ -59,6 +59,8 @@ bool File::OpenWrite(const String& path, bool append /*= false*/)
 	int flags = O_WRONLY | O_CREAT;
 	if(append)
 		flags |= O_APPEND;
+	else
+		flags |= O_TRUNC; // Same as CREATE_ALWAYS on windows
 	int handle = open(*path, flags, S_IRUSR | S_IWUSR | S_IROTH);
 	if(handle == -1)
 	{
@@ -6,8 +6,23 @@
 #include "File.hpp"
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <dirent.h>
 
+static bool _IsDirectory(dirent* ent, const String& fullPath)
+{
+	if(ent->d_type == DT_DIR)
+		return true;
+	if(ent->d_type != DT_UNKNOWN)
+		return false;
+
+	// Some filesystems don't fill in the type
+	struct stat sb;
+	if(lstat(*fullPath, &sb) != 0)
+		return false;
+	return S_ISDIR(sb.st_mode);
+}
+
 static Vector<FileInfo> _ScanFiles(String rootFolder, String extFilter, bool recurse, bool* interrupt)
 {
 	Vector<FileInfo> ret;
@@ -52,10 +67,12 @@ static Vector<FileInfo> _ScanFiles(String rootFolder, String extFilter, bool rec
 
 				FileInfo info;
                 info.fullPath = Path::Normalize(searchPath + Path::sep + filename);
-				info.lastWriteTime = File::GetLastWriteTime(info.fullPath); // linux doesn't provide this timestamp in the directory entry
+				info.lastWriteTime = 0;
 				info.type = FileType::Regular;
 
-				if(ent->d_type == DT_DIR)
+				// linux doesn't provide the timestamp in the directory entry,
+				//	so only stat entries that are actually returned
+				if(_IsDirectory(ent, info.fullPath))
 				{
 					if(recurse)
 					{
@@ -65,6 +82,7 @@ static Vector<FileInfo> _ScanFiles(String rootFolder, String extFilter, bool rec
 					else if(!filterByExtension)
 					{
                         info.type = FileType::Folder;
+						info.lastWriteTime = File::GetLastWriteTime(info.fullPath);
                         ret.Add(info);
 					}
 				}
@@ -73,14 +91,16 @@ static Vector<FileInfo> _ScanFiles(String rootFolder, String extFilter, bool rec
 					// Check file
 					if(filterByExtension)
 					{
-						String ext = Path::GetExtension(info.fullPath);
+						String ext = Path::GetExtension(filename);
 						if(ext == extFilter)
 						{
+							info.lastWriteTime = File::GetLastWriteTime(info.fullPath);
 							ret.Add(info);
 						}
 					}
 					else
 					{
+						info.lastWriteTime = File::GetLastWriteTime(info.fullPath);
 						ret.Add(info);
 					}
 				}
@@ -101,3 +121,41 @@ Vector<FileInfo> Files::ScanFilesRecursive(const String& folder, String extFilte
 {
 	return _ScanFiles(folder, extFilter, true, interrupt);
 }
+bool Files::ListFolder(const String& folder, String extFilter, Vector<FileInfo>& outFiles, Vector<String>& outFolders)
+{
+	DIR* dir = opendir(*folder);
+	if(dir == nullptr)
+		return false;
+
+	bool filterByExtension = !extFilter.empty();
+	extFilter.TrimFront('.');
+
+	dirent* ent;
+	while((ent = readdir(dir)))
+	{
+		String filename = ent->d_name;
+		if(filename == "." || filename == "..")
+			continue;
+
+		String fullPath = Path::Normalize(folder + Path::sep + filename);
+		if(_IsDirectory(ent, fullPath))
+		{
+			outFolders.Add(fullPath);
+		}
+		else if(!filterByExtension || Path::GetExtension(filename) == extFilter)
+		{
+			FileInfo info;
+			info.fullPath = fullPath;
+			info.lastWriteTime = File::GetLastWriteTime(fullPath);
+			info.type = FileType::Regular;
+			outFiles.Add(info);
+		}
+	}
+
+	closedir(dir);
+	return true;
+}
+uint64 Files::GetLastWriteTime(const String& path)
+{
+	return File::GetLastWriteTime(path);
+}
@@ -0,0 +1,90 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+#include "Log.hpp"
+
+/*
+	Unix implementation
+*/
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+class MappedFile_Impl
+{
+public:
+	MappedFile_Impl(void* data, size_t size) : data(data), size(size) {};
+	~MappedFile_Impl()
+	{
+		if(size > 0)
+			munmap(data, size);
+	}
+	void* data;
+	size_t size;
+};
+
+MappedFile::MappedFile()
+{
+}
+MappedFile::~MappedFile()
+{
+	Close();
+}
+bool MappedFile::Open(const String& path)
+{
+	Close();
+
+	int handle = open(*path, O_RDONLY);
+	if(handle == -1)
+	{
+		Logf("Failed to open file for mapping %s: %d", Logger::Warning, *path, errno);
+		return false;
+	}
+
+	struct stat fileStat;
+	if(fstat(handle, &fileStat) != 0)
+	{
+		close(handle);
+		return false;
+	}
+
+	size_t size = (size_t)fileStat.st_size;
+	void* data = nullptr;
+	if(size > 0)
+	{
+		data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, handle, 0);
+		if(data == MAP_FAILED)
+		{
+			Logf("Failed to map file %s: %d", Logger::Warning, *path, errno);
+			close(handle);
+			return false;
+		}
+	}
+	// The mapping stays valid after the file is closed
+	close(handle);
+
+	m_impl = new MappedFile_Impl(data, size);
+	return true;
+}
+void MappedFile::Close()
+{
+	if(m_impl)
+	{
+		delete m_impl;
+		m_impl = nullptr;
+	}
+}
+bool MappedFile::IsOpen() const
+{
+	return m_impl != nullptr;
+}
+const uint8* MappedFile::GetData() const
+{
+	return m_impl ? (const uint8*)m_impl->data : nullptr;
+}
+size_t MappedFile::GetSize() const
+{
+	return m_impl ? m_impl->size : 0;
+}
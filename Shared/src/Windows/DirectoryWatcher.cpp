@@ -0,0 +1,27 @@
+#include "stdafx.h"
+#include "DirectoryWatcher.hpp"
+
+// Not implemented on this platform, the map database falls back to full rescans
+
+DirectoryWatcher::DirectoryWatcher()
+{
+	m_impl = nullptr;
+}
+DirectoryWatcher::~DirectoryWatcher()
+{
+}
+bool DirectoryWatcher::IsSupported()
+{
+	return false;
+}
+bool DirectoryWatcher::AddFolder(const String& folder)
+{
+	return false;
+}
+void DirectoryWatcher::RemoveFolder(const String& folder)
+{
+}
+Vector<DirectoryWatcher::Change> DirectoryWatcher::Poll()
+{
+	return Vector<DirectoryWatcher::Change>();
+}
@@ -92,3 +92,47 @@ Vector<FileInfo> Files::ScanFilesRecursive(const String& folder, String extFilte
 {
 	return _ScanFiles(folder, extFilter, true, interrupt);
 }
+bool Files::ListFolder(const String& folder, String extFilter, Vector<FileInfo>& outFiles, Vector<String>& outFolders)
+{
+	WString searchPathW = Utility::ConvertToWString(folder + "\\*");
+	WIN32_FIND_DATA findDataW;
+	HANDLE searchHandle = FindFirstFile(*searchPathW, &findDataW);
+	if(searchHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	bool filterByExtension = !extFilter.empty();
+	extFilter.TrimFront('.');
+
+	do
+	{
+		String filename = Utility::ConvertToUTF8(findDataW.cFileName);
+		if(filename == "." || filename == "..")
+			continue;
+
+		String fullPath = Path::Normalize(folder + Path::sep + filename);
+		if(findDataW.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			outFolders.Add(fullPath);
+		}
+		else if(!filterByExtension || Path::GetExtension(filename) == extFilter)
+		{
+			FileInfo info;
+			info.fullPath = fullPath;
+			info.lastWriteTime = ((uint64)findDataW.ftLastWriteTime.dwHighDateTime << 32) | (uint64)findDataW.ftLastWriteTime.dwLowDateTime;
+			info.type = FileType::Regular;
+			outFiles.Add(info);
+		}
+	} while(FindNextFile(searchHandle, &findDataW));
+
+	FindClose(searchHandle);
+	return true;
+}
+uint64 Files::GetLastWriteTime(const String& path)
+{
+	// Unlike File::GetLastWriteTime this works on folders and doesn't create missing files
+	WString pathW = Utility::ConvertToWString(path);
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if(!GetFileAttributesExW(*pathW, GetFileExInfoStandard, &data))
+		return 0;
+	return ((uint64)data.ftLastWriteTime.dwHighDateTime << 32) | (uint64)data.ftLastWriteTime.dwLowDateTime;
+}
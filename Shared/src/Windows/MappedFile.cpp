@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include "MappedFile.hpp"
+#include "Log.hpp"
+
+/*
+	Windows implementation
+*/
+class MappedFile_Impl
+{
+public:
+	MappedFile_Impl(HANDLE file, HANDLE mapping, void* data, size_t size) : file(file), mapping(mapping), data(data), size(size) {};
+	~MappedFile_Impl()
+	{
+		if(data)
+			UnmapViewOfFile(data);
+		if(mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+	}
+	HANDLE file;
+	HANDLE mapping;
+	void* data;
+	size_t size;
+};
+
+MappedFile::MappedFile()
+{
+}
+MappedFile::~MappedFile()
+{
+	Close();
+}
+bool MappedFile::Open(const String& path)
+{
+	Close();
+	WString wstringPath = Utility::ConvertToWString(path);
+	HANDLE file = CreateFileW(*wstringPath,
+		GENERIC_READ, // Desired Access
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_FLAG_RANDOM_ACCESS, 0);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		Logf("Failed to open file for mapping %s: %s", Logger::Warning, *path, Utility::WindowsFormatMessage(GetLastError()));
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	// Empty files can't be mapped
+	HANDLE mapping = nullptr;
+	void* data = nullptr;
+	if(fileSize.QuadPart > 0)
+	{
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mapping)
+			data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if(!data)
+		{
+			Logf("Failed to map file %s: %s", Logger::Warning, *path, Utility::WindowsFormatMessage(GetLastError()));
+			if(mapping)
+				CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+	}
+
+	m_impl = new MappedFile_Impl(file, mapping, data, (size_t)fileSize.QuadPart);
+	return true;
+}
+void MappedFile::Close()
+{
+	if(m_impl)
+	{
+		delete m_impl;
+		m_impl = nullptr;
+	}
+}
+bool MappedFile::IsOpen() const
+{
+	return m_impl != nullptr;
+}
+const uint8* MappedFile::GetData() const
+{
+	return m_impl ? (const uint8*)m_impl->data : nullptr;
+}
+size_t MappedFile::GetSize() const
+{
+	return m_impl ? m_impl->size : 0;
+}
@@ -15,4 +15,9 @@ size_t Thread::SetCurrentThreadAffinityMask(size_t affinityMask)
 	HANDLE h = (HANDLE)GetCurrentThread();
 	size_t res = (uint32)SetThreadAffinityMask(h, affinityMask);
 	return res;
-}
\ No newline at end of file
+}
+
+bool Thread::SetCurrentThreadRealtimePriority()
+{
+	return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+}
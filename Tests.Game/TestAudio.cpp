@@ -1,10 +1,19 @@
 #include "stdafx.h"
 #include <Audio/Audio.hpp>
 #include <Audio/DSP.hpp>
+#include <Audio/Audio_Impl.hpp>
+#include <Audio/AudioClock.hpp>
+#include <Audio/TimeStretcher.hpp>
+#include <Audio/LoudnessMeter.hpp>
+#include <Audio/AudioSummary.hpp>
+#include <Shared/Files.hpp>
+#include <Shared/File.hpp>
 #include <float.h>
 #include "TestMusicPlayer.hpp"
 
 #include <thread>
+#include <atomic>
+#include <random>
 using namespace std;
 
 static String testSamplePath = Path::Normalize("audio/laser_slam1.wav");
@@ -310,3 +319,1130 @@ Test("Audio.Music.Flanger")
 	mp.Init(testSongPath, testSongOffset);
 	mp.Run();
 }
+
+// Sweeps a peaking filter laser over a sine the way AudioPlayback does, without an audio device
+//	parameters are set once per frame while the audio is processed in blocks that don't line up with the frames
+Test("Audio.LaserSweep.Continuity")
+{
+	const float sampleRate = 44100.0f;
+	const uint32 blockSize = 512;
+	const uint32 samplesPerFrame = 735;
+	const uint32 numSamples = (uint32)sampleRate * 4;
+	const float toneFreq = 220.0f;
+
+	auto SetLaser = [&](BQFDSP& filter, float input)
+	{
+		float mix = 1.0f;
+		if(input < 0.1f)
+			mix *= input / 0.1f;
+		if(input > 0.8f)
+			mix *= 1.0f - (input - 0.8f) / 0.2f;
+		float freq = 80.0f + (8000.0f - 80.0f) * input * input;
+		float q = 1.0f - 0.2f * input;
+		filter.SetPeaking(q, freq, 20.0f * mix, sampleRate);
+	};
+
+	Vector<float> samples;
+	samples.resize(numSamples * 2);
+	for(uint32 i = 0; i < numSamples; i++)
+	{
+		float s = 0.25f * sinf(Math::pi * 2.0f * toneFreq * (float)i / sampleRate);
+		samples[i * 2] = s;
+		samples[i * 2 + 1] = s;
+	}
+
+	BQFDSP filter;
+	SetLaser(filter, 0.0f);
+	// Largest second difference of the output, a sudden change in the filter shows up as a kink in the waveform
+	float maxKink = 0.0f;
+	float prev[2][2] = { { 0.0f } };
+	for(uint32 offset = 0; offset < numSamples; offset += blockSize)
+	{
+		// Laser goes back and forth once every second, moving every frame
+		uint32 frame = offset / samplesPerFrame;
+		float t = fmodf((float)(frame * samplesPerFrame) / sampleRate, 1.0f);
+		SetLaser(filter, 1.0f - fabsf(t * 2.0f - 1.0f));
+
+		uint32 count = Math::Min(blockSize, numSamples - offset);
+		float* block = samples.data() + offset * 2;
+		filter.Process(block, count);
+		for(uint32 i = 0; i < count * 2; i++)
+		{
+			TestEnsure(std::isfinite(block[i]));
+			float* p = prev[i % 2];
+			// Skip the start while the filter settles
+			if(offset + i / 2 > blockSize)
+				maxKink = Math::Max(maxKink, fabsf(block[i] - 2.0f * p[0] + p[1]));
+			p[1] = p[0];
+			p[0] = block[i];
+		}
+	}
+
+	// A 220Hz tone boosted by at most 20dB has a second difference of at most 10 * 0.25 * (2pi * 220 / 44100)^2 = ~0.0025
+	Logf("Largest second difference: %f", Logger::Info, maxKink);
+	TestEnsure(maxKink < 0.004f);
+
+	// Set parameters from another thread while processing, the output has to stay finite and bounded
+	std::atomic<bool> done;
+	done = false;
+	std::thread writer([&]()
+	{
+		float input = 0.0f;
+		while(!done)
+		{
+			SetLaser(filter, input);
+			input = fmodf(input + 0.013f, 1.0f);
+		}
+	});
+	float maxLevel = 0.0f;
+	for(uint32 offset = 0; offset + blockSize <= numSamples; offset += blockSize)
+	{
+		float* block = samples.data() + offset * 2;
+		for(uint32 i = 0; i < blockSize * 2; i++)
+			block[i] = 0.25f * sinf(Math::pi * 2.0f * toneFreq * (float)(offset + i / 2) / sampleRate);
+		filter.Process(block, blockSize);
+		for(uint32 i = 0; i < blockSize * 2; i++)
+			maxLevel = Math::Max(maxLevel, fabsf(block[i]));
+	}
+	done = true;
+	writer.join();
+	Logf("Largest sample with concurrent updates: %f", Logger::Info, maxLevel);
+	TestEnsure(std::isfinite(maxLevel) && maxLevel < 4.0f);
+}
+
+// Counts allocations for Audio.EffectGraph.NoAllocations, to check that processing effects doesn't allocate
+//	replacing the global operator new applies to every test in Tests.Game, so it only counts anything
+//	while that test sets allocationTracking, and then only on threads that set trackAllocations
+static std::atomic<bool> allocationTracking(false);
+static thread_local bool trackAllocations = false;
+static std::atomic<uint32> numTrackedAllocations(0);
+void* operator new(size_t size)
+{
+	if(allocationTracking.load(std::memory_order_relaxed) && trackAllocations)
+		numTrackedAllocations++;
+	void* ptr = malloc(size);
+	if(!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
+
+// Looping tone that DSPs can be added to without an audio device
+class TestToneSource : public AudioBase
+{
+public:
+	TestToneSource(Audio_Impl* impl, uint32 numSamples)
+	{
+		audio = impl;
+		m_pcm.resize(numSamples * 2);
+		for(uint32 i = 0; i < numSamples; i++)
+		{
+			float s = 0.25f * sinf(Math::pi * 2.0f * 220.0f * (float)i / (float)GetSampleRate());
+			m_pcm[i * 2] = s;
+			m_pcm[i * 2 + 1] = s;
+		}
+	}
+	~TestToneSource()
+	{
+		audio = nullptr;
+	}
+	virtual void Process(float* out, uint32 numSamples) override
+	{
+		uint32 length = (uint32)m_pcm.size() / 2;
+		for(uint32 i = 0; i < numSamples; i++)
+		{
+			uint32 src = (m_position + i) % length;
+			out[i * 2] = m_pcm[src * 2];
+			out[i * 2 + 1] = m_pcm[src * 2 + 1];
+		}
+		m_position += numSamples;
+	}
+	virtual int32 GetPosition() const override
+	{
+		return (int32)((uint64)m_position * 1000 / GetSampleRate());
+	}
+	virtual uint32 GetSampleRate() const override
+	{
+		return audio->GetSampleRate();
+	}
+	virtual float* GetPCM() override
+	{
+		return m_pcm.data();
+	}
+
+private:
+	Vector<float> m_pcm;
+	uint32 m_position = 0;
+};
+
+// Builds one of every effect up front and turns them on and off while processing, like gameplay does
+//	the processing side must not allocate
+Test("Audio.EffectGraph.NoAllocations")
+{
+	// No output device, the fallback sample rate is used
+	Audio_Impl testAudio;
+	TestToneSource source(&testAudio, testAudio.GetSampleRate() * 10);
+	const uint32 blockSize = testAudio.m_sampleBufferLength;
+	const uint32 maxLength = 2000;
+
+	Vector<DSP*> dsps;
+	auto AddEffect = [&](DSP* dsp)
+	{
+		dsp->Bypass();
+		source.AddDSP(dsp);
+		dsps.Add(dsp);
+		return dsp;
+	};
+	BQFDSP* filter = (BQFDSP*)AddEffect(new BQFDSP());
+	BitCrusherDSP* bitCrusher = (BitCrusherDSP*)AddEffect(new BitCrusherDSP());
+	EchoDSP* echo = (EchoDSP*)AddEffect(new EchoDSP());
+	echo->SetMaxLength(maxLength);
+	GateDSP* gate = (GateDSP*)AddEffect(new GateDSP());
+	TapeStopDSP* tapeStop = (TapeStopDSP*)AddEffect(new TapeStopDSP());
+	tapeStop->SetMaxLength(maxLength);
+	RetriggerDSP* retrigger = (RetriggerDSP*)AddEffect(new RetriggerDSP());
+	retrigger->SetMaxLength(maxLength);
+	WobbleDSP* wobble = (WobbleDSP*)AddEffect(new WobbleDSP());
+	PhaserDSP* phaser = (PhaserDSP*)AddEffect(new PhaserDSP());
+	FlangerDSP* flanger = (FlangerDSP*)AddEffect(new FlangerDSP());
+	flanger->SetDelayRange(0, 120);
+	SidechainDSP* sidechain = (SidechainDSP*)AddEffect(new SidechainDSP());
+	PitchShiftDSP* pitchShift = (PitchShiftDSP*)AddEffect(new PitchShiftDSP());
+
+	// Parameters that are only set while a DSP is idle
+	auto Configure = [&](DSP* dsp, uint32 length)
+	{
+		if(dsp == echo)
+			echo->SetLength(length);
+		else if(dsp == gate)
+			gate->SetLength(length);
+		else if(dsp == tapeStop)
+			tapeStop->SetLength(length);
+		else if(dsp == retrigger)
+			retrigger->SetLength(length);
+		else if(dsp == wobble)
+			wobble->SetLength(length);
+		else if(dsp == phaser)
+			phaser->SetLength(length);
+		else if(dsp == flanger)
+		{
+			flanger->SetLength(length);
+			flanger->SetDelayRange(10, 40 + length % 80);
+		}
+		else if(dsp == sidechain)
+			sidechain->SetLength(length);
+	};
+
+	Vector<uint32> timesEnabled;
+	timesEnabled.resize(dsps.size());
+	Vector<float> buffer;
+	buffer.resize(blockSize * 2);
+	numTrackedAllocations = 0;
+	allocationTracking = true;
+	for(uint32 frame = 0; frame < 3000; frame++)
+	{
+		// Game thread, start or stop an effect every few frames and automate the laser parameters every frame
+		if(frame % 7 == 0)
+		{
+			uint32 index = (frame / 7) % dsps.size();
+			DSP* dsp = dsps[index];
+			if(dsp->IsEnabled())
+			{
+				dsp->Bypass();
+			}
+			else if(dsp->IsIdle())
+			{
+				Configure(dsp, 100 + (frame * 13) % (maxLength - 100));
+				dsp->mix = 0.0f;
+				dsp->Enable();
+				timesEnabled[index]++;
+			}
+		}
+		float input = fabsf(fmodf((float)frame / 120.0f, 2.0f) - 1.0f);
+		filter->SetPeaking(1.0f - 0.2f * input, 80.0f + 7920.0f * input * input, 20.0f, (float)testAudio.GetSampleRate());
+		bitCrusher->SetPeriod(input * 20.0f);
+		echo->feedback = input;
+		gate->SetGating(0.2f + 0.6f * input);
+		pitchShift->amount = input * 12.0f - 6.0f;
+		for(DSP* dsp : dsps)
+			dsp->mix = input;
+
+		// Audio thread, about two blocks per frame
+		trackAllocations = true;
+		for(uint32 i = 0; i < 2; i++)
+		{
+			float* out = buffer.data();
+			source.Process(out, blockSize);
+			source.ProcessDSPs(out, blockSize);
+		}
+		trackAllocations = false;
+
+		for(float s : buffer)
+			TestEnsure(std::isfinite(s));
+	}
+	allocationTracking = false;
+
+	Logf("Allocations while processing: %d", Logger::Info, (uint32)numTrackedAllocations);
+	for(uint32 i = 0; i < dsps.size(); i++)
+		TestEnsure(timesEnabled[i] > 0);
+	TestEnsure(numTrackedAllocations == 0);
+
+	for(DSP* dsp : dsps)
+	{
+		source.RemoveDSP(dsp);
+		delete dsp;
+	}
+}
+
+// Silent source that reports the position it renders to a clock, the same way AudioStreamBase does
+class TestClockSource : public AudioBase
+{
+public:
+	virtual void Process(float* out, uint32 numSamples) override
+	{
+		m_position += numSamples;
+		lastObservation = audio->GetBlockOutputTime() + (double)numSamples * audio->GetSecondsPerSample();
+		lastMediaTime = (double)m_position / (double)GetSampleRate();
+		clock.Observe(lastObservation, lastMediaTime);
+	}
+	virtual int32 GetPosition() const override
+	{
+		return (int32)(clock.GetTime() * 1000.0);
+	}
+	virtual uint32 GetSampleRate() const override
+	{
+		return audio->GetSampleRate();
+	}
+	virtual float* GetPCM() override
+	{
+		return nullptr;
+	}
+
+	AudioClock clock;
+	double lastObservation = 0.0;
+	double lastMediaTime = 0.0;
+
+private:
+	uint64 m_position = 0;
+};
+
+// Drives the mixer like an output device whose callbacks arrive late by a random amount and that runs slightly fast
+//	the song time the game sees has to stay monotonic and close to what is actually heard
+Test("Audio.Clock.JitteryCallbacks")
+{
+	Audio_Impl testAudio;
+	const uint32 bufferSize = 1024;
+	const double sampleRate = (double)testAudio.GetSampleRate();
+	const double drift = 0.0005;
+	const double callbackInterval = (double)bufferSize / (sampleRate * (1.0 + drift));
+	testAudio.bufferLatency = (double)bufferSize / sampleRate;
+	testAudio.Start();
+	TestClockSource source;
+	testAudio.Register(&source);
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<double> jitter(-0.002, 0.002);
+	Vector<float> buffer;
+	buffer.resize(bufferSize * 2);
+
+	double gameTime = 0.0;
+	double lastTime = -1.0;
+	double maxError = 0.0;
+	double maxRawError = 0.0;
+	for(uint32 i = 0; i < 2000; i++)
+	{
+		double callbackTime = (double)i * callbackInterval + jitter(random);
+		// Scheduler hiccup
+		if(i % 40 == 39)
+			callbackTime += 0.01;
+
+		// Game frames until the next callback
+		for(; gameTime < callbackTime; gameTime += 0.001)
+		{
+			double time = source.clock.GetTime(gameTime);
+			TestEnsure(time >= lastTime);
+			lastTime = time;
+
+			// Song time of the sample that is being heard, once the first callback started playing
+			double heard = (gameTime - testAudio.GetOutputLatency()) * (1.0 + drift);
+			if(gameTime > 2.0)
+			{
+				maxError = Math::Max(maxError, fabs(time - heard));
+				// Extrapolating the last reported time directly, which the smoothing should improve on
+				double raw = source.lastMediaTime + (gameTime - source.lastObservation);
+				maxRawError = Math::Max(maxRawError, fabs(raw - heard));
+			}
+		}
+
+		uint32 numSamples = bufferSize;
+		testAudio.Mix(buffer.data(), numSamples, bufferSize, callbackTime);
+	}
+
+	Logf("Largest clock error: %.3f ms, without smoothing: %.3f ms", Logger::Info, maxError * 1000.0, maxRawError * 1000.0);
+	TestEnsure(maxError < 0.002);
+
+	testAudio.Deregister(&source);
+	testAudio.Stop();
+}
+
+// Source that keeps the audio thread busy for a while, for the next callback
+class TestLoadSource : public AudioBase
+{
+public:
+	virtual void Process(float* out, uint32 numSamples) override
+	{
+		if(stall > 0.0)
+		{
+			double end = AudioClock::Now() + stall;
+			while(AudioClock::Now() < end)
+			{
+			}
+			stall = 0.0;
+		}
+	}
+	virtual int32 GetPosition() const override
+	{
+		return 0;
+	}
+	virtual uint32 GetSampleRate() const override
+	{
+		return audio->GetSampleRate();
+	}
+	virtual float* GetPCM() override
+	{
+		return nullptr;
+	}
+
+	double stall = 0.0;
+};
+
+// Runs the mixer without an output device while the audio thread stalls on every callback, like with a busy CPU
+//	the adaptive buffer has to grow until the stalls fit and shrink back after they stop
+Test("Audio.Buffer.AdaptiveUnderruns")
+{
+	Audio_Impl testAudio;
+	testAudio.bufferSize = 256;
+	testAudio.adaptiveBuffer = true;
+	testAudio.stableDuration = 1.0;
+	testAudio.Start();
+	TestLoadSource source;
+	testAudio.Register(&source);
+
+	const double sampleRate = (double)testAudio.GetSampleRate();
+	Vector<float> buffer;
+	double time = 0.0;
+	// Plays <duration> seconds of audio, the test applies buffer size changes like Audio::Update does
+	auto Play = [&](double duration, double stall)
+	{
+		double end = time + duration;
+		while(time < end)
+		{
+			uint32 numSamples = testAudio.currentBufferSize;
+			buffer.resize(numSamples * 2);
+			source.stall = stall;
+			testAudio.Mix(buffer.data(), numSamples, numSamples, time);
+			time += (double)numSamples / sampleRate;
+			testAudio.currentBufferSize = (uint32)testAudio.targetBufferSize;
+		}
+	};
+
+	Play(2.0, 0.0);
+	Logf("Without load: %d samples, %d underruns", Logger::Info, (uint32)testAudio.currentBufferSize, (uint32)testAudio.underruns);
+	TestEnsure(testAudio.underruns == 0);
+	TestEnsure(testAudio.currentBufferSize == 256);
+
+	// 8ms stalls don't fit in 256 samples (5.8ms) but do in 512
+	Play(2.0, 0.008);
+	uint32 underrunsUnderLoad = testAudio.underruns;
+	Logf("With load: %d samples, %d underruns, worst callback %.2f ms", Logger::Info,
+		(uint32)testAudio.currentBufferSize, underrunsUnderLoad, (float)testAudio.worstCallbackTime / 1000.0f);
+	TestEnsure(underrunsUnderLoad > 0 && underrunsUnderLoad <= 3);
+	TestEnsure(testAudio.currentBufferSize >= 512);
+	TestEnsure(testAudio.worstCallbackTime >= 8000);
+
+	Play(3.0, 0.0);
+	Logf("After load: %d samples, %d underruns", Logger::Info, (uint32)testAudio.currentBufferSize, (uint32)testAudio.underruns);
+	TestEnsure(testAudio.currentBufferSize == 256);
+	TestEnsure(testAudio.underruns == underrunsUnderLoad);
+
+	testAudio.Deregister(&source);
+	testAudio.Stop();
+}
+
+// Counts rising zero crossings per second in the left channel
+static double MeasureFrequency(const Vector<float>& left, uint32 sampleRate)
+{
+	uint32 crossings = 0;
+	for(size_t i = 1; i < left.size(); i++)
+	{
+		if(left[i - 1] < 0.0f && left[i] >= 0.0f)
+			crossings++;
+	}
+	return (double)crossings * (double)sampleRate / (double)left.size();
+}
+
+// Level of the tone used by the time stretch tests, it rises over the source so the level of the output shows which part of the source it came from
+static float StretchTestLevel(double frame, uint32 numFrames)
+{
+	return 0.1f + 0.8f * (float)(frame / (double)numFrames);
+}
+static Vector<float> CreateStretchTestTone(uint32 numFrames, uint32 sampleRate)
+{
+	Vector<float> pcm;
+	pcm.resize(numFrames * 2);
+	for(uint32 i = 0; i < numFrames; i++)
+	{
+		float s = StretchTestLevel(i, numFrames) * sinf(Math::pi * 2.0f * 440.0f * (float)i / (float)sampleRate);
+		pcm[i * 2] = s;
+		pcm[i * 2 + 1] = s;
+	}
+	return pcm;
+}
+static float PeakLevel(const float* samples, uint32 numSamples)
+{
+	float peak = 0.0f;
+	for(uint32 i = 0; i < numSamples; i++)
+		peak = Math::Max(peak, fabsf(samples[i]));
+	return peak;
+}
+
+// Stretches a tone at the practice mode speeds, the pitch has to stay the same while the length and the reported source position follow the tempo
+//	also logs how much CPU time each speed takes
+Test("Audio.TimeStretch.Speeds")
+{
+	const uint32 sampleRate = 44100;
+	const uint32 numFrames = sampleRate * 10;
+	Vector<float> pcm = CreateStretchTestTone(numFrames, sampleRate);
+
+	float left[TimeStretcher::chunkFrames];
+	float right[TimeStretcher::chunkFrames];
+	for(float tempo : { 0.5f, 0.75f, 1.0f })
+	{
+		TimeStretcher stretcher(pcm.data(), numFrames, sampleRate);
+		stretcher.SetTempo(tempo);
+
+		Vector<float> output;
+		TimeStretcher::ReadInfo info;
+		double lastSourceEnd = 0.0;
+		float worstLevelError = 0.0f;
+		Timer timer;
+		while(!info.end)
+		{
+			stretcher.Render();
+			TestEnsure(stretcher.Read(left, right, info));
+			output.insert(output.end(), left, left + info.numFrames);
+			lastSourceEnd = info.sourceEnd;
+
+			// The reported source position has to match the part of the source that is heard
+			//	away from the start and the end, where SoundTouch fades in and pads with silence
+			if(info.numFrames == TimeStretcher::chunkFrames && info.sourceStart > sampleRate && info.sourceEnd < numFrames - sampleRate)
+			{
+				float expected = StretchTestLevel((info.sourceStart + info.sourceEnd) * 0.5, numFrames);
+				worstLevelError = Math::Max(worstLevelError, fabsf(PeakLevel(left, info.numFrames) - expected));
+			}
+		}
+		double renderTime = timer.SecondsAsDouble();
+
+		double outputSeconds = (double)output.size() / (double)sampleRate;
+		double frequency = MeasureFrequency(output, sampleRate);
+		Logf("Tempo %.2f: %.2f s of output, %.1f Hz, source position %.0f, level error %.3f, %.2f ms per second of output", Logger::Info,
+			tempo, outputSeconds, frequency, lastSourceEnd, worstLevelError, renderTime * 1000.0 / outputSeconds);
+		TestEnsure(fabs(frequency - 440.0) < 5.0);
+		TestEnsure(fabs(outputSeconds - 10.0 / tempo) < 0.2);
+		// A level error of 0.04 is half a second of source
+		TestEnsure(worstLevelError < 0.04f);
+		TestEnsure(fabs(lastSourceEnd - (double)numFrames) < TimeStretcher::chunkFrames);
+	}
+}
+
+// Loops a section on the worker thread, the chunks have to stay inside the loop and count the jumps
+//	the loop holds a whole number of periods of the tone, so the output has to continue without a gap or click at the seam
+Test("Audio.TimeStretch.Loop")
+{
+	const uint32 sampleRate = 44100;
+	const uint32 numFrames = sampleRate * 10;
+	Vector<float> pcm = CreateStretchTestTone(numFrames, sampleRate);
+
+	TimeStretcher stretcher(pcm.data(), numFrames, sampleRate);
+	stretcher.SetTempo(0.5f);
+	stretcher.SetLoop(sampleRate * 2, sampleRate * 3);
+	stretcher.Seek(sampleRate * 2);
+	stretcher.Start();
+
+	float left[TimeStretcher::chunkFrames];
+	float right[TimeStretcher::chunkFrames];
+	TimeStretcher::ReadInfo info;
+	uint32 framesRead = 0;
+	uint32 lastLoopCount = 0;
+	float lastSample = 0.0f;
+	// Largest change between two samples, the tone itself changes by at most level * 2pi * 440 / 44100 per sample
+	float maxStep = 0.0f;
+	float minSeamLevel = 1.0f;
+	Timer timer;
+	// 5 seconds of output at half speed covers the loop two and a half times
+	while(framesRead < sampleRate * 5 && timer.Seconds() < 10.0f)
+	{
+		if(!stretcher.Read(left, right, info))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		TestEnsure(info.sourceStart >= sampleRate * 2 && info.sourceStart < sampleRate * 3);
+		TestEnsure(info.loopCount >= lastLoopCount);
+
+		// The start of the output fades in from silence
+		if(framesRead >= sampleRate / 10)
+		{
+			for(uint32 i = 0; i < info.numFrames; i++)
+			{
+				maxStep = Math::Max(maxStep, fabsf(left[i] - lastSample));
+				lastSample = left[i];
+			}
+			if(info.loopCount != lastLoopCount)
+				minSeamLevel = Math::Min(minSeamLevel, PeakLevel(left, info.numFrames));
+		}
+		lastSample = left[info.numFrames - 1];
+		lastLoopCount = info.loopCount;
+		framesRead += info.numFrames;
+	}
+	stretcher.Stop();
+	Logf("Looped %d times in %d frames, largest step %.3f, level at the seam %.3f", Logger::Info, lastLoopCount, framesRead, maxStep, minSeamLevel);
+	TestEnsure(lastLoopCount == 2);
+	TestEnsure(maxStep < 0.1f);
+	// The level in the loop is between 0.26 and 0.34
+	TestEnsure(minSeamLevel > 0.2f);
+}
+
+// Writes an MP3 of silent MPEG-1 layer III frames at 44.1kHz 128kbps behind an ID3 tag
+static void WriteSilentMP3(const String& path, uint32 numFrames)
+{
+	Buffer data;
+	const uint8 tag[10] = { 'I', 'D', '3', 3, 0, 0, 0, 0, 0, 32 };
+	data.insert(data.end(), tag, tag + 10);
+	data.resize(data.size() + 32);
+	for(uint32 i = 0; i < numFrames; i++)
+	{
+		// Padding every third frame, so frame lengths differ like they do in real files
+		bool padding = i % 3 == 0;
+		size_t start = data.size();
+		data.resize(start + 417 + (padding ? 1 : 0));
+		data[start] = 0xFF;
+		data[start + 1] = 0xFB;
+		data[start + 2] = 0x90 | (padding ? 0x02 : 0x00);
+		data[start + 3] = 0xC0; // Mono
+	}
+	File file;
+	file.OpenWrite(path);
+	file.Write(data.data(), data.size());
+}
+
+// Opens an MP3 lazily and seeks close to its end, first while the frame index is still being built and then with the saved index
+Test("Audio.MP3.LazySeekIndex")
+{
+	Audio audio;
+	String path = "mp3_seek_test.mp3";
+	String indexFolder = Path::GetCacheFolder("audio");
+	const uint32 numFrames = 4000;
+	const double length = (double)(numFrames * 1152) / 44100.0;
+	WriteSilentMP3(path, numFrames);
+	Set<String> existingIndices;
+	for(const FileInfo& file : Files::ScanFiles(indexFolder, "mp3idx"))
+		existingIndices.Add(file.fullPath);
+	size_t savedIndices = existingIndices.size();
+
+	uint32 outputRate = audio.GetSampleRate();
+	float block[256 * 2];
+	for(uint32 pass = 0; pass < 2; pass++)
+	{
+		Timer timer;
+		AudioStream stream = audio.CreateStream(path);
+		TestEnsure(stream);
+		double openTime = timer.SecondsAsDouble() * 1000.0;
+
+		stream->SetPosition((int32)((length - 1.0) * 1000.0));
+		stream->PreBuffer();
+		double seekTime = timer.SecondsAsDouble() * 1000.0 - openTime;
+
+		// Everything after the seek position plays until the end
+		stream->Play();
+		uint32 played = 0;
+		while(!stream->HasEnded() && played < outputRate * 4)
+		{
+			stream->Process(block, 256);
+			played += 256;
+		}
+		double remaining = (double)played / (double)outputRate;
+		Logf("Pass %d: open %.2f ms, seek %.2f ms, first sample after %.2f ms, %.3f s played after the seek", Logger::Info,
+			pass, openTime, seekTime, stream->GetFirstSampleLatency(), remaining);
+		TestEnsure(stream->GetFirstSampleLatency() >= 0.0);
+		TestEnsure(fabs(remaining - 1.0) < 0.02);
+
+		// The index is saved once the background scan reaches the end of the file
+		if(pass == 0)
+		{
+			Timer waitTimer;
+			while(Files::ScanFiles(indexFolder, "mp3idx").size() == savedIndices && waitTimer.Seconds() < 5.0f)
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			TestEnsure(Files::ScanFiles(indexFolder, "mp3idx").size() > savedIndices);
+		}
+		stream.Destroy();
+	}
+	Path::Delete(path);
+
+	// Remove the index this test saved
+	for(const FileInfo& file : Files::ScanFiles(indexFolder, "mp3idx"))
+	{
+		if(!existingIndices.Contains(file.fullPath))
+			Path::Delete(file.fullPath);
+	}
+}
+
+// Mixes the same voices with effects serially and on render threads, the output has to be identical
+//	logs the time per block, the costliest voice and the deadline slack of both
+Test("Audio.Render.Parallel")
+{
+	const uint32 numVoices = 8;
+	Vector<float> outputs[2];
+	for(uint32 parallel = 0; parallel < 2; parallel++)
+	{
+		Audio_Impl testAudio;
+		testAudio.parallelRender = parallel != 0;
+		testAudio.renderThreads = 3;
+		testAudio.Start();
+
+		Vector<TestToneSource*> voices;
+		for(uint32 i = 0; i < numVoices; i++)
+		{
+			TestToneSource* voice = new TestToneSource(&testAudio, testAudio.GetSampleRate() + i * 100);
+			testAudio.Register(voice);
+			PhaserDSP* phaser = new PhaserDSP();
+			voice->AddDSP(phaser);
+			phaser->SetLength(500 + i * 50);
+			EchoDSP* echo = new EchoDSP();
+			voice->AddDSP(echo);
+			echo->SetMaxLength(1000);
+			echo->SetLength(100 + i * 30);
+			BQFDSP* filter = new BQFDSP();
+			voice->AddDSP(filter);
+			filter->SetPeaking(1.0f, 500.0f + i * 400.0f, 6.0f);
+			voice->SetVolume(1.0f / numVoices);
+			voices.Add(voice);
+		}
+
+		// 5 seconds in callbacks of 1024 samples
+		const uint32 callbackSize = 1024;
+		const uint32 numCallbacks = testAudio.GetSampleRate() * 5 / callbackSize;
+		Vector<float>& output = outputs[parallel];
+		output.resize(numCallbacks * callbackSize * 2);
+		double callbackTime = 0.0;
+		float worstSlack = FLT_MAX;
+		float costliestVoice = 0.0f;
+		Timer timer;
+		for(uint32 i = 0; i < numCallbacks; i++)
+		{
+			uint32 numSamples = callbackSize;
+			testAudio.Mix(output.data() + i * callbackSize * 2, numSamples, callbackSize, callbackTime);
+			callbackTime += (double)callbackSize * testAudio.GetSecondsPerSample();
+			worstSlack = Math::Min(worstSlack, (float)testAudio.minDeadlineSlack.exchange(INT32_MAX) / 1000.0f);
+			costliestVoice = Math::Max(costliestVoice, (float)testAudio.costliestItem);
+		}
+		double blockTime = timer.SecondsAsDouble() * 1000.0 / (double)(numCallbacks * callbackSize / testAudio.m_sampleBufferLength);
+		Logf("%s: %d render threads, %.3f ms per block, costliest voice %.3f ms, worst deadline slack %.2f ms", Logger::Info,
+			parallel ? "Parallel" : "Serial", testAudio.GetNumRenderThreads(), blockTime, costliestVoice, worstSlack);
+		TestEnsure(testAudio.GetNumRenderThreads() == (parallel ? 3u : 0u));
+
+		for(TestToneSource* voice : voices)
+		{
+			while(!voice->DSPs.empty())
+			{
+				DSP* dsp = voice->DSPs.back();
+				voice->RemoveDSP(dsp);
+				delete dsp;
+			}
+			testAudio.Deregister(voice);
+			delete voice;
+		}
+		testAudio.Stop();
+	}
+
+	TestEnsure(outputs[0].size() == outputs[1].size());
+	TestEnsure(memcmp(outputs[0].data(), outputs[1].data(), outputs[0].size() * sizeof(float)) == 0);
+}
+
+// Writes a wav file with the given format tag, format details and data chunk
+static Buffer MakeWav(uint16 format, uint16 channels, uint32 sampleRate, uint16 bitsPerSample, uint16 blockAlign, const Buffer& extra, const Buffer& data)
+{
+	Buffer wav;
+	MemoryWriter writer(wav);
+	uint32 fmtSize = 16 + (extra.empty() ? 0 : 2 + (uint32)extra.size());
+	uint32 riffSize = 4 + 8 + fmtSize + 8 + (uint32)data.size();
+	uint32 byteRate = sampleRate * blockAlign;
+	writer.Serialize((void*)"RIFF", 4);
+	writer << riffSize;
+	writer.Serialize((void*)"WAVEfmt ", 8);
+	writer << fmtSize << format << channels << sampleRate << byteRate << blockAlign << bitsPerSample;
+	if(!extra.empty())
+	{
+		uint16 extraSize = (uint16)extra.size();
+		writer << extraSize;
+		writer.Serialize((void*)extra.data(), extra.size());
+	}
+	uint32 dataSize = (uint32)data.size();
+	writer.Serialize((void*)"data", 4);
+	writer << dataSize;
+	writer.Serialize((void*)data.data(), data.size());
+	return wav;
+}
+
+// Measures sines with a known loudness and true peak, silence between them must not lower the integrated loudness
+Test("Audio.Loudness.Sine")
+{
+	const uint32 sampleRate = 48000;
+	Vector<float> pcm;
+	auto AddSine = [&](double frequency, double amplitude, double phase, double seconds)
+	{
+		uint32 numFrames = (uint32)(seconds * sampleRate);
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			float sample = (float)(amplitude * sin(2.0 * Math::pi * frequency * i / sampleRate + phase));
+			pcm.Add(sample);
+			pcm.Add(sample);
+		}
+	};
+
+	// A 1kHz sine at -20 dBFS on both channels is -20 LUFS
+	AddSine(997.0, pow(10.0, -20.0 / 20.0), 0.0, 10.0);
+	LoudnessMeter meter(sampleRate);
+	Timer timer;
+	meter.Process(pcm.data(), (uint32)pcm.size() / 2);
+	double seconds = timer.SecondsAsDouble();
+	double loudness = meter.GetIntegratedLoudness();
+	Logf("Sine: %.2f LUFS, %.2f dBTP, measured at %.0fx real time", Logger::Info, loudness, meter.GetTruePeak(), 10.0 / seconds);
+	TestEnsure(fabs(loudness + 20.0) < 0.1);
+	TestEnsure(fabs(meter.GetTruePeak() + 20.0) < 0.1);
+
+	// Only the blocks overlapping the start of the silence count towards the loudness
+	pcm.clear();
+	AddSine(997.0, 0.0, 0.0, 10.0);
+	meter.Process(pcm.data(), (uint32)pcm.size() / 2);
+	Logf("Sine followed by silence: %.2f LUFS", Logger::Info, meter.GetIntegratedLoudness());
+	TestEnsure(fabs(meter.GetIntegratedLoudness() - loudness) < 0.1);
+
+	// Sampled 45 degrees off its peaks, a quarter of the sample rate peaks 3 dB above its highest sample
+	pcm.clear();
+	AddSine(sampleRate / 4.0, 0.5, Math::pi / 4.0, 1.0);
+	LoudnessMeter peakMeter(sampleRate);
+	peakMeter.Process(pcm.data(), (uint32)pcm.size() / 2);
+	Logf("Quarter sample rate sine: %.2f dBTP", Logger::Info, peakMeter.GetTruePeak());
+	TestEnsure(fabs(peakMeter.GetTruePeak() + 6.02) < 0.5);
+
+	LoudnessMeter silentMeter(sampleRate);
+	TestEnsure(silentMeter.GetIntegratedLoudness() == LoudnessMeter::silence);
+}
+
+// Measures sine files through a decoder, which reads them in blocks without registering with the mixer
+Test("Audio.Loudness.Measure")
+{
+	Audio audio;
+	const uint32 sampleRate = 48000;
+	const uint32 numFrames = sampleRate * 5;
+	String path = "loudness_test.wav";
+	for(uint16 channels = 1; channels <= 2; channels++)
+	{
+		// A 1kHz sine at -20 dBFS on every channel is -20 LUFS
+		Buffer data;
+		data.resize(numFrames * channels * sizeof(int16));
+		int16* samples = (int16*)data.data();
+		for(uint32 i = 0; i < numFrames * channels; i++)
+			samples[i] = (int16)roundf(0.1f * 32767.0f * sinf(2.0f * Math::pi * 997.0f * (i / channels) / sampleRate));
+		Buffer wav = MakeWav(1, channels, sampleRate, 16, (uint16)(channels * 2), Buffer(), data);
+		File file;
+		TestEnsure(file.OpenWrite(path));
+		file.Write(wav.data(), wav.size());
+		file.Close();
+
+		float loudness, truePeak;
+		TestEnsure(LoudnessMeter::Measure(&audio, path, loudness, truePeak));
+		Logf("%d channel file: %.2f LUFS, %.2f dBTP", Logger::Info, channels, loudness, truePeak);
+		TestEnsure(fabsf(loudness + 20.0f) < 0.1f);
+		TestEnsure(fabsf(truePeak + 20.0f) < 0.1f);
+		Path::Delete(path);
+	}
+	float loudness, truePeak;
+	TestEnsure(!LoudnessMeter::Measure(&audio, path, loudness, truePeak));
+}
+
+// Builds a summary of a tone with a silent second half, checks the waveform levels and spectrum and that it survives being stored
+Test("Audio.Summary.Pyramid")
+{
+	const uint32 sampleRate = 48000;
+	const uint32 numFrames = sampleRate * 20;
+	Vector<float> pcm;
+	pcm.resize(numFrames * 2);
+	for(uint32 i = 0; i < numFrames; i++)
+	{
+		float sample = i < numFrames / 2 ? 0.5f * sinf(2.0f * Math::pi * 1000.0f * i / sampleRate) : 0.0f;
+		pcm[i * 2] = sample;
+		pcm[i * 2 + 1] = sample;
+	}
+
+	AudioSummary summary;
+	Timer timer;
+	summary.Build(pcm.data(), numFrames, sampleRate);
+	Logf("Built summary of 20s in %.1f ms, %zu bytes", Logger::Info, timer.SecondsAsDouble() * 1000.0, summary.GetMemoryUsage());
+	TestEnsure(fabs(summary.GetDuration() - 20.0) < 0.001);
+
+	// Every level has half the bins of the one before, down to the minimum
+	const Vector<AudioSummary::WaveformLevel>& levels = summary.GetLevels();
+	TestEnsure(levels.size() > 1);
+	TestEnsure(levels[0].rms.size() == (numFrames + AudioSummary::baseBinFrames - 1) / AudioSummary::baseBinFrames);
+	for(size_t i = 1; i < levels.size(); i++)
+	{
+		TestEnsure(levels[i].rms.size() == (levels[i - 1].rms.size() + 1) / 2);
+		TestEnsure(levels[i].binFrames == levels[i - 1].binFrames * 2);
+	}
+	TestEnsure(levels.back().rms.size() <= AudioSummary::minBins);
+
+	// Loud first half, silent second half
+	Vector<float> min, max, rms;
+	summary.GetWaveform(100, min, max, rms);
+	TestEnsure(rms.size() == 100 && min.size() == 100 && max.size() == 100);
+	TestEnsure(fabs(max[10] - 0.5f) < 0.02f && fabs(min[10] + 0.5f) < 0.02f);
+	TestEnsure(fabs(rms[10] - 0.5f / sqrtf(2.0f)) < 0.02f);
+	TestEnsure(max[90] == 0.0f && min[90] == 0.0f && rms[90] == 0.0f);
+
+	// The tone is in the band containing 1kHz, which is louder than the bands far away from it
+	Vector<float> spectrum;
+	summary.GetSpectrum(10, spectrum);
+	TestEnsure(spectrum.size() == 10 * AudioSummary::numBands);
+	uint32 loudestBand = 0;
+	for(uint32 band = 1; band < AudioSummary::numBands; band++)
+	{
+		if(spectrum[band] > spectrum[loudestBand])
+			loudestBand = band;
+	}
+	uint32 expectedBand = (uint32)(log(1000.0 / 40.0) / log(16000.0 / 40.0) * AudioSummary::numBands);
+	TestEnsure(loudestBand == expectedBand);
+	TestEnsure(spectrum[0] < 0.1f && spectrum[AudioSummary::numBands - 1] < 0.1f);
+	TestEnsure(spectrum[9 * AudioSummary::numBands + loudestBand] == 0.0f);
+
+	// Round trip through a stored summary
+	Buffer stored;
+	MemoryWriter writer(stored);
+	TestEnsure(summary.Serialize(writer));
+	AudioSummary loaded;
+	MemoryReader reader(stored);
+	TestEnsure(loaded.Serialize(reader));
+	Vector<float> loadedMin, loadedMax, loadedRms, loadedSpectrum;
+	loaded.GetWaveform(100, loadedMin, loadedMax, loadedRms);
+	loaded.GetSpectrum(10, loadedSpectrum);
+	TestEnsure(loadedMin == min && loadedMax == max && loadedRms == rms && loadedSpectrum == spectrum);
+	TestEnsure(loaded.GetDuration() == summary.GetDuration());
+
+	// Truncated data is rejected
+	stored.resize(stored.size() / 2);
+	MemoryReader truncatedReader(stored);
+	AudioSummary truncated;
+	TestEnsure(!truncated.Serialize(truncatedReader));
+}
+
+// Builds a summary from a file through a decoder, it has to match the one built from the same samples in memory
+Test("Audio.Summary.File")
+{
+	Audio audio;
+	const uint32 sampleRate = 44100;
+	const uint32 numFrames = sampleRate * 3 + 1000;
+	String path = "summary_test.wav";
+	Buffer data;
+	data.resize(numFrames * 2 * sizeof(int16));
+	int16* samples = (int16*)data.data();
+	Vector<float> pcm;
+	pcm.resize(numFrames * 2);
+	for(uint32 i = 0; i < numFrames * 2; i++)
+	{
+		float frequency = i % 2 ? 3000.0f : 200.0f;
+		samples[i] = (int16)roundf(0.5f * 32767.0f * sinf(2.0f * Math::pi * frequency * (i / 2) / sampleRate));
+		pcm[i] = (float)samples[i] / (float)0x7FFF;
+	}
+	Buffer wav = MakeWav(1, 2, sampleRate, 16, 4, Buffer(), data);
+	File file;
+	TestEnsure(file.OpenWrite(path));
+	file.Write(wav.data(), wav.size());
+	file.Close();
+
+	AudioSummary fromFile;
+	TestEnsure(fromFile.Build(&audio, path));
+	AudioSummary fromMemory;
+	fromMemory.Build(pcm.data(), numFrames, sampleRate);
+	TestEnsure(fromFile.GetDuration() == fromMemory.GetDuration());
+	TestEnsure(fromFile.GetLevels().size() == fromMemory.GetLevels().size());
+	for(size_t i = 0; i < fromFile.GetLevels().size(); i++)
+	{
+		const AudioSummary::WaveformLevel& a = fromFile.GetLevels()[i];
+		const AudioSummary::WaveformLevel& b = fromMemory.GetLevels()[i];
+		TestEnsure(a.min == b.min && a.max == b.max && a.rms == b.rms);
+	}
+	Vector<float> a, b;
+	fromFile.GetSpectrum(fromFile.GetSpectrumLength(), a);
+	fromMemory.GetSpectrum(fromMemory.GetSpectrumLength(), b);
+	TestEnsure(a == b);
+	Path::Delete(path);
+}
+
+// Loads the same tone in every supported sample format, the decoded samples have to match it and play back without changes
+//	also checks the MS-ADPCM decoder against a block with a known result, resampling and playing big float files from a mapped file
+Test("Audio.Sample.Formats")
+{
+	Audio audio;
+	const uint32 sampleRate = audio.GetSampleRate();
+	const uint32 numFrames = sampleRate / 2;
+	Vector<float> tone;
+	tone.resize(numFrames);
+	for(uint32 i = 0; i < numFrames; i++)
+		tone[i] = 0.5f * sinf(2.0f * Math::pi * 440.0f * i / sampleRate);
+
+	struct Format
+	{
+		const char* name;
+		uint16 format;
+		uint16 bits;
+		float tolerance;
+	};
+	const Format formats[] = {
+		{ "8 bit", 1, 8, 1.0f / 100.0f },
+		{ "16 bit", 1, 16, 1.0f / 30000.0f },
+		{ "24 bit", 1, 24, 1.0f / 4000000.0f },
+		{ "32 bit", 1, 32, 1e-7f },
+		{ "float", 3, 32, 0.0f },
+	};
+	for(const Format& format : formats)
+	{
+		for(uint16 channels = 1; channels <= 2; channels++)
+		{
+			uint32 bytes = format.bits / 8;
+			Buffer data;
+			data.resize(numFrames * channels * bytes);
+			for(uint32 i = 0; i < numFrames * channels; i++)
+			{
+				float sample = tone[i / channels];
+				uint8* dst = data.data() + i * bytes;
+				if(format.format == 3)
+					memcpy(dst, &sample, 4);
+				else if(format.bits == 8)
+					*dst = (uint8)(int32)(128.0f + roundf(sample * 127.0f));
+				else
+				{
+					int32 value = (int32)roundf(sample * (float)((1u << (format.bits - 1)) - 1));
+					memcpy(dst, &value, bytes);
+				}
+			}
+			Buffer wav = MakeWav(format.format, channels, sampleRate, format.bits, (uint16)(channels * bytes), Buffer(), data);
+			Sample sample = SampleRes::Create(&audio, wav.data(), wav.size(), format.name);
+			TestEnsure(sample);
+			TestEnsure(sample->GetLength() == numFrames);
+			TestEnsure(sample->GetSampleRate() == sampleRate);
+
+			float maxError = 0.0f;
+			const float* samples = sample->GetSamples();
+			for(uint32 i = 0; i < numFrames; i++)
+			{
+				maxError = Math::Max(maxError, fabsf(samples[i * 2] - tone[i]));
+				maxError = Math::Max(maxError, fabsf(samples[i * 2 + 1] - tone[i]));
+			}
+			TestEnsure(maxError <= format.tolerance);
+		}
+	}
+
+	// All nibbles 1 with the smallest step count up by 16 per sample from the header samples, on both channels
+	{
+		const uint16 blockAlign = 14 + 32;
+		const uint16 framesPerBlock = 2 + 32;
+		Buffer block;
+		block.resize(blockAlign, 0x11);
+		int16 header[] = { 16, 16, 16, 16, 0, 0 };
+		block[0] = 0;
+		block[1] = 0;
+		memcpy(block.data() + 2, header, sizeof(header));
+		Buffer extra;
+		extra.resize(4, 0);
+		memcpy(extra.data(), &framesPerBlock, 2);
+		Buffer wav = MakeWav(2, 2, sampleRate, 4, blockAlign, extra, block);
+		Sample sample = SampleRes::Create(&audio, wav.data(), wav.size(), "MS-ADPCM");
+		TestEnsure(sample);
+		TestEnsure(sample->GetLength() == framesPerBlock);
+		const float* samples = sample->GetSamples();
+		for(uint32 i = 0; i < framesPerBlock; i++)
+		{
+			float expected = (float)(i * 16) / 32768.0f;
+			TestEnsure(samples[i * 2] == expected && samples[i * 2 + 1] == expected);
+		}
+	}
+
+	// Half the output rate, played at the same pitch and twice the number of frames
+	{
+		Buffer data;
+		data.resize(numFrames * 2);
+		for(uint32 i = 0; i < numFrames; i++)
+		{
+			int16 value = (int16)roundf(0.5f * sinf(2.0f * Math::pi * 440.0f * i / (sampleRate / 2)) * 32767.0f);
+			memcpy(data.data() + i * 2, &value, 2);
+		}
+		Buffer wav = MakeWav(1, 1, sampleRate / 2, 16, 2, Buffer(), data);
+		Sample sample = SampleRes::Create(&audio, wav.data(), wav.size(), "Resampled");
+		TestEnsure(sample);
+		TestEnsure(sample->GetLength() == numFrames * 2);
+		Vector<float> left;
+		for(uint64 i = 0; i < sample->GetLength(); i++)
+			left.Add(sample->GetSamples()[i * 2]);
+		double frequency = MeasureFrequency(left, sampleRate);
+		Logf("Resampled tone: %.1f Hz", Logger::Info, frequency);
+		TestEnsure(fabs(frequency - 440.0) < 2.0);
+	}
+
+	// Big float files are mapped and play exactly the file contents, looping without a gap
+	//	a fmt chunk with 4 extra bytes leaves the floats misaligned in the file, those have to be copied instead
+	for(uint32 misaligned = 0; misaligned < 2; misaligned++)
+	{
+		const uint32 mappedFrames = sampleRate * 4;
+		Buffer data;
+		data.resize(mappedFrames * 2 * sizeof(float));
+		float* values = (float*)data.data();
+		for(uint32 i = 0; i < mappedFrames * 2; i++)
+			values[i] = tone[(i / 2) % numFrames];
+		Buffer extra;
+		extra.resize(misaligned ? 4 : 0);
+		Buffer wav = MakeWav(3, 2, sampleRate, 32, 8, extra, data);
+		String path = "sample_map_test.wav";
+		{
+			File file;
+			TestEnsure(file.OpenWrite(path));
+			file.Write(wav.data(), wav.size());
+		}
+		Sample sample = audio.CreateSample(path);
+		TestEnsure(sample);
+		TestEnsure(sample->IsMapped() == !misaligned);
+		TestEnsure(sample->GetLength() == mappedFrames);
+
+		const uint32 blockSize = 384;
+		Vector<float> out;
+		out.resize(blockSize * 2);
+		sample->Play(true);
+		uint64 position = 0;
+		bool matches = true;
+		Timer timer;
+		for(uint32 b = 0; b < mappedFrames * 2 / blockSize; b++)
+		{
+			sample->Process(out.data(), blockSize);
+			for(uint32 i = 0; i < blockSize * 2; i++)
+				matches = matches && out[i] == values[(position * 2 + i) % (mappedFrames * 2)];
+			position += blockSize;
+		}
+		Logf("Mixed %.1fs of a %s sample in %.2f ms", Logger::Info, (double)position / sampleRate, misaligned ? "copied" : "mapped", timer.SecondsAsDouble() * 1000.0);
+		TestEnsure(matches);
+		sample.Release();
+		Path::Delete(path);
+	}
+}
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include <Audio/Audio.hpp>
 #include <Beatmap/BeatmapPlayback.hpp>
+#include <Shared/Files.hpp>
 #include <Audio/DSP.hpp>
 #include "TestMusicPlayer.hpp"
 
@@ -338,3 +339,150 @@ Test("Beatmap.SingleFilter")
 	Player player(beatmap, mapRootPath);
 	player.Run();
 }
+
+// Dense chart with buttons, FX holds and zigzagging lasers on every 16th note
+static String GenerateDenseChart(uint32 numMeasures)
+{
+	static const char* buttons[] = { "1010", "0101", "1100", "0011", "2000", "0002", "1001", "0110" };
+	static const char* fx[] = { "22", "22", "20", "02", "00", "11", "22", "00" };
+	String chart = "title=Dense\r\nartist=\r\nt=240\r\nm=dense.ogg\r\no=0\r\n--\r\n";
+	for(uint32 m = 0; m < numMeasures; m++)
+	{
+		for(uint32 i = 0; i < 16; i++)
+		{
+			uint32 k = (m * 16 + i) % 8;
+			char left = (i % 2) == 0 ? '0' : 'o';
+			char right = (i % 2) == 0 ? 'o' : '0';
+			chart += Utility::Sprintf("%s|%s|%c%c\r\n", buttons[k], fx[k], left, right);
+		}
+		chart += "--\r\n";
+	}
+	return chart;
+}
+
+// Checks the view window against the range queries while playing through a chart, and with USC_BENCHMARKS set
+//	measures the time spent in BeatmapPlayback per frame
+//	uses the ksh files in USC_CHART_FOLDER when set, otherwise a generated chart
+Test("Beatmap.PlaybackBenchmark")
+{
+	bool benchmark = context.BenchmarksEnabled();
+	Vector<Beatmap*> beatmaps;
+	Vector<String> names;
+	const char* folder = getenv("USC_CHART_FOLDER");
+	if(folder)
+	{
+		for(const FileInfo& file : Files::ScanFilesRecursive(folder))
+		{
+			if(Path::GetExtension(file.fullPath) != "ksh")
+				continue;
+			File mapFile;
+			if(!mapFile.OpenRead(file.fullPath))
+				continue;
+			FileReader reader(mapFile);
+			Beatmap* beatmap = new Beatmap();
+			if(!beatmap->Load(reader))
+			{
+				delete beatmap;
+				continue;
+			}
+			beatmaps.Add(beatmap);
+			names.Add(file.fullPath);
+		}
+		// Only the densest charts
+		Vector<size_t> order;
+		for(size_t i = 0; i < beatmaps.size(); i++)
+			order.Add(i);
+		order.Sort([&](size_t l, size_t r) { return beatmaps[l]->GetLinearObjects().size() > beatmaps[r]->GetLinearObjects().size(); });
+		Vector<Beatmap*> densest;
+		Vector<String> densestNames;
+		for(size_t i = 0; i < order.size(); i++)
+		{
+			if(i < 5)
+			{
+				densest.Add(beatmaps[order[i]]);
+				densestNames.Add(names[order[i]]);
+			}
+			else
+				delete beatmaps[order[i]];
+		}
+		beatmaps = densest;
+		names = densestNames;
+	}
+	if(beatmaps.empty())
+	{
+		// A short chart is enough to check the results
+		Buffer buffer(GenerateDenseChart(benchmark ? 400 : 40).c_str());
+		MemoryReader reader(buffer);
+		Beatmap* beatmap = new Beatmap();
+		TestEnsure(beatmap->Load(reader));
+		beatmaps.Add(beatmap);
+		names.Add("generated");
+	}
+
+	for(size_t i = 0; i < beatmaps.size(); i++)
+	{
+		const Vector<ObjectState*>& objects = beatmaps[i]->GetLinearObjects();
+		MapTime endTime = objects.back()->time + 2000;
+
+		// The view window should contain the same objects as the range, grouped by render group
+		//	also when the range changes like it does with speed changes
+		{
+			BeatmapPlayback playback(*beatmaps[i]);
+			TestEnsure(playback.Reset(0));
+			for(MapTime time = 0; time < endTime; time += 4)
+			{
+				playback.Update(time);
+				MapTime range = 200 + (time * 7) % 3000;
+				Vector<ObjectState*> visible = playback.GetObjectsInRange(range);
+				ObjectSpan view = playback.GetObjectsInView(range);
+				// Objects should be in chart order without duplicates
+				for(size_t j = 1; j < visible.size(); j++)
+					TestEnsure(visible[j - 1]->time <= visible[j]->time && visible[j - 1] != visible[j]);
+				for(size_t j = 1; j < view.size(); j++)
+					TestEnsure(BeatmapPlayback::GetRenderGroup(view[j - 1]) <= BeatmapPlayback::GetRenderGroup(view[j]));
+				Vector<ObjectState*> viewSorted(view.begin(), view.end());
+				viewSorted.Sort([](ObjectState* l, ObjectState* r) { return l < r; });
+				visible.Sort([](ObjectState* l, ObjectState* r) { return l < r; });
+				TestEnsure(viewSorted == visible);
+			}
+		}
+
+		if(!benchmark)
+		{
+			delete beatmaps[i];
+			continue;
+		}
+
+		double rangeTime = 0.0, viewTime = 0.0;
+		uint64 numVisible = 0;
+		uint32 numFrames = 0;
+		for(uint32 run = 0; run < 4; run++)
+		{
+			BeatmapPlayback playback(*beatmaps[i]);
+			TestEnsure(playback.Reset(0));
+			Timer timer;
+			for(MapTime time = 0; time < endTime; time += 4)
+			{
+				playback.Update(time);
+				Vector<ObjectState*> visible = playback.GetObjectsInRange(3000);
+				numVisible += visible.size();
+				numFrames++;
+			}
+			rangeTime += timer.SecondsAsDouble() * 1000.0;
+
+			TestEnsure(playback.Reset(0));
+			timer.Restart();
+			for(MapTime time = 0; time < endTime; time += 4)
+			{
+				playback.Update(time);
+				ObjectSpan view = playback.GetObjectsInView(3000);
+				numVisible -= view.size();
+			}
+			viewTime += timer.SecondsAsDouble() * 1000.0;
+		}
+		TestEnsure(numVisible == 0);
+		Logf("%s: %d objects, %.2f us per frame with GetObjectsInRange, %.2f us with GetObjectsInView", Logger::Info, names[i], (int32)objects.size(),
+			rangeTime * 1000.0 / numFrames, viewTime * 1000.0 / numFrames);
+		delete beatmaps[i];
+	}
+}
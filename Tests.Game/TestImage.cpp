@@ -0,0 +1,226 @@
+#include "stdafx.h"
+#include <Shared/Files.hpp>
+using namespace Graphics;
+
+// PNG encoding doesn't need a window or OpenGL context, this is how frames are dumped without rendering to the screen
+Test("Image.EncodePNG")
+{
+	Vector2i size(1280, 720);
+	Image image = ImageRes::Create(size);
+	Colori* bits = image->GetBits();
+	for(int32 y = 0; y < size.y; y++)
+	{
+		for(int32 x = 0; x < size.x; x++)
+		{
+			// Gradient with some noise so the compression levels make a difference
+			uint8 noise = (uint8)((x * 7 + y * 13) ^ (x * y)) & 0xF;
+			bits[y * size.x + x] = Colori((uint8)(x & 0xFF) ^ noise, (uint8)(y & 0xFF), (uint8)((x + y) & 0xFF), 255);
+		}
+	}
+
+	for(int32 level : { 0, 1, 6, 9 })
+	{
+		String path = TestFilename + ".png";
+		Timer timer;
+		TestEnsure(image->SavePNG(path, level));
+		double encodeTime = timer.SecondsAsDouble() * 1000.0;
+
+		File file;
+		TestEnsure(file.OpenRead(path));
+		Logf("PNG compression level %d: %.2f ms, %d KiB", Logger::Info, level, encodeTime, (int32)(file.GetSize() / 1024));
+		file.Close();
+
+		// Rows are stored bottom-up
+		Image loaded = ImageRes::Create(path);
+		TestEnsure(loaded);
+		TestEnsure(loaded->GetSize().x == size.x && loaded->GetSize().y == size.y);
+		const Colori* loadedBits = loaded->GetBits();
+		for(int32 y = 0; y < size.y; y++)
+		{
+			TestEnsure(memcmp(loadedBits + y * size.x, bits + (size.y - y - 1) * size.x, size.x * sizeof(Colori)) == 0);
+		}
+	}
+}
+
+// Frames of an animation are packed into one image, the cached atlas has to give the same result
+Test("Image.TextureAtlas")
+{
+	Vector<Image> frames;
+	for(int32 i = 0; i < 12; i++)
+	{
+		Vector2i size(64 + (i % 3) * 16, 48);
+		Image frame = ImageRes::Create(size);
+		Colori* bits = frame->GetBits();
+		for(int32 p = 0; p < size.x * size.y; p++)
+			bits[p] = Colori((uint8)(i * 20), (uint8)(p & 0xFF), (uint8)(p >> 8), 255);
+		frames.Add(frame);
+	}
+
+	TextureAtlas atlas;
+	TestEnsure(!atlas.Pack(frames, 64));
+	TestEnsure(atlas.Pack(frames, 1024));
+	const Vector<Recti>& rects = atlas.GetFrames();
+	TestEnsure(rects.size() == frames.size());
+	Vector2i atlasSize = atlas.GetImage()->GetSize();
+	for(size_t i = 0; i < rects.size(); i++)
+	{
+		const Recti& rect = rects[i];
+		TestEnsure(rect.size.x == frames[i]->GetSize().x && rect.size.y == frames[i]->GetSize().y);
+		TestEnsure(rect.pos.x >= 0 && rect.pos.y >= 0 && rect.pos.x + rect.size.x <= atlasSize.x && rect.pos.y + rect.size.y <= atlasSize.y);
+		for(size_t j = 0; j < i; j++)
+		{
+			const Recti& other = rects[j];
+			bool overlaps = rect.pos.x < other.pos.x + other.size.x && other.pos.x < rect.pos.x + rect.size.x &&
+				rect.pos.y < other.pos.y + other.size.y && other.pos.y < rect.pos.y + rect.size.y;
+			TestEnsure(!overlaps);
+		}
+		// Same pixels as the source frame
+		const Colori* src = frames[i]->GetBits();
+		const Colori* dst = atlas.GetImage()->GetBits() + rect.pos.x + rect.pos.y * atlasSize.x;
+		for(int32 y = 0; y < rect.size.y; y++)
+			TestEnsure(memcmp(dst + y * atlasSize.x, src + y * rect.size.x, rect.size.x * sizeof(Colori)) == 0);
+	}
+
+	String imagePath = TestFilename + ".png";
+	String indexPath = TestFilename + ".atlas";
+	TestEnsure(atlas.Save(imagePath, indexPath));
+	TextureAtlas loaded;
+	TestEnsure(loaded.Load(imagePath, indexPath));
+	TestEnsure(loaded.GetFrames().size() == rects.size());
+	for(size_t i = 0; i < rects.size(); i++)
+	{
+		TestEnsure(loaded.GetFrames()[i].pos.x == rects[i].pos.x && loaded.GetFrames()[i].pos.y == rects[i].pos.y);
+	}
+	TestEnsure(memcmp(loaded.GetImage()->GetBits(), atlas.GetImage()->GetBits(), atlas.GetImage()->GetMemoryUsage()) == 0);
+}
+
+Test("Image.Resize")
+{
+	// A flat color has to stay the same with every filter, including the negative lobes of Lanczos
+	Vector2i size(123, 77);
+	Image flat = ImageRes::Create(size);
+	for(int32 i = 0; i < size.x * size.y; i++)
+		flat->GetBits()[i] = Colori(200, 100, 50, 255);
+	for(ResizeFilter filter : { ResizeFilter::Nearest, ResizeFilter::Box, ResizeFilter::Lanczos })
+	{
+		for(Vector2i target : { Vector2i(40, 30), Vector2i(123, 20), Vector2i(250, 160), Vector2i(1, 1) })
+		{
+			Vector<Colori> out(target.x * target.y);
+			ImageProcessing::Resize(flat->GetBits(), size, out.data(), target, filter);
+			for(const Colori& c : out)
+				TestEnsure(c.x == 200 && c.y == 100 && c.z == 50 && c.w == 255);
+		}
+	}
+
+	// Box filter averages a black and white checkerboard to gray, nearest neighbour picks one of the two
+	Vector2i boardSize(64, 64);
+	Vector<Colori> board(boardSize.x * boardSize.y);
+	for(int32 y = 0; y < boardSize.y; y++)
+	{
+		for(int32 x = 0; x < boardSize.x; x++)
+		{
+			uint8 v = ((x + y) & 1) ? 255 : 0;
+			board[y * boardSize.x + x] = Colori(v, v, v, 255);
+		}
+	}
+	Vector<Colori> half(32 * 32);
+	ImageProcessing::Resize(board.data(), boardSize, half.data(), Vector2i(32, 32), ResizeFilter::Box);
+	for(const Colori& c : half)
+		TestEnsure(c.x >= 127 && c.x <= 128);
+	ImageProcessing::Resize(board.data(), boardSize, half.data(), Vector2i(32, 32), ResizeFilter::Nearest);
+	for(const Colori& c : half)
+		TestEnsure(c.x == 0 || c.x == 255);
+
+	// Invisible pixels must not change the color of visible ones
+	Vector<Colori> sprite(64 * 64);
+	for(int32 i = 0; i < 64 * 64; i++)
+		sprite[i] = (i % 64) < 32 ? Colori(255, 0, 0, 255) : Colori(0, 255, 0, 0);
+	Vector<Colori> small(16 * 16);
+	ImageProcessing::Resize(sprite.data(), Vector2i(64, 64), small.data(), Vector2i(16, 16), ResizeFilter::Lanczos);
+	for(const Colori& c : small)
+	{
+		if(c.w > 8)
+			TestEnsure(c.x > 240 && c.y < 8);
+	}
+
+	// Premultiplying and back again keeps opaque pixels and clears invisible ones
+	Colori pixels[3] = { Colori(10, 20, 30, 255), Colori(255, 128, 0, 128), Colori(50, 60, 70, 0) };
+	ImageProcessing::PremultiplyAlpha(pixels, 3);
+	TestEnsure(pixels[0].x == 10 && pixels[1].x == 128 && pixels[1].y == 64 && pixels[2].x == 0);
+	ImageProcessing::UnpremultiplyAlpha(pixels, 3);
+	TestEnsure(pixels[0].x == 10 && pixels[0].z == 30 && pixels[1].x == 255 && pixels[2].y == 0);
+
+	// ImageRes uses the same code
+	flat->ReSize(Vector2i(10, 10), ResizeFilter::Box);
+	TestEnsure(flat->GetSize().x == 10 && flat->GetSize().y == 10 && flat->GetMemoryUsage() == 400);
+	TestEnsure(flat->GetBits()[55].x == 200);
+}
+
+// Decodes and downscales the images in a folder the way jackets are loaded
+//	set USC_JACKET_FOLDER to a folder of real jacket images, otherwise generated images are used
+Test("Image.ResizeBenchmark")
+{
+	// Generating the images takes a while, so only run on request or when real jackets are given
+	const char* folder = getenv("USC_JACKET_FOLDER");
+	if(!folder && !context.BenchmarksEnabled())
+		return;
+
+	Vector<String> paths;
+	if(folder)
+	{
+		for(const FileInfo& file : Files::ScanFilesRecursive(folder))
+		{
+			String ext = Path::GetExtension(file.fullPath);
+			ext.ToLower();
+			if(ext == "png" || ext == "jpg" || ext == "jpeg")
+				paths.Add(file.fullPath);
+		}
+	}
+	if(paths.empty())
+	{
+		for(int32 i = 0; i < 8; i++)
+		{
+			Vector2i size(1000 + i * 37, 1000);
+			Image image = ImageRes::Create(size);
+			Colori* bits = image->GetBits();
+			for(int32 p = 0; p < size.x * size.y; p++)
+				bits[p] = Colori((uint8)(p * 7 + i), (uint8)((p / size.x) ^ p), (uint8)(p >> 5), 255);
+			String path = Utility::Sprintf("%s_%d.png", TestFilename, i);
+			TestEnsure(image->SavePNG(path, 1, false));
+			paths.Add(path);
+		}
+	}
+
+	const Vector2i jacketSize(256, 256);
+	double loadTime = 0.0, scaledLoadTime = 0.0;
+	double resizeTime[3] = {};
+	uint64 sourcePixels = 0;
+	for(const String& path : paths)
+	{
+		Timer timer;
+		Image image = ImageRes::Create(path);
+		loadTime += timer.SecondsAsDouble();
+		if(!image)
+			continue;
+		sourcePixels += (uint64)image->GetSize().x * image->GetSize().y;
+
+		timer.Restart();
+		Image scaled = ImageRes::Create(path, jacketSize);
+		scaledLoadTime += timer.SecondsAsDouble();
+		TestEnsure(scaled && scaled->GetSize().x >= Math::Min(jacketSize.x, image->GetSize().x));
+
+		Vector<Colori> out(jacketSize.x * jacketSize.y);
+		for(int32 filter = 0; filter < 3; filter++)
+		{
+			timer.Restart();
+			ImageProcessing::Resize(image->GetBits(), image->GetSize(), out.data(), jacketSize, (ResizeFilter)filter);
+			resizeTime[filter] += timer.SecondsAsDouble();
+		}
+	}
+
+	double n = (double)paths.size();
+	Logf("%d images (%.1f MPixels), SIMD %s: decode %.2f ms, reduced JPEG decode %.2f ms, resize to %dx%d: nearest %.2f ms, box %.2f ms, lanczos %.2f ms (per image)",
+		Logger::Info, (int32)paths.size(), (double)sourcePixels / 1000000.0, ImageProcessing::IsSIMDEnabled() ? "on" : "off",
+		loadTime * 1000.0 / n, scaledLoadTime * 1000.0 / n, jacketSize.x, jacketSize.y,
+		resizeTime[0] * 1000.0 / n, resizeTime[1] * 1000.0 / n, resizeTime[2] * 1000.0 / n);
+}
@@ -0,0 +1,89 @@
+#include <Shared/Shared.hpp>
+#include <Shared/AssetBundle.hpp>
+#include <Shared/MappedFile.hpp>
+#include <Tests/Tests.hpp>
+
+Test("MappedFile.Read")
+{
+	File file;
+	TestEnsure(file.OpenWrite(TestFilename));
+	const char text[] = "Mapped file contents";
+	file.Write(text, sizeof(text));
+	file.Close();
+
+	MappedFile mapped;
+	TestEnsure(mapped.Open(TestFilename));
+	TestEnsure(mapped.IsOpen());
+	TestEnsure(mapped.GetSize() == sizeof(text));
+	TestEnsure(memcmp(mapped.GetData(), text, sizeof(text)) == 0);
+	mapped.Close();
+	TestEnsure(!mapped.IsOpen());
+	TestEnsure(!mapped.Open(TestFilename + ".missing"));
+}
+
+Test("AssetBundle.RoundTrip")
+{
+	String bundlePath = TestFilename;
+	{
+		AssetBundleWriter writer;
+		TestEnsure(writer.Open(bundlePath));
+		const char shader[] = "void main() {}";
+		uint8 image[4 * 2 * 2 + 8] = { 2, 0, 0, 0, 2, 0, 0, 0 };
+		for(uint32 i = 8; i < sizeof(image); i++)
+			image[i] = (uint8)i;
+		TestEnsure(writer.Add("shaders/test.vs", AssetType::Raw, 1234, shader, sizeof(shader) - 1));
+		TestEnsure(writer.Add("textures\\anim\\1.png", AssetType::Image, 5, image, sizeof(image)));
+		TestEnsure(writer.Add("textures/anim/0.png", AssetType::Image, 6, image, sizeof(image)));
+		TestEnsure(writer.Add("textures/anim/sub/0.png", AssetType::Image, 7, image, sizeof(image)));
+		TestEnsure(writer.Add("empty", AssetType::Raw, 0, nullptr, 0));
+		TestEnsure(writer.Finish());
+		TestEnsure(writer.GetAssetCount() == 5);
+	}
+
+	AssetBundle bundle;
+	TestEnsure(bundle.Open(bundlePath));
+	TestEnsure(bundle.GetAssetCount() == 5);
+
+	const AssetBundle::Asset* shader = bundle.Find("shaders/test.vs");
+	TestEnsure(shader != nullptr);
+	TestEnsure(shader->type == AssetType::Raw);
+	TestEnsure(shader->lastWriteTime == 1234);
+	TestEnsure(String((const char*)shader->data, shader->size) == "void main() {}");
+	// Asset data is aligned, so decoded images can be used in place
+	TestEnsure(((size_t)shader->data % 16) == 0);
+
+	const AssetBundle::Asset* frame = bundle.Find("textures\\anim\\1.png");
+	TestEnsure(frame != nullptr);
+	TestEnsure(frame->type == AssetType::Image);
+	TestEnsure(frame->size == 24);
+	TestEnsure(frame->data[23] == 23);
+	TestEnsure(((size_t)frame->data % 16) == 0);
+
+	TestEnsure(bundle.Find("empty") != nullptr);
+	TestEnsure(bundle.Find("empty")->size == 0);
+	TestEnsure(bundle.Find("missing.png") == nullptr);
+
+	// Only direct children, in order
+	Vector<const AssetBundle::Asset*> frames = bundle.List("textures/anim/");
+	TestEnsure(frames.size() == 2);
+	TestEnsure(frames[0]->path == "textures/anim/0.png");
+	TestEnsure(frames[1]->path == "textures/anim/1.png");
+	TestEnsure(bundle.List("textures").empty());
+
+	bundle.Close();
+	TestEnsure(!bundle.IsOpen());
+	TestEnsure(bundle.Find("shaders/test.vs") == nullptr);
+}
+
+Test("AssetBundle.Invalid")
+{
+	File file;
+	TestEnsure(file.OpenWrite(TestFilename));
+	const char garbage[] = "This is not an asset bundle, just some text that is long enough for a header";
+	file.Write(garbage, sizeof(garbage));
+	file.Close();
+
+	AssetBundle bundle;
+	TestEnsure(!bundle.Open(TestFilename));
+	TestEnsure(!bundle.IsOpen());
+}
@@ -32,6 +32,11 @@ Test("File.PathString")
 
 	String rem = Path::RemoveBase(a, b);
 	TestEnsure(rem == filename);
+
+	// Only the last path component contains the extension
+	TestEnsure(Path::GetExtension(a) == "ext");
+	TestEnsure(Path::GetExtension(String() + "Vol.1" + Path::sep + "chart.ksh") == "ksh");
+	TestEnsure(Path::GetExtension(String() + "Vol.1" + Path::sep + "chart") == "");
 }
 Test("File.Create")
 {
@@ -166,3 +171,15 @@ Test("File.ReadWrite")
 		TestEnsure(file.Read(data, 1) == 0);
 	}
 }
+
+// Cache file names have to stay the same between runs and versions, or every cached file is built again
+Test("Path.CacheFilePath")
+{
+	TestEnsure(Utility::Hash64("", 0) == 14695981039346656037ULL);
+	TestEnsure(Utility::Hash64("a", 1) == 0xaf63dc4c8601ec8cULL);
+
+	String folder = Path::GetCacheFolder("jackets");
+	TestEnsure(folder == String("cache") + Path::sep + "jackets");
+	TestEnsure(Path::GetCacheFilePath(folder, "a", "png") == folder + Path::sep + "af63dc4c8601ec8c.png");
+	TestEnsure(Path::GetCacheFilePath(folder, "a") == folder + Path::sep + "af63dc4c8601ec8c");
+}
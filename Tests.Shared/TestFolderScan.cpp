@@ -0,0 +1,109 @@
+#include <Shared/Shared.hpp>
+#include <Shared/Files.hpp>
+#include <Shared/FolderScanCache.hpp>
+#include <Shared/DirectoryWatcher.hpp>
+#include <Tests/Tests.hpp>
+#include <thread>
+
+void CreateDummyFile(const String& filename);
+
+// Creates a song folder tree similar to a chart library, every song has 4 charts and 2 other files
+static void CreateSongTree(const String& root, uint32 numSongs)
+{
+	TestEnsure(Path::CreateDir(root));
+	for(uint32 i = 0; i < numSongs; i++)
+	{
+		String pack = root + Path::sep + Utility::Sprintf("Pack%d", i / 100);
+		if(i % 100 == 0)
+			TestEnsure(Path::CreateDir(pack));
+		String song = pack + Path::sep + Utility::Sprintf("Song%d", i);
+		TestEnsure(Path::CreateDir(song));
+		for(uint32 j = 0; j < 4; j++)
+			CreateDummyFile(song + Path::sep + Utility::Sprintf("chart%d.ksh", j));
+		CreateDummyFile(song + Path::sep + "song.ogg");
+		CreateDummyFile(song + Path::sep + "jacket.png");
+	}
+}
+
+Test("File.ScanCache")
+{
+	String root = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	CreateSongTree(root, 10);
+
+	FolderScanCache cache;
+	Vector<FileInfo> cold = cache.Scan({ root }, "ksh");
+	TestEnsure(cold.size() == 40);
+	TestEnsure(cache.GetCachedCount() == 0);
+	size_t numFolders = cache.folders.size();
+
+	// Nothing changed, no folder is listed again
+	Vector<FileInfo> warm = cache.Scan({ root }, "ksh");
+	TestEnsure(warm.size() == 40);
+	TestEnsure(cache.GetListedCount() == 0);
+	TestEnsure(cache.GetCachedCount() == numFolders);
+
+	// New files are found through the changed folder time
+	String song = root + Path::sep + "Pack0" + Path::sep + "Song3";
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CreateDummyFile(song + Path::sep + "extra.ksh");
+	warm = cache.Scan({ root }, "ksh");
+	TestEnsure(warm.size() == 41);
+	TestEnsure(cache.GetListedCount() == 1);
+
+	// Interrupted scans leave the cache untouched
+	bool interrupt = true;
+	cache.Scan({ root }, "ksh", &interrupt);
+	TestEnsure(cache.folders.size() == numFolders);
+}
+
+// Cold and warm scan times on a library of 20k charts, only runs with USC_BENCHMARKS set
+Test("File.ScanBenchmark")
+{
+	if(!context.BenchmarksEnabled())
+		return;
+
+	String root = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	CreateSongTree(root, 5000);
+
+	Timer t;
+	Vector<FileInfo> files = Files::ScanFilesRecursive(root, "ksh");
+	double fullMs = t.SecondsAsDouble() * 1000.0;
+	TestEnsure(files.size() == 20000);
+
+	FolderScanCache cache;
+	t.Restart();
+	files = cache.Scan({ root }, "ksh");
+	double coldMs = t.SecondsAsDouble() * 1000.0;
+	TestEnsure(files.size() == 20000);
+
+	t.Restart();
+	files = cache.Scan({ root }, "ksh");
+	double warmMs = t.SecondsAsDouble() * 1000.0;
+	TestEnsure(files.size() == 20000);
+	TestEnsure(cache.GetListedCount() == 0);
+
+	Logf("Scan of 20000 charts: recursive scan %.1f ms, cold %.1f ms, warm %.1f ms", Logger::Info, fullMs, coldMs, warmMs);
+}
+
+Test("File.DirectoryWatcher")
+{
+	if(!DirectoryWatcher::IsSupported())
+		return;
+
+	String root = Path::Absolute(TestBasePath + Path::sep + context.GetName() + "_TestFolder");
+	TestEnsure(Path::CreateDir(root));
+
+	DirectoryWatcher watcher;
+	TestEnsure(watcher.AddFolder(root));
+	CreateDummyFile(root + Path::sep + "a.ksh");
+	TestEnsure(Path::CreateDir(root + Path::sep + "Song"));
+	TestEnsure(Path::Delete(root + Path::sep + "a.ksh"));
+
+	Vector<DirectoryWatcher::Change> changes = watcher.Poll();
+	TestEnsure(changes.size() == 3);
+	TestEnsure(changes[0].action == DirectoryWatcher::Action::Modified);
+	TestEnsure(changes[0].path == root + Path::sep + "a.ksh");
+	TestEnsure(changes[1].action == DirectoryWatcher::Action::FolderAdded);
+	TestEnsure(changes[2].action == DirectoryWatcher::Action::Removed);
+	TestEnsure(watcher.Poll().empty());
+}
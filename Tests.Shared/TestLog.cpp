@@ -0,0 +1,129 @@
+#include <Shared/Shared.hpp>
+#include <Shared/Timer.hpp>
+#include <Shared/Thread.hpp>
+#include <Shared/File.hpp>
+#include <Tests/Tests.hpp>
+#include <atomic>
+
+Test("Log.Filter")
+{
+	Logger& logger = Logger::Get();
+	logger.SetLogLevel(Logger::Warning);
+	TestEnsure(!logger.IsEnabled(Logger::Info));
+	TestEnsure(!logger.IsEnabled(Logger::Normal));
+	TestEnsure(logger.IsEnabled(Logger::Warning));
+	TestEnsure(logger.IsEnabled(Logger::Error));
+	TestEnsure(!logger.ShouldLog(Logger::Info, "Filtered"));
+	logger.SetLogLevel(Logger::Info);
+	TestEnsure(logger.IsEnabled(Logger::Info));
+
+	// Same format string, only the first few pass within the same second
+	logger.SetRateLimit(5);
+	static const char* format = "Rate limited %d";
+	uint32 passed = 0;
+	for(uint32 i = 0; i < 100; i++)
+	{
+		if(logger.ShouldLog(Logger::Normal, format))
+			passed++;
+	}
+	TestEnsure(passed >= 5 && passed < 100);
+	logger.SetRateLimit(0);
+	TestEnsure(logger.ShouldLog(Logger::Normal, format));
+	logger.SetRateLimit(100);
+}
+
+// Messages from several threads below the queue capacity are all written, in the order each thread logged them
+Test("Log.Ordering")
+{
+	Logger& logger = Logger::Get();
+	logger.Flush();
+	logger.SetConsoleOutput(false);
+
+	String logPath = Utility::Sprintf("log_%s.txt", Path::GetModuleName());
+	File logFile;
+	TestEnsure(logFile.OpenRead(logPath));
+	size_t start = logFile.GetSize();
+
+	const uint32 numThreads = 4;
+	const uint32 messagesPerThread = 500;
+	uint64 droppedBefore = logger.GetDroppedCount();
+	Vector<Thread> threads;
+	for(uint32 t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			for(uint32 i = 0; i < messagesPerThread; i++)
+				logger.Log(Utility::Sprintf("Log ordering test %d %d", t, i), Logger::Normal);
+		});
+	}
+	for(Thread& t : threads)
+		t.join();
+	logger.Flush();
+	logger.SetConsoleOutput(true);
+	TestEnsure(logger.GetDroppedCount() == droppedBefore);
+
+	String written;
+	written.resize(logFile.GetSize() - start);
+	logFile.Seek(start);
+	TestEnsure(logFile.Read(&written.front(), written.size()) == written.size());
+	uint32 next[numThreads] = { 0 };
+	bool ordered = true;
+	for(const char* line = strstr(written.c_str(), "Log ordering test "); line; line = strstr(line + 1, "Log ordering test "))
+	{
+		uint32 t, i;
+		if(sscanf(line, "Log ordering test %u %u", &t, &i) != 2 || t >= numThreads)
+			continue;
+		ordered = ordered && i == next[t];
+		next[t] = i + 1;
+	}
+	TestEnsure(ordered);
+	for(uint32 t = 0; t < numThreads; t++)
+		TestEnsure(next[t] == messagesPerThread);
+}
+
+// Measures the time producers spend logging, the writer thread does the actual I/O
+//	only runs with USC_BENCHMARKS set, producers outrun the writer so most messages are dropped
+Test("Log.Throughput")
+{
+	if(!context.BenchmarksEnabled())
+		return;
+
+	Logger& logger = Logger::Get();
+	logger.Flush();
+	logger.SetConsoleOutput(false);
+
+	const uint32 numThreads = 4;
+	const uint32 messagesPerThread = 20000;
+	uint64 droppedBefore = logger.GetDroppedCount();
+	std::atomic<uint64> totalNs;
+	totalNs = 0;
+
+	Vector<Thread> threads;
+	for(uint32 t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			String msg = Utility::Sprintf("Log throughput test message from thread %d with some extra padding text", t);
+			Timer timer;
+			for(uint32 i = 0; i < messagesPerThread; i++)
+			{
+				logger.Log(msg, Logger::Info);
+			}
+			totalNs += (uint64)(timer.SecondsAsDouble() * 1000000000.0);
+		});
+	}
+	for(Thread& t : threads)
+		t.join();
+
+	Timer flushTimer;
+	logger.Flush();
+	double flushMs = flushTimer.SecondsAsDouble() * 1000.0;
+	logger.SetConsoleOutput(true);
+
+	uint64 sent = numThreads * messagesPerThread;
+	uint64 dropped = logger.GetDroppedCount() - droppedBefore;
+	double nsPerMessage = (double)totalNs / (double)sent;
+	Logf("Log throughput: %.1f ns/message per producer, %.0f messages/s, %d dropped, %.1f ms to flush", Logger::Info,
+		nsPerMessage, 1000000000.0 / nsPerMessage, (int32)dropped, flushMs);
+	TestEnsure(dropped < sent);
+}
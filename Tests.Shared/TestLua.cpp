@@ -0,0 +1,101 @@
+#include <Shared/Shared.hpp>
+#include <Shared/LuaBindings.hpp>
+#include <Tests/Tests.hpp>
+#include "lua.hpp"
+
+// Pushes a table that sets the global 'collected' when it is garbage collected
+static void PushTrackedTable(lua_State* L)
+{
+	luaL_dostring(L, "collected = false; return setmetatable({}, { __gc = function() collected = true end })");
+}
+static bool IsCollected(lua_State* L)
+{
+	lua_getglobal(L, "collected");
+	bool collected = lua_toboolean(L, -1) != 0;
+	lua_pop(L, 1);
+	return collected;
+}
+
+Test("Lua.RefLifetime")
+{
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+
+	LuaRef ref;
+	TestEnsure(!ref.IsValid());
+
+	// The reference keeps the value alive after it is removed from the stack
+	PushTrackedTable(L);
+	const void* table = lua_topointer(L, -1);
+	ref.Set(L, -1);
+	lua_pop(L, 1);
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	TestEnsure(ref.IsValid());
+	TestEnsure(!IsCollected(L));
+	ref.Push();
+	TestEnsure(lua_topointer(L, -1) == table);
+	lua_pop(L, 1);
+
+	// Releasing it lets the value be collected and pushes nil afterwards
+	ref.Release();
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	TestEnsure(!ref.IsValid());
+	TestEnsure(IsCollected(L));
+	ref.Push();
+	TestEnsure(lua_isnil(L, -1));
+	lua_pop(L, 1);
+
+	// Replacing a reference releases the old value
+	PushTrackedTable(L);
+	ref.Set(L, -1);
+	lua_pop(L, 1);
+	lua_pushinteger(L, 5);
+	ref.Set(L, -1);
+	lua_pop(L, 1);
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	TestEnsure(IsCollected(L));
+
+	// Missing globals leave the reference empty
+	TestEnsure(!ref.SetGlobal(L, "missing"));
+	TestEnsure(!ref.IsValid());
+	lua_pushinteger(L, 7);
+	lua_setglobal(L, "present");
+	TestEnsure(ref.SetGlobal(L, "present"));
+	ref.Push();
+	TestEnsure(lua_tointeger(L, -1) == 7);
+	lua_pop(L, 1);
+	TestEnsure(lua_gettop(L) == 0);
+
+	ref.Release();
+	lua_close(L);
+}
+
+Test("Lua.GarbageCollectorSteps")
+{
+	lua_State* L = luaL_newstate();
+	luaL_openlibs(L);
+
+	LuaGarbageCollector gc;
+	gc.Attach(L, 1000);
+
+	// Garbage is only collected by the steps once the automatic collector is stopped
+	PushTrackedTable(L);
+	lua_pop(L, 1);
+	luaL_dostring(L, "for i = 1, 10000 do local t = { i } end");
+	TestEnsure(!IsCollected(L));
+
+	// Steps from several calls in a frame add up
+	//	the finalizer runs before the step that finishes the cycle, so wait for the cycle to be counted too
+	for(uint32 frame = 0; frame < 10000 && !(IsCollected(L) && gc.GetStats().gcCycles > 0); frame++)
+	{
+		gc.Step();
+		gc.Step();
+		gc.EndFrame();
+	}
+	TestEnsure(IsCollected(L));
+	TestEnsure(gc.GetStats().gcCycles > 0);
+	TestEnsure(gc.GetStats().memoryUsage > 0);
+
+	gc.Detach();
+	lua_close(L);
+}
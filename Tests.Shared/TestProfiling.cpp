@@ -0,0 +1,81 @@
+#include <Shared/Shared.hpp>
+#include <Shared/Profiling.hpp>
+#include <Shared/File.hpp>
+#include <Tests/Tests.hpp>
+#include <thread>
+
+Test("Profiler.Capture")
+{
+	// Events outside of a capture are not recorded
+	Profiler::BeginEvent("Outside");
+	Profiler::EndEvent("Outside");
+
+	Profiler::SetThreadName("Test Thread");
+	Profiler::BeginCapture();
+	TestEnsure(Profiler::IsCapturing());
+	{
+		ProfilerEventScope outer("Outer");
+		ProfilerEventScope inner("Inner");
+	}
+	// Left open, should be closed at the end of the capture
+	Profiler::BeginEvent("Open");
+
+	String path = TestFilename;
+	TestEnsure(Profiler::EndCapture(path));
+	TestEnsure(!Profiler::IsCapturing());
+	Profiler::EndEvent("Open");
+
+	File file;
+	TestEnsure(file.OpenRead(path));
+	String json;
+	json.resize(file.GetSize());
+	file.Read(&json[0], json.size());
+
+	TestEnsure(json.find("\"traceEvents\"") != String::npos);
+	TestEnsure(json.find("\"Test Thread\"") != String::npos);
+	TestEnsure(json.find("\"Outer\"") != String::npos);
+	TestEnsure(json.find("\"Inner\"") != String::npos);
+	TestEnsure(json.find("\"Outside\"") == String::npos);
+
+	// Every begin has a matching end
+	size_t begins = 0, ends = 0;
+	for(size_t pos = 0; (pos = json.find("\"ph\":\"B\"", pos)) != String::npos; pos++)
+		begins++;
+	for(size_t pos = 0; (pos = json.find("\"ph\":\"E\"", pos)) != String::npos; pos++)
+		ends++;
+	TestEnsure(begins == 3);
+	TestEnsure(begins == ends);
+}
+
+// A thread that writes more events than its buffer holds during a capture loses exactly the oldest ones
+Test("Profiler.Overflow")
+{
+	const uint32 extraEvents = 100;
+	Profiler::BeginCapture();
+	for(uint32 i = 0; i < Profiler::bufferSize + extraEvents; i++)
+		Profiler::BeginEvent("Overflow");
+	String path = TestFilename;
+	TestEnsure(Profiler::EndCapture(path));
+	TestEnsure(Profiler::GetDroppedEvents() == extraEvents);
+
+	// Reserved buffers are used by the thread that attaches to them
+	ProfilerThread reserved = Profiler::ReserveThread("Reserved Thread");
+	Profiler::BeginCapture();
+	std::thread thread([reserved]()
+	{
+		Profiler::AttachThread(reserved);
+		Profiler::BeginEvent("Reserved");
+		Profiler::EndEvent("Reserved");
+	});
+	thread.join();
+	TestEnsure(Profiler::EndCapture(path));
+	TestEnsure(Profiler::GetDroppedEvents() == 0);
+
+	File file;
+	TestEnsure(file.OpenRead(path));
+	String json;
+	json.resize(file.GetSize());
+	file.Read(&json[0], json.size());
+	TestEnsure(json.find("\"Reserved Thread\"") != String::npos);
+	TestEnsure(json.find("\"Reserved\"") != String::npos);
+}
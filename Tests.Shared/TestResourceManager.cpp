@@ -0,0 +1,51 @@
+#include <Shared/Shared.hpp>
+#include <Shared/ResourceManager.hpp>
+#include <Tests/Tests.hpp>
+
+static int32 numAlive = 0;
+class TestResource
+{
+public:
+	TestResource() { numAlive++; }
+	~TestResource() { numAlive--; }
+	size_t GetMemoryUsage() const { return 100; }
+};
+
+Test("ResourceManager.Collect")
+{
+	ResourceManager<TestResource> manager;
+	Vector<Ref<TestResource>> kept;
+	for(uint32 i = 0; i < 1000; i++)
+	{
+		Ref<TestResource> res = manager.Register(new TestResource());
+		if(i % 2 == 0)
+			kept.Add(res);
+	}
+	TestEnsure(numAlive == 1000);
+	TestEnsure(manager.GetStats().liveObjects == 1000);
+
+	TestEnsure(manager.GarbageCollect());
+	TestEnsure(numAlive == 500);
+	ResourceManagerStats stats = manager.GetStats();
+	TestEnsure(stats.liveObjects == 500);
+	TestEnsure(stats.totalCollected == 500);
+	TestEnsure(stats.memoryUsage == 500 * 100);
+
+	// Released slots are reused
+	for(uint32 i = 0; i < 500; i++)
+		kept.Add(manager.Register(new TestResource()));
+	TestEnsure(manager.GetStats().liveObjects == 1000);
+
+	// Deferred objects stay alive until released
+	manager.SetDeferDestruction(true);
+	kept.clear();
+	while(!manager.GarbageCollect(1))
+	{
+	}
+	TestEnsure(numAlive == 1000);
+	TestEnsure(manager.GetStats().pendingDestruction == 1000);
+	TestEnsure(manager.GetStats().liveObjects == 0);
+	manager.SetDeferDestruction(false);
+	TestEnsure(numAlive == 0);
+	TestEnsure(manager.GetStats().pendingDestruction == 0);
+}
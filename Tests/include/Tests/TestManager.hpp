@@ -67,6 +67,8 @@ public:
 	String GenerateTestFilePath() const;
 	String GetTestBasePath() const;
 	String GetName() const { return m_name; }
+	// Benchmarks that generate big inputs on disk only run when the USC_BENCHMARKS environment variable is set
+	bool BenchmarksEnabled() const;
 
 private:
 	TestManager* m_testManager;
@@ -177,3 +177,7 @@ String TestContext::GetTestBasePath() const
 {
 	return m_testManager->m_testBasePath;
 }
+bool TestContext::BenchmarksEnabled() const
+{
+	return getenv("USC_BENCHMARKS") != nullptr;
+}
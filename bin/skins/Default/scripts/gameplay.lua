@@ -61,9 +61,7 @@ draw_stat = function(x,y,w,h, name, value, format,r,g,b)
 end
 
 drawSongInfo = function(deltaTime)
-    if jacket == nil or jacket == jacketFallback then
-        jacket = gfx.LoadImageJob(gameplay.jacketPath, jacketFallback)
-    end
+    jacket = gfx.LoadImageJob(gameplay.jacketPath, jacketFallback)
     gfx.Save()
     if portrait then gfx.Scale(0.7,0.7) end
     gfx.BeginPath()
@@ -301,9 +301,8 @@ draw_selected = function(song, x, y, w, h)
       imageSize = math.floor((height/3)*2)
       imageXPos = x+xMargin+xPadding
     end
-    if not songCache[song.id][selectedDiff] or songCache[song.id][selectedDiff] ==  jacketFallback then
-        songCache[song.id][selectedDiff] = gfx.LoadImageJob(diff.jacketPath, jacketFallback, 200,200)
-    end
+    -- Jackets can be freed by the cache when they haven't been drawn for a while, so request them every frame
+    songCache[song.id][selectedDiff] = gfx.LoadImageJob(diff.jacketPath, jacketFallback, 200,200)
 
     if songCache[song.id][selectedDiff] then
         gfx.BeginPath()
@@ -0,0 +1,23 @@
+#version 330
+#extension GL_ARB_separate_shader_objects : enable
+layout(location=0) in vec3 inPos;
+layout(location=1) in vec2 inTex;
+layout(location=2) in vec4 inColor;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+layout(location=1) out vec2 fsTex;
+layout(location=2) out vec4 fsColor;
+
+uniform mat4 proj;
+uniform mat4 camera;
+uniform mat4 world;
+
+void main()
+{
+	fsTex = inTex;
+	fsColor = inColor;
+	gl_Position = proj * camera * world * vec4(inPos, 1);
+}
\ No newline at end of file
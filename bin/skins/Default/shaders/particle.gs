@@ -22,6 +22,8 @@ layout(location=2) out vec2 fsTex;
 uniform mat4 proj;
 uniform mat4 camera;
 uniform mat4 billboard;
+// Part of the texture to use, offset in xy and size in zw
+uniform vec4 texRect;
 
 void main()
 {
@@ -36,19 +38,19 @@ void main()
 	
 	gl_Position = proj * camera * (gl_in[0].gl_Position + (-cameraRight - cameraUp) * fScale);
 	fsColor = inColor[0];
-	fsTex = vec2(0.0f, 1.0f);
+	fsTex = texRect.xy + vec2(0.0f, 1.0f) * texRect.zw;
 	EmitVertex();
 
 	gl_Position = proj * camera * (gl_in[0].gl_Position + (cameraRight - cameraUp) * fScale);
-	fsTex = vec2(1.0f, 1.0f);
+	fsTex = texRect.xy + vec2(1.0f, 1.0f) * texRect.zw;
 	EmitVertex();
 	
 	gl_Position = proj * camera * (gl_in[0].gl_Position + (-cameraRight + cameraUp) * fScale);
-	fsTex = vec2(0.0f, 0.0f);
+	fsTex = texRect.xy + vec2(0.0f, 0.0f) * texRect.zw;
 	EmitVertex();
 
 	gl_Position = proj * camera * (gl_in[0].gl_Position + (cameraRight + cameraUp) * fScale);
-	fsTex = vec2(1.0f, 0.0f);
+	fsTex = texRect.xy + vec2(1.0f, 0.0f) * texRect.zw;
 	EmitVertex();
 
 	EndPrimitive();